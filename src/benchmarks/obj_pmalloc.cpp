@@ -42,6 +42,8 @@ struct prog_args {
 	size_t minsize;	      /* minimum size for random allocation size */
 	bool use_random_size; /* if set, use random size allocations */
 	unsigned seed;	      /* PRNG seed */
+	bool lockfree;	      /* if set, reserve run blocks lock-free */
+	char *huge_container; /* container type of the free chunks */
 };
 
 POBJ_LAYOUT_BEGIN(pmalloc_layout);
@@ -142,6 +144,25 @@ obj_init(struct benchmark *bench, struct benchmark_args *args)
 		poolsize = 0;
 	}
 
+	enum pobj_huge_container_type huge_container;
+	if (strcmp(ob->pa->huge_container, "ravl") == 0) {
+		huge_container = POBJ_HUGE_CONTAINER_RAVL;
+	} else if (strcmp(ob->pa->huge_container, "tlsf") == 0) {
+		huge_container = POBJ_HUGE_CONTAINER_TLSF;
+	} else {
+		fprintf(stderr, "unknown huge container: %s\n",
+			ob->pa->huge_container);
+		goto free_ob;
+	}
+
+	/* global setting, applies to the pool created below */
+	if (pmemobj_ctl_set(nullptr, "heap.huge_container",
+			    &huge_container) != 0) {
+		fprintf(stderr, "heap.huge_container: %s\n",
+			pmemobj_errormsg());
+		goto free_ob;
+	}
+
 	ob->pop = pmemobj_create(path, POBJ_LAYOUT_NAME(pmalloc_layout),
 				 poolsize, args->fmode);
 	if (ob->pop == nullptr) {
@@ -149,6 +170,16 @@ obj_init(struct benchmark *bench, struct benchmark_args *args)
 		goto free_ob;
 	}
 
+	if (ob->pa->lockfree) {
+		int enabled = 1;
+		if (pmemobj_ctl_set(ob->pop, "heap.run.lockfree",
+				    &enabled) != 0) {
+			fprintf(stderr, "heap.run.lockfree: %s\n",
+				pmemobj_errormsg());
+			goto free_pop;
+		}
+	}
+
 	ob->root = POBJ_ROOT(ob->pop, struct my_root);
 	if (TOID_IS_NULL(ob->root)) {
 		fprintf(stderr, "POBJ_ROOT: %s\n", pmemobj_errormsg());
@@ -401,7 +432,7 @@ pfree_op(struct benchmark *bench, struct operation_info *info)
 }
 
 /* command line options definition */
-static struct benchmark_clo pmalloc_clo[3];
+static struct benchmark_clo pmalloc_clo[5];
 /*
  * Stores information about pmalloc benchmark.
  */
@@ -451,6 +482,21 @@ obj_pmalloc_constructor(void)
 	pmalloc_clo[2].type_uint.min = 1;
 	pmalloc_clo[2].type_uint.max = UINT_MAX;
 
+	pmalloc_clo[3].opt_short = 'l';
+	pmalloc_clo[3].opt_long = "lockfree";
+	pmalloc_clo[3].descr = "Reserve blocks from runs without "
+			       "the bucket lock (heap.run.lockfree)";
+	pmalloc_clo[3].off = clo_field_offset(struct prog_args, lockfree);
+	pmalloc_clo[3].type = CLO_TYPE_FLAG;
+
+	pmalloc_clo[4].opt_short = 'H';
+	pmalloc_clo[4].opt_long = "huge-container";
+	pmalloc_clo[4].descr = "Container of the free chunks: ravl, tlsf "
+			       "(heap.huge_container)";
+	pmalloc_clo[4].off = clo_field_offset(struct prog_args, huge_container);
+	pmalloc_clo[4].type = CLO_TYPE_STR;
+	pmalloc_clo[4].def = "ravl";
+
 	pmalloc_info.name = "pmalloc",
 	pmalloc_info.brief = "Benchmark for internal pmalloc() "
 			     "operation";
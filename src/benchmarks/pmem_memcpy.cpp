@@ -12,16 +12,20 @@
 #include <cstring>
 #include <fcntl.h>
 #include <libpmem.h>
+#include <libpmem2.h>
 #include <sys/mman.h>
 #include <unistd.h>
 
 #include "benchmark.hpp"
 #include "file.h"
+#include "os.h"
 
 #define FLUSH_ALIGN 64
 
 #define MAX_OFFSET (FLUSH_ALIGN - 1)
 
+#define MAX_IOV 1024
+
 struct pmem_bench;
 
 typedef size_t (*offset_fn)(struct pmem_bench *pmb,
@@ -83,6 +87,25 @@ struct pmem_args {
 
 	/* do not do warmup */
 	bool no_warmup;
+
+	/*
+	 * When set to a non-zero value, the file is mapped with libpmem2
+	 * and each data chunk is copied to it as that many pieces.
+	 */
+	size_t iov;
+
+	/*
+	 * When this flag is set to true, all the pieces of a chunk are
+	 * copied with a single pmem2_memcpy_v() call, otherwise each of
+	 * them is copied with its own pmem2_memcpy_fn call.
+	 */
+	bool vector;
+
+	/*
+	 * When this flag is set to true, the non-temporal threshold of
+	 * the libpmem2 mapping is calibrated when the file is mapped.
+	 */
+	bool calibrate;
 };
 
 /*
@@ -107,6 +130,11 @@ struct pmem_bench {
 	/* Pointer to the allocated PMEM */
 	unsigned char *pmem_addr;
 
+	/* libpmem2 mapping of the file, used only with the iov argument */
+	int fd;
+	struct pmem2_map *map;
+	pmem2_memcpy_fn memcpy_fn;
+
 	/*
 	 * This field gets 'buf' or 'pmem_addr' fields assigned,
 	 * depending on the prog_args operation direction.
@@ -295,6 +323,112 @@ libpmem_memcpy_persist(void *dest, void *source, size_t len)
 	return 0;
 }
 
+/*
+ * pmem2_memcpy_pieces -- copy the chunk piece by piece, using either
+ * pmem2_memcpy_v() or pmem2_memcpy_fn for each of them.
+ */
+static void
+pmem2_memcpy_pieces(struct pmem_bench *pmb, unsigned char *dest,
+		    unsigned char *source, size_t len)
+{
+	size_t n = pmb->pargs->iov;
+	size_t piece = len / n;
+	unsigned flags = pmb->pargs->persist ? 0 : PMEM2_F_MEM_NODRAIN;
+
+	if (!pmb->pargs->vector) {
+		for (size_t i = 0; i < n; ++i)
+			pmb->memcpy_fn(dest + i * piece, source + i * piece,
+				       piece, flags);
+		return;
+	}
+
+	struct pmem2_iov iov[MAX_IOV];
+	for (size_t i = 0; i < n; ++i) {
+		iov[i].dest = dest + i * piece;
+		iov[i].src = source + i * piece;
+		iov[i].len = piece;
+	}
+
+	pmem2_memcpy_v(pmb->map, iov, n, flags);
+}
+
+/*
+ * Nt_threshold -- the non-temporal threshold of the last libpmem2 mapping,
+ * kept here because the results are printed after the mapping is deleted
+ */
+static size_t Nt_threshold;
+
+/*
+ * pmem2_map_file -- create the file of the given size and map it with libpmem2
+ */
+static int
+pmem2_map_file(struct pmem_bench *pmb, struct benchmark_args *args,
+	       enum file_type type)
+{
+	int flags = O_RDWR;
+	if (type != TYPE_DEVDAX)
+		flags |= O_CREAT | O_EXCL;
+
+	pmb->fd = os_open(args->fname, flags, args->fmode);
+	if (pmb->fd < 0) {
+		perror(args->fname);
+		return -1;
+	}
+
+	if (type != TYPE_DEVDAX &&
+	    (errno = os_posix_fallocate(pmb->fd, 0, (os_off_t)pmb->fsize)) !=
+		    0) {
+		perror("posix_fallocate");
+		goto err_close;
+	}
+
+	struct pmem2_config *cfg;
+	struct pmem2_source *src;
+	if (pmem2_config_new(&cfg)) {
+		pmem2_perror("pmem2_config_new");
+		goto err_close;
+	}
+
+	if (pmem2_source_from_fd(&src, pmb->fd)) {
+		pmem2_perror("pmem2_source_from_fd");
+		goto err_config;
+	}
+
+	if (pmem2_config_set_required_store_granularity(
+		    cfg, PMEM2_GRANULARITY_PAGE)) {
+		pmem2_perror("pmem2_config_set_required_store_granularity");
+		goto err_source;
+	}
+
+	if (pmem2_config_set_nt_threshold_calibration(
+		    cfg, pmb->pargs->calibrate)) {
+		pmem2_perror("pmem2_config_set_nt_threshold_calibration");
+		goto err_source;
+	}
+
+	if (pmem2_map_new(&pmb->map, cfg, src)) {
+		pmem2_perror("pmem2_map_new");
+		goto err_source;
+	}
+
+	pmem2_source_delete(&src);
+	pmem2_config_delete(&cfg);
+
+	pmb->pmem_addr = (unsigned char *)pmem2_map_get_address(pmb->map);
+	pmb->memcpy_fn = pmem2_get_memcpy_fn(pmb->map);
+	Nt_threshold = pmem2_map_get_nt_threshold(pmb->map);
+
+	return 0;
+
+err_source:
+	pmem2_source_delete(&src);
+err_config:
+	pmem2_config_delete(&cfg);
+err_close:
+	os_close(pmb->fd);
+	return -1;
+}
+
 /*
  * assign_size -- assigns file and buffer size
  * depending on the operation mode and type.
@@ -348,6 +482,20 @@ assign_size(struct pmem_bench *pmb, struct benchmark_args *args,
 	return 0;
 }
 
+/*
+ * pmem_memcpy_unmap -- unmap the file mapped by either library
+ */
+static void
+pmem_memcpy_unmap(struct pmem_bench *pmb)
+{
+	if (pmb->map != nullptr) {
+		pmem2_map_delete(&pmb->map);
+		os_close(pmb->fd);
+	} else {
+		pmem_unmap(pmb->pmem_addr, pmb->fsize);
+	}
+}
+
 /*
  * pmem_memcpy_init -- benchmark initialization
  *
@@ -376,6 +524,7 @@ pmem_memcpy_init(struct benchmark *bench, struct benchmark_args *args)
 	assert(pmb->pargs != nullptr);
 
 	pmb->pargs->chunk_size = args->dsize;
+	pmb->map = nullptr;
 
 	enum operation_type op_type;
 	/*
@@ -386,6 +535,24 @@ pmem_memcpy_init(struct benchmark *bench, struct benchmark_args *args)
 		ret = -1;
 		goto err_free_pmb;
 	}
+
+	if (pmb->pargs->iov != 0) {
+		if (op_type != OP_TYPE_WRITE || pmb->pargs->memcpy) {
+			fprintf(stderr,
+				"iov requires the write operation and "
+				"libpmem2\n");
+			ret = -1;
+			goto err_free_pmb;
+		}
+
+		if (pmb->pargs->chunk_size % pmb->pargs->iov != 0) {
+			fprintf(stderr,
+				"data size must be a multiple of iov\n");
+			ret = -1;
+			goto err_free_pmb;
+		}
+	}
+
 	pmb->buf =
 		(unsigned char *)util_aligned_malloc(FLUSH_ALIGN, pmb->bsize);
 	if (pmb->buf == nullptr) {
@@ -414,12 +581,20 @@ pmem_memcpy_init(struct benchmark *bench, struct benchmark_args *args)
 	}
 
 	/* create a pmem file and memory map it */
-	pmb->pmem_addr = (unsigned char *)pmem_map_file(
-		args->fname, file_size, flags, args->fmode, nullptr, nullptr);
-	if (pmb->pmem_addr == nullptr) {
-		perror(args->fname);
-		ret = -1;
-		goto err_free_pmb_rand_offsets;
+	if (pmb->pargs->iov != 0) {
+		if (pmem2_map_file(pmb, args, type) != 0) {
+			ret = -1;
+			goto err_free_pmb_rand_offsets;
+		}
+	} else {
+		pmb->pmem_addr = (unsigned char *)pmem_map_file(
+			args->fname, file_size, flags, args->fmode, nullptr,
+			nullptr);
+		if (pmb->pmem_addr == nullptr) {
+			perror(args->fname);
+			ret = -1;
+			goto err_free_pmb_rand_offsets;
+		}
 	}
 
 	if (op_type == OP_TYPE_READ) {
@@ -457,7 +632,11 @@ pmem_memcpy_init(struct benchmark *bench, struct benchmark_args *args)
 
 	if (!pmb->pargs->no_warmup) {
 		memset(pmb->buf, 0, pmb->bsize);
-		pmem_memset_persist(pmb->pmem_addr, 0, pmb->fsize);
+		if (pmb->map != nullptr)
+			pmem2_get_memset_fn(pmb->map)(pmb->pmem_addr, 0,
+						      pmb->fsize, 0);
+		else
+			pmem_memset_persist(pmb->pmem_addr, 0, pmb->fsize);
 	}
 
 	pmembench_set_priv(bench, pmb);
@@ -465,7 +644,7 @@ pmem_memcpy_init(struct benchmark *bench, struct benchmark_args *args)
 	return 0;
 
 err_unmap:
-	pmem_unmap(pmb->pmem_addr, pmb->fsize);
+	pmem_memcpy_unmap(pmb);
 err_free_pmb_rand_offsets:
 	free(pmb->rand_offsets);
 err_free_pmb_buf:
@@ -497,7 +676,11 @@ pmem_memcpy_operation(struct benchmark *bench, struct operation_info *info)
 		pmb->pargs->dest_off;
 	size_t len = pmb->pargs->chunk_size;
 
-	pmb->func_op(dest, source, len);
+	if (pmb->pargs->iov != 0)
+		pmem2_memcpy_pieces(pmb, (unsigned char *)dest,
+				    (unsigned char *)source, len);
+	else
+		pmb->func_op(dest, source, len);
 	return 0;
 }
 
@@ -508,7 +691,7 @@ static int
 pmem_memcpy_exit(struct benchmark *bench, struct benchmark_args *args)
 {
 	auto *pmb = (struct pmem_bench *)pmembench_get_priv(bench);
-	pmem_unmap(pmb->pmem_addr, pmb->fsize);
+	pmem_memcpy_unmap(pmb);
 	util_aligned_free(pmb->buf);
 	free(pmb->rand_offsets);
 	free(pmb);
@@ -516,7 +699,36 @@ pmem_memcpy_exit(struct benchmark *bench, struct benchmark_args *args)
 }
 
 /* structure to define command line arguments */
-static struct benchmark_clo pmem_memcpy_clo[8];
+/*
+ * pmem_memcpy_print_extra_headers -- print the header of the non-temporal
+ * threshold column
+ */
+static void
+pmem_memcpy_print_extra_headers()
+{
+	printf(";nt-threshold");
+}
+
+/*
+ * pmem_memcpy_print_extra_values -- print the non-temporal threshold of
+ * the libpmem2 mapping, if there was one
+ */
+static void
+pmem_memcpy_print_extra_values(struct benchmark *bench,
+			       struct benchmark_args *args,
+			       struct total_results *res)
+{
+	auto *pargs = (struct pmem_args *)args->opts;
+
+	if (pargs->iov == 0)
+		printf(";-");
+	else if (Nt_threshold == SIZE_MAX)
+		printf(";never");
+	else
+		printf(";%zu", Nt_threshold);
+}
+
+static struct benchmark_clo pmem_memcpy_clo[11];
 
 /* Stores information about benchmark. */
 static struct benchmark_info pmem_memcpy_bench;
@@ -592,6 +804,34 @@ pmem_memcpy_constructor(void)
 	pmem_memcpy_clo[7].type = CLO_TYPE_FLAG;
 	pmem_memcpy_clo[7].off = clo_field_offset(struct pmem_args, no_warmup);
 
+	pmem_memcpy_clo[8].opt_short = 0;
+	pmem_memcpy_clo[8].opt_long = "iov";
+	pmem_memcpy_clo[8].descr = "Copy each chunk as that many pieces "
+				   "using libpmem2";
+	pmem_memcpy_clo[8].type = CLO_TYPE_UINT;
+	pmem_memcpy_clo[8].off = clo_field_offset(struct pmem_args, iov);
+	pmem_memcpy_clo[8].def = "0";
+	pmem_memcpy_clo[8].type_uint.size =
+		clo_field_size(struct pmem_args, iov);
+	pmem_memcpy_clo[8].type_uint.base = CLO_INT_BASE_DEC;
+	pmem_memcpy_clo[8].type_uint.min = 0;
+	pmem_memcpy_clo[8].type_uint.max = MAX_IOV;
+
+	pmem_memcpy_clo[9].opt_short = 0;
+	pmem_memcpy_clo[9].opt_long = "vector";
+	pmem_memcpy_clo[9].descr = "Copy the pieces with pmem2_memcpy_v()";
+	pmem_memcpy_clo[9].type = CLO_TYPE_FLAG;
+	pmem_memcpy_clo[9].off = clo_field_offset(struct pmem_args, vector);
+	pmem_memcpy_clo[9].def = "false";
+
+	pmem_memcpy_clo[10].opt_short = 0;
+	pmem_memcpy_clo[10].opt_long = "calibrate";
+	pmem_memcpy_clo[10].descr = "Calibrate the non-temporal threshold "
+				    "of the libpmem2 mapping";
+	pmem_memcpy_clo[10].type = CLO_TYPE_FLAG;
+	pmem_memcpy_clo[10].off = clo_field_offset(struct pmem_args, calibrate);
+	pmem_memcpy_clo[10].def = "false";
+
 	pmem_memcpy_bench.name = "pmem_memcpy";
 	pmem_memcpy_bench.brief = "Benchmark for"
 				  "pmem_memcpy_persist() and "
@@ -609,5 +849,7 @@ pmem_memcpy_constructor(void)
 	pmem_memcpy_bench.rm_file = true;
 	pmem_memcpy_bench.allow_poolset = false;
 	pmem_memcpy_bench.print_bandwidth = true;
+	pmem_memcpy_bench.print_extra_headers = pmem_memcpy_print_extra_headers;
+	pmem_memcpy_bench.print_extra_values = pmem_memcpy_print_extra_values;
 	REGISTER_BENCHMARK(pmem_memcpy_bench);
 };
@@ -47,6 +47,7 @@ struct ranged_obj {
 struct obj_bench_args {
 	uint64_t nranges;  /* number of allocated objects */
 	bool shuffle_objs; /* shuffles the array of allocated objects */
+	bool sparse;	   /* leaves gaps between the ranges */
 };
 
 /*
@@ -56,6 +57,7 @@ struct obj_bench {
 	PMEMobjpool *pop;	   /* persistent pool handle */
 	struct ranged_obj *ranges; /* array of ranges */
 	size_t obj_size;	   /* size of a single range */
+	size_t stride;		   /* distance between the ranges */
 	uint64_t nranges;	   /* number of ranges */
 	uint64_t nallocs;	   /* number of allocations */
 	bool shuffle_objs;	   /* shuffles array of ranges */
@@ -94,7 +96,7 @@ init_ranges(struct obj_bench *ob)
 		return -1;
 	}
 
-	size_t nranges_per_object = MAX_ALLOC_SIZE / ob->obj_size;
+	size_t nranges_per_object = MAX_ALLOC_SIZE / ob->stride;
 
 	for (size_t i = 0, n = 0; n < ob->nranges && i < ob->nallocs; i++) {
 		PMEMoid oid;
@@ -106,7 +108,7 @@ init_ranges(struct obj_bench *ob)
 
 		for (size_t j = 0; j < nranges_per_object; j++) {
 			void *ptr = (char *)pmemobj_direct(oid) +
-				(j * ob->obj_size);
+				(j * ob->stride);
 			struct ranged_obj range = {ptr, ob->obj_size};
 			ob->ranges[n++] = range;
 			if (n == ob->nranges)
@@ -149,8 +151,14 @@ tx_add_range_init(struct benchmark *bench, struct benchmark_args *args)
 		return -1;
 	}
 
+	/*
+	 * Adjacent ranges are merged by the transaction, gaps between them
+	 * keep every range separate.
+	 */
+	ob->stride = bargs->sparse ? 2 * args->dsize : args->dsize;
+
 	/* let's calculate number of allocations */
-	ob->nallocs = (args->dsize * bargs->nranges / MAX_ALLOC_SIZE) + 1;
+	ob->nallocs = (ob->stride * bargs->nranges / MAX_ALLOC_SIZE) + 1;
 
 	size_t pool_size;
 
@@ -229,7 +237,7 @@ tx_add_range_exit(struct benchmark *bench, struct benchmark_args *args)
 	return 0;
 }
 
-static struct benchmark_clo tx_add_range_clo[2];
+static struct benchmark_clo tx_add_range_clo[3];
 
 /* Stores information about benchmark. */
 static struct benchmark_info tx_add_range_info;
@@ -260,6 +268,16 @@ tx_add_range_constructor(void)
 		clo_field_offset(struct obj_bench_args, shuffle_objs);
 	tx_add_range_clo[1].type = CLO_TYPE_FLAG;
 
+	tx_add_range_clo[2].opt_short = 0;
+	tx_add_range_clo[2].opt_long = "sparse";
+	tx_add_range_clo[2].descr =
+		"Leave gaps between the ranges - "
+		"prevents merging of adjacent ranges";
+	tx_add_range_clo[2].def = "false";
+	tx_add_range_clo[2].off =
+		clo_field_offset(struct obj_bench_args, sparse);
+	tx_add_range_clo[2].type = CLO_TYPE_FLAG;
+
 	tx_add_range_info.name = "pmemobj_tx_add_range";
 	tx_add_range_info.brief = "Benchmark for pmemobj_tx_add_range() "
 				  "operation";
@@ -0,0 +1,186 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/* Copyright 2026, Intel Corporation */
+
+/*
+ * util_checksum.cpp -- benchmark for the Fletcher64 checksum
+ *
+ * Measures util_checksum_seq() and util_checksum() on a DRAM buffer of
+ * data-size bytes. The vectorized code paths can be compared against the
+ * scalar one by running with PMEM_AVX512F=0 and/or PMEM_AVX=0.
+ */
+
+#include <cassert>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "benchmark.hpp"
+#include "util.h"
+
+/*
+ * checksum_args -- benchmark specific command line options
+ */
+struct checksum_args {
+	char *operation; /* operation type - seq or compute */
+};
+
+/*
+ * checksum_bench -- benchmark context
+ */
+struct checksum_bench {
+	struct checksum_args *pargs; /* prog_args structure */
+	uint64_t *buf;		     /* checksummed buffer */
+	size_t len;		     /* length of the buffer */
+	uint64_t result;	     /* keeps the result alive */
+
+	/* the actual benchmark operation */
+	void (*func_op)(struct checksum_bench *cb);
+};
+
+/*
+ * checksum_seq_op -- checksum the whole buffer as a plain sequence
+ */
+static void
+checksum_seq_op(struct checksum_bench *cb)
+{
+	cb->result += util_checksum_seq(cb->buf, cb->len, 0);
+}
+
+/*
+ * checksum_compute_op -- checksum the buffer with an embedded checksum
+ * field in the first 8 bytes, the way pool and log headers are checked
+ */
+static void
+checksum_compute_op(struct checksum_bench *cb)
+{
+	util_checksum(cb->buf, cb->len, cb->buf, 1, 0);
+	cb->result += *cb->buf;
+}
+
+/*
+ * parse_op_type -- parses command line "--operation" argument
+ */
+static int
+parse_op_type(struct checksum_bench *cb, const char *arg)
+{
+	if (strcmp(arg, "seq") == 0)
+		cb->func_op = checksum_seq_op;
+	else if (strcmp(arg, "compute") == 0)
+		cb->func_op = checksum_compute_op;
+	else
+		return -1;
+
+	return 0;
+}
+
+/*
+ * checksum_op -- actual benchmark operation
+ */
+static int
+checksum_op(struct benchmark *bench, struct operation_info *info)
+{
+	auto *cb = (struct checksum_bench *)pmembench_get_priv(bench);
+
+	cb->func_op(cb);
+
+	return 0;
+}
+
+/*
+ * checksum_init -- initialization function
+ */
+static int
+checksum_init(struct benchmark *bench, struct benchmark_args *args)
+{
+	assert(bench != nullptr);
+	assert(args != nullptr);
+	assert(args->opts != nullptr);
+
+	if (args->dsize < sizeof(uint64_t) || args->dsize % sizeof(uint32_t)) {
+		fprintf(stderr, "data-size must be a multiple of 4 and at "
+				"least 8 bytes\n");
+		return -1;
+	}
+
+	/* the dispatch to the vectorized code paths is done here */
+	util_init();
+
+	auto *cb = (struct checksum_bench *)calloc(1,
+						   sizeof(struct checksum_bench));
+	if (cb == nullptr) {
+		perror("calloc");
+		return -1;
+	}
+
+	cb->pargs = (struct checksum_args *)args->opts;
+	if (parse_op_type(cb, cb->pargs->operation)) {
+		fprintf(stderr, "wrong operation: %s\n", cb->pargs->operation);
+		goto err_free_cb;
+	}
+
+	cb->len = args->dsize;
+	errno = posix_memalign((void **)&cb->buf, CACHELINE_SIZE, cb->len);
+	if (errno) {
+		perror("posix_memalign");
+		goto err_free_cb;
+	}
+
+	for (size_t i = 0; i < cb->len / sizeof(uint32_t); ++i)
+		((uint32_t *)cb->buf)[i] = (uint32_t)rand();
+
+	pmembench_set_priv(bench, cb);
+
+	return 0;
+
+err_free_cb:
+	free(cb);
+	return -1;
+}
+
+/*
+ * checksum_exit -- benchmark cleanup function
+ */
+static int
+checksum_exit(struct benchmark *bench, struct benchmark_args *args)
+{
+	auto *cb = (struct checksum_bench *)pmembench_get_priv(bench);
+
+	free(cb->buf);
+	free(cb);
+
+	return 0;
+}
+
+static struct benchmark_clo checksum_clo[1];
+/* Stores information about benchmark. */
+static struct benchmark_info checksum_info;
+CONSTRUCTOR(checksum_constructor)
+void
+checksum_constructor(void)
+{
+	checksum_clo[0].opt_short = 'o';
+	checksum_clo[0].opt_long = "operation";
+	checksum_clo[0].descr = "Operation type - seq, compute";
+	checksum_clo[0].type = CLO_TYPE_STR;
+	checksum_clo[0].off = clo_field_offset(struct checksum_args, operation);
+	checksum_clo[0].def = "seq";
+
+	checksum_info.name = "checksum";
+	checksum_info.brief = "Benchmark for util_checksum() and "
+			      "util_checksum_seq()";
+	checksum_info.init = checksum_init;
+	checksum_info.exit = checksum_exit;
+	checksum_info.multithread = false;
+	checksum_info.multiops = true;
+	checksum_info.operation = checksum_op;
+	checksum_info.measure_time = true;
+	checksum_info.clos = checksum_clo;
+	checksum_info.nclos = ARRAY_SIZE(checksum_clo);
+	checksum_info.opts_size = sizeof(struct checksum_args);
+	checksum_info.rm_file = true;
+	checksum_info.allow_poolset = false;
+	checksum_info.print_bandwidth = true;
+	REGISTER_BENCHMARK(checksum_info);
+}
@@ -1,5 +1,5 @@
 /* SPDX-License-Identifier: BSD-3-Clause */
-/* Copyright 2017-2023, Intel Corporation */
+/* Copyright 2017-2026, Intel Corporation */
 
 /*
  * os.h -- os abstraction layer
@@ -63,6 +63,9 @@ int os_setenv(const char *name, const char *value, int overwrite);
 char *os_getenv(const char *name);
 const char *os_strsignal(int sig);
 int os_execv(const char *path, char *const argv[]);
+int os_getcpu_node(unsigned *node);
+int os_addr_numa_node(const void *addr, int *node);
+unsigned os_numa_nnodes(void);
 
 /*
  * XXX: missing APis (used in ut_file.c)
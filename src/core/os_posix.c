@@ -1,5 +1,5 @@
 // SPDX-License-Identifier: BSD-3-Clause
-/* Copyright 2017-2023, Intel Corporation */
+/* Copyright 2017-2026, Intel Corporation */
 
 /*
  * os_posix.c -- abstraction layer for basic Posix functions
@@ -8,9 +8,11 @@
 #define _GNU_SOURCE
 
 #include <fcntl.h>
+#include <limits.h>
 #include <stdarg.h>
 #include <sys/file.h>
 #include <sys/stat.h>
+#include <sys/syscall.h>
 #include <sys/types.h>
 #include <sys/uio.h>
 #include <stdlib.h>
@@ -22,6 +24,12 @@
 #include "out.h"
 #include "os.h"
 
+/* get_mempolicy(2) flags, defined here to avoid a dependency on libnuma */
+#define OS_MPOL_F_NODE (1 << 0)
+#define OS_MPOL_F_ADDR (1 << 1)
+
+#define OS_NUMA_NODES_PATH "/sys/devices/system/node/possible"
+
 /*
  * os_open -- open abstraction layer
  */
@@ -295,3 +303,51 @@ os_execv(const char *path, char *const argv[])
 {
 	return execv(path, argv);
 }
+
+/*
+ * os_getcpu_node -- returns the NUMA node of the cpu the calling thread is
+ *	currently running on
+ */
+int
+os_getcpu_node(unsigned *node)
+{
+	return (int)syscall(SYS_getcpu, NULL, node, NULL);
+}
+
+/*
+ * os_addr_numa_node -- returns the NUMA node of the memory backing the page
+ *	under the given address, the page is faulted in if needed
+ */
+int
+os_addr_numa_node(const void *addr, int *node)
+{
+	return (int)syscall(SYS_get_mempolicy, node, NULL, 0UL, addr,
+		OS_MPOL_F_NODE | OS_MPOL_F_ADDR);
+}
+
+/*
+ * os_numa_nnodes -- returns the number of possible NUMA nodes, which is one
+ *	more than the highest node id, or 1 if it cannot be determined
+ */
+unsigned
+os_numa_nnodes(void)
+{
+	FILE *f = fopen(OS_NUMA_NODES_PATH, "r");
+	if (f == NULL)
+		return 1;
+
+	/* the file contains a list of ranges, e.g. "0-1,3" */
+	unsigned max = 0;
+	unsigned long val;
+	char sep;
+	while (fscanf(f, "%lu", &val) == 1) {
+		if (val < UINT_MAX && val > max)
+			max = (unsigned)val;
+		if (fscanf(f, "%c", &sep) != 1)
+			break;
+	}
+
+	(void) fclose(f);
+
+	return max + 1;
+}
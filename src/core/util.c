@@ -123,6 +123,192 @@ util_is_zeroed(const void *addr, size_t len)
 	return 0;
 }
 
+/*
+ * checksum_seq_generic -- (internal) portable implementation of
+ *	util_checksum_seq
+ */
+static uint64_t
+checksum_seq_generic(const void *addr, size_t len, uint64_t csum)
+{
+	const uint32_t *p32 = addr;
+	const uint32_t *p32end = (const uint32_t *)((const char *)addr + len);
+	uint32_t lo32 = (uint32_t)csum;
+	uint32_t hi32 = (uint32_t)(csum >> 32);
+	while (p32 < p32end) {
+		lo32 += le32toh(*p32);
+		++p32;
+		hi32 += lo32;
+	}
+	return (uint64_t)hi32 << 32 | lo32;
+}
+
+/* implementation of util_checksum_seq, selected in util_init */
+static uint64_t (*Checksum_seq)(const void *addr, size_t len, uint64_t csum) =
+	checksum_seq_generic;
+
+#if (defined(__x86_64__) || defined(__amd64__)) && defined(__GNUC__)
+
+#include <immintrin.h>
+
+/*
+ * The vectorized implementations keep, for each of the N lanes, the sum of
+ * the words in that lane (a) and the running sum of a after each block of N
+ * words (b). For a block of words w[0..N-1], Fletcher adds N * lo + sum of
+ * (N - j) * w[j] to hi, and so, after all the blocks, hi is increased by
+ * nwords * lo + sum of (N * b[j] - j * a[j]). All the arithmetic is modulo
+ * 2^32, just like in the scalar loop, which makes the results identical.
+ */
+
+/*
+ * checksum_blocks_avx2 -- (internal) checksums the given number of 32-byte
+ *	blocks
+ */
+__attribute__((target("avx2")))
+static uint64_t
+checksum_blocks_avx2(const uint32_t *p32, size_t nblocks, uint64_t csum)
+{
+	__m256i a = _mm256_setzero_si256();
+	__m256i b = _mm256_setzero_si256();
+
+	for (size_t i = 0; i < nblocks; ++i) {
+		__m256i w = _mm256_loadu_si256((const __m256i *)p32 + i);
+		a = _mm256_add_epi32(a, w);
+		b = _mm256_add_epi32(b, a);
+	}
+
+	const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+	__m256i hi = _mm256_sub_epi32(_mm256_slli_epi32(b, 3),
+		_mm256_mullo_epi32(a, lanes));
+
+	uint32_t av[8];
+	uint32_t hv[8];
+	_mm256_storeu_si256((__m256i *)av, a);
+	_mm256_storeu_si256((__m256i *)hv, hi);
+
+	uint32_t lo32 = (uint32_t)csum;
+	uint32_t hi32 = (uint32_t)(csum >> 32) + (uint32_t)(nblocks * 8) * lo32;
+	for (int j = 0; j < 8; ++j) {
+		lo32 += av[j];
+		hi32 += hv[j];
+	}
+
+	return (uint64_t)hi32 << 32 | lo32;
+}
+
+/*
+ * checksum_seq_avx2 -- (internal) AVX2 implementation of util_checksum_seq
+ */
+static uint64_t
+checksum_seq_avx2(const void *addr, size_t len, uint64_t csum)
+{
+	size_t nblocks = len / 32;
+	if (nblocks != 0)
+		csum = checksum_blocks_avx2(addr, nblocks, csum);
+
+	return checksum_seq_generic((const char *)addr + nblocks * 32,
+		len - nblocks * 32, csum);
+}
+
+/*
+ * checksum_blocks_avx512f -- (internal) checksums the given number of
+ *	64-byte blocks
+ */
+__attribute__((target("avx512f")))
+static uint64_t
+checksum_blocks_avx512f(const uint32_t *p32, size_t nblocks, uint64_t csum)
+{
+	__m512i a = _mm512_setzero_si512();
+	__m512i b = _mm512_setzero_si512();
+
+	for (size_t i = 0; i < nblocks; ++i) {
+		__m512i w = _mm512_loadu_si512((const __m512i *)p32 + i);
+		a = _mm512_add_epi32(a, w);
+		b = _mm512_add_epi32(b, a);
+	}
+
+	const __m512i lanes = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7,
+		8, 9, 10, 11, 12, 13, 14, 15);
+	__m512i hi = _mm512_sub_epi32(_mm512_slli_epi32(b, 4),
+		_mm512_mullo_epi32(a, lanes));
+
+	uint32_t av[16];
+	uint32_t hv[16];
+	_mm512_storeu_si512(av, a);
+	_mm512_storeu_si512(hv, hi);
+
+	uint32_t lo32 = (uint32_t)csum;
+	uint32_t hi32 = (uint32_t)(csum >> 32) +
+		(uint32_t)(nblocks * 16) * lo32;
+	for (int j = 0; j < 16; ++j) {
+		lo32 += av[j];
+		hi32 += hv[j];
+	}
+
+	return (uint64_t)hi32 << 32 | lo32;
+}
+
+/*
+ * checksum_seq_avx512f -- (internal) AVX-512 implementation of
+ *	util_checksum_seq
+ */
+static uint64_t
+checksum_seq_avx512f(const void *addr, size_t len, uint64_t csum)
+{
+	size_t nblocks = len / 64;
+	if (nblocks != 0)
+		csum = checksum_blocks_avx512f(addr, nblocks, csum);
+
+	return checksum_seq_avx2((const char *)addr + nblocks * 64,
+		len - nblocks * 64, csum);
+}
+
+/*
+ * checksum_seq_select -- (internal) picks the fastest implementation of
+ *	util_checksum_seq supported by the CPU, unless disabled with
+ *	the PMEM_AVX or PMEM_AVX512F environment variables
+ */
+static void
+checksum_seq_select(void)
+{
+	__builtin_cpu_init();
+
+	char *e = os_getenv("PMEM_AVX");
+	if ((e != NULL && strcmp(e, "0") == 0) ||
+	    !__builtin_cpu_supports("avx2"))
+		return;
+
+	Checksum_seq = checksum_seq_avx2;
+
+	e = os_getenv("PMEM_AVX512F");
+	if ((e != NULL && strcmp(e, "0") == 0) ||
+	    !__builtin_cpu_supports("avx512f"))
+		return;
+
+	Checksum_seq = checksum_seq_avx512f;
+}
+
+#else
+
+static void
+checksum_seq_select(void)
+{
+}
+
+#endif
+
+/*
+ * checksum_zeros -- (internal) updates the checksum with the given number of
+ *	zeroed words
+ */
+static inline uint64_t
+checksum_zeros(uint64_t csum, size_t nwords)
+{
+	uint32_t lo32 = (uint32_t)csum;
+	uint32_t hi32 = (uint32_t)(csum >> 32) + (uint32_t)nwords * lo32;
+
+	return (uint64_t)hi32 << 32 | lo32;
+}
+
 /*
  * util_checksum_compute -- compute Fletcher64-like checksum
  *
@@ -136,32 +322,40 @@ util_checksum_compute(void *addr, size_t len, uint64_t *csump, size_t skip_off)
 	if (len % 4 != 0)
 		abort();
 
-	uint32_t *p32 = addr;
-	uint32_t *p32end = (uint32_t *)((char *)addr + len);
-	uint32_t *skip;
-	uint32_t lo32 = 0;
-	uint32_t hi32 = 0;
+	/*
+	 * The range is checksummed in up to three runs of data: before the
+	 * checksum, between the checksum and skip_off, and the zeroes after
+	 * skip_off. Both the checksum and the part after skip_off are
+	 * skipped in pairs of words.
+	 */
+	size_t skip = skip_off ?
+		MIN(ALIGN_UP(skip_off, sizeof(uint32_t)), len) : len;
+
+	uintptr_t csum_addr = (uintptr_t)csump;
+	uintptr_t base = (uintptr_t)addr;
+	size_t csum_off = len;
+	if (csum_addr >= base && csum_addr - base < len &&
+	    (csum_addr - base) % 4 == 0)
+		csum_off = csum_addr - base;
+
+	uint64_t csum = 0;
+	size_t off = 0;
+
+	if (csum_off < skip) {
+		csum = util_checksum_seq(addr, csum_off, csum);
+		csum = checksum_zeros(csum, 2);
+		off = csum_off + 2 * sizeof(uint32_t);
+	}
 
-	if (skip_off)
-		skip = (uint32_t *)((char *)addr + skip_off);
-	else
-		skip = (uint32_t *)((char *)addr + len);
-
-	while (p32 < p32end)
-		if (p32 == (uint32_t *)csump || p32 >= skip) {
-			/* lo32 += 0; treat first 32-bits as zero */
-			p32++;
-			hi32 += lo32;
-			/* lo32 += 0; treat second 32-bits as zero */
-			p32++;
-			hi32 += lo32;
-		} else {
-			lo32 += le32toh(*p32);
-			++p32;
-			hi32 += lo32;
-		}
+	if (off < skip) {
+		csum = util_checksum_seq((char *)addr + off, skip - off, csum);
+		off = skip;
+	}
 
-	return (uint64_t)hi32 << 32 | lo32;
+	if (off < len)
+		csum = checksum_zeros(csum, 2 * ((len - off + 7) / 8));
+
+	return csum;
 }
 
 /*
@@ -198,16 +392,12 @@ util_checksum_seq(const void *addr, size_t len, uint64_t csum)
 {
 	if (len % 4 != 0)
 		abort();
-	const uint32_t *p32 = addr;
-	const uint32_t *p32end = (const uint32_t *)((const char *)addr + len);
-	uint32_t lo32 = (uint32_t)csum;
-	uint32_t hi32 = (uint32_t)(csum >> 32);
-	while (p32 < p32end) {
-		lo32 += le32toh(*p32);
-		++p32;
-		hi32 += lo32;
-	}
-	return (uint64_t)hi32 << 32 | lo32;
+
+	/* not worth the indirect call */
+	if (len < 32)
+		return checksum_seq_generic(addr, len, csum);
+
+	return Checksum_seq(addr, len, csum);
 }
 
 /*
@@ -300,6 +490,8 @@ util_init(void)
 
 	Mmap_align = Pagesize;
 
+	checksum_seq_select();
+
 #if ANY_VG_TOOL_ENABLED
 	_On_valgrind = RUNNING_ON_VALGRIND;
 #endif
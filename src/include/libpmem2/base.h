@@ -58,6 +58,8 @@ extern "C" {
 #define PMEM2_E_FILE_DESCRIPTOR_NOT_SET		(-100035)
 #define PMEM2_E_SOURCE_TYPE_NOT_SUPPORTED	(-100036)
 #define PMEM2_E_IO_FAIL				(-100037)
+#define PMEM2_E_FUTURE_RUNNING			(-100038)
+#define PMEM2_E_INVALID_MOVER			(-100039)
 
 /* source setup */
 
@@ -117,6 +119,7 @@ int pmem2_vm_reservation_map_find_last(struct pmem2_vm_reservation *rsv,
 /* config setup */
 
 struct pmem2_config;
+struct pmem2_mover;
 
 int pmem2_config_new(struct pmem2_config **cfg);
 
@@ -154,6 +157,12 @@ int pmem2_config_set_protection(struct pmem2_config *cfg,
 int pmem2_config_set_vm_reservation(struct pmem2_config *cfg,
 	struct pmem2_vm_reservation *rsv, size_t offset);
 
+int pmem2_config_set_nt_threshold_calibration(struct pmem2_config *cfg,
+	int calibrate);
+
+int pmem2_config_set_mover(struct pmem2_config *cfg,
+	struct pmem2_mover *mover);
+
 /* mapping */
 struct pmem2_map;
 int pmem2_map_from_existing(struct pmem2_map **map,
@@ -171,6 +180,8 @@ size_t pmem2_map_get_size(struct pmem2_map *map);
 
 enum pmem2_granularity pmem2_map_get_store_granularity(struct pmem2_map *map);
 
+size_t pmem2_map_get_nt_threshold(struct pmem2_map *map);
+
 /* flushing */
 
 typedef void (*pmem2_persist_fn)(const void *ptr, size_t size);
@@ -185,6 +196,18 @@ pmem2_flush_fn pmem2_get_flush_fn(struct pmem2_map *map);
 
 pmem2_drain_fn pmem2_get_drain_fn(struct pmem2_map *map);
 
+struct pmem2_flush_batch;
+
+int pmem2_flush_batch_new(struct pmem2_flush_batch **batch,
+	struct pmem2_map *map);
+
+int pmem2_flush_batch_delete(struct pmem2_flush_batch **batch);
+
+void pmem2_flush_batch_add(struct pmem2_flush_batch *batch, const void *addr,
+	size_t len);
+
+void pmem2_flush_batch_commit(struct pmem2_flush_batch *batch);
+
 #define PMEM2_F_MEM_NODRAIN	(1U << 0)
 
 #define PMEM2_F_MEM_NONTEMPORAL	(1U << 1)
@@ -211,12 +234,75 @@ typedef void *(*pmem2_memcpy_fn)(void *pmemdest, const void *src, size_t len,
 typedef void *(*pmem2_memset_fn)(void *pmemdest, int c, size_t len,
 	unsigned flags);
 
+typedef int (*pmem2_memcmp_fn)(const void *pmemaddr, const void *buf,
+	size_t len);
+
 pmem2_memmove_fn pmem2_get_memmove_fn(struct pmem2_map *map);
 
 pmem2_memcpy_fn pmem2_get_memcpy_fn(struct pmem2_map *map);
 
 pmem2_memset_fn pmem2_get_memset_fn(struct pmem2_map *map);
 
+pmem2_memcmp_fn pmem2_get_memcmp_fn(struct pmem2_map *map);
+
+struct pmem2_iov {
+	void *dest;
+	const void *src;
+	size_t len;
+};
+
+void pmem2_memcpy_v(struct pmem2_map *map, const struct pmem2_iov *iov,
+	size_t iovcnt, unsigned flags);
+
+int pmem2_memcpy_checksum(struct pmem2_map *map, void *pmemdest,
+	const void *src, size_t len, unsigned flags, uint64_t *csum);
+
+/* asynchronous operations */
+
+struct pmem2_future;
+
+enum pmem2_future_state {
+    PMEM2_FUTURE_STATE_IDLE,
+    PMEM2_FUTURE_STATE_RUNNING,
+    PMEM2_FUTURE_STATE_COMPLETE,
+};
+
+typedef void (*pmem2_future_cb)(struct pmem2_future *fut, void *arg);
+
+int pmem2_future_new(struct pmem2_future **fut);
+
+int pmem2_future_delete(struct pmem2_future **fut);
+
+int pmem2_future_set_callback(struct pmem2_future *fut, pmem2_future_cb cb,
+	void *arg);
+
+enum pmem2_future_state pmem2_future_poll(struct pmem2_future *fut);
+
+void pmem2_future_wait(struct pmem2_future *fut);
+
+void pmem2_future_execute(struct pmem2_future *fut);
+
+typedef int (*pmem2_mover_submit_fn)(struct pmem2_future *fut, void *arg);
+
+int pmem2_mover_new(struct pmem2_mover **mover, unsigned nthreads);
+
+int pmem2_mover_from_fn(struct pmem2_mover **mover,
+	pmem2_mover_submit_fn submit, void *arg);
+
+int pmem2_mover_delete(struct pmem2_mover **mover);
+
+int pmem2_memcpy_async(struct pmem2_map *map, struct pmem2_future *fut,
+	void *pmemdest, const void *src, size_t len, unsigned flags);
+
+int pmem2_memmove_async(struct pmem2_map *map, struct pmem2_future *fut,
+	void *pmemdest, const void *src, size_t len, unsigned flags);
+
+int pmem2_memset_async(struct pmem2_map *map, struct pmem2_future *fut,
+	void *pmemdest, int c, size_t len, unsigned flags);
+
+int pmem2_persist_async(struct pmem2_map *map, struct pmem2_future *fut,
+	const void *ptr, size_t size);
+
 /* RAS */
 
 int pmem2_deep_flush(struct pmem2_map *map, void *ptr, size_t size);
@@ -1,5 +1,5 @@
 /* SPDX-License-Identifier: BSD-3-Clause */
-/* Copyright 2017-2023, Intel Corporation */
+/* Copyright 2017-2026, Intel Corporation */
 
 /*
  * libpmemobj/action_base.h -- definitions of libpmemobj action interface
@@ -55,6 +55,8 @@ PMEMoid pmemobj_reserve(PMEMobjpool *pop, struct pobj_action *act,
 	size_t size, uint64_t type_num);
 PMEMoid pmemobj_xreserve(PMEMobjpool *pop, struct pobj_action *act,
 	size_t size, uint64_t type_num, uint64_t flags);
+int pmemobj_xreserve_bulk(PMEMobjpool *pop, struct pobj_action *actv,
+	size_t actvcnt, size_t size, uint64_t type_num, uint64_t flags);
 void pmemobj_set_value(PMEMobjpool *pop, struct pobj_action *act,
 	uint64_t *ptr, uint64_t value);
 void pmemobj_defer_free(PMEMobjpool *pop, PMEMoid oid, struct pobj_action *act);
@@ -86,6 +86,31 @@ struct pobj_defrag_result {
 int pmemobj_defrag(PMEMobjpool *pop, PMEMoid **oidv, size_t oidcnt,
 	struct pobj_defrag_result *result);
 
+/*
+ * Called by the pointer enumeration callback for every pointer to an object.
+ */
+typedef void (*pmemobj_defrag_visit)(PMEMoid *oidp, void *visit_arg);
+
+/*
+ * Enumerates all pointers to the objects in the pool, returns non-zero
+ * on failure.
+ */
+typedef int (*pmemobj_defrag_enum)(PMEMobjpool *pop,
+	pmemobj_defrag_visit visit, void *visit_arg, void *arg);
+
+/*
+ * Registers the pointer enumeration callback used by pmemobj_defrag_step.
+ */
+int pmemobj_defrag_register(PMEMobjpool *pop, pmemobj_defrag_enum enumerate,
+	void *arg);
+
+/*
+ * Performs one step of incremental defragmentation, processing at most
+ * max_runs of the sparsest runs of the heap.
+ */
+int pmemobj_defrag_step(PMEMobjpool *pop, size_t max_runs,
+	struct pobj_defrag_result *result);
+
 #ifdef __cplusplus
 }
 #endif
@@ -1,5 +1,5 @@
 /* SPDX-License-Identifier: BSD-3-Clause */
-/* Copyright 2017-2023, Intel Corporation */
+/* Copyright 2017-2026, Intel Corporation */
 
 /*
  * libpmemobj/ctl.h -- definitions of pmemobj_ctl related entry points
@@ -147,6 +147,12 @@ enum pobj_stats_enabled {
 enum pobj_arenas_assignment_type {
 	POBJ_ARENAS_ASSIGNMENT_THREAD_KEY,
 	POBJ_ARENAS_ASSIGNMENT_GLOBAL,
+	POBJ_ARENAS_ASSIGNMENT_NUMA,
+};
+
+enum pobj_huge_container_type {
+	POBJ_HUGE_CONTAINER_RAVL,
+	POBJ_HUGE_CONTAINER_TLSF,
 };
 
 /* EXPERIMENTAL */
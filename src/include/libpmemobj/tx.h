@@ -61,6 +61,15 @@ _pobj_validate_cb_sig(pmemobj_tx_callback cb)
 
 #define TX_BEGIN(pop) _POBJ_TX_BEGIN(pop, TX_PARAM_NONE)
 
+/*
+ * Runs the transaction again, up to POBJ_TX_RETRY_MAX times, for as long as
+ * it's aborted with EAGAIN, which is how conflicts are reported by
+ * the optimistic concurrency control.
+ */
+#define TX_BEGIN_RETRY(pop)\
+for (int _pobj_attempt = 0; pmemobj_tx_retry(_pobj_attempt); ++_pobj_attempt)\
+_POBJ_TX_BEGIN(pop, TX_PARAM_NONE)
+
 #define TX_ONABORT\
 				pmemobj_tx_process();\
 				break;\
@@ -114,6 +123,18 @@ pmemobj_tx_xadd_range_direct(p, sizeof(*(p)), flags)
 #define TX_XADD_FIELD_DIRECT(p, field, flags)\
 pmemobj_tx_xadd_range_direct(&(p)->field, sizeof((p)->field), flags)
 
+#define TX_READ(o)\
+pmemobj_tx_read_range((o).oid, 0, sizeof(*(o)._type))
+
+#define TX_READ_FIELD(o, field)\
+	TX_READ_DIRECT(&(D_RO(o)->field))
+
+#define TX_READ_DIRECT(p)\
+pmemobj_tx_read_range_direct(p, sizeof(*(p)))
+
+#define TX_READ_FIELD_DIRECT(p, field)\
+pmemobj_tx_read_range_direct(&(p)->field, sizeof((p)->field))
+
 #define TX_NEW(t)\
 ((TOID(t))pmemobj_tx_alloc(sizeof(t), TOID_TYPE_NUM(t)))
 
@@ -112,6 +112,12 @@ typedef void (*pmemobj_tx_callback)(PMEMobjpool *pop, enum pobj_tx_stage stage,
 	POBJ_XADD_ASSUME_INITIALIZED |\
 	POBJ_XADD_NO_ABORT)
 
+#define POBJ_XWRITE_NO_ABORT		POBJ_FLAG_TX_NO_ABORT
+#define POBJ_XWRITE_VALID_FLAGS	(POBJ_XWRITE_NO_ABORT)
+
+#define POBJ_XREAD_NO_ABORT		POBJ_FLAG_TX_NO_ABORT
+#define POBJ_XREAD_VALID_FLAGS	(POBJ_XREAD_NO_ABORT)
+
 #define POBJ_XLOCK_NO_ABORT		POBJ_FLAG_TX_NO_ABORT
 #define POBJ_XLOCK_VALID_FLAGS	(POBJ_XLOCK_NO_ABORT)
 
@@ -191,6 +197,16 @@ void pmemobj_tx_process(void);
  */
 int pmemobj_tx_errno(void);
 
+/* the number of times a transaction started with TX_BEGIN_RETRY is run */
+#define POBJ_TX_RETRY_MAX 64
+
+/*
+ * Decides whether the transaction, which has already been run the given
+ * number of times, is run again after a conflict, and if so, backs off
+ * before that. Used by TX_BEGIN_RETRY.
+ */
+int pmemobj_tx_retry(int attempt);
+
 /*
  * Takes a "snapshot" of the memory block of given size and located at given
  * offset 'off' in the object 'oid' and saves it in the undo log.
@@ -242,6 +258,103 @@ int pmemobj_tx_xadd_range(PMEMoid oid, uint64_t off, size_t size,
  */
 int pmemobj_tx_xadd_range_direct(const void *ptr, size_t size, uint64_t flags);
 
+/*
+ * Logs the new contents of the memory range of the given object, starting at
+ * 'off' and 'size' bytes long, in the redo log. Unlike with
+ * pmemobj_tx_add_range, the old contents are not snapshotted - the range is
+ * only written when the transaction commits, after all the other changes
+ * made in it. Until then, the new contents can be read with
+ * pmemobj_tx_read_direct. In case of failure or abort, nothing is written.
+ *
+ * If successful, returns zero.
+ * Otherwise, stage changes to TX_STAGE_ONABORT and an error number is returned.
+ *
+ * This function must be called during TX_STAGE_WORK.
+ */
+int pmemobj_tx_write(PMEMoid oid, uint64_t off, const void *src, size_t size);
+
+/*
+ * Logs the new contents of the given memory range in the redo log, see
+ * pmemobj_tx_write. The supplied block of memory has to be within the pool.
+ *
+ * If successful, returns zero.
+ * Otherwise, stage changes to TX_STAGE_ONABORT and an error number is returned.
+ *
+ * This function must be called during TX_STAGE_WORK.
+ */
+int pmemobj_tx_write_direct(void *dest, const void *src, size_t size);
+
+/*
+ * Behaves exactly the same as pmemobj_tx_write when 'flags' equals 0.
+ * 'Flags' is a bitmask of the following values:
+ *  - POBJ_XWRITE_NO_ABORT - if the function does not end successfully,
+ *  do not abort the transaction and return the error number.
+ */
+int pmemobj_tx_xwrite(PMEMoid oid, uint64_t off, const void *src, size_t size,
+		uint64_t flags);
+
+/*
+ * Behaves exactly the same as pmemobj_tx_write_direct when 'flags' equals 0.
+ * 'Flags' is a bitmask of the following values:
+ *  - POBJ_XWRITE_NO_ABORT - if the function does not end successfully,
+ *  do not abort the transaction and return the error number.
+ */
+int pmemobj_tx_xwrite_direct(void *dest, const void *src, size_t size,
+		uint64_t flags);
+
+/*
+ * Copies 'size' bytes from 'src' to 'dest', including the changes made to
+ * that range by pmemobj_tx_write and its variants in the current
+ * transaction.
+ *
+ * This function must be called in a transaction.
+ */
+void pmemobj_tx_read_direct(void *dest, const void *src, size_t size);
+
+/*
+ * Adds the memory range of the given object, starting at 'off' and 'size'
+ * bytes long, to the read set of the transaction. When the optimistic
+ * concurrency control is enabled for the pool (tx.optimistic.enabled), the
+ * transaction aborts with EAGAIN if the range is modified by a different
+ * transaction before it commits. Otherwise, this function has no effect.
+ *
+ * If successful, returns zero.
+ * Otherwise, stage changes to TX_STAGE_ONABORT and an error number is returned.
+ *
+ * This function must be called during TX_STAGE_WORK.
+ */
+int pmemobj_tx_read_range(PMEMoid oid, uint64_t off, size_t size);
+
+/*
+ * Adds the given memory range to the read set of the transaction, see
+ * pmemobj_tx_read_range. The supplied block of memory has to be within the
+ * pool.
+ *
+ * If successful, returns zero.
+ * Otherwise, stage changes to TX_STAGE_ONABORT and an error number is returned.
+ *
+ * This function must be called during TX_STAGE_WORK.
+ */
+int pmemobj_tx_read_range_direct(const void *ptr, size_t size);
+
+/*
+ * Behaves exactly the same as pmemobj_tx_read_range when 'flags' equals 0.
+ * 'Flags' is a bitmask of the following values:
+ *  - POBJ_XREAD_NO_ABORT - if the function does not end successfully,
+ *  do not abort the transaction and return the error number.
+ */
+int pmemobj_tx_xread_range(PMEMoid oid, uint64_t off, size_t size,
+		uint64_t flags);
+
+/*
+ * Behaves exactly the same as pmemobj_tx_read_range_direct when 'flags'
+ * equals 0. 'Flags' is a bitmask of the following values:
+ *  - POBJ_XREAD_NO_ABORT - if the function does not end successfully,
+ *  do not abort the transaction and return the error number.
+ */
+int pmemobj_tx_xread_range_direct(const void *ptr, size_t size,
+		uint64_t flags);
+
 /*
  * Transactionally allocates a new object.
  *
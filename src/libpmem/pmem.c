@@ -846,6 +846,7 @@ pmem_init(void)
 	info.memset_nodrain_eadr = NULL;
 	info.flush = NULL;
 	info.fence = NULL;
+	info.memcmp_ntload = NULL;
 	info.flush_has_builtin_fence = 0;
 
 	pmem2_arch_init(&info);
@@ -26,6 +26,8 @@ pmem2_config_init(struct pmem2_config *cfg)
 	cfg->protection_flag = PMEM2_PROT_READ | PMEM2_PROT_WRITE;
 	cfg->reserv = NULL;
 	cfg->reserv_offset = 0;
+	cfg->nt_threshold_calibration = 0;
+	cfg->mover = NULL;
 }
 
 /*
@@ -193,6 +195,20 @@ pmem2_config_set_vm_reservation(struct pmem2_config *cfg,
 	return 0;
 }
 
+/*
+ * pmem2_config_set_mover -- set the mover of the asynchronous operations
+ *                           in the pmem2_config structure
+ */
+int
+pmem2_config_set_mover(struct pmem2_config *cfg, struct pmem2_mover *mover)
+{
+	PMEM2_ERR_CLR();
+
+	cfg->mover = mover;
+
+	return 0;
+}
+
 /*
  * pmem2_config_set_protection -- set protection flags
  * in the config struct
@@ -213,3 +229,17 @@ pmem2_config_set_protection(struct pmem2_config *cfg,
 	cfg->protection_flag = prot;
 	return 0;
 }
+
+/*
+ * pmem2_config_set_nt_threshold_calibration -- enable or disable measuring
+ * the non-temporal threshold of the mapping
+ */
+int
+pmem2_config_set_nt_threshold_calibration(struct pmem2_config *cfg,
+		int calibrate)
+{
+	PMEM2_ERR_CLR();
+
+	cfg->nt_threshold_calibration = calibrate;
+	return 0;
+}
@@ -24,6 +24,9 @@ struct pmem2_config {
 	unsigned protection_flag;
 	struct pmem2_vm_reservation *reserv;
 	size_t reserv_offset;
+	/* measure the non-temporal threshold of the mapping */
+	int nt_threshold_calibration;
+	struct pmem2_mover *mover; /* performs the asynchronous operations */
 };
 
 void pmem2_config_init(struct pmem2_config *cfg);
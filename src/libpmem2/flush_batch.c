@@ -0,0 +1,232 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/* Copyright 2026, Intel Corporation */
+
+/*
+ * flush_batch.c -- implementation of the flush batches, which collect
+ * the ranges to flush and flush each of their cache lines (or pages) once
+ */
+
+#include <stdlib.h>
+
+#include "alloc.h"
+#include "libpmem2.h"
+#include "map.h"
+#include "out.h"
+#include "pmem2_utils.h"
+#include "util.h"
+
+/* the initial number of ranges the batch can hold */
+#define FLUSH_BATCH_CAPACITY 256
+
+/*
+ * flush_batch_range -- range of the batch, aligned to the flush unit
+ */
+struct flush_batch_range {
+	uintptr_t start;
+	uintptr_t end;
+};
+
+struct pmem2_flush_batch {
+	pmem2_flush_fn flush_fn;
+	pmem2_drain_fn drain_fn;
+	size_t unit; /* 0 if the mapping does not need flushing */
+
+	size_t nranges;
+	size_t capacity;
+	struct flush_batch_range *ranges;
+};
+
+/*
+ * pmem2_flush_batch_new -- creates an empty flush batch for the mapping
+ */
+int
+pmem2_flush_batch_new(struct pmem2_flush_batch **batch_ptr,
+		struct pmem2_map *map)
+{
+	PMEM2_ERR_CLR();
+
+	int ret;
+	struct pmem2_flush_batch *batch = pmem2_malloc(sizeof(*batch), &ret);
+	if (ret)
+		return ret;
+
+	batch->ranges = pmem2_malloc(
+		FLUSH_BATCH_CAPACITY * sizeof(*batch->ranges), &ret);
+	if (ret) {
+		Free(batch);
+		return ret;
+	}
+
+	batch->flush_fn = map->flush_fn;
+	batch->drain_fn = map->drain_fn;
+	batch->nranges = 0;
+	batch->capacity = FLUSH_BATCH_CAPACITY;
+
+	switch (map->effective_granularity) {
+		case PMEM2_GRANULARITY_PAGE:
+			batch->unit = Pagesize;
+			break;
+		case PMEM2_GRANULARITY_CACHE_LINE:
+			batch->unit = CACHELINE_SIZE;
+			break;
+		case PMEM2_GRANULARITY_BYTE:
+			batch->unit = 0;
+			break;
+		default:
+			abort();
+	}
+
+	*batch_ptr = batch;
+
+	return 0;
+}
+
+/*
+ * pmem2_flush_batch_delete -- deletes the flush batch, the ranges which were
+ *	not committed may or may not be flushed
+ */
+int
+pmem2_flush_batch_delete(struct pmem2_flush_batch **batch_ptr)
+{
+	/* we do not need to clear err because this function cannot fail */
+
+	Free((*batch_ptr)->ranges);
+	Free(*batch_ptr);
+	*batch_ptr = NULL;
+
+	return 0;
+}
+
+/*
+ * flush_batch_range_cmp -- (internal) compares the ranges by their starts
+ */
+static int
+flush_batch_range_cmp(const void *lhs, const void *rhs)
+{
+	const struct flush_batch_range *l = lhs;
+	const struct flush_batch_range *r = rhs;
+
+	if (l->start < r->start)
+		return -1;
+
+	return l->start > r->start;
+}
+
+/*
+ * flush_batch_coalesce -- (internal) sorts the ranges and merges the ones
+ *	which overlap or are adjacent
+ */
+static void
+flush_batch_coalesce(struct pmem2_flush_batch *batch)
+{
+	if (batch->nranges < 2)
+		return;
+
+	struct flush_batch_range *r = batch->ranges;
+	qsort(r, batch->nranges, sizeof(*r), flush_batch_range_cmp);
+
+	size_t n = 0;
+	for (size_t i = 1; i < batch->nranges; ++i) {
+		if (r[i].start <= r[n].end)
+			r[n].end = MAX(r[n].end, r[i].end);
+		else
+			r[++n] = r[i];
+	}
+
+	batch->nranges = n + 1;
+}
+
+/*
+ * flush_batch_flush -- (internal) flushes all the ranges of the batch and
+ *	empties it
+ */
+static void
+flush_batch_flush(struct pmem2_flush_batch *batch)
+{
+	for (size_t i = 0; i < batch->nranges; ++i) {
+		struct flush_batch_range *r = &batch->ranges[i];
+		batch->flush_fn((const void *)r->start, r->end - r->start);
+	}
+
+	batch->nranges = 0;
+}
+
+/*
+ * flush_batch_grow -- (internal) makes room for more ranges in the batch,
+ *	or, if there is no memory for them, flushes the ones it has
+ */
+static void
+flush_batch_grow(struct pmem2_flush_batch *batch)
+{
+	size_t capacity = 2 * batch->capacity;
+	struct flush_batch_range *ranges = Realloc(batch->ranges,
+		capacity * sizeof(*ranges));
+
+	if (ranges == NULL) {
+		/*
+		 * Flushing the cache lines early is always correct, only
+		 * the drain has to wait for the commit.
+		 */
+		LOG(4, "cannot grow the flush batch, flushing it early");
+		flush_batch_flush(batch);
+		return;
+	}
+
+	batch->ranges = ranges;
+	batch->capacity = capacity;
+}
+
+/*
+ * pmem2_flush_batch_add -- adds the range to the batch
+ */
+void
+pmem2_flush_batch_add(struct pmem2_flush_batch *batch, const void *addr,
+		size_t len)
+{
+	LOG(15, "batch %p addr %p len %zu", batch, addr, len);
+
+	if (batch->unit == 0 || len == 0)
+		return;
+
+	uintptr_t start = ALIGN_DOWN((uintptr_t)addr, batch->unit);
+	uintptr_t end = ALIGN_UP((uintptr_t)addr + len, batch->unit);
+
+	/* the ranges are often added in order, next to each other */
+	if (batch->nranges > 0) {
+		struct flush_batch_range *last =
+			&batch->ranges[batch->nranges - 1];
+
+		if (start <= last->end && end >= last->start) {
+			last->start = MIN(last->start, start);
+			last->end = MAX(last->end, end);
+			return;
+		}
+	}
+
+	if (batch->nranges == batch->capacity) {
+		flush_batch_coalesce(batch);
+
+		if (batch->nranges > batch->capacity / 2)
+			flush_batch_grow(batch);
+	}
+
+	batch->ranges[batch->nranges].start = start;
+	batch->ranges[batch->nranges].end = end;
+	batch->nranges++;
+}
+
+/*
+ * pmem2_flush_batch_commit -- flushes the ranges of the batch, each cache
+ *	line (or page) once, waits for the flushes to complete and empties
+ *	the batch
+ */
+void
+pmem2_flush_batch_commit(struct pmem2_flush_batch *batch)
+{
+	LOG(15, "batch %p", batch);
+
+	flush_batch_coalesce(batch);
+	flush_batch_flush(batch);
+
+	batch->drain_fn();
+}
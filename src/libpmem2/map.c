@@ -59,6 +59,19 @@ pmem2_map_get_store_granularity(struct pmem2_map *map)
 	return map->effective_granularity;
 }
 
+/*
+ * pmem2_map_get_nt_threshold -- returns the length from which the copies
+ * to the mapping are done with non-temporal stores
+ */
+size_t
+pmem2_map_get_nt_threshold(struct pmem2_map *map)
+{
+	LOG(3, "map %p", map);
+
+	/* we do not need to clear err because this function cannot fail */
+	return map->nt_threshold;
+}
+
 /*
  * parse_force_granularity -- parse PMEM2_FORCE_GRANULARITY environment variable
  */
@@ -262,6 +275,7 @@ pmem2_map_from_existing(struct pmem2_map **map_ptr,
 		return ret;
 
 	map->reserv = NULL;
+	map->mover = NULL;
 	map->addr = addr;
 	map->reserved_length = 0;
 	map->content_length = len;
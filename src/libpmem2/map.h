@@ -36,9 +36,13 @@ struct pmem2_map {
 	pmem2_memmove_fn memmove_fn;
 	pmem2_memcpy_fn memcpy_fn;
 	pmem2_memset_fn memset_fn;
+	pmem2_memcmp_fn memcmp_fn;
+	/* shorter copies are done with temporal stores, unless forced */
+	size_t nt_threshold;
 
 	struct pmem2_source source;
 	struct pmem2_vm_reservation *reserv;
+	struct pmem2_mover *mover; /* NULL if the operations are synchronous */
 };
 
 enum pmem2_granularity get_min_granularity(bool eADR, bool is_pmem,
@@ -508,7 +508,12 @@ pmem2_map_new(struct pmem2_map **map_ptr, const struct pmem2_config *cfg,
 	map->effective_granularity = available_min_granularity;
 	pmem2_set_flush_fns(map);
 	pmem2_set_mem_fns(map);
+	if (cfg->nt_threshold_calibration &&
+	    (cfg->protection_flag & PMEM2_PROT_READ) &&
+	    (cfg->protection_flag & PMEM2_PROT_WRITE))
+		pmem2_calibrate_nt_threshold(map);
 	map->reserv = rsv;
+	map->mover = cfg->mover;
 	map->source = *src;
 	map->source.value.fd = INVALID_FD; /* fd should not be used after map */
 
@@ -0,0 +1,459 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/* Copyright 2026, Intel Corporation */
+
+/*
+ * mover.c -- implementation of the asynchronous operations and the default,
+ * thread pool based data mover
+ */
+
+#include "alloc.h"
+#include "libpmem2.h"
+#include "map.h"
+#include "mover.h"
+#include "out.h"
+#include "pmem2_utils.h"
+#include "sys_util.h"
+#include "util.h"
+
+/*
+ * future_get_state -- (internal) reads the state of the future, the data
+ *	written by a completed operation is visible after this
+ */
+static inline enum pmem2_future_state
+future_get_state(struct pmem2_future *fut)
+{
+	unsigned state;
+	util_atomic_load_explicit32(&fut->state, &state, memory_order_acquire);
+
+	return (enum pmem2_future_state)state;
+}
+
+/*
+ * future_set_state -- (internal) changes the state of the future
+ */
+static inline void
+future_set_state(struct pmem2_future *fut, enum pmem2_future_state state)
+{
+	util_atomic_store_explicit32(&fut->state, (unsigned)state,
+		memory_order_release);
+}
+
+/*
+ * pmem2_future_new -- allocates a future
+ */
+int
+pmem2_future_new(struct pmem2_future **fut_ptr)
+{
+	PMEM2_ERR_CLR();
+
+	int ret;
+	struct pmem2_future *fut = pmem2_zalloc(sizeof(*fut), &ret);
+	if (ret)
+		return ret;
+
+	fut->state = PMEM2_FUTURE_STATE_IDLE;
+	util_mutex_init(&fut->lock);
+	util_cond_init(&fut->cond);
+
+	*fut_ptr = fut;
+
+	return 0;
+}
+
+/*
+ * pmem2_future_delete -- deallocates a future which is not running
+ */
+int
+pmem2_future_delete(struct pmem2_future **fut_ptr)
+{
+	PMEM2_ERR_CLR();
+
+	struct pmem2_future *fut = *fut_ptr;
+
+	if (future_get_state(fut) == PMEM2_FUTURE_STATE_RUNNING) {
+		ERR_WO_ERRNO("future %p is running", fut);
+		return PMEM2_E_FUTURE_RUNNING;
+	}
+
+	/*
+	 * The future could have been completed a moment ago, by a thread
+	 * which may still be waking up the waiters.
+	 */
+	util_mutex_lock(&fut->lock);
+	util_mutex_unlock(&fut->lock);
+
+	util_cond_destroy(&fut->cond);
+	util_mutex_destroy(&fut->lock);
+	Free(fut);
+	*fut_ptr = NULL;
+
+	return 0;
+}
+
+/*
+ * pmem2_future_set_callback -- sets the function called when the operations
+ *	of the future complete
+ */
+int
+pmem2_future_set_callback(struct pmem2_future *fut, pmem2_future_cb cb,
+		void *arg)
+{
+	PMEM2_ERR_CLR();
+
+	if (future_get_state(fut) == PMEM2_FUTURE_STATE_RUNNING) {
+		ERR_WO_ERRNO("future %p is running", fut);
+		return PMEM2_E_FUTURE_RUNNING;
+	}
+
+	fut->cb = cb;
+	fut->cb_arg = arg;
+
+	return 0;
+}
+
+/*
+ * pmem2_future_poll -- returns the state of the future
+ */
+enum pmem2_future_state
+pmem2_future_poll(struct pmem2_future *fut)
+{
+	/* we do not need to clear err because this function cannot fail */
+
+	return future_get_state(fut);
+}
+
+/*
+ * pmem2_future_wait -- waits until the operation of the future completes
+ */
+void
+pmem2_future_wait(struct pmem2_future *fut)
+{
+	/* we do not need to clear err because this function cannot fail */
+
+	if (future_get_state(fut) != PMEM2_FUTURE_STATE_RUNNING)
+		return;
+
+	util_mutex_lock(&fut->lock);
+	while (future_get_state(fut) == PMEM2_FUTURE_STATE_RUNNING)
+		os_cond_wait(&fut->cond, &fut->lock);
+	util_mutex_unlock(&fut->lock);
+}
+
+/*
+ * pmem2_future_execute -- performs the operation of the future and
+ *	completes it, called by the movers, on any thread
+ */
+void
+pmem2_future_execute(struct pmem2_future *fut)
+{
+	LOG(15, "future %p", fut);
+
+	ASSERTeq(future_get_state(fut), PMEM2_FUTURE_STATE_RUNNING);
+
+	struct pmem2_map *map = fut->map;
+
+	/*
+	 * The stores are drained by the thread which did them, the caller
+	 * may not be able to do it on its own.
+	 */
+	unsigned flags = fut->flags & ~PMEM2_F_MEM_NODRAIN;
+
+	switch (fut->op) {
+		case PMEM2_FUTURE_OP_MEMCPY:
+			map->memcpy_fn(fut->dest, fut->src, fut->len, flags);
+			break;
+		case PMEM2_FUTURE_OP_MEMMOVE:
+			map->memmove_fn(fut->dest, fut->src, fut->len, flags);
+			break;
+		case PMEM2_FUTURE_OP_MEMSET:
+			map->memset_fn(fut->dest, fut->c, fut->len, flags);
+			break;
+		case PMEM2_FUTURE_OP_PERSIST:
+			map->persist_fn(fut->dest, fut->len);
+			break;
+		default:
+			ASSERT(0);
+	}
+
+	if (fut->cb)
+		fut->cb(fut, fut->cb_arg);
+
+	util_mutex_lock(&fut->lock);
+	future_set_state(fut, PMEM2_FUTURE_STATE_COMPLETE);
+	os_cond_broadcast(&fut->cond);
+	util_mutex_unlock(&fut->lock);
+}
+
+/*
+ * future_submit -- (internal) hands the operation set up in the future over
+ *	to the mover of the mapping, or performs it right away if the mapping
+ *	has no mover
+ */
+static int
+future_submit(struct pmem2_map *map, struct pmem2_future *fut,
+		enum pmem2_future_op op, void *dest, const void *src, int c,
+		size_t len, unsigned flags)
+{
+	if (future_get_state(fut) == PMEM2_FUTURE_STATE_RUNNING) {
+		ERR_WO_ERRNO("future %p is running", fut);
+		return PMEM2_E_FUTURE_RUNNING;
+	}
+
+	fut->op = op;
+	fut->map = map;
+	fut->dest = dest;
+	fut->src = src;
+	fut->c = c;
+	fut->len = len;
+	fut->flags = flags;
+	future_set_state(fut, PMEM2_FUTURE_STATE_RUNNING);
+
+	struct pmem2_mover *mover = map->mover;
+	if (mover == NULL) {
+		pmem2_future_execute(fut);
+		return 0;
+	}
+
+	int ret = mover->submit(fut, mover->arg);
+	if (ret) {
+		ERR_WO_ERRNO("mover %p cannot take the future %p", mover, fut);
+		future_set_state(fut, PMEM2_FUTURE_STATE_IDLE);
+		return ret;
+	}
+
+	return 0;
+}
+
+/*
+ * pmem2_memcpy_async -- starts an asynchronous memcpy to the mapping
+ */
+int
+pmem2_memcpy_async(struct pmem2_map *map, struct pmem2_future *fut,
+		void *pmemdest, const void *src, size_t len, unsigned flags)
+{
+	LOG(15, "map %p future %p pmemdest %p src %p len %zu flags 0x%x",
+		map, fut, pmemdest, src, len, flags);
+	PMEM2_ERR_CLR();
+
+	return future_submit(map, fut, PMEM2_FUTURE_OP_MEMCPY, pmemdest, src,
+		0, len, flags);
+}
+
+/*
+ * pmem2_memmove_async -- starts an asynchronous memmove to the mapping
+ */
+int
+pmem2_memmove_async(struct pmem2_map *map, struct pmem2_future *fut,
+		void *pmemdest, const void *src, size_t len, unsigned flags)
+{
+	LOG(15, "map %p future %p pmemdest %p src %p len %zu flags 0x%x",
+		map, fut, pmemdest, src, len, flags);
+	PMEM2_ERR_CLR();
+
+	return future_submit(map, fut, PMEM2_FUTURE_OP_MEMMOVE, pmemdest, src,
+		0, len, flags);
+}
+
+/*
+ * pmem2_memset_async -- starts an asynchronous memset of the mapping
+ */
+int
+pmem2_memset_async(struct pmem2_map *map, struct pmem2_future *fut,
+		void *pmemdest, int c, size_t len, unsigned flags)
+{
+	LOG(15, "map %p future %p pmemdest %p c %d len %zu flags 0x%x",
+		map, fut, pmemdest, c, len, flags);
+	PMEM2_ERR_CLR();
+
+	return future_submit(map, fut, PMEM2_FUTURE_OP_MEMSET, pmemdest, NULL,
+		c, len, flags);
+}
+
+/*
+ * pmem2_persist_async -- starts an asynchronous persist of a range of
+ *	the mapping
+ */
+int
+pmem2_persist_async(struct pmem2_map *map, struct pmem2_future *fut,
+		const void *ptr, size_t size)
+{
+	LOG(15, "map %p future %p ptr %p size %zu", map, fut, ptr, size);
+	PMEM2_ERR_CLR();
+
+	return future_submit(map, fut, PMEM2_FUTURE_OP_PERSIST, (void *)ptr,
+		NULL, 0, size, 0);
+}
+
+/*
+ * mover_worker -- (internal) the thread of the default mover, performs
+ *	the queued operations until the mover is deleted
+ */
+static void *
+mover_worker(void *arg)
+{
+	struct pmem2_mover *mover = arg;
+
+	util_mutex_lock(&mover->lock);
+	while (1) {
+		while (PMDK_STAILQ_EMPTY(&mover->queue) && !mover->stop)
+			os_cond_wait(&mover->cond, &mover->lock);
+
+		/* the queued operations are always performed */
+		if (PMDK_STAILQ_EMPTY(&mover->queue))
+			break;
+
+		struct pmem2_future *fut = PMDK_STAILQ_FIRST(&mover->queue);
+		PMDK_STAILQ_REMOVE_HEAD(&mover->queue, next);
+		util_mutex_unlock(&mover->lock);
+
+		pmem2_future_execute(fut);
+
+		util_mutex_lock(&mover->lock);
+	}
+	util_mutex_unlock(&mover->lock);
+
+	return NULL;
+}
+
+/*
+ * mover_queue_submit -- (internal) queues the operation for the worker
+ *	threads of the default mover
+ */
+static int
+mover_queue_submit(struct pmem2_future *fut, void *arg)
+{
+	struct pmem2_mover *mover = arg;
+
+	util_mutex_lock(&mover->lock);
+	PMDK_STAILQ_INSERT_TAIL(&mover->queue, fut, next);
+	os_cond_signal(&mover->cond);
+	util_mutex_unlock(&mover->lock);
+
+	return 0;
+}
+
+/*
+ * mover_stop -- (internal) waits for the queued operations and joins
+ *	the first nthreads worker threads of the default mover
+ */
+static void
+mover_stop(struct pmem2_mover *mover, unsigned nthreads)
+{
+	util_mutex_lock(&mover->lock);
+	mover->stop = 1;
+	os_cond_broadcast(&mover->cond);
+	util_mutex_unlock(&mover->lock);
+
+	for (unsigned i = 0; i < nthreads; ++i)
+		os_thread_join(&mover->threads[i], NULL);
+}
+
+/*
+ * pmem2_mover_new -- creates the default mover, with a pool of worker
+ *	threads
+ */
+int
+pmem2_mover_new(struct pmem2_mover **mover_ptr, unsigned nthreads)
+{
+	PMEM2_ERR_CLR();
+	*mover_ptr = NULL;
+
+	if (nthreads == 0) {
+		ERR_WO_ERRNO("the mover needs at least one thread");
+		return PMEM2_E_INVALID_MOVER;
+	}
+
+	int ret;
+	struct pmem2_mover *mover = pmem2_zalloc(sizeof(*mover), &ret);
+	if (ret)
+		return ret;
+
+	mover->threads = pmem2_malloc(nthreads * sizeof(*mover->threads),
+		&ret);
+	if (ret)
+		goto err_free_mover;
+
+	mover->submit = mover_queue_submit;
+	mover->arg = mover;
+	util_mutex_init(&mover->lock);
+	util_cond_init(&mover->cond);
+	PMDK_STAILQ_INIT(&mover->queue);
+
+	for (unsigned i = 0; i < nthreads; ++i) {
+		errno = os_thread_create(&mover->threads[i], NULL,
+			mover_worker, mover);
+		if (errno) {
+			ERR_W_ERRNO("os_thread_create");
+			ret = PMEM2_E_ERRNO;
+			mover_stop(mover, i);
+			goto err_free_threads;
+		}
+	}
+	mover->nthreads = nthreads;
+
+	*mover_ptr = mover;
+
+	return 0;
+
+err_free_threads:
+	util_cond_destroy(&mover->cond);
+	util_mutex_destroy(&mover->lock);
+	Free(mover->threads);
+err_free_mover:
+	Free(mover);
+	return ret;
+}
+
+/*
+ * pmem2_mover_from_fn -- creates a mover which hands the operations over
+ *	to the given function
+ */
+int
+pmem2_mover_from_fn(struct pmem2_mover **mover_ptr,
+		pmem2_mover_submit_fn submit, void *arg)
+{
+	PMEM2_ERR_CLR();
+	*mover_ptr = NULL;
+
+	if (submit == NULL) {
+		ERR_WO_ERRNO("the submit function is NULL");
+		return PMEM2_E_INVALID_MOVER;
+	}
+
+	int ret;
+	struct pmem2_mover *mover = pmem2_zalloc(sizeof(*mover), &ret);
+	if (ret)
+		return ret;
+
+	mover->submit = submit;
+	mover->arg = arg;
+
+	*mover_ptr = mover;
+
+	return 0;
+}
+
+/*
+ * pmem2_mover_delete -- deletes the mover, the default one completes all
+ *	the operations submitted to it first
+ */
+int
+pmem2_mover_delete(struct pmem2_mover **mover_ptr)
+{
+	/* we do not need to clear err because this function cannot fail */
+
+	struct pmem2_mover *mover = *mover_ptr;
+
+	if (mover->nthreads) {
+		mover_stop(mover, mover->nthreads);
+
+		util_cond_destroy(&mover->cond);
+		util_mutex_destroy(&mover->lock);
+		Free(mover->threads);
+	}
+
+	Free(mover);
+	*mover_ptr = NULL;
+
+	return 0;
+}
@@ -0,0 +1,64 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright 2026, Intel Corporation */
+
+/*
+ * mover.h -- internal definitions for the asynchronous operations
+ */
+#ifndef PMEM2_MOVER_H
+#define PMEM2_MOVER_H
+
+#include "libpmem2.h"
+#include "os_thread.h"
+#include "queue.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum pmem2_future_op {
+	PMEM2_FUTURE_OP_MEMCPY,
+	PMEM2_FUTURE_OP_MEMMOVE,
+	PMEM2_FUTURE_OP_MEMSET,
+	PMEM2_FUTURE_OP_PERSIST,
+};
+
+struct pmem2_future {
+	/* the operation, valid while the future is running */
+	enum pmem2_future_op op;
+	struct pmem2_map *map;
+	void *dest;
+	const void *src;
+	int c;
+	size_t len;
+	unsigned flags;
+
+	pmem2_future_cb cb;
+	void *cb_arg;
+
+	/* enum pmem2_future_state, read without the lock by the pollers */
+	unsigned state;
+	os_mutex_t lock;
+	os_cond_t cond;
+
+	/* the queue of the default mover */
+	PMDK_STAILQ_ENTRY(pmem2_future) next;
+};
+
+struct pmem2_mover {
+	pmem2_mover_submit_fn submit;
+	void *arg;
+
+	/* the worker threads of the default mover, 0 for the custom ones */
+	unsigned nthreads;
+	os_thread_t *threads;
+	os_mutex_t lock;
+	os_cond_t cond;
+	PMDK_STAILQ_HEAD(pmem2_mover_queue, pmem2_future) queue;
+	int stop;
+};
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* mover.h */
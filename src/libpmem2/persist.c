@@ -6,10 +6,14 @@
  */
 
 #include <errno.h>
+#include <inttypes.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
 
 #include "libpmem2.h"
 #include "libpmem2/base.h"
+#include "alloc.h"
 #include "map.h"
 #include "out.h"
 #include "os.h"
@@ -70,6 +74,15 @@ memset_nodrain_libc(void *pmemdest, int c, size_t len, unsigned flags,
 	return pmemdest;
 }
 
+/*
+ * memcmp_libc -- (internal) compares pmem with a buffer using libc
+ */
+static int
+memcmp_libc(const void *pmemaddr, const void *buf, size_t len)
+{
+	return memcmp(pmemaddr, buf, len);
+}
+
 /*
  * pmem2_persist_init -- initialize persist module
  */
@@ -82,7 +95,9 @@ pmem2_persist_init(void)
 	Info.memset_nodrain_eadr = NULL;
 	Info.flush = NULL;
 	Info.fence = NULL;
+	Info.memcmp_ntload = NULL;
 	Info.flush_has_builtin_fence = 0;
+	Info.movnt_threshold = SIZE_MAX;
 
 	pmem2_arch_init(&Info);
 
@@ -114,6 +129,11 @@ pmem2_persist_init(void)
 			LOG(3, "using generic memset");
 		}
 	}
+
+	if (Info.memcmp_ntload == NULL) {
+		Info.memcmp_ntload = memcmp_libc;
+		LOG(3, "using libc memcmp");
+	}
 }
 
 /*
@@ -556,12 +576,119 @@ pmem2_memset_eadr(void *pmemdest, int c, size_t len, unsigned flags)
 	return pmemdest;
 }
 
+/*
+ * pmem2_memcmp -- compares pmem with a buffer
+ */
+static int
+pmem2_memcmp(const void *pmemaddr, const void *buf, size_t len)
+{
+	LOG(15, "pmemaddr %p buf %p len %zu", pmemaddr, buf, len);
+
+	return Info.memcmp_ntload(pmemaddr, buf, len);
+}
+
+/*
+ * pmem2_nt_flags -- (internal) picks the type of stores for an operation
+ *	of the given length, unless it was already picked by the caller
+ */
+static inline unsigned
+pmem2_nt_flags(size_t len, unsigned flags, size_t threshold)
+{
+	if (flags & (PMEM2_F_MEM_NONTEMPORAL | PMEM2_F_MEM_TEMPORAL |
+			PMEM2_F_MEM_WC | PMEM2_F_MEM_WB | PMEM2_F_MEM_NOFLUSH))
+		return flags;
+
+	if (len >= threshold)
+		return flags | PMEM2_F_MEM_NONTEMPORAL;
+
+	return flags | PMEM2_F_MEM_TEMPORAL;
+}
+
+/*
+ * PMEM2_MEM_FNS_NT -- defines the mem[move|cpy|set] functions of mappings
+ *	with a calibrated non-temporal threshold, the threshold cannot be
+ *	passed to these functions, so there is one set for every value
+ *	the calibration may end up with
+ */
+#define PMEM2_MEM_FNS_NT(name, threshold)\
+static void *\
+pmem2_memmove_nt_##name(void *pmemdest, const void *src, size_t len,\
+		unsigned flags)\
+{\
+	return pmem2_memmove(pmemdest, src, len,\
+		pmem2_nt_flags(len, flags, threshold));\
+}\
+static void *\
+pmem2_memset_nt_##name(void *pmemdest, int c, size_t len, unsigned flags)\
+{\
+	return pmem2_memset(pmemdest, c, len,\
+		pmem2_nt_flags(len, flags, threshold));\
+}\
+static void *\
+pmem2_memmove_eadr_nt_##name(void *pmemdest, const void *src, size_t len,\
+		unsigned flags)\
+{\
+	return pmem2_memmove_eadr(pmemdest, src, len,\
+		pmem2_nt_flags(len, flags, threshold));\
+}\
+static void *\
+pmem2_memset_eadr_nt_##name(void *pmemdest, int c, size_t len,\
+		unsigned flags)\
+{\
+	return pmem2_memset_eadr(pmemdest, c, len,\
+		pmem2_nt_flags(len, flags, threshold));\
+}
+
+PMEM2_MEM_FNS_NT(64, 64)
+PMEM2_MEM_FNS_NT(128, 128)
+PMEM2_MEM_FNS_NT(256, 256)
+PMEM2_MEM_FNS_NT(512, 512)
+PMEM2_MEM_FNS_NT(1k, 1 << 10)
+PMEM2_MEM_FNS_NT(2k, 2 << 10)
+PMEM2_MEM_FNS_NT(4k, 4 << 10)
+PMEM2_MEM_FNS_NT(8k, 8 << 10)
+PMEM2_MEM_FNS_NT(16k, 16 << 10)
+PMEM2_MEM_FNS_NT(32k, 32 << 10)
+PMEM2_MEM_FNS_NT(64k, 64 << 10)
+PMEM2_MEM_FNS_NT(never, SIZE_MAX)
+
+#define PMEM2_MEM_FNS_NT_ENTRY(name, threshold)\
+	{threshold, pmem2_memmove_nt_##name, pmem2_memset_nt_##name,\
+	pmem2_memmove_eadr_nt_##name, pmem2_memset_eadr_nt_##name}
+
+static const struct {
+	size_t threshold;
+	pmem2_memmove_fn memmove_fn;
+	pmem2_memset_fn memset_fn;
+	pmem2_memmove_fn memmove_eadr_fn;
+	pmem2_memset_fn memset_eadr_fn;
+} Mem_fns_nt[] = {
+	PMEM2_MEM_FNS_NT_ENTRY(64, 64),
+	PMEM2_MEM_FNS_NT_ENTRY(128, 128),
+	PMEM2_MEM_FNS_NT_ENTRY(256, 256),
+	PMEM2_MEM_FNS_NT_ENTRY(512, 512),
+	PMEM2_MEM_FNS_NT_ENTRY(1k, 1 << 10),
+	PMEM2_MEM_FNS_NT_ENTRY(2k, 2 << 10),
+	PMEM2_MEM_FNS_NT_ENTRY(4k, 4 << 10),
+	PMEM2_MEM_FNS_NT_ENTRY(8k, 8 << 10),
+	PMEM2_MEM_FNS_NT_ENTRY(16k, 16 << 10),
+	PMEM2_MEM_FNS_NT_ENTRY(32k, 32 << 10),
+	PMEM2_MEM_FNS_NT_ENTRY(64k, 64 << 10),
+	PMEM2_MEM_FNS_NT_ENTRY(never, SIZE_MAX),
+};
+
 /*
  * pmem2_set_mem_fns -- set function pointers related to mem[move|cpy|set]
  */
 void
 pmem2_set_mem_fns(struct pmem2_map *map)
 {
+	/* the copies to eADR mappings are non-temporal only if requested */
+	if (map->effective_granularity == PMEM2_GRANULARITY_BYTE)
+		map->nt_threshold = SIZE_MAX;
+	else
+		map->nt_threshold = Info.movnt_threshold;
+
 	switch (map->effective_granularity) {
 		case PMEM2_GRANULARITY_PAGE:
 			map->memmove_fn = pmem2_memmove_nonpmem;
@@ -582,6 +709,7 @@ pmem2_set_mem_fns(struct pmem2_map *map)
 			abort();
 	}
 
+	map->memcmp_fn = pmem2_memcmp;
 }
 
 /*
@@ -614,6 +742,348 @@ pmem2_get_memset_fn(struct pmem2_map *map)
 	return map->memset_fn;
 }
 
+/*
+ * pmem2_get_memcmp_fn - return a pointer to a function
+ */
+pmem2_memcmp_fn
+pmem2_get_memcmp_fn(struct pmem2_map *map)
+{
+	/* we do not need to clear err because this function cannot fail */
+	return map->memcmp_fn;
+}
+
+/*
+ * memcpy_v_range -- (internal) part of the destination not flushed yet
+ */
+struct memcpy_v_range {
+	uintptr_t start;
+	uintptr_t end;
+};
+
+/*
+ * memcpy_v_flush -- (internal) flushes the pending range, if any
+ */
+static void
+memcpy_v_flush(struct memcpy_v_range *r, flush_func flush)
+{
+	if (r->start == r->end)
+		return;
+
+	flush((const void *)r->start, r->end - r->start);
+	r->start = r->end = 0;
+}
+
+/*
+ * memcpy_v_defer_flush -- (internal) adds the range to the pending one,
+ *	if the two touch the same or adjacent units of the given alignment
+ *	(cache lines or pages), otherwise flushes the pending range first
+ */
+static void
+memcpy_v_defer_flush(struct memcpy_v_range *r, const void *addr, size_t len,
+		size_t align, flush_func flush)
+{
+	if (len == 0)
+		return;
+
+	uintptr_t start = (uintptr_t)addr;
+	uintptr_t end = start + len;
+
+	if (r->start != r->end &&
+	    ALIGN_DOWN(start, align) <= ALIGN_UP(r->end, align) &&
+	    ALIGN_UP(end, align) >= ALIGN_DOWN(r->start, align)) {
+		r->start = MIN(r->start, start);
+		r->end = MAX(r->end, end);
+		return;
+	}
+
+	memcpy_v_flush(r, flush);
+	r->start = start;
+	r->end = end;
+}
+
+/*
+ * pmem2_memcpy_v -- copies all the elements of the vector to pmem, flushing
+ *	each of the cache lines shared by consecutive elements once and
+ *	draining only after the last one
+ */
+void
+pmem2_memcpy_v(struct pmem2_map *map, const struct pmem2_iov *iov,
+		size_t iovcnt, unsigned flags)
+{
+#ifdef DEBUG
+	if (flags & ~PMEM2_F_MEM_VALID_FLAGS)
+		ERR_WO_ERRNO("invalid flags 0x%x", flags);
+#endif
+	PMEM2_API_START("pmem2_memcpy_v");
+
+	struct memcpy_v_range r = {0, 0};
+
+	switch (map->effective_granularity) {
+		case PMEM2_GRANULARITY_PAGE:
+			for (size_t i = 0; i < iovcnt; ++i) {
+				Info.memmove_nodrain(iov[i].dest, iov[i].src,
+					iov[i].len,
+					flags & ~PMEM2_F_MEM_NODRAIN,
+					Info.flush, &Info.memmove_funcs);
+
+				if (!(flags & PMEM2_F_MEM_NOFLUSH))
+					memcpy_v_defer_flush(&r, iov[i].dest,
+						iov[i].len, Pagesize,
+						pmem2_persist_pages);
+			}
+
+			memcpy_v_flush(&r, pmem2_persist_pages);
+			break;
+		case PMEM2_GRANULARITY_CACHE_LINE:
+			for (size_t i = 0; i < iovcnt; ++i) {
+				unsigned f = pmem2_nt_flags(iov[i].len, flags,
+					map->nt_threshold);
+
+				/* non-temporal stores flush on their own */
+				if (f & (PMEM2_F_MEM_NOFLUSH |
+						PMEM2_F_MEM_WC |
+						PMEM2_F_MEM_NONTEMPORAL)) {
+					Info.memmove_nodrain(iov[i].dest,
+						iov[i].src, iov[i].len, f,
+						Info.flush,
+						&Info.memmove_funcs);
+					continue;
+				}
+
+				Info.memmove_nodrain(iov[i].dest, iov[i].src,
+					iov[i].len, f | PMEM2_F_MEM_NOFLUSH,
+					Info.flush, &Info.memmove_funcs);
+				memcpy_v_defer_flush(&r, iov[i].dest,
+					iov[i].len, CACHELINE_SIZE,
+					pmem2_flush_cpu_cache);
+			}
+
+			memcpy_v_flush(&r, pmem2_flush_cpu_cache);
+			if ((flags & (PMEM2_F_MEM_NODRAIN |
+					PMEM2_F_MEM_NOFLUSH)) == 0)
+				pmem2_drain();
+			break;
+		case PMEM2_GRANULARITY_BYTE:
+			for (size_t i = 0; i < iovcnt; ++i) {
+				Info.memmove_nodrain_eadr(iov[i].dest,
+					iov[i].src, iov[i].len,
+					pmem2_nt_flags(iov[i].len, flags,
+						map->nt_threshold),
+					Info.flush, &Info.memmove_funcs);
+			}
+
+			if ((flags & (PMEM2_F_MEM_NODRAIN |
+					PMEM2_F_MEM_NOFLUSH)) == 0)
+				pmem2_drain();
+			break;
+		default:
+			abort();
+	}
+
+	PMEM2_API_END("pmem2_memcpy_v");
+}
+
+/* the piece of the buffer checksummed while it is still in the CPU cache */
+#define MEMCPY_CHECKSUM_CHUNK (8 << 10)
+
+/*
+ * pmem2_memcpy_checksum -- copies the buffer to pmem and continues
+ *	the checksum of the copied data, each piece of the buffer is checksummed
+ *	right after it is copied, so that it is read from memory once
+ */
+int
+pmem2_memcpy_checksum(struct pmem2_map *map, void *pmemdest, const void *src,
+		size_t len, unsigned flags, uint64_t *csum)
+{
+	PMEM2_ERR_CLR();
+
+#ifdef DEBUG
+	if (flags & ~PMEM2_F_MEM_VALID_FLAGS)
+		ERR_WO_ERRNO("invalid flags 0x%x", flags);
+#endif
+	if (len % sizeof(uint32_t) != 0) {
+		ERR_WO_ERRNO("length %zu is not a multiple of %zu", len,
+			sizeof(uint32_t));
+		return PMEM2_E_LENGTH_UNALIGNED;
+	}
+
+	PMEM2_API_START("pmem2_memcpy_checksum");
+
+	memmove_nodrain_func memmove_nodrain = Info.memmove_nodrain;
+	unsigned f;
+
+	switch (map->effective_granularity) {
+		case PMEM2_GRANULARITY_PAGE:
+			/* the pages are synced once, after the whole copy */
+			f = flags | PMEM2_F_MEM_NOFLUSH;
+			break;
+		case PMEM2_GRANULARITY_CACHE_LINE:
+			/* the type of stores depends on the whole length */
+			f = pmem2_nt_flags(len, flags, map->nt_threshold);
+			break;
+		case PMEM2_GRANULARITY_BYTE:
+			memmove_nodrain = Info.memmove_nodrain_eadr;
+			f = pmem2_nt_flags(len, flags, map->nt_threshold);
+			break;
+		default:
+			abort();
+	}
+
+	char *dest = pmemdest;
+	const char *s = src;
+	uint64_t c = *csum;
+
+	for (size_t off = 0; off < len; off += MEMCPY_CHECKSUM_CHUNK) {
+		size_t n = MIN(len - off, MEMCPY_CHECKSUM_CHUNK);
+
+		memmove_nodrain(dest + off, s + off, n, f, Info.flush,
+			&Info.memmove_funcs);
+		c = util_checksum_seq(s + off, n, c);
+	}
+
+	*csum = c;
+
+	if (map->effective_granularity == PMEM2_GRANULARITY_PAGE) {
+		if (!(flags & PMEM2_F_MEM_NOFLUSH))
+			pmem2_persist_pages(pmemdest, len);
+	} else if ((flags & (PMEM2_F_MEM_NODRAIN |
+			PMEM2_F_MEM_NOFLUSH)) == 0) {
+		pmem2_drain();
+	}
+
+	PMEM2_API_END("pmem2_memcpy_checksum");
+
+	return 0;
+}
+
+/* sizes of the copies measured by the calibration */
+#define NT_CALIBRATION_MIN_SIZE 64
+#define NT_CALIBRATION_MAX_SIZE (64 << 10)
+
+/* bytes copied to measure every size with every type of stores */
+#define NT_CALIBRATION_BYTES (256 << 10)
+#define NT_CALIBRATION_ROUNDS 3
+
+/*
+ * nt_calibration_time -- (internal) returns the shortest time, in ns, of
+ *	copying the saved content of the region back to it in persisted pieces
+ *	of the given size
+ */
+static uint64_t
+nt_calibration_time(memmove_nodrain_func memmove_nodrain, char *region,
+		const char *saved, size_t region_size, size_t size,
+		unsigned flags)
+{
+	uint64_t best = UINT64_MAX;
+
+	for (int r = 0; r < NT_CALIBRATION_ROUNDS; ++r) {
+		struct timespec start;
+		struct timespec end;
+		size_t off = 0;
+
+		os_clock_gettime(CLOCK_MONOTONIC, &start);
+		for (size_t n = 0; n < NT_CALIBRATION_BYTES; n += size) {
+			memmove_nodrain(region + off, saved + off, size, flags,
+				Info.flush, &Info.memmove_funcs);
+			Info.fence();
+
+			off = (off + size) % region_size;
+		}
+		os_clock_gettime(CLOCK_MONOTONIC, &end);
+
+		uint64_t t = (uint64_t)(end.tv_sec - start.tv_sec) *
+			1000000000ULL + (uint64_t)end.tv_nsec -
+			(uint64_t)start.tv_nsec;
+		best = MIN(best, t);
+	}
+
+	return best;
+}
+
+/*
+ * pmem2_calibrate_nt_threshold -- measures the copies to the mapping with
+ *	temporal and non-temporal stores, and makes the mem[move|cpy|set]
+ *	functions of the mapping use the latter from the length at which they
+ *	become faster
+ *
+ * The beginning of the mapping is used as the scratch region. It is
+ * overwritten with its own content, so the data never changes, but it must
+ * not be modified concurrently by anyone else.
+ */
+void
+pmem2_calibrate_nt_threshold(struct pmem2_map *map)
+{
+	LOG(3, "map %p", map);
+
+	if (map->effective_granularity == PMEM2_GRANULARITY_PAGE ||
+	    Info.movnt_threshold == SIZE_MAX) {
+		LOG(3, "non-temporal stores not used, calibration skipped");
+		return;
+	}
+
+	size_t region_size = NT_CALIBRATION_MAX_SIZE;
+	while (region_size > map->content_length)
+		region_size /= 2;
+
+	if (region_size < NT_CALIBRATION_MIN_SIZE) {
+		LOG(3, "mapping too small, calibration skipped");
+		return;
+	}
+
+	char *saved = Malloc(region_size);
+	if (saved == NULL) {
+		LOG(3, "cannot allocate the calibration buffer");
+		return;
+	}
+
+	char *region = map->addr;
+	memcpy(saved, region, region_size);
+
+	memmove_nodrain_func memmove_nodrain =
+		map->effective_granularity == PMEM2_GRANULARITY_BYTE ?
+		Info.memmove_nodrain_eadr : Info.memmove_nodrain;
+
+	/* the smallest size from which non-temporal stores are always faster */
+	size_t threshold = SIZE_MAX;
+	for (size_t size = region_size; size >= NT_CALIBRATION_MIN_SIZE;
+			size /= 2) {
+		uint64_t t = nt_calibration_time(memmove_nodrain, region,
+			saved, region_size, size, PMEM2_F_MEM_TEMPORAL);
+		uint64_t nt = nt_calibration_time(memmove_nodrain, region,
+			saved, region_size, size, PMEM2_F_MEM_NONTEMPORAL);
+
+		LOG(4, "size %zu temporal %" PRIu64 " ns non-temporal %"
+			PRIu64 " ns", size, t, nt);
+
+		if (nt >= t)
+			break;
+
+		threshold = size;
+	}
+
+	Free(saved);
+
+	for (size_t i = 0; i < ARRAY_SIZE(Mem_fns_nt); ++i) {
+		if (Mem_fns_nt[i].threshold != threshold)
+			continue;
+
+		if (map->effective_granularity == PMEM2_GRANULARITY_BYTE) {
+			map->memmove_fn = Mem_fns_nt[i].memmove_eadr_fn;
+			map->memset_fn = Mem_fns_nt[i].memset_eadr_fn;
+		} else {
+			map->memmove_fn = Mem_fns_nt[i].memmove_fn;
+			map->memset_fn = Mem_fns_nt[i].memset_fn;
+		}
+		map->memcpy_fn = map->memmove_fn;
+		map->nt_threshold = threshold;
+
+		LOG(3, "calibrated non-temporal threshold %zu", threshold);
+		return;
+	}
+
+	ASSERT(0);
+}
+
 #if VG_PMEMCHECK_ENABLED
 /*
  * pmem2_emit_log -- logs library and function names to pmemcheck store log
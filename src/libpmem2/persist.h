@@ -21,6 +21,7 @@ int pmem2_flush_file_buffers_os(struct pmem2_map *map, const void *addr,
 		size_t len, int autorestart);
 void pmem2_set_flush_fns(struct pmem2_map *map);
 void pmem2_set_mem_fns(struct pmem2_map *map);
+void pmem2_calibrate_nt_threshold(struct pmem2_map *map);
 
 #ifdef __cplusplus
 }
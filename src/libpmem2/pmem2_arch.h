@@ -32,6 +32,7 @@ typedef void *(*memset_nodrain_func)(void *pmemdest, int c, size_t len,
 		const struct memset_nodrain *memset_funcs);
 typedef void (*memmove_func)(char *pmemdest, const char *src, size_t len);
 typedef void (*memset_func)(char *pmemdest, int c, size_t len);
+typedef int (*memcmp_func)(const void *pmemaddr, const void *buf, size_t len);
 
 struct memmove_nodrain {
 	struct {
@@ -68,7 +69,11 @@ struct pmem2_arch_info {
 	memset_nodrain_func memset_nodrain_eadr;
 	flush_func flush;
 	fence_func fence;
+	/* reads the pmem with non-temporal loads, if the CPU has them */
+	memcmp_func memcmp_ntload;
 	int flush_has_builtin_fence;
+	/* shorter copies are done with temporal stores, unless forced */
+	size_t movnt_threshold;
 };
 
 void pmem2_arch_init(struct pmem2_arch_info *info);
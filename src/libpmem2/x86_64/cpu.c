@@ -66,6 +66,10 @@ cpuid(unsigned func, unsigned subfunc, unsigned cpuinfo[4])
 #define bit_AVX		(1 << 28)
 #endif
 
+#ifndef bit_AVX2
+#define bit_AVX2	(1 << 5)
+#endif
+
 #ifndef bit_AVX512F
 #define bit_AVX512F	(1 << 16)
 #endif
@@ -165,6 +169,18 @@ is_cpu_avx_present(void)
 	return ret;
 }
 
+/*
+ * is_cpu_avx2_present -- checks if AVX2 instructions are supported
+ */
+int
+is_cpu_avx2_present(void)
+{
+	int ret = is_cpu_feature_present(0x7, EBX_IDX, bit_AVX2);
+	LOG(4, "AVX2 %ssupported", ret == 0 ? "not " : "");
+
+	return ret;
+}
+
 /*
  * is_cpu_avx512f_present -- checks if AVX-512f instructions are supported
  */
@@ -464,6 +464,36 @@ use_movdir64b_memcpy_memset(struct pmem2_arch_info *info,
 #endif
 }
 
+/*
+ * pmem_cpuinfo_to_memcmp -- (internal) picks the widest comparison with
+ *	non-temporal loads the CPU supports
+ */
+static void
+pmem_cpuinfo_to_memcmp(struct pmem2_arch_info *info)
+{
+#if AVX512F_AVAILABLE
+	if (is_cpu_avx512f_present()) {
+		char *e = os_getenv("PMEM_AVX512F");
+		if (e == NULL || strcmp(e, "0") != 0) {
+			info->memcmp_ntload = memcmp_ntload_avx512f;
+			return;
+		}
+	}
+#endif
+
+#if AVX_AVAILABLE
+	if (is_cpu_avx2_present()) {
+		char *e = os_getenv("PMEM_AVX");
+		if (e == NULL || strcmp(e, "0") != 0) {
+			info->memcmp_ntload = memcmp_ntload_avx2;
+			return;
+		}
+	}
+#endif
+
+	SUPPRESS_UNUSED(info);
+}
+
 /*
  * pmem_get_cpuinfo -- configure libpmem based on CPUID
  */
@@ -560,6 +590,7 @@ pmem2_arch_init(struct pmem2_arch_info *info)
 	enum memcpy_impl impl = MEMCPY_INVALID;
 
 	pmem_cpuinfo_to_funcs(info, &impl);
+	pmem_cpuinfo_to_memcmp(info);
 
 	/*
 	 * For testing, allow overriding the default threshold
@@ -579,6 +610,9 @@ pmem2_arch_init(struct pmem2_arch_info *info)
 		}
 	}
 
+	if (impl != MEMCPY_INVALID)
+		info->movnt_threshold = Movnt_threshold;
+
 	if (info->flush == flush_clwb)
 		LOG(3, "using clwb");
 	else if (info->flush == flush_clflushopt)
@@ -596,4 +630,13 @@ pmem2_arch_init(struct pmem2_arch_info *info)
 		LOG(3, "using movnt AVX");
 	else if (impl == MEMCPY_SSE2)
 		LOG(3, "using movnt SSE2");
+
+#if AVX512F_AVAILABLE
+	if (info->memcmp_ntload == memcmp_ntload_avx512f)
+		LOG(3, "using memcmp AVX512F");
+#endif
+#if AVX_AVAILABLE
+	if (info->memcmp_ntload == memcmp_ntload_avx2)
+		LOG(3, "using memcmp AVX2");
+#endif
 }
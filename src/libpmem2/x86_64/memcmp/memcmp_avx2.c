@@ -0,0 +1,103 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/* Copyright 2026, Intel Corporation */
+
+/*
+ * memcmp_avx2.c -- comparison of pmem with a buffer, the pmem is read with
+ *	non-temporal loads
+ */
+
+#include <immintrin.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "pmem2_arch.h"
+#include "avx.h"
+#include "memcpy_memset.h"
+
+/*
+ * xor32b -- (internal) loads 32 bytes of pmem and of the buffer and returns
+ *	their xor
+ */
+static force_inline __m256i
+xor32b(const char *pmem, const char *buf, unsigned idx)
+{
+	__m256i p = _mm256_stream_load_si256((const __m256i *)pmem + idx);
+	__m256i b = _mm256_loadu_si256((const __m256i *)buf + idx);
+
+	return _mm256_xor_si256(p, b);
+}
+
+/*
+ * differ4x32b -- (internal) checks if 128 bytes of pmem differ from
+ *	the buffer
+ */
+static force_inline int
+differ4x32b(const char *pmem, const char *buf)
+{
+	__m256i x0 = xor32b(pmem, buf, 0);
+	__m256i x1 = xor32b(pmem, buf, 1);
+	__m256i x2 = xor32b(pmem, buf, 2);
+	__m256i x3 = xor32b(pmem, buf, 3);
+
+	__m256i x = _mm256_or_si256(_mm256_or_si256(x0, x1),
+		_mm256_or_si256(x2, x3));
+
+	return !_mm256_testz_si256(x, x);
+}
+
+/*
+ * differ1x32b -- (internal) checks if 32 bytes of pmem differ from the buffer
+ */
+static force_inline int
+differ1x32b(const char *pmem, const char *buf)
+{
+	__m256i x = xor32b(pmem, buf, 0);
+
+	return !_mm256_testz_si256(x, x);
+}
+
+/*
+ * memcmp_ntload_avx2 -- compares len bytes of pmem with the buffer,
+ *	returns the same as memcmp
+ */
+int
+memcmp_ntload_avx2(const void *pmemaddr, const void *buf, size_t len)
+{
+	const char *pmem = pmemaddr;
+	const char *b = buf;
+
+	/* the non-temporal loads need 32-byte aligned addresses */
+	size_t cnt = (uint64_t)pmem & 31;
+	if (cnt > 0) {
+		cnt = MIN(32 - cnt, len);
+
+		int ret = memcmp(pmem, b, cnt);
+		if (ret != 0)
+			return ret;
+
+		pmem += cnt;
+		b += cnt;
+		len -= cnt;
+	}
+
+	/*
+	 * The blocks are only checked for a difference, the first block
+	 * which differs (or the tail) is compared byte by byte to get the sign.
+	 */
+	while (len >= 4 * 32 && !differ4x32b(pmem, b)) {
+		pmem += 4 * 32;
+		b += 4 * 32;
+		len -= 4 * 32;
+	}
+
+	while (len >= 32 && !differ1x32b(pmem, b)) {
+		pmem += 32;
+		b += 32;
+		len -= 32;
+	}
+
+	avx_zeroupper();
+
+	return memcmp(pmem, b, len);
+}
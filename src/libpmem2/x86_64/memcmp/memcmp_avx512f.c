@@ -0,0 +1,105 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/* Copyright 2026, Intel Corporation */
+
+/*
+ * memcmp_avx512f.c -- comparison of pmem with a buffer, the pmem is read
+ *	with non-temporal loads
+ */
+
+#include <immintrin.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "pmem2_arch.h"
+#include "avx.h"
+#include "memcpy_memset.h"
+
+/*
+ * xor64b -- (internal) loads 64 bytes of pmem and of the buffer and returns
+ *	their xor
+ */
+static force_inline __m512i
+xor64b(const char *pmem, const char *buf, unsigned idx)
+{
+	/* the intrinsic takes a non-const pointer, but does not write to it */
+	__m512i p = _mm512_stream_load_si512((void *)((uintptr_t)pmem +
+		idx * 64));
+	__m512i b = _mm512_loadu_si512((const __m512i *)buf + idx);
+
+	return _mm512_xor_si512(p, b);
+}
+
+/*
+ * differ4x64b -- (internal) checks if 256 bytes of pmem differ from
+ *	the buffer
+ */
+static force_inline int
+differ4x64b(const char *pmem, const char *buf)
+{
+	__m512i x0 = xor64b(pmem, buf, 0);
+	__m512i x1 = xor64b(pmem, buf, 1);
+	__m512i x2 = xor64b(pmem, buf, 2);
+	__m512i x3 = xor64b(pmem, buf, 3);
+
+	__m512i x = _mm512_or_si512(_mm512_or_si512(x0, x1),
+		_mm512_or_si512(x2, x3));
+
+	return _mm512_test_epi64_mask(x, x) != 0;
+}
+
+/*
+ * differ1x64b -- (internal) checks if 64 bytes of pmem differ from the buffer
+ */
+static force_inline int
+differ1x64b(const char *pmem, const char *buf)
+{
+	__m512i x = xor64b(pmem, buf, 0);
+
+	return _mm512_test_epi64_mask(x, x) != 0;
+}
+
+/*
+ * memcmp_ntload_avx512f -- compares len bytes of pmem with the buffer,
+ *	returns the same as memcmp
+ */
+int
+memcmp_ntload_avx512f(const void *pmemaddr, const void *buf, size_t len)
+{
+	const char *pmem = pmemaddr;
+	const char *b = buf;
+
+	/* the non-temporal loads need 64-byte aligned addresses */
+	size_t cnt = (uint64_t)pmem & 63;
+	if (cnt > 0) {
+		cnt = MIN(64 - cnt, len);
+
+		int ret = memcmp(pmem, b, cnt);
+		if (ret != 0)
+			return ret;
+
+		pmem += cnt;
+		b += cnt;
+		len -= cnt;
+	}
+
+	/*
+	 * The blocks are only checked for a difference, the first block
+	 * which differs (or the tail) is compared byte by byte to get the sign.
+	 */
+	while (len >= 4 * 64 && !differ4x64b(pmem, b)) {
+		pmem += 4 * 64;
+		b += 4 * 64;
+		len -= 4 * 64;
+	}
+
+	while (len >= 64 && !differ1x64b(pmem, b)) {
+		pmem += 64;
+		b += 64;
+		len -= 64;
+	}
+
+	avx_zeroupper();
+
+	return memcmp(pmem, b, len);
+}
@@ -228,6 +228,14 @@ void memset_movnt_movdir64b_empty(char *dest, int c, size_t len);
 void memset_movnt_movdir64b_noflush(char *dest, int c, size_t len);
 #endif
 
+#if AVX_AVAILABLE
+int memcmp_ntload_avx2(const void *pmemaddr, const void *buf, size_t len);
+#endif
+
+#if AVX512F_AVAILABLE
+int memcmp_ntload_avx512f(const void *pmemaddr, const void *buf, size_t len);
+#endif
+
 extern size_t Movnt_threshold;
 
 /*
@@ -1,5 +1,5 @@
 // SPDX-License-Identifier: BSD-3-Clause
-/* Copyright 2015-2023, Intel Corporation */
+/* Copyright 2015-2026, Intel Corporation */
 
 /*
  * bucket.c -- bucket implementation
@@ -11,8 +11,17 @@
  * responsible for selecting blocks - which means that whether the allocator
  * serves memory blocks in best/first/next -fit manner is decided during bucket
  * creation.
+ *
+ * Buckets of run allocation classes can be switched into a lock-free mode in
+ * which the free units of the active run are tracked in a transient copy of
+ * the run bitmap instead of the container. Reservations claim bits in that
+ * copy with compare-and-swap, without acquiring the bucket lock. The lock is
+ * still needed to attach or detach the active run.
  */
 
+#include <errno.h>
+#include <sched.h>
+
 #include "alloc_class.h"
 #include "bucket.h"
 #include "heap.h"
@@ -21,6 +30,24 @@
 #include "sys_util.h"
 #include "valgrind_internal.h"
 
+/* the gate is open, new lock-free reservations are allowed */
+#define BUCKET_LF_OPEN (1ULL << 63)
+
+/*
+ * Transient bitmap of the active run, a set bit means that the corresponding
+ * unit is free and can be claimed.
+ */
+struct bucket_lockfree {
+	/* BUCKET_LF_OPEN flag and the number of in-flight reservations */
+	uint64_t gate;
+
+	/* value at which the search for free units starts */
+	uint64_t hint;
+
+	unsigned nvalues;
+	uint64_t *values;
+};
+
 struct bucket {
 	/* this struct is both the lock guard and the locked state */
 	struct bucket_locked *locked;
@@ -32,6 +59,9 @@ struct bucket {
 
 	struct memory_block_reserved *active_memory_block;
 	int is_active;
+
+	int lockfree_enabled;
+	struct bucket_lockfree lockfree;
 };
 
 struct bucket_locked {
@@ -39,6 +69,132 @@ struct bucket_locked {
 	os_mutex_t lock;
 };
 
+/*
+ * bucket_lockfree_insert -- (internal) marks the units of the block as free
+ *	in the transient bitmap
+ */
+static int
+bucket_lockfree_insert(struct bucket_lockfree *lf,
+	const struct memory_block *m)
+{
+	unsigned v = m->block_off / RUN_BITS_PER_VALUE;
+	unsigned bit = m->block_off % RUN_BITS_PER_VALUE;
+
+	/* blocks of a run never cross the boundary of a bitmap value */
+	ASSERT(bit + m->size_idx <= RUN_BITS_PER_VALUE);
+
+	if (v >= lf->nvalues) {
+		/*
+		 * The bitmap is only resized while the run is attached, with
+		 * the gate closed. A claimer can still briefly increment the
+		 * gate in bucket_lockfree_alloc, but it backs off without
+		 * touching the bitmap once it sees the gate closed.
+		 */
+#ifdef DEBUG /* variables required for ASSERTs below */
+		uint64_t gate;
+		util_atomic_load_explicit64(&lf->gate, &gate,
+			memory_order_acquire);
+#endif
+		ASSERTeq(gate & BUCKET_LF_OPEN, 0);
+
+		uint64_t *values = Realloc(lf->values,
+			sizeof(uint64_t) * (v + 1));
+		if (values == NULL)
+			return -1;
+
+		memset(values + lf->nvalues, 0,
+			sizeof(uint64_t) * (v + 1 - lf->nvalues));
+		lf->values = values;
+		lf->nvalues = v + 1;
+	}
+
+	uint64_t mask = m->size_idx == RUN_BITS_PER_VALUE ?
+		UINT64_MAX : ((1ULL << m->size_idx) - 1) << bit;
+
+	util_fetch_and_or64(&lf->values[v], mask);
+
+	return 0;
+}
+
+/*
+ * bucket_lockfree_claim -- (internal) finds and atomically clears
+ *	the requested number of consecutive free units in the transient bitmap
+ */
+static int
+bucket_lockfree_claim(struct bucket_lockfree *lf, uint32_t size_idx,
+	uint32_t *block_off)
+{
+	ASSERT(size_idx > 0);
+	if (size_idx > RUN_BITS_PER_VALUE || lf->nvalues == 0)
+		return ENOMEM;
+
+	uint64_t mask = size_idx == RUN_BITS_PER_VALUE ?
+		UINT64_MAX : (1ULL << size_idx) - 1;
+
+	uint64_t hint;
+	util_atomic_load_explicit64(&lf->hint, &hint, memory_order_relaxed);
+
+	for (unsigned n = 0; n < lf->nvalues; ++n) {
+		unsigned i = (unsigned)((hint + n) % lf->nvalues);
+		uint64_t *valp = &lf->values[i];
+
+		uint64_t value;
+		util_atomic_load_explicit64(valp, &value,
+			memory_order_acquire);
+
+		while (value != 0) {
+			/* positions which start a long enough free range */
+			uint64_t starts = value;
+			for (uint32_t s = 1; s < size_idx && starts != 0; ++s)
+				starts &= value >> s;
+
+			if (starts == 0)
+				break;
+
+			unsigned pos = (unsigned)util_lssb_index64(starts);
+			uint64_t claimed = mask << pos;
+
+			if (util_bool_compare_and_swap64(valp, value,
+					value & ~claimed)) {
+				if (i != hint)
+					util_atomic_store_explicit64(&lf->hint,
+						i, memory_order_relaxed);
+				*block_off = i * RUN_BITS_PER_VALUE + pos;
+				return 0;
+			}
+
+			util_atomic_load_explicit64(valp, &value,
+				memory_order_acquire);
+		}
+	}
+
+	return ENOMEM;
+}
+
+/*
+ * bucket_lockfree_close -- (internal) prevents new lock-free reservations,
+ *	waits for the in-flight ones and clears the transient bitmap
+ */
+static void
+bucket_lockfree_close(struct bucket_lockfree *lf)
+{
+	util_fetch_and_and64(&lf->gate, ~BUCKET_LF_OPEN);
+
+	uint64_t gate;
+	for (;;) {
+		util_atomic_load_explicit64(&lf->gate, &gate,
+			memory_order_acquire);
+		if (gate == 0)
+			break;
+
+		sched_yield();
+	}
+
+	if (lf->values != NULL)
+		memset(lf->values, 0, sizeof(uint64_t) * lf->nvalues);
+	lf->hint = 0;
+}
+
 /*
  * bucket_init -- initializes the bucket's runtime state
  */
@@ -51,6 +207,11 @@ bucket_init(struct bucket *b, struct block_container *c,
 
 	b->is_active = 0;
 	b->active_memory_block = NULL;
+	b->lockfree_enabled = 0;
+	b->lockfree.gate = 0;
+	b->lockfree.hint = 0;
+	b->lockfree.nvalues = 0;
+	b->lockfree.values = NULL;
 	if (aclass && aclass->type == CLASS_RUN) {
 		b->active_memory_block =
 			Zalloc(sizeof(struct memory_block_reserved));
@@ -71,6 +232,8 @@ bucket_fini(struct bucket *b)
 {
 	if (b->active_memory_block)
 		Free(b->active_memory_block);
+	if (b->lockfree.values)
+		Free(b->lockfree.values);
 	b->c_ops->destroy(b->container);
 }
 
@@ -120,6 +283,19 @@ bucket_acquire(struct bucket_locked *b)
 	return &b->bucket;
 }
 
+/*
+ * bucket_try_acquire -- acquires a usable bucket struct if it's not
+ *	currently held by anyone else, returns NULL otherwise
+ */
+struct bucket *
+bucket_try_acquire(struct bucket_locked *b)
+{
+	if (util_mutex_trylock(&b->lock) != 0)
+		return NULL;
+
+	return &b->bucket;
+}
+
 /*
  * bucket_release -- releases a bucket struct
  */
@@ -168,6 +344,9 @@ bucket_insert_block(struct bucket *b, const struct memory_block *m)
 		VALGRIND_ANNOTATE_NEW_MEMORY(data, size);
 	}
 #endif
+	if (b->lockfree_enabled)
+		return bucket_lockfree_insert(&b->lockfree, m);
+
 	return b->c_ops->insert(b->container, m);
 }
 
@@ -186,9 +365,90 @@ bucket_remove_block(struct bucket *b, const struct memory_block *m)
 int
 bucket_alloc_block(struct bucket *b, struct memory_block *m_out)
 {
+	if (b->lockfree_enabled) {
+		if (!b->is_active)
+			return ENOMEM;
+
+		uint32_t block_off;
+		int ret = bucket_lockfree_claim(&b->lockfree,
+			m_out->size_idx, &block_off);
+		if (ret != 0)
+			return ret;
+
+		uint32_t size_idx = m_out->size_idx;
+		*m_out = b->active_memory_block->m;
+		m_out->block_off = block_off;
+		m_out->size_idx = size_idx;
+
+		return 0;
+	}
+
 	return b->c_ops->get_rm_bestfit(b->container, m_out);
 }
 
+/*
+ * bucket_lockfree_alloc -- reserves a block from the active run of the bucket
+ *	without acquiring the bucket lock, fails if the bucket is not in
+ *	the lock-free mode or if there are no suitable free units left
+ */
+int
+bucket_lockfree_alloc(struct bucket_locked *locked, uint32_t size_idx,
+	struct memory_block *m_out, struct memory_block_reserved **mresv)
+{
+	struct bucket *b = &locked->bucket;
+	struct bucket_lockfree *lf = &b->lockfree;
+
+	uint64_t gate;
+	util_atomic_load_explicit64(&lf->gate, &gate, memory_order_acquire);
+	if (!(gate & BUCKET_LF_OPEN))
+		return ENOENT;
+
+	/*
+	 * The run cannot be detached from the bucket as long as there are
+	 * reservations in flight.
+	 */
+	if (!(util_fetch_and_add64(&lf->gate, 1) & BUCKET_LF_OPEN)) {
+		util_fetch_and_sub64(&lf->gate, 1);
+		return ENOENT;
+	}
+
+	uint32_t block_off;
+	int ret = bucket_lockfree_claim(lf, size_idx, &block_off);
+	if (ret == 0) {
+		*mresv = b->active_memory_block;
+		*m_out = (*mresv)->m;
+		m_out->block_off = block_off;
+		m_out->size_idx = size_idx;
+
+		util_fetch_and_add64(&(*mresv)->nresv, 1);
+	}
+
+	util_fetch_and_sub64(&lf->gate, 1);
+
+	return ret;
+}
+
+/*
+ * bucket_is_empty -- checks whether the bucket has any free blocks left
+ */
+int
+bucket_is_empty(struct bucket *b)
+{
+	if (!b->lockfree_enabled)
+		return b->c_ops->is_empty(b->container);
+
+	struct bucket_lockfree *lf = &b->lockfree;
+	for (unsigned i = 0; i < lf->nvalues; ++i) {
+		uint64_t value;
+		util_atomic_load_explicit64(&lf->values[i], &value,
+			memory_order_relaxed);
+		if (value != 0)
+			return 0;
+	}
+
+	return 1;
+}
+
 /*
  * bucket_memblock_insert_block -- (internal) bucket insert wrapper
  *	for callbacks
@@ -218,6 +478,10 @@ bucket_attach_run(struct bucket *b, const struct memory_block *m)
 		b->active_memory_block->bucket = b->locked;
 		b->is_active = 1;
 		util_fetch_and_add64(&b->active_memory_block->nresv, 1);
+		if (b->lockfree_enabled)
+			util_fetch_and_or64(&b->lockfree.gate, BUCKET_LF_OPEN);
+	} else if (b->lockfree_enabled) {
+		bucket_lockfree_close(&b->lockfree);
 	} else {
 		b->c_ops->rm_all(b->container);
 	}
@@ -235,7 +499,10 @@ bucket_detach_run(struct bucket *b, struct memory_block *m_out, int *empty)
 	struct memory_block_reserved **active = &b->active_memory_block;
 
 	if (b->is_active) {
-		b->c_ops->rm_all(b->container);
+		if (b->lockfree_enabled)
+			bucket_lockfree_close(&b->lockfree);
+		else
+			b->c_ops->rm_all(b->container);
 		if (util_fetch_and_sub64(&(*active)->nresv, 1) == 1) {
 			*m_out = (*active)->m;
 			*empty = 1;
@@ -258,6 +525,30 @@ bucket_detach_run(struct bucket *b, struct memory_block *m_out, int *empty)
 	return 0;
 }
 
+/*
+ * bucket_set_lockfree -- switches the bucket between the container and
+ *	the lock-free bitmap mode, the bucket must not have an active run
+ */
+void
+bucket_set_lockfree(struct bucket *b, int enabled)
+{
+	ASSERTeq(b->is_active, 0);
+
+	if (b->aclass == NULL || b->aclass->type != CLASS_RUN)
+		return;
+
+	b->lockfree_enabled = enabled;
+}
+
+/*
+ * bucket_get_lockfree -- returns whether the bucket is in the lock-free mode
+ */
+int
+bucket_get_lockfree(struct bucket *b)
+{
+	return b->lockfree_enabled;
+}
+
 /*
  * bucket_active_block -- returns the bucket active block
  */
@@ -1,5 +1,5 @@
 /* SPDX-License-Identifier: BSD-3-Clause */
-/* Copyright 2015-2021, Intel Corporation */
+/* Copyright 2015-2026, Intel Corporation */
 
 /*
  * bucket.h -- internal definitions for bucket
@@ -30,6 +30,7 @@ struct bucket_locked *bucket_locked_new(struct block_container *c,
 					struct alloc_class *aclass);
 
 struct bucket *bucket_acquire(struct bucket_locked *b);
+struct bucket *bucket_try_acquire(struct bucket_locked *b);
 void bucket_release(struct bucket *b);
 
 struct alloc_class *bucket_alloc_class(struct bucket *b);
@@ -39,11 +40,17 @@ void bucket_try_insert_attached_block(struct bucket *b,
 	const struct memory_block *m);
 int bucket_remove_block(struct bucket *b, const struct memory_block *m);
 int bucket_alloc_block(struct bucket *b, struct memory_block *m_out);
+int bucket_is_empty(struct bucket *b);
+int bucket_lockfree_alloc(struct bucket_locked *locked, uint32_t size_idx,
+	struct memory_block *m_out, struct memory_block_reserved **mresv);
 
 int bucket_attach_run(struct bucket *b, const struct memory_block *m);
 int bucket_detach_run(struct bucket *b,
 	struct memory_block *m_out, int *empty);
 
+void bucket_set_lockfree(struct bucket *b, int enabled);
+int bucket_get_lockfree(struct bucket *b);
+
 struct memory_block_reserved *bucket_active_block(struct bucket *b);
 
 void bucket_locked_delete(struct bucket_locked *b);
@@ -0,0 +1,339 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/* Copyright 2026, Intel Corporation */
+
+/*
+ * container_tlsf.c -- implementation of two-level segregated fit (TLSF)
+ *	block container
+ *
+ * Free blocks are kept on intrusive lists, one per size class. The first
+ * level of the index splits the sizes into power-of-two ranges and the
+ * second level divides each range into TLSF_SL_COUNT linear subranges.
+ * A bitmap per level records which classes are non-empty, so that both
+ * finding a suitable class and inserting/removing a block are O(1).
+ *
+ * Exact removal, needed to coalesce neighbouring chunks, goes through
+ * a critnib keyed by the block location.
+ */
+
+#include "alloc.h"
+#include "container_tlsf.h"
+#include "critnib.h"
+#include "out.h"
+#include "queue.h"
+#include "sys_util.h"
+#include "util.h"
+
+#define TLSF_SL_LOG2 4U
+#define TLSF_SL_COUNT (1U << TLSF_SL_LOG2)
+#define TLSF_FL_COUNT 32U
+
+struct tlsf_node {
+	PMDK_LIST_ENTRY(tlsf_node) entry;
+	struct memory_block m;
+};
+
+PMDK_LIST_HEAD(tlsf_list, tlsf_node);
+
+struct block_container_tlsf {
+	struct block_container super;
+
+	uint32_t fl_bitmap;
+	uint32_t sl_bitmap[TLSF_FL_COUNT];
+	struct tlsf_list lists[TLSF_FL_COUNT][TLSF_SL_COUNT];
+
+	struct critnib *index; /* location -> node, for exact removal */
+	struct tlsf_list unused; /* nodes kept for reuse */
+};
+
+/*
+ * tlsf_mapping -- (internal) calculates the size class of the given size
+ */
+static void
+tlsf_mapping(uint64_t size, unsigned *fl, unsigned *sl)
+{
+	if (size < TLSF_SL_COUNT) {
+		*fl = 0;
+		*sl = (unsigned)size;
+	} else {
+		unsigned l = util_mssb_index64(size);
+		*fl = l - TLSF_SL_LOG2 + 1;
+		*sl = (unsigned)(size >> (l - TLSF_SL_LOG2)) - TLSF_SL_COUNT;
+	}
+}
+
+/*
+ * tlsf_mapping_search -- (internal) calculates the smallest size class whose
+ *	every block is at least of the given size
+ */
+static void
+tlsf_mapping_search(uint64_t size, unsigned *fl, unsigned *sl)
+{
+	if (size >= TLSF_SL_COUNT) {
+		unsigned l = util_mssb_index64(size);
+		size += (1ULL << (l - TLSF_SL_LOG2)) - 1;
+	}
+
+	tlsf_mapping(size, fl, sl);
+}
+
+/*
+ * tlsf_key -- (internal) returns the index key of a memory block
+ */
+static uint64_t
+tlsf_key(const struct memory_block *m)
+{
+	return ((uint64_t)m->zone_id << 48) |
+		((uint64_t)m->chunk_id << 16) | m->block_off;
+}
+
+/*
+ * tlsf_list_remove -- (internal) unlinks a node from its size class
+ */
+static void
+tlsf_list_remove(struct block_container_tlsf *c, struct tlsf_node *n)
+{
+	unsigned fl;
+	unsigned sl;
+	tlsf_mapping(n->m.size_idx, &fl, &sl);
+
+	PMDK_LIST_REMOVE(n, entry);
+
+	if (PMDK_LIST_EMPTY(&c->lists[fl][sl])) {
+		c->sl_bitmap[fl] &= ~(1U << sl);
+		if (c->sl_bitmap[fl] == 0)
+			c->fl_bitmap &= ~(1U << fl);
+	}
+
+	PMDK_LIST_INSERT_HEAD(&c->unused, n, entry);
+}
+
+/*
+ * container_tlsf_insert_block -- (internal) inserts a new memory block
+ *	into the container
+ */
+static int
+container_tlsf_insert_block(struct block_container *bc,
+	const struct memory_block *m)
+{
+	ASSERT(m->chunk_id < MAX_CHUNK);
+	ASSERT(m->zone_id < UINT16_MAX);
+	ASSERTne(m->size_idx, 0);
+
+	struct block_container_tlsf *c =
+		(struct block_container_tlsf *)bc;
+
+	struct tlsf_node *n = PMDK_LIST_FIRST(&c->unused);
+	if (n != NULL) {
+		PMDK_LIST_REMOVE(n, entry);
+	} else {
+		n = Malloc(sizeof(*n));
+		if (n == NULL)
+			return ENOMEM;
+	}
+
+	n->m = *m;
+
+	int ret = critnib_insert(c->index, tlsf_key(m), n);
+	if (ret != 0) {
+		PMDK_LIST_INSERT_HEAD(&c->unused, n, entry);
+		return ret;
+	}
+
+	unsigned fl;
+	unsigned sl;
+	tlsf_mapping(m->size_idx, &fl, &sl);
+
+	PMDK_LIST_INSERT_HEAD(&c->lists[fl][sl], n, entry);
+	c->sl_bitmap[fl] |= 1U << sl;
+	c->fl_bitmap |= 1U << fl;
+
+	return 0;
+}
+
+/*
+ * container_tlsf_get_rm_block_bestfit -- (internal) removes and returns
+ *	a memory block that fits the requested size
+ *
+ * The search starts from the size class in which every block is large
+ * enough, so that any of its blocks can be taken without a scan. Only when
+ * all such classes are empty, the class the requested size belongs to is
+ * scanned, so that no fitting block is ever missed.
+ */
+static int
+container_tlsf_get_rm_block_bestfit(struct block_container *bc,
+	struct memory_block *m)
+{
+	struct block_container_tlsf *c =
+		(struct block_container_tlsf *)bc;
+
+	struct tlsf_node *n = NULL;
+
+	unsigned fl;
+	unsigned sl;
+	tlsf_mapping_search(m->size_idx, &fl, &sl);
+
+	uint32_t sl_map = fl < TLSF_FL_COUNT ?
+		c->sl_bitmap[fl] & (~0U << sl) : 0;
+	if (sl_map == 0) {
+		uint32_t fl_map = fl + 1 < TLSF_FL_COUNT ?
+			c->fl_bitmap & (~0U << (fl + 1)) : 0;
+		if (fl_map != 0) {
+			fl = util_lssb_index(fl_map);
+			sl_map = c->sl_bitmap[fl];
+		}
+	}
+
+	if (sl_map != 0) {
+		sl = util_lssb_index(sl_map);
+		n = PMDK_LIST_FIRST(&c->lists[fl][sl]);
+	} else {
+		tlsf_mapping(m->size_idx, &fl, &sl);
+
+		struct tlsf_node *i;
+		PMDK_LIST_FOREACH(i, &c->lists[fl][sl], entry) {
+			if (i->m.size_idx >= m->size_idx) {
+				n = i;
+				break;
+			}
+		}
+	}
+
+	if (n == NULL)
+		return ENOMEM;
+
+	*m = n->m;
+
+	void *removed = critnib_remove(c->index, tlsf_key(m));
+	ASSERTeq(removed, n);
+	SUPPRESS_UNUSED(removed);
+
+	tlsf_list_remove(c, n);
+
+	return 0;
+}
+
+/*
+ * container_tlsf_get_rm_block_exact --
+ *	(internal) removes exact match memory block
+ */
+static int
+container_tlsf_get_rm_block_exact(struct block_container *bc,
+	const struct memory_block *m)
+{
+	struct block_container_tlsf *c =
+		(struct block_container_tlsf *)bc;
+
+	uint64_t key = tlsf_key(m);
+
+	struct tlsf_node *n = critnib_get(c->index, key);
+	if (n == NULL || n->m.size_idx != m->size_idx)
+		return ENOMEM;
+
+	critnib_remove(c->index, key);
+	tlsf_list_remove(c, n);
+
+	return 0;
+}
+
+/*
+ * container_tlsf_is_empty -- (internal) checks whether the container is empty
+ */
+static int
+container_tlsf_is_empty(struct block_container *bc)
+{
+	struct block_container_tlsf *c =
+		(struct block_container_tlsf *)bc;
+
+	return c->fl_bitmap == 0;
+}
+
+/*
+ * container_tlsf_rm_all -- (internal) removes all elements from the container
+ */
+static void
+container_tlsf_rm_all(struct block_container *bc)
+{
+	struct block_container_tlsf *c =
+		(struct block_container_tlsf *)bc;
+
+	while (c->fl_bitmap != 0) {
+		unsigned fl = util_lssb_index(c->fl_bitmap);
+		unsigned sl = util_lssb_index(c->sl_bitmap[fl]);
+
+		struct tlsf_node *n = PMDK_LIST_FIRST(&c->lists[fl][sl]);
+		critnib_remove(c->index, tlsf_key(&n->m));
+		tlsf_list_remove(c, n);
+	}
+}
+
+/*
+ * container_tlsf_destroy -- (internal) deletes the container
+ */
+static void
+container_tlsf_destroy(struct block_container *bc)
+{
+	struct block_container_tlsf *c =
+		(struct block_container_tlsf *)bc;
+
+	container_tlsf_rm_all(bc);
+
+	struct tlsf_node *n;
+	while ((n = PMDK_LIST_FIRST(&c->unused)) != NULL) {
+		PMDK_LIST_REMOVE(n, entry);
+		Free(n);
+	}
+
+	critnib_delete(c->index);
+
+	Free(bc);
+}
+
+/*
+ * Two-level segregated fit container used to provide good-fit functionality
+ * to the bucket. Insert, exact removal and the lookup of a fitting size class
+ * are O(1) operations.
+ *
+ * Unlike the ravl container, the returned block is not guaranteed to be the
+ * smallest one that fits, nor the one with the lowest address. A block from
+ * the first non-empty size class that is guaranteed to fit is returned, which
+ * wastes at most 1/TLSF_SL_COUNT of the block before it is split.
+ */
+static const struct block_container_ops container_tlsf_ops = {
+	.insert = container_tlsf_insert_block,
+	.get_rm_exact = container_tlsf_get_rm_block_exact,
+	.get_rm_bestfit = container_tlsf_get_rm_block_bestfit,
+	.is_empty = container_tlsf_is_empty,
+	.rm_all = container_tlsf_rm_all,
+	.destroy = container_tlsf_destroy,
+};
+
+/*
+ * container_new_tlsf -- allocates and initializes a TLSF container
+ */
+struct block_container *
+container_new_tlsf(struct palloc_heap *heap)
+{
+	struct block_container_tlsf *bc = Zalloc(sizeof(*bc));
+	if (bc == NULL)
+		goto error_container_malloc;
+
+	bc->super.heap = heap;
+	bc->super.c_ops = &container_tlsf_ops;
+
+	bc->index = critnib_new();
+	if (bc->index == NULL)
+		goto error_critnib_new;
+
+	for (unsigned fl = 0; fl < TLSF_FL_COUNT; ++fl)
+		for (unsigned sl = 0; sl < TLSF_SL_COUNT; ++sl)
+			PMDK_LIST_INIT(&bc->lists[fl][sl]);
+	PMDK_LIST_INIT(&bc->unused);
+
+	return (struct block_container *)&bc->super;
+
+error_critnib_new:
+	Free(bc);
+
+error_container_malloc:
+	return NULL;
+}
@@ -6,6 +6,8 @@
  */
 
 #include <errno.h>
+#include <limits.h>
+#include <sys/mman.h>
 #include <unistd.h>
 #include <string.h>
 #include <float.h>
@@ -21,9 +23,12 @@
 #include "sys_util.h"
 #include "valgrind_internal.h"
 #include "recycler.h"
+#include "tcache.h"
 #include "container_ravl.h"
 #include "container_seglists.h"
+#include "container_tlsf.h"
 #include "alloc_class.h"
+#include "os.h"
 #include "os_thread.h"
 #include "set.h"
 
@@ -36,11 +41,30 @@
 #define HEAP_DEFAULT_GROW_SIZE (1 << 27) /* 128 megabytes */
 #define MAX_DEFAULT_ARENAS (1 << 10) /* 1024 arenas */
 
+/* default period of the background reclamation, in milliseconds */
+#define HEAP_RECLAIM_DEFAULT_INTERVAL 100
+#define HEAP_RECLAIM_MAX_INTERVAL 60000
+
+/* the arena or the zone is not bound to any particular NUMA node */
+#define NUMA_NODE_ANY (-1)
+/* the NUMA node of the zone has not been queried yet */
+#define NUMA_NODE_UNKNOWN (-2)
+
+/* states of the persistent zone summaries, as seen by the runtime */
+#define ZONE_SUMMARY_NONE 0 /* missing or stale */
+#define ZONE_SUMMARY_FREE 1 /* the zone had free space when reclaimed */
+#define ZONE_SUMMARY_FULL 2 /* the zone had no free space when reclaimed */
+
 enum pobj_arenas_assignment_type Default_arenas_assignment_type =
 	POBJ_ARENAS_ASSIGNMENT_THREAD_KEY;
 
 size_t Default_arenas_max = 0;
 
+enum pobj_huge_container_type Default_huge_container =
+	POBJ_HUGE_CONTAINER_RAVL;
+
+unsigned Default_reclaim_parallel = 0;
+
 struct arenas_thread_assignment {
 	enum pobj_arenas_assignment_type type;
 	union {
@@ -53,6 +77,9 @@ struct arenas {
 	VEC(, struct arena *) vec;
 	size_t nactive;
 
+	/* number of NUMA nodes of the platform */
+	unsigned nnodes;
+
 	/*
 	 * When nesting with other locks, this one must be acquired first,
 	 * prior to locking any buckets or memory blocks.
@@ -63,6 +90,19 @@ struct arenas {
 	struct arenas_thread_assignment assignment;
 };
 
+/*
+ * State of the background reclamation workers, threads that scan the zones
+ * and recycle the runs in advance so that the allocating threads don't have to.
+ */
+struct heap_reclaim {
+	os_mutex_t lock;
+	os_cond_t cond;
+
+	unsigned nworkers; /* number of running workers */
+	int stop; /* set by heap_reclaim_stop until heap_reclaim_start */
+	unsigned interval; /* milliseconds between reclamation passes */
+};
+
 /*
  * Arenas store the collection of buckets for allocation classes.
  * Each thread is assigned an arena on its first allocator operation
@@ -79,6 +119,9 @@ struct arena {
 	int automatic;
 	size_t nthreads;
 	struct arenas *arenas;
+
+	/* NUMA node of the threads served by the arena or NUMA_NODE_ANY */
+	int numa_node;
 };
 
 struct heap_rt {
@@ -95,6 +138,19 @@ struct heap_rt {
 
 	unsigned nzones;
 	int *zone_reclaimed_map;
+
+	/* state of the persistent summary of each zone */
+	int *zone_summary_map;
+
+	/* NUMA node of each zone, only used with NUMA arenas assignment */
+	int *zone_numa_map;
+
+	struct heap_tcache *tcache;
+
+	/* run buckets reserve blocks without the bucket lock */
+	int run_lockfree;
+
+	struct heap_reclaim reclaim;
 };
 
 /*
@@ -162,6 +218,15 @@ heap_alloc_classes(struct palloc_heap *heap)
 	return heap->rt ? heap->rt->alloc_classes : NULL;
 }
 
+/*
+ * heap_tcache -- returns the thread cache collection of the heap
+ */
+struct heap_tcache *
+heap_tcache(struct palloc_heap *heap)
+{
+	return heap->rt->tcache;
+}
+
 /*
  * heap_arena_delete -- (internal) destroys arena instance
  */
@@ -174,11 +239,32 @@ heap_arena_delete(struct arena *arena)
 	Free(arena);
 }
 
+/*
+ * heap_run_bucket_new -- (internal) creates a bucket for the alloc class
+ *	in the current reservation mode of the heap
+ */
+static struct bucket_locked *
+heap_run_bucket_new(struct palloc_heap *heap, struct alloc_class *c)
+{
+	struct bucket_locked *locked =
+		bucket_locked_new(container_new_seglists(heap), c);
+	if (locked == NULL)
+		return NULL;
+
+	if (heap_get_run_lockfree(heap)) {
+		struct bucket *b = bucket_acquire(locked);
+		bucket_set_lockfree(b, 1);
+		bucket_release(b);
+	}
+
+	return locked;
+}
+
 /*
  * heap_arena_new -- (internal) initializes arena instance
  */
 static struct arena *
-heap_arena_new(struct palloc_heap *heap, int automatic)
+heap_arena_new(struct palloc_heap *heap, int automatic, int numa_node)
 {
 	struct heap_rt *rt = heap->rt;
 
@@ -190,15 +276,14 @@ heap_arena_new(struct palloc_heap *heap, int automatic)
 	arena->nthreads = 0;
 	arena->automatic = automatic;
 	arena->arenas = &heap->rt->arenas;
+	arena->numa_node = numa_node;
 
 	COMPILE_ERROR_ON(MAX_ALLOCATION_CLASSES > UINT8_MAX);
 	for (uint8_t i = 0; i < MAX_ALLOCATION_CLASSES; ++i) {
 		struct alloc_class *ac =
 			alloc_class_by_id(rt->alloc_classes, i);
 		if (ac != NULL) {
-			arena->buckets[i] =
-				bucket_locked_new(container_new_seglists(heap),
-					ac);
+			arena->buckets[i] = heap_run_bucket_new(heap, ac);
 			if (arena->buckets[i] == NULL)
 				goto error_bucket_create;
 		} else {
@@ -251,7 +336,8 @@ heap_arena_thread_attach(struct palloc_heap *heap, struct arena *a)
 	struct heap_rt *h = heap->rt;
 
 	struct arenas_thread_assignment *assignment = &h->arenas.assignment;
-	ASSERTeq(assignment->type, POBJ_ARENAS_ASSIGNMENT_THREAD_KEY);
+	ASSERT(assignment->type == POBJ_ARENAS_ASSIGNMENT_THREAD_KEY ||
+		assignment->type == POBJ_ARENAS_ASSIGNMENT_NUMA);
 
 	struct arena *thread_arena = os_tls_get(assignment->thread);
 	if (thread_arena)
@@ -296,6 +382,7 @@ arena_thread_assignment_init(struct arenas_thread_assignment *assignment,
 
 	switch (type) {
 		case POBJ_ARENAS_ASSIGNMENT_THREAD_KEY:
+		case POBJ_ARENAS_ASSIGNMENT_NUMA:
 			ret = os_tls_key_create(&assignment->thread,
 				heap_thread_arena_destructor);
 			break;
@@ -319,6 +406,7 @@ arena_thread_assignment_fini(struct arenas_thread_assignment *assignment)
 {
 	switch (assignment->type) {
 		case POBJ_ARENAS_ASSIGNMENT_THREAD_KEY:
+		case POBJ_ARENAS_ASSIGNMENT_NUMA:
 			os_tls_key_delete(assignment->thread);
 			break;
 		case POBJ_ARENAS_ASSIGNMENT_GLOBAL:
@@ -368,6 +456,20 @@ heap_global_arena_assign(struct palloc_heap *heap)
 	return a;
 }
 
+/*
+ * heap_thread_numa_node -- (internal) returns the NUMA node on which the
+ *	calling thread is currently running or NUMA_NODE_ANY if unknown
+ */
+static int
+heap_thread_numa_node(void)
+{
+	unsigned node;
+	if (os_getcpu_node(&node) != 0 || node > INT_MAX)
+		return NUMA_NODE_ANY;
+
+	return (int)node;
+}
+
 /*
  * heap_thread_arena_assign -- (internal) assigns the least used arena
  *	to current thread
@@ -376,13 +478,21 @@ heap_global_arena_assign(struct palloc_heap *heap)
  * used arena, a lock is used, but the nthreads counter of the arena is still
  * bumped using atomic instruction because it can happen in parallel to a
  * destructor of a thread, which also touches that variable.
+ *
+ * With the NUMA assignment type, arenas bound to the node on which the thread
+ * is running are preferred over all others.
  */
 static struct arena *
 heap_thread_arena_assign(struct palloc_heap *heap)
 {
+	int node = NUMA_NODE_ANY;
+	if (heap->rt->arenas.assignment.type == POBJ_ARENAS_ASSIGNMENT_NUMA)
+		node = heap_thread_numa_node();
+
 	util_mutex_lock(&heap->rt->arenas.lock);
 
 	struct arena *least_used = NULL;
+	struct arena *least_used_local = NULL;
 
 	ASSERTne(VEC_SIZE(&heap->rt->arenas.vec), 0);
 
@@ -393,8 +503,15 @@ heap_thread_arena_assign(struct palloc_heap *heap)
 		if (least_used == NULL ||
 			a->nthreads < least_used->nthreads)
 			least_used = a;
+		if (node != NUMA_NODE_ANY && a->numa_node == node &&
+			(least_used_local == NULL ||
+			a->nthreads < least_used_local->nthreads))
+			least_used_local = a;
 	}
 
+	if (least_used_local != NULL)
+		least_used = least_used_local;
+
 	LOG(4, "assigning %p arena to current thread", least_used);
 
 	/* at least one automatic arena must exist */
@@ -419,6 +536,7 @@ heap_thread_arena(struct palloc_heap *heap)
 
 	switch (assignment->type) {
 		case POBJ_ARENAS_ASSIGNMENT_THREAD_KEY:
+		case POBJ_ARENAS_ASSIGNMENT_NUMA:
 			if ((arena = os_tls_get(assignment->thread)) == NULL)
 				arena = heap_thread_arena_assign(heap);
 			break;
@@ -463,11 +581,11 @@ heap_get_thread_arena_id(struct palloc_heap *heap)
 }
 
 /*
- * heap_bucket_acquire -- fetches by arena or by id a bucket exclusive
- * for the thread until heap_bucket_release is called
+ * heap_bucket_locked -- fetches by arena or by id a bucket without
+ *	acquiring it
  */
-struct bucket *
-heap_bucket_acquire(struct palloc_heap *heap, uint8_t class_id,
+struct bucket_locked *
+heap_bucket_locked(struct palloc_heap *heap, uint8_t class_id,
 		uint16_t arena_id)
 {
 	struct heap_rt *rt = heap->rt;
@@ -488,7 +606,18 @@ heap_bucket_acquire(struct palloc_heap *heap, uint8_t class_id,
 	}
 
 out:
-	return bucket_acquire(b);
+	return b;
+}
+
+/*
+ * heap_bucket_acquire -- fetches by arena or by id a bucket exclusive
+ * for the thread until heap_bucket_release is called
+ */
+struct bucket *
+heap_bucket_acquire(struct palloc_heap *heap, uint8_t class_id,
+		uint16_t arena_id)
+{
+	return bucket_acquire(heap_bucket_locked(heap, class_id, arena_id));
 }
 
 /*
@@ -573,6 +702,9 @@ heap_zone_init(struct palloc_heap *heap, uint32_t zone_id,
 	};
 	z->header = nhdr; /* write the entire header (8 bytes) at once */
 	pmemops_persist(&heap->p_ops, &z->header, sizeof(z->header));
+
+	util_atomic_store_explicit32(&heap->rt->zone_summary_map[zone_id],
+		ZONE_SUMMARY_NONE, memory_order_release);
 }
 
 /*
@@ -726,11 +858,13 @@ heap_run_into_free_chunk(struct palloc_heap *heap,
 
 /*
  * heap_reclaim_run -- checks the run for available memory if unclaimed.
+ *	The number of free units is returned through free_space, if provided.
  *
  * Returns 1 if reclaimed chunk, 0 otherwise.
  */
 static int
-heap_reclaim_run(struct palloc_heap *heap, struct memory_block *m, int startup)
+heap_reclaim_run(struct palloc_heap *heap, struct memory_block *m, int startup,
+	uint32_t *free_space)
 {
 	struct chunk_run *run = heap_get_chunk_run(heap, m);
 	struct chunk_header *hdr = heap_get_chunk_hdr(heap, m);
@@ -740,6 +874,9 @@ heap_reclaim_run(struct palloc_heap *heap, struct memory_block *m, int startup)
 		run->hdr.block_size, hdr->flags, m->size_idx);
 
 	struct recycler_element e = recycler_element_new(heap, m);
+	if (free_space != NULL)
+		*free_space = e.free_space;
+
 	if (c == NULL) {
 #ifdef DEBUG
 		uint32_t size_idx = m->size_idx;
@@ -772,15 +909,141 @@ heap_reclaim_run(struct palloc_heap *heap, struct memory_block *m, int startup)
 	return 0;
 }
 
+/*
+ * heap_zone_summary_write -- (internal) stores the summary of the zone's free
+ *	space found by the reclamation
+ */
+static void
+heap_zone_summary_write(struct palloc_heap *heap, uint32_t zone_id,
+	uint64_t free_chunks, uint32_t free_runs)
+{
+	struct zone *z = ZID_TO_ZONE(heap->layout, zone_id);
+
+	struct zone_summary summary = {
+		.magic = ZONE_SUMMARY_MAGIC,
+		.free_runs = free_runs,
+		.free_chunks = free_chunks,
+		.checksum = 0,
+	};
+	util_checksum(&summary, sizeof(summary), &summary.checksum, 1, 0);
+
+	/* a torn write is detected by the checksum */
+	z->header.summary = summary;
+	pmemops_persist(&heap->p_ops, &z->header.summary,
+		sizeof(z->header.summary));
+
+	int state = free_chunks == 0 && free_runs == 0 ?
+		ZONE_SUMMARY_FULL : ZONE_SUMMARY_FREE;
+	util_atomic_store_explicit32(&heap->rt->zone_summary_map[zone_id],
+		state, memory_order_release);
+}
+
+/*
+ * heap_zone_summary_invalidate -- (internal) marks the summary of the zone
+ *	as stale if it claims that there's no free space in the zone
+ */
+static void
+heap_zone_summary_invalidate(struct palloc_heap *heap, uint32_t zone_id)
+{
+	int *state = &heap->rt->zone_summary_map[zone_id];
+
+	int full;
+	util_atomic_load_explicit32(state, &full, memory_order_acquire);
+	if (full != ZONE_SUMMARY_FULL ||
+	    !util_bool_compare_and_swap32(state, ZONE_SUMMARY_FULL,
+		ZONE_SUMMARY_NONE))
+		return;
+
+	struct zone *z = ZID_TO_ZONE(heap->layout, zone_id);
+	z->header.summary.magic = 0;
+	pmemops_persist(&heap->p_ops, &z->header.summary.magic,
+		sizeof(z->header.summary.magic));
+}
+
+/*
+ * heap_zone_summary_load -- (internal) reads the summaries of all zones,
+ *	the ones which are not consistent are ignored
+ */
+static void
+heap_zone_summary_load(struct palloc_heap *heap)
+{
+	for (uint32_t i = 0; i < heap->rt->nzones; ++i) {
+		struct zone *z = ZID_TO_ZONE(heap->layout, i);
+		struct zone_summary *summary = &z->header.summary;
+
+		heap->rt->zone_summary_map[i] = ZONE_SUMMARY_NONE;
+
+		if (z->header.magic != ZONE_HEADER_MAGIC ||
+		    summary->magic != ZONE_SUMMARY_MAGIC ||
+		    util_checksum(summary, sizeof(*summary),
+			&summary->checksum, 0, 0) != 1)
+			continue;
+
+		heap->rt->zone_summary_map[i] =
+			summary->free_chunks == 0 && summary->free_runs == 0 ?
+			ZONE_SUMMARY_FULL : ZONE_SUMMARY_FREE;
+	}
+}
+
+/* free chunks and empty runs found in a zone, not yet inserted to a bucket */
+VEC(zone_free_blocks, struct memory_block);
+
+/*
+ * heap_reclaim_free_block -- (internal) inserts a free chunk or an empty run
+ *	found by the zone reclamation into the bucket
+ */
+static void
+heap_reclaim_free_block(struct palloc_heap *heap, struct bucket *bucket,
+	struct memory_block *m)
+{
+	if (m->type == MEMORY_BLOCK_RUN)
+		heap_run_into_free_chunk(heap, bucket, m);
+	else
+		heap_free_chunk_reuse(heap, bucket, m);
+}
+
+/*
+ * heap_reclaim_zone_block -- (internal) inserts the free block into
+ *	the bucket, or defers that if the bucket isn't held by the caller
+ */
+static void
+heap_reclaim_zone_block(struct palloc_heap *heap, struct bucket *bucket,
+	struct memory_block *m, struct zone_free_blocks *deferred)
+{
+	if (bucket != NULL) {
+		heap_reclaim_free_block(heap, bucket, m);
+		return;
+	}
+
+	if (VEC_PUSH_BACK(deferred, *m) == 0)
+		return;
+
+	/* out of memory, take the bucket just for this block */
+	struct bucket *defb = heap_bucket_acquire(heap,
+		DEFAULT_ALLOC_CLASS_ID, HEAP_ARENA_PER_THREAD);
+	heap_reclaim_free_block(heap, defb, m);
+	heap_bucket_release(defb);
+}
+
 /*
  * heap_reclaim_zone_garbage -- (internal) creates volatile state of unused runs
+ *
+ * If the bucket is NULL, the free chunks and empty runs are appended to
+ * the deferred vector instead of being inserted, so that the zone can be
+ * scanned without holding the default bucket.
  */
 static void
 heap_reclaim_zone_garbage(struct palloc_heap *heap, struct bucket *bucket,
-	uint32_t zone_id)
+	uint32_t zone_id, struct zone_free_blocks *deferred)
 {
+	ASSERT(bucket != NULL || deferred != NULL);
+
 	struct zone *z = ZID_TO_ZONE(heap->layout, zone_id);
 
+	uint64_t free_chunks = 0;
+	uint32_t free_runs = 0;
+	uint32_t free_space;
+
 	for (uint32_t i = 0; i < z->header.size_idx; ) {
 		struct chunk_header *hdr = &z->chunk_headers[i];
 		ASSERT(hdr->size_idx != 0);
@@ -795,12 +1058,19 @@ heap_reclaim_zone_garbage(struct palloc_heap *heap, struct bucket *bucket,
 
 		switch (hdr->type) {
 			case CHUNK_TYPE_RUN:
-				if (heap_reclaim_run(heap, &m, 1) != 0)
-					heap_run_into_free_chunk(heap, bucket,
-						&m);
+				if (heap_reclaim_run(heap, &m, 1,
+				    &free_space) != 0) {
+					free_chunks += m.size_idx;
+					heap_reclaim_zone_block(heap, bucket,
+						&m, deferred);
+				} else if (free_space != 0) {
+					free_runs++;
+				}
 				break;
 			case CHUNK_TYPE_FREE:
-				heap_free_chunk_reuse(heap, bucket, &m);
+				free_chunks += m.size_idx;
+				heap_reclaim_zone_block(heap, bucket, &m,
+					deferred);
 				break;
 			case CHUNK_TYPE_USED:
 				break;
@@ -810,6 +1080,8 @@ heap_reclaim_zone_garbage(struct palloc_heap *heap, struct bucket *bucket,
 
 		i = m.chunk_id + m.size_idx; /* hdr might have changed */
 	}
+
+	heap_zone_summary_write(heap, zone_id, free_chunks, free_runs);
 }
 
 /*
@@ -843,12 +1115,163 @@ heap_ensure_zone_reclaimed(struct palloc_heap *heap, uint32_t zone_id)
 	util_atomic_store_explicit32(&heap->rt->zone_reclaimed_map[zone_id], 1,
 		memory_order_release);
 
-	heap_reclaim_zone_garbage(heap, defb, zone_id);
+	heap_reclaim_zone_garbage(heap, defb, zone_id, NULL);
 
 out:
 	heap_bucket_release(defb);
 }
 
+/*
+ * State shared by the threads reclaiming the zones in parallel.
+ */
+struct heap_reclaim_parallel {
+	struct palloc_heap *heap;
+	uint32_t next_zone;
+};
+
+/*
+ * heap_reclaim_parallel_worker -- (internal) reclaims zones until there are
+ *	none left, the default bucket is only held to insert the free blocks
+ */
+static void *
+heap_reclaim_parallel_worker(void *arg)
+{
+	struct heap_reclaim_parallel *p = arg;
+	struct palloc_heap *heap = p->heap;
+
+	struct zone_free_blocks blocks;
+	VEC_INIT(&blocks);
+
+	for (;;) {
+		uint32_t zone_id = util_fetch_and_add32(&p->next_zone, 1);
+		if (zone_id >= heap->rt->nzones)
+			break;
+
+		/* zones that were never used are initialized on demand */
+		struct zone *z = ZID_TO_ZONE(heap->layout, zone_id);
+		if (z->header.magic != ZONE_HEADER_MAGIC)
+			continue;
+
+		if (!util_bool_compare_and_swap32(
+		    &heap->rt->zone_reclaimed_map[zone_id], 0, 1))
+			continue;
+
+		heap_reclaim_zone_garbage(heap, NULL, zone_id, &blocks);
+
+		struct bucket *defb = heap_bucket_acquire(heap,
+			DEFAULT_ALLOC_CLASS_ID, HEAP_ARENA_PER_THREAD);
+
+		struct memory_block *m;
+		VEC_FOREACH_BY_PTR(m, &blocks)
+			heap_reclaim_free_block(heap, defb, m);
+
+		heap_bucket_release(defb);
+
+		VEC_CLEAR(&blocks);
+	}
+
+	VEC_DELETE(&blocks);
+
+	return NULL;
+}
+
+/*
+ * heap_reclaim_parallel -- reclaims all the initialized zones of the heap
+ *	using the given number of threads, including the calling one
+ */
+void
+heap_reclaim_parallel(struct palloc_heap *heap, unsigned nthreads)
+{
+	ASSERTne(nthreads, 0);
+
+	struct heap_reclaim_parallel p = {
+		.heap = heap,
+		.next_zone = 0,
+	};
+
+	os_thread_t *threads = Malloc(sizeof(os_thread_t) * (nthreads - 1));
+
+	/* if the threads can't be created, the zones are reclaimed anyway */
+	unsigned nstarted = 0;
+	for (unsigned i = 0; threads != NULL && i < nthreads - 1; ++i) {
+		if (os_thread_create(&threads[i], NULL,
+			heap_reclaim_parallel_worker, &p) != 0) {
+			CORE_LOG_WARNING("failed to create a reclaim thread, "
+				"continuing with %u", nstarted + 1);
+			break;
+		}
+		nstarted++;
+	}
+
+	heap_reclaim_parallel_worker(&p);
+
+	for (unsigned i = 0; i < nstarted; ++i)
+		os_thread_join(&threads[i], NULL);
+
+	Free(threads);
+}
+
+/*
+ * heap_zone_numa_node -- (internal) returns the NUMA node of the memory
+ *	backing the zone
+ */
+static int
+heap_zone_numa_node(struct palloc_heap *heap, uint32_t zone_id)
+{
+	int *node = &heap->rt->zone_numa_map[zone_id];
+	if (*node != NUMA_NODE_UNKNOWN)
+		return *node;
+
+	struct zone *z = ZID_TO_ZONE(heap->layout, zone_id);
+	if (os_addr_numa_node(z, node) != 0)
+		*node = NUMA_NODE_ANY;
+
+	return *node;
+}
+
+/*
+ * heap_first_unreclaimed_zone -- (internal) returns the first zone that has
+ *	not been reclaimed yet, with the NUMA assignment type the zones backed
+ *	by the node of the calling thread are preferred
+ *
+ * Must be called with the default bucket held.
+ */
+static unsigned
+heap_first_unreclaimed_zone(struct palloc_heap *heap)
+{
+	struct heap_rt *h = heap->rt;
+
+	unsigned first = h->nzones;
+	unsigned first_full = h->nzones;
+	int node = h->zone_numa_map ? heap_thread_numa_node() : NUMA_NODE_ANY;
+
+	for (unsigned zone_id = 0; zone_id < h->nzones; ++zone_id) {
+		if (h->zone_reclaimed_map[zone_id] != 0)
+			continue;
+
+		int summary;
+		util_atomic_load_explicit32(&h->zone_summary_map[zone_id],
+			&summary, memory_order_acquire);
+		if (summary == ZONE_SUMMARY_FULL) {
+			if (first_full == h->nzones)
+				first_full = zone_id;
+			continue;
+		}
+
+		if (node == NUMA_NODE_ANY)
+			return zone_id;
+
+		if (first == h->nzones)
+			first = zone_id;
+
+		if (heap_zone_numa_node(heap, zone_id) == node)
+			return zone_id;
+	}
+
+	/* summaries are only hints, the full zones are reclaimed last */
+	return first != h->nzones ? first : first_full;
+}
+
 /*
  * heap_populate_bucket -- (internal) creates volatile state of memory blocks
  */
@@ -857,11 +1280,7 @@ heap_populate_bucket(struct palloc_heap *heap, struct bucket *bucket)
 {
 	struct heap_rt *h = heap->rt;
 
-	unsigned zone_id; /* first not reclaimed zone */
-	for (zone_id = 0; zone_id < h->nzones; ++zone_id) {
-		if (h->zone_reclaimed_map[zone_id] == 0)
-			break;
-	}
+	unsigned zone_id = heap_first_unreclaimed_zone(heap);
 
 	/* at this point we are sure that there's no more memory in the heap */
 	if (zone_id == h->nzones)
@@ -879,7 +1298,7 @@ heap_populate_bucket(struct palloc_heap *heap, struct bucket *bucket)
 	if (z->header.magic != ZONE_HEADER_MAGIC)
 		heap_zone_init(heap, zone_id, 0);
 
-	heap_reclaim_zone_garbage(heap, bucket, zone_id);
+	heap_reclaim_zone_garbage(heap, bucket, zone_id, NULL);
 
 	/*
 	 * It doesn't matter that this function might not have found any
@@ -890,17 +1309,13 @@ heap_populate_bucket(struct palloc_heap *heap, struct bucket *bucket)
 }
 
 /*
- * heap_recycle_unused -- recalculate scores in the recycler and turn any
- *	empty runs into free chunks
- *
- * If force is not set, this function might effectively be a noop if not enough
- * of space was freed.
+ * heap_release_empty_runs -- (internal) turns the empty runs found by
+ *	the recycler into free chunks
  */
 static int
-heap_recycle_unused(struct palloc_heap *heap, struct recycler *recycler,
-	struct bucket *defb, int force)
+heap_release_empty_runs(struct palloc_heap *heap, struct empty_runs r,
+	struct bucket *defb)
 {
-	struct empty_runs r = recycler_recalc(recycler, force);
 	if (VEC_SIZE(&r) == 0)
 		return ENOMEM;
 
@@ -922,6 +1337,21 @@ heap_recycle_unused(struct palloc_heap *heap, struct recycler *recycler,
 	return 0;
 }
 
+/*
+ * heap_recycle_unused -- recalculate scores in the recycler and turn any
+ *	empty runs into free chunks
+ *
+ * If force is not set, this function might effectively be a noop if not enough
+ * of space was freed.
+ */
+static int
+heap_recycle_unused(struct palloc_heap *heap, struct recycler *recycler,
+	struct bucket *defb, int force)
+{
+	return heap_release_empty_runs(heap,
+		recycler_recalc(recycler, force), defb);
+}
+
 /*
  * heap_reclaim_garbage -- (internal) creates volatile state of unused runs
  */
@@ -979,7 +1409,7 @@ heap_ensure_huge_bucket_filled(struct palloc_heap *heap,
 void
 heap_discard_run(struct palloc_heap *heap, struct memory_block *m)
 {
-	if (heap_reclaim_run(heap, m, 0)) {
+	if (heap_reclaim_run(heap, m, 0, NULL)) {
 		struct bucket *b =
 			heap_bucket_acquire(heap,
 			DEFAULT_ALLOC_CLASS_ID, 0);
@@ -1032,6 +1462,114 @@ heap_force_recycle(struct palloc_heap *heap)
 	heap_reclaim_garbage(heap, NULL);
 }
 
+/*
+ * heap_get_sparse_runs -- takes up to max runs that are at most max_fill_pct
+ *	full out of the recyclers, the least filled ones first. The runs are not
+ *	used for allocations until they are given back through
+ *	heap_discard_run().
+ *
+ * Returns the number of runs taken.
+ */
+size_t
+heap_get_sparse_runs(struct palloc_heap *heap, struct memory_block *runs,
+	size_t max, unsigned max_fill_pct)
+{
+	struct heap_rt *rt = heap->rt;
+	struct recycler *r;
+
+	/* bring the scores up to date, releasing the runs that became empty */
+	for (size_t i = 0; i < MAX_ALLOCATION_CLASSES; ++i) {
+		if ((r = rt->recyclers[i]) == NULL)
+			continue;
+
+		heap_release_empty_runs(heap,
+			recycler_recalc_unaccounted(r), NULL);
+	}
+
+	size_t n = 0;
+	while (n < max) {
+		struct recycler *best = NULL;
+		unsigned best_fill = max_fill_pct + 1;
+
+		for (size_t i = 0; i < MAX_ALLOCATION_CLASSES; ++i) {
+			if ((r = rt->recyclers[i]) == NULL)
+				continue;
+
+			struct alloc_class *c = alloc_class_by_id(
+				rt->alloc_classes, (uint8_t)i);
+			struct recycler_element e;
+			if (c == NULL || recycler_peek_sparsest(r, &e) != 0)
+				continue;
+
+			uint32_t nallocs = c->rdsc.nallocs;
+			unsigned fill = (unsigned)((uint64_t)(nallocs -
+				MIN(e.free_space, nallocs)) * 100 / nallocs);
+			if (fill < best_fill) {
+				best_fill = fill;
+				best = r;
+			}
+		}
+
+		if (best == NULL)
+			break;
+
+		/* the run might have been taken by a bucket in the meantime */
+		if (recycler_get_sparsest(best, &runs[n]) == 0)
+			n++;
+	}
+
+	return n;
+}
+
+/*
+ * heap_get_run_lockfree -- returns whether run buckets reserve blocks
+ *	without acquiring the bucket lock
+ */
+int
+heap_get_run_lockfree(struct palloc_heap *heap)
+{
+	int enabled;
+	util_atomic_load_explicit32(&heap->rt->run_lockfree, &enabled,
+		memory_order_acquire);
+
+	return enabled;
+}
+
+/*
+ * heap_set_run_lockfree -- switches all run buckets between the locked and
+ *	the lock-free reservation mode
+ */
+void
+heap_set_run_lockfree(struct palloc_heap *heap, int enabled)
+{
+	enabled = !!enabled;
+
+	util_mutex_lock(&heap->rt->arenas.lock);
+	util_atomic_store_explicit32(&heap->rt->run_lockfree, enabled,
+		memory_order_release);
+
+	struct arena *arenap;
+	VEC_FOREACH(arenap, &heap->rt->arenas.vec) {
+		for (int i = 0; i < MAX_ALLOCATION_CLASSES; ++i) {
+			struct bucket_locked *locked = arenap->buckets[i];
+			if (locked == NULL)
+				continue;
+
+			struct bucket *b = bucket_acquire(locked);
+			if (bucket_get_lockfree(b) != enabled) {
+				/*
+				 * The free blocks of the active run are
+				 * tracked differently in each mode.
+				 */
+				heap_detach_and_try_discard_run(heap, b);
+				bucket_set_lockfree(b, enabled);
+			}
+			bucket_release(b);
+		}
+	}
+	util_mutex_unlock(&heap->rt->arenas.lock);
+}
+
 /*
  * heap_reuse_from_recycler -- (internal) try reusing runs that are currently
  *	in the recycler
@@ -1082,6 +1620,26 @@ heap_run_create(struct palloc_heap *heap, struct bucket *b,
 	return 0;
 }
 
+/*
+ * heap_reclaim_wakeup -- (internal) notifies the background reclamation
+ *	workers, if there are any, that a bucket ran out of memory
+ */
+static void
+heap_reclaim_wakeup(struct palloc_heap *heap)
+{
+	struct heap_reclaim *r = &heap->rt->reclaim;
+
+	unsigned nworkers;
+	util_atomic_load_explicit32(&r->nworkers, &nworkers,
+		memory_order_relaxed);
+	if (nworkers == 0)
+		return;
+
+	util_mutex_lock(&r->lock);
+	os_cond_signal(&r->cond);
+	util_mutex_unlock(&r->lock);
+}
+
 /*
  * heap_ensure_run_bucket_filled -- (internal) refills the bucket if needed
  */
@@ -1093,6 +1651,8 @@ heap_ensure_run_bucket_filled(struct palloc_heap *heap, struct bucket *b,
 	ASSERTeq(aclass->type, CLASS_RUN);
 	int ret = 0;
 
+	heap_reclaim_wakeup(heap);
+
 	if (heap_detach_and_try_discard_run(heap, b) != 0)
 		return ENOMEM;
 
@@ -1146,6 +1706,8 @@ out:
 void
 heap_memblock_on_free(struct palloc_heap *heap, const struct memory_block *m)
 {
+	heap_zone_summary_invalidate(heap, m->zone_id);
+
 	if (m->type != MEMORY_BLOCK_RUN)
 		return;
 
@@ -1240,6 +1802,203 @@ heap_get_bestfit_block(struct palloc_heap *heap, struct bucket *b,
 	return 0;
 }
 
+/*
+ * heap_reclaim_stopping -- (internal) checks whether the background workers
+ *	were asked to stop
+ */
+static int
+heap_reclaim_stopping(struct palloc_heap *heap)
+{
+	int stop;
+	util_atomic_load_explicit32(&heap->rt->reclaim.stop, &stop,
+		memory_order_acquire);
+
+	return stop;
+}
+
+/*
+ * heap_reclaim_zones -- (internal) reclaims all zones which haven't been
+ *	reclaimed yet, one at a time
+ */
+static void
+heap_reclaim_zones(struct palloc_heap *heap)
+{
+	int ret;
+	do {
+		struct bucket *defb = heap_bucket_acquire(heap,
+			DEFAULT_ALLOC_CLASS_ID, HEAP_ARENA_PER_THREAD);
+		ret = heap_populate_bucket(heap, defb);
+		heap_bucket_release(defb);
+	} while (ret == 0 && !heap_reclaim_stopping(heap));
+}
+
+/*
+ * heap_reclaim_recyclers -- (internal) recalculates the scores of runs in
+ *	the recyclers and turns the empty ones into free chunks
+ */
+static void
+heap_reclaim_recyclers(struct palloc_heap *heap)
+{
+	struct recycler *r;
+	for (size_t i = 0; i < MAX_ALLOCATION_CLASSES; ++i) {
+		util_atomic_load_explicit64(&heap->rt->recyclers[i], &r,
+			memory_order_acquire);
+		if (r == NULL)
+			continue;
+
+		heap_recycle_unused(heap, r, NULL, 0);
+	}
+}
+
+/*
+ * heap_reclaim_buckets -- (internal) attaches a new run to every bucket whose
+ *	active run has been exhausted, buckets currently in use are skipped
+ */
+static void
+heap_reclaim_buckets(struct palloc_heap *heap)
+{
+	util_mutex_lock(&heap->rt->arenas.lock);
+
+	struct arena *arenap;
+	VEC_FOREACH(arenap, &heap->rt->arenas.vec) {
+		for (int i = 0; i < MAX_ALLOCATION_CLASSES; ++i) {
+			struct bucket_locked *locked = arenap->buckets[i];
+			if (locked == NULL)
+				continue;
+
+			struct bucket *b = bucket_try_acquire(locked);
+			if (b == NULL)
+				continue;
+
+			/*
+			 * Buckets that were never used don't have an active
+			 * run, there's no point in creating one for them.
+			 */
+			if (bucket_alloc_class(b)->type == CLASS_RUN &&
+			    bucket_active_block(b) != NULL &&
+			    bucket_is_empty(b))
+				heap_ensure_run_bucket_filled(heap, b, 1);
+
+			bucket_release(b);
+		}
+	}
+
+	util_mutex_unlock(&heap->rt->arenas.lock);
+}
+
+/*
+ * heap_reclaim_worker -- runs the background reclamation in the calling
+ *	thread until heap_reclaim_stop is called, returns immediately if
+ *	the workers were stopped and not started again
+ */
+void
+heap_reclaim_worker(struct palloc_heap *heap)
+{
+	struct heap_reclaim *r = &heap->rt->reclaim;
+
+	util_mutex_lock(&r->lock);
+	util_fetch_and_add32(&r->nworkers, 1);
+
+	while (!r->stop) {
+		util_mutex_unlock(&r->lock);
+
+		heap_reclaim_zones(heap);
+		heap_reclaim_recyclers(heap);
+		heap_reclaim_buckets(heap);
+
+		util_mutex_lock(&r->lock);
+		if (r->stop)
+			break;
+
+		struct timespec abstime;
+		os_clock_gettime(CLOCK_REALTIME, &abstime);
+		uint64_t nsec = (uint64_t)abstime.tv_nsec +
+			(uint64_t)r->interval * 1000000ULL;
+		abstime.tv_sec += (time_t)(nsec / 1000000000ULL);
+		abstime.tv_nsec = (long)(nsec % 1000000000ULL);
+
+		os_cond_timedwait(&r->cond, &r->lock, &abstime);
+	}
+
+	util_fetch_and_sub32(&r->nworkers, 1);
+	os_cond_broadcast(&r->cond);
+	util_mutex_unlock(&r->lock);
+}
+
+/*
+ * heap_reclaim_stop -- stops all background reclamation workers and waits
+ *	for them to return, the workers started later return immediately
+ *	until heap_reclaim_start is called
+ */
+void
+heap_reclaim_stop(struct palloc_heap *heap)
+{
+	struct heap_reclaim *r = &heap->rt->reclaim;
+
+	util_mutex_lock(&r->lock);
+
+	util_atomic_store_explicit32(&r->stop, 1, memory_order_release);
+	os_cond_broadcast(&r->cond);
+	while (r->nworkers != 0)
+		os_cond_wait(&r->cond, &r->lock);
+
+	util_mutex_unlock(&r->lock);
+}
+
+/*
+ * heap_reclaim_start -- allows the background reclamation workers to run
+ *	again after they were stopped
+ */
+void
+heap_reclaim_start(struct palloc_heap *heap)
+{
+	struct heap_reclaim *r = &heap->rt->reclaim;
+
+	util_mutex_lock(&r->lock);
+	util_atomic_store_explicit32(&r->stop, 0, memory_order_release);
+	util_mutex_unlock(&r->lock);
+}
+
+/*
+ * heap_reclaim_get_interval -- returns the time between the reclamation
+ *	passes of the background workers, in milliseconds
+ */
+unsigned
+heap_reclaim_get_interval(struct palloc_heap *heap)
+{
+	struct heap_reclaim *r = &heap->rt->reclaim;
+
+	util_mutex_lock(&r->lock);
+	unsigned interval = r->interval;
+	util_mutex_unlock(&r->lock);
+
+	return interval;
+}
+
+/*
+ * heap_reclaim_set_interval -- sets the time between the reclamation passes
+ *	of the background workers, in milliseconds
+ */
+int
+heap_reclaim_set_interval(struct palloc_heap *heap, unsigned interval)
+{
+	if (interval == 0 || interval > HEAP_RECLAIM_MAX_INTERVAL) {
+		ERR_WO_ERRNO("invalid reclaim interval %u, must be between 1 "
+			"and %u", interval, HEAP_RECLAIM_MAX_INTERVAL);
+		errno = EINVAL;
+		return -1;
+	}
+
+	struct heap_reclaim *r = &heap->rt->reclaim;
+
+	util_mutex_lock(&r->lock);
+	r->interval = interval;
+	os_cond_broadcast(&r->cond);
+	util_mutex_unlock(&r->lock);
+
+	return 0;
+}
+
 #if VG_MEMCHECK_ENABLED
 /*
  * heap_end -- returns first address after heap
@@ -1264,7 +2023,7 @@ heap_arena_create(struct palloc_heap *heap)
 {
 	struct heap_rt *h = heap->rt;
 
-	struct arena *arena = heap_arena_new(heap, 0);
+	struct arena *arena = heap_arena_new(heap, 0, NUMA_NODE_ANY);
 	if (arena == NULL)
 		return -1;
 
@@ -1421,6 +2180,60 @@ out:
 
 }
 
+/*
+ * heap_get_arena_numa_node -- returns the NUMA node to which the arena is
+ *	bound or -1 if it serves threads from any node
+ */
+int
+heap_get_arena_numa_node(struct palloc_heap *heap, unsigned arena_id)
+{
+	util_mutex_lock(&heap->rt->arenas.lock);
+	struct arena *a = heap_get_arena_by_id(heap, arena_id);
+	int ret = a->numa_node;
+	util_mutex_unlock(&heap->rt->arenas.lock);
+
+	return ret;
+}
+
+/*
+ * heap_get_numa_nnodes -- returns the number of NUMA nodes
+ */
+unsigned
+heap_get_numa_nnodes(struct palloc_heap *heap)
+{
+	return heap->rt->arenas.nnodes;
+}
+
+/*
+ * heap_get_numa_node_arenas -- returns the number of automatic arenas bound
+ *	to the NUMA node and the number of threads assigned to them
+ */
+unsigned
+heap_get_numa_node_arenas(struct palloc_heap *heap, unsigned node,
+	size_t *nthreads)
+{
+	struct heap_rt *h = heap->rt;
+	struct arena *arena;
+	unsigned narenas = 0;
+	size_t threads = 0;
+
+	util_mutex_lock(&h->arenas.lock);
+
+	VEC_FOREACH(arena, &h->arenas.vec) {
+		if (!arena->automatic || arena->numa_node != (int)node)
+			continue;
+		narenas++;
+		threads += arena->nthreads;
+	}
+
+	util_mutex_unlock(&h->arenas.lock);
+
+	if (nthreads)
+		*nthreads = threads;
+
+	return narenas;
+}
+
 /*
  * heap_set_arena_thread -- assign arena with given id to the current thread
  */
@@ -1463,8 +2276,7 @@ heap_create_alloc_class_buckets(struct palloc_heap *heap, struct alloc_class *c)
 	VEC_FOREACH_BY_POS(i, &h->arenas.vec) {
 		arena = VEC_ARR(&h->arenas.vec)[i];
 		if (arena->buckets[c->id] == NULL)
-			arena->buckets[c->id] = bucket_locked_new(
-				container_new_seglists(heap), c);
+			arena->buckets[c->id] = heap_run_bucket_new(heap, c);
 		if (arena->buckets[c->id] == NULL)
 			goto error_cache_bucket_new;
 	}
@@ -1495,7 +2307,11 @@ heap_buckets_init(struct palloc_heap *heap)
 		}
 	}
 
-	h->default_bucket = bucket_locked_new(container_new_ravl(heap),
+	struct block_container *huge =
+		Default_huge_container == POBJ_HUGE_CONTAINER_TLSF ?
+		container_new_tlsf(heap) : container_new_ravl(heap);
+
+	h->default_bucket = bucket_locked_new(huge,
 		alloc_class_by_id(h->alloc_classes, DEFAULT_ALLOC_CLASS_ID));
 
 	if (h->default_bucket == NULL)
@@ -1560,6 +2376,130 @@ heap_extend(struct palloc_heap *heap, struct bucket *b, size_t size)
 	return 1;
 }
 
+/*
+ * heap_shrink_block -- (internal) releases the backing storage of the pages
+ *	fully covered by the free chunk, in every replica of the pool
+ */
+static int
+heap_shrink_block(struct palloc_heap *heap, const struct memory_block *m,
+	size_t *released)
+{
+	uintptr_t start = (uintptr_t)heap_get_chunk(heap, m);
+	uintptr_t end = start + (uintptr_t)m->size_idx * CHUNKSIZE;
+
+	start = ALIGN_UP(start, Pagesize);
+	end = ALIGN_DOWN(end, Pagesize);
+	if (end <= start)
+		return 0;
+
+	size_t off = start - (uintptr_t)heap->base;
+	size_t len = end - start;
+
+	unsigned nreplicas = heap->set != NULL ? heap->set->nreplicas : 1;
+	for (unsigned r = 0; r < nreplicas; ++r) {
+		char *addr = heap->set != NULL ?
+			heap->set->replica[r]->part[0].addr : heap->base;
+
+		if (os_madvise(addr + off, len, MADV_REMOVE) != 0) {
+			ERR_W_ERRNO("madvise");
+			return -1;
+		}
+	}
+
+	*released += len;
+
+	return 0;
+}
+
+/*
+ * heap_shrink_zone -- (internal) releases the backing storage of the free
+ *	chunks of the zone that span at least min_size_idx chunks
+ *
+ * Must be called with the default bucket held. Only the chunks that can be
+ * removed from the bucket are released, the ones that are reserved by
+ * an ongoing allocation are skipped.
+ */
+static int
+heap_shrink_zone(struct palloc_heap *heap, struct bucket *defb,
+	uint32_t zone_id, uint32_t min_size_idx, size_t *released)
+{
+	struct zone *z = ZID_TO_ZONE(heap->layout, zone_id);
+
+	for (uint32_t i = 0; i < z->header.size_idx; ) {
+		struct chunk_header hdr = z->chunk_headers[i];
+		if (hdr.size_idx == 0)
+			break;
+
+		struct memory_block m = MEMORY_BLOCK_NONE;
+		m.zone_id = zone_id;
+		m.chunk_id = i;
+		m.size_idx = hdr.size_idx;
+
+		i += hdr.size_idx;
+
+		if (hdr.type != CHUNK_TYPE_FREE || m.size_idx < min_size_idx)
+			continue;
+
+		memblock_rebuild_state(heap, &m);
+
+		if (bucket_remove_block(defb, &m) != 0)
+			continue;
+
+		int ret = heap_shrink_block(heap, &m, released);
+
+		if (bucket_insert_block(defb, &m) != 0) {
+			ERR_WO_ERRNO("failed to reinsert a released chunk");
+			errno = ENOMEM;
+			return -1;
+		}
+
+		if (ret != 0)
+			return ret;
+	}
+
+	return 0;
+}
+
+/*
+ * heap_shrink -- releases the backing storage of the free chunk ranges of
+ *	the heap that are at least of the given size
+ *
+ * The released pages read back as zeroes and are faulted in again, on
+ * demand, once the chunks are reused.
+ */
+int
+heap_shrink(struct palloc_heap *heap, size_t min_size, size_t *released)
+{
+	*released = 0;
+
+	/* no free chunk range can be larger than a zone */
+	if (min_size > MAX_MEMORY_BLOCK_SIZE)
+		return 0;
+
+	uint32_t min_size_idx = min_size <= CHUNKSIZE ? 1 :
+		(uint32_t)CALC_SIZE_IDX(CHUNKSIZE, min_size);
+
+	int ret = 0;
+	for (uint32_t zone_id = 0; ret == 0; ++zone_id) {
+		struct bucket *defb = heap_bucket_acquire(heap,
+			DEFAULT_ALLOC_CLASS_ID, HEAP_ARENA_PER_THREAD);
+
+		if (zone_id >= heap->rt->nzones) {
+			heap_bucket_release(defb);
+			break;
+		}
+
+		/* unreclaimed zones have no chunks in the bucket yet */
+		if (heap->rt->zone_reclaimed_map[zone_id])
+			ret = heap_shrink_zone(heap, defb, zone_id,
+				min_size_idx, released);
+
+		heap_bucket_release(defb);
+	}
+
+	return ret;
+}
+
 /*
  * heap_zone_update_if_needed -- updates the zone metadata if the pool has been
  *	extended.
@@ -1622,6 +2562,23 @@ heap_boot(struct palloc_heap *heap, void *heap_start, uint64_t heap_size,
 		goto err_reclaimed_map_malloc;
 	}
 
+	h->zone_summary_map = Zalloc(sizeof(int) * h->nzones);
+	if (h->zone_summary_map == NULL) {
+		err = ENOMEM;
+		goto err_summary_map_malloc;
+	}
+
+	h->zone_numa_map = NULL;
+	if (Default_arenas_assignment_type == POBJ_ARENAS_ASSIGNMENT_NUMA) {
+		h->zone_numa_map = Malloc(sizeof(int) * h->nzones);
+		if (h->zone_numa_map == NULL) {
+			err = ENOMEM;
+			goto err_numa_map_malloc;
+		}
+		for (unsigned i = 0; i < h->nzones; ++i)
+			h->zone_numa_map[i] = NUMA_NODE_UNKNOWN;
+	}
+
 	if ((err = arena_thread_assignment_init(&h->arenas.assignment,
 		Default_arenas_assignment_type)) != 0) {
 		goto error_assignment_init;
@@ -1641,10 +2598,19 @@ heap_boot(struct palloc_heap *heap, void *heap_start, uint64_t heap_size,
 		goto error_arenas_malloc;
 	}
 
+	h->arenas.nnodes = os_numa_nnodes();
+	h->run_lockfree = 0;
+
 	h->nlocks = On_valgrind ? MAX_RUN_LOCKS_VG : MAX_RUN_LOCKS;
 	for (unsigned i = 0; i < h->nlocks; ++i)
 		util_mutex_init(&h->run_locks[i]);
 
+	util_mutex_init(&h->reclaim.lock);
+	util_cond_init(&h->reclaim.cond);
+	h->reclaim.nworkers = 0;
+	h->reclaim.stop = 0;
+	h->reclaim.interval = HEAP_RECLAIM_DEFAULT_INTERVAL;
+
 	heap->p_ops = *p_ops;
 	heap->layout = heap_start;
 	heap->rt = h;
@@ -1656,8 +2622,15 @@ heap_boot(struct palloc_heap *heap, void *heap_start, uint64_t heap_size,
 	heap->alloc_pattern = PALLOC_CTL_DEBUG_NO_PATTERN;
 	VALGRIND_DO_CREATE_MEMPOOL(heap->layout, 0, 0);
 
+	/*
+	 * With NUMA assignment, default arenas are spread evenly across
+	 * nodes.
+	 */
+	int numa = h->arenas.assignment.type == POBJ_ARENAS_ASSIGNMENT_NUMA;
 	for (unsigned i = 0; i < narenas_default; ++i) {
-		if (VEC_PUSH_BACK(&h->arenas.vec, heap_arena_new(heap, 1))) {
+		int node = numa ? (int)(i % h->arenas.nnodes) : NUMA_NODE_ANY;
+		if (VEC_PUSH_BACK(&h->arenas.vec,
+			heap_arena_new(heap, 1, node))) {
 			err = errno;
 			goto error_vec_reserve;
 		}
@@ -1666,17 +2639,30 @@ heap_boot(struct palloc_heap *heap, void *heap_start, uint64_t heap_size,
 	for (unsigned i = 0; i < MAX_ALLOCATION_CLASSES; ++i)
 		h->recyclers[i] = NULL;
 
+	h->tcache = tcache_new(heap);
+	if (h->tcache == NULL) {
+		err = ENOMEM;
+		goto error_vec_reserve;
+	}
+
 	heap_zone_update_if_needed(heap);
+	heap_zone_summary_load(heap);
 
 	return 0;
 
 error_vec_reserve:
+	util_cond_destroy(&h->reclaim.cond);
+	util_mutex_destroy(&h->reclaim.lock);
 	heap_arenas_fini(&h->arenas);
 error_arenas_malloc:
 	alloc_class_collection_delete(h->alloc_classes);
 error_alloc_classes_new:
 	arena_thread_assignment_fini(&h->arenas.assignment);
 error_assignment_init:
+	Free(h->zone_numa_map);
+err_numa_map_malloc:
+	Free(h->zone_summary_map);
+err_summary_map_malloc:
 	Free(h->zone_reclaimed_map);
 err_reclaimed_map_malloc:
 	Free(h);
@@ -1751,6 +2737,15 @@ heap_cleanup(struct palloc_heap *heap)
 {
 	struct heap_rt *rt = heap->rt;
 
+	util_cond_destroy(&rt->reclaim.cond);
+	util_mutex_destroy(&rt->reclaim.lock);
+
+	/*
+	 * Cached reservations must be returned to the buckets before those
+	 * are destroyed.
+	 */
+	tcache_delete(rt->tcache);
+
 	alloc_class_collection_delete(rt->alloc_classes);
 
 	arena_thread_assignment_fini(&rt->arenas.assignment);
@@ -1774,6 +2769,8 @@ heap_cleanup(struct palloc_heap *heap)
 
 	VALGRIND_DO_DESTROY_MEMPOOL(heap->layout);
 
+	Free(rt->zone_numa_map);
+	Free(rt->zone_summary_map);
 	Free(rt->zone_reclaimed_map);
 	Free(rt);
 	heap->rt = NULL;
@@ -22,7 +22,9 @@ extern "C" {
 #endif
 
 extern enum pobj_arenas_assignment_type Default_arenas_assignment_type;
+extern enum pobj_huge_container_type Default_huge_container;
 extern size_t Default_arenas_max;
+extern unsigned Default_reclaim_parallel;
 
 #define HEAP_OFF_TO_PTR(heap, off) ((void *)((char *)((heap)->base) + (off)))
 #define HEAP_PTR_TO_OFF(heap, ptr)\
@@ -30,6 +32,7 @@ extern size_t Default_arenas_max;
 
 #define BIT_IS_CLR(a, i)	(!((a) & (1ULL << (i))))
 #define HEAP_ARENA_PER_THREAD (0)
+#define HEAP_RECLAIM_MAX_THREADS (1 << 10)
 
 int heap_boot(struct palloc_heap *heap, void *heap_start, uint64_t heap_size,
 		uint64_t *sizep,
@@ -46,10 +49,15 @@ int heap_create_alloc_class_buckets(struct palloc_heap *heap,
 
 int heap_extend(struct palloc_heap *heap, struct bucket *defb,
 	size_t size);
+int heap_shrink(struct palloc_heap *heap, size_t min_size, size_t *released);
 
 struct alloc_class *
 heap_get_best_class(struct palloc_heap *heap, size_t size);
 
+struct bucket_locked *
+heap_bucket_locked(struct palloc_heap *heap, uint8_t class_id,
+		uint16_t arena_id);
+
 struct bucket *
 heap_bucket_acquire(struct palloc_heap *heap, uint8_t class_id,
 		uint16_t arena_id);
@@ -65,9 +73,22 @@ os_mutex_t *heap_get_run_lock(struct palloc_heap *heap,
 void
 heap_force_recycle(struct palloc_heap *heap);
 
+void heap_reclaim_parallel(struct palloc_heap *heap, unsigned nthreads);
+void heap_reclaim_worker(struct palloc_heap *heap);
+void heap_reclaim_stop(struct palloc_heap *heap);
+void heap_reclaim_start(struct palloc_heap *heap);
+unsigned heap_reclaim_get_interval(struct palloc_heap *heap);
+int heap_reclaim_set_interval(struct palloc_heap *heap, unsigned interval);
+
+int heap_get_run_lockfree(struct palloc_heap *heap);
+void heap_set_run_lockfree(struct palloc_heap *heap, int enabled);
+
 void
 heap_discard_run(struct palloc_heap *heap, struct memory_block *m);
 
+size_t heap_get_sparse_runs(struct palloc_heap *heap, struct memory_block *runs,
+	size_t max, unsigned max_fill_pct);
+
 void
 heap_memblock_on_free(struct palloc_heap *heap, const struct memory_block *m);
 
@@ -83,6 +104,8 @@ void heap_foreach_object(struct palloc_heap *heap, object_callback cb,
 
 struct alloc_class_collection *heap_alloc_classes(struct palloc_heap *heap);
 
+struct heap_tcache *heap_tcache(struct palloc_heap *heap);
+
 #if VG_MEMCHECK_ENABLED
 void *heap_end(struct palloc_heap *heap);
 #endif /* VG_MEMCHECK_ENABLED */
@@ -109,6 +132,13 @@ int heap_set_arena_auto(struct palloc_heap *heap, unsigned arena_id,
 
 void heap_set_arena_thread(struct palloc_heap *heap, unsigned arena_id);
 
+int heap_get_arena_numa_node(struct palloc_heap *heap, unsigned arena_id);
+
+unsigned heap_get_numa_nnodes(struct palloc_heap *heap);
+
+unsigned heap_get_numa_node_arenas(struct palloc_heap *heap, unsigned node,
+	size_t *nthreads);
+
 unsigned heap_get_procs(void);
 
 void heap_vg_open(struct palloc_heap *heap, object_callback cb,
@@ -25,6 +25,7 @@ extern "C" {
 #define HEAP_SIGNATURE_LEN 16
 #define HEAP_SIGNATURE "MEMORY_HEAP_HDR\0"
 #define ZONE_HEADER_MAGIC 0xC3F0A2D2
+#define ZONE_SUMMARY_MAGIC 0x5A53554D
 #define ZONE_MIN_SIZE (sizeof(struct zone) + sizeof(struct chunk))
 #define ZONE_MAX_SIZE (sizeof(struct zone) + sizeof(struct chunk) * MAX_CHUNK)
 #define HEAP_MIN_SIZE (sizeof(struct heap_layout) + ZONE_MIN_SIZE)
@@ -108,10 +109,23 @@ struct chunk_header {
 	uint32_t size_idx;
 };
 
+/*
+ * Hint about the free space in the zone, written when the zone is reclaimed
+ * and invalidated on the first deallocation from the zone. It is ignored
+ * if the magic or the checksum don't match.
+ */
+struct zone_summary {
+	uint32_t magic;
+	uint32_t free_runs; /* runs with at least one free block */
+	uint64_t free_chunks; /* free chunks, including ones of empty runs */
+	uint64_t checksum;
+};
+
 struct zone_header {
 	uint32_t magic;
 	uint32_t size_idx;
-	uint8_t reserved[56];
+	struct zone_summary summary;
+	uint8_t reserved[32];
 };
 
 struct zone {
@@ -13,15 +13,17 @@
 #include <inttypes.h>
 #include <errno.h>
 #include <limits.h>
-#include <sched.h>
 
 #include "libpmemobj.h"
 #include "critnib.h"
+#include "ctl.h"
 #include "lane.h"
 #include "core_assert.h"
 #include "util.h"
 #include "obj.h"
+#include "os.h"
 #include "os_thread.h"
+#include "sys_util.h"
 #include "valgrind_internal.h"
 #include "memops.h"
 #include "palloc.h"
@@ -33,6 +35,10 @@ static __thread struct critnib *Lane_info_ht;
 static __thread struct lane_info *Lane_info_records;
 static __thread struct lane_info *Lane_info_cache;
 
+unsigned Lane_recovery_parallel = 0;
+
+static void lane_undo_recover(PMEMobjpool *pop, unsigned nthreads);
+
 /*
  * lane_info_create -- (internal) constructor for thread shared data
  */
@@ -177,8 +183,11 @@ lane_ulog_constructor(void *base, void *ptr, size_t usable_size, void *arg)
  * lane_undo_extend -- allocates a new undo log
  */
 static int
-lane_undo_extend(void *base, uint64_t *redo, uint64_t gen_num)
+lane_undo_extend(void *base, uint64_t *redo, uint64_t gen_num, size_t size)
 {
+	/* suppress unused-parameter errors */
+	SUPPRESS_UNUSED(size);
+
 	PMEMobjpool *pop = base;
 	struct tx_parameters *params = pop->tx_params;
 	size_t s = SIZEOF_ALIGNED_ULOG(params->cache_size);
@@ -188,12 +197,14 @@ lane_undo_extend(void *base, uint64_t *redo, uint64_t gen_num)
 }
 
 /*
- * lane_redo_extend -- allocates a new redo log
+ * lane_redo_extend -- allocates a new redo log, large enough to hold the
+ *	requested number of bytes in one piece
  */
 static int
-lane_redo_extend(void *base, uint64_t *redo, uint64_t gen_num)
+lane_redo_extend(void *base, uint64_t *redo, uint64_t gen_num, size_t size)
 {
-	size_t s = SIZEOF_ALIGNED_ULOG(LANE_REDO_EXTERNAL_SIZE);
+	size_t s = SIZEOF_ALIGNED_ULOG(MAX(ALIGN_UP(size, CACHELINE_SIZE),
+		LANE_REDO_EXTERNAL_SIZE));
 
 	return pmalloc_construct(base, redo, s, lane_ulog_constructor, &gen_num,
 		0, OBJ_INTERNAL_OBJECT_MASK, 0);
@@ -269,8 +280,6 @@ lane_boot(PMEMobjpool *pop)
 		goto error_lanes_malloc;
 	}
 
-	pop->lanes_desc.next_lane_idx = 0;
-
 	pop->lanes_desc.lane_locks =
 		Zalloc(sizeof(*pop->lanes_desc.lane_locks) * pop->nlanes);
 	if (pop->lanes_desc.lane_locks == NULL) {
@@ -278,6 +287,20 @@ lane_boot(PMEMobjpool *pop)
 		goto error_locks_malloc;
 	}
 
+	pop->lanes_desc.ngroups = os_numa_nnodes();
+	pop->lanes_desc.group_next = Zalloc(sizeof(unsigned) *
+		pop->lanes_desc.ngroups);
+	if (pop->lanes_desc.group_next == NULL) {
+		err = ENOMEM;
+		ERR_W_ERRNO("Malloc for lane groups");
+		goto error_groups_malloc;
+	}
+
+	pop->lanes_desc.nwaiters = 0;
+	pop->lanes_desc.nreleases = 0;
+	util_mutex_init(&pop->lanes_desc.wait_lock);
+	util_cond_init(&pop->lanes_desc.wait_cond);
+
 	/* add lanes to pmemcheck ignored list */
 	VALGRIND_ADD_TO_GLOBAL_TX_IGNORE((char *)pop + pop->lanes_offset,
 		(sizeof(struct lane_layout) * pop->nlanes));
@@ -297,6 +320,11 @@ lane_boot(PMEMobjpool *pop)
 error_lane_init:
 	for (; i >= 1; --i)
 		lane_destroy(pop, &pop->lanes_desc.lane[i - 1]);
+	util_cond_destroy(&pop->lanes_desc.wait_cond);
+	util_mutex_destroy(&pop->lanes_desc.wait_lock);
+	Free(pop->lanes_desc.group_next);
+	pop->lanes_desc.group_next = NULL;
+error_groups_malloc:
 	Free(pop->lanes_desc.lane_locks);
 	pop->lanes_desc.lane_locks = NULL;
 error_locks_malloc:
@@ -342,6 +370,11 @@ lane_cleanup(PMEMobjpool *pop)
 	pop->lanes_desc.lane = NULL;
 	Free(pop->lanes_desc.lane_locks);
 	pop->lanes_desc.lane_locks = NULL;
+	Free(pop->lanes_desc.group_next);
+	pop->lanes_desc.group_next = NULL;
+
+	util_cond_destroy(&pop->lanes_desc.wait_cond);
+	util_mutex_destroy(&pop->lanes_desc.wait_lock);
 
 	lane_info_cleanup(pop);
 }
@@ -381,13 +414,7 @@ lane_recover_and_section_boot(PMEMobjpool *pop)
 	 * Undo logs must be processed after the heap is initialized since
 	 * a undo recovery might require deallocation of the next ulogs.
 	 */
-	for (i = 0; i < pop->nlanes; ++i) {
-		struct operation_context *ctx = pop->lanes_desc.lane[i].undo;
-		operation_resume(ctx);
-		operation_process(ctx);
-		operation_finish(ctx, ULOG_INC_FIRST_GEN_NUM |
-				ULOG_FREE_AFTER_FIRST);
-	}
+	lane_undo_recover(pop, Lane_recovery_parallel);
 
 	return 0;
 }
@@ -426,38 +453,129 @@ lane_check(PMEMobjpool *pop)
 }
 
 /*
- * get_lane -- (internal) get free lane index
+ * lane_try_acquire -- (internal) looks for a free lane, starting from the
+ *	primary one, returns 0 if all the lanes are busy
+ */
+static inline int
+lane_try_acquire(uint64_t *locks, struct lane_info *info, uint64_t nlocks)
+{
+	for (uint64_t i = 0; i < nlocks; ++i) {
+		info->lane_idx = (info->primary + i) % nlocks;
+		if (likely(util_bool_compare_and_swap64(
+				&locks[info->lane_idx], 0, 1))) {
+			if (info->lane_idx == info->primary) {
+				info->primary_attempts =
+					LANE_PRIMARY_ATTEMPTS;
+			} else if (info->primary_attempts == 0) {
+				info->primary = info->lane_idx;
+				info->primary_attempts =
+					LANE_PRIMARY_ATTEMPTS;
+			}
+			return 1;
+		}
+
+		if (info->lane_idx == info->primary &&
+				info->primary_attempts > 0) {
+			info->primary_attempts--;
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * get_lane -- (internal) get free lane index, waits for one of the lanes to
+ *	be released if all of them are busy
  */
 static inline void
-get_lane(uint64_t *locks, struct lane_info *info, uint64_t nlocks)
+get_lane(struct lane_descriptor *ld, struct lane_info *info)
 {
-	info->lane_idx = info->primary;
+	if (likely(lane_try_acquire(ld->lane_locks, info,
+			ld->runtime_nlanes)))
+		return;
+
+	/*
+	 * The releasing thread checks the number of waiters after freeing the
+	 * lane, so either it sees this thread as a waiter or the scan below
+	 * sees the lane as free.
+	 */
+	util_fetch_and_add32(&ld->nwaiters, 1);
+
 	while (1) {
-		do {
-			info->lane_idx %= nlocks;
-			if (likely(util_bool_compare_and_swap64(
-					&locks[info->lane_idx], 0, 1))) {
-				if (info->lane_idx == info->primary) {
-					info->primary_attempts =
-						LANE_PRIMARY_ATTEMPTS;
-				} else if (info->primary_attempts == 0) {
-					info->primary = info->lane_idx;
-					info->primary_attempts =
-						LANE_PRIMARY_ATTEMPTS;
-				}
-				return;
-			}
+		util_mutex_lock(&ld->wait_lock);
+		uint64_t nreleases = ld->nreleases;
+		util_mutex_unlock(&ld->wait_lock);
 
-			if (info->lane_idx == info->primary &&
-					info->primary_attempts > 0) {
-				info->primary_attempts--;
-			}
+		if (lane_try_acquire(ld->lane_locks, info, ld->runtime_nlanes))
+			break;
+
+		util_mutex_lock(&ld->wait_lock);
+		while (ld->nreleases == nreleases)
+			os_cond_wait(&ld->wait_cond, &ld->wait_lock);
+		util_mutex_unlock(&ld->wait_lock);
+	}
 
-			++info->lane_idx;
-		} while (info->lane_idx < nlocks);
+	util_fetch_and_sub32(&ld->nwaiters, 1);
+}
 
-		sched_yield();
+/*
+ * put_lane -- (internal) frees the lane and wakes up one of the threads
+ *	waiting for a lane, if there are any
+ */
+static inline void
+put_lane(struct lane_descriptor *ld, uint64_t lane_idx)
+{
+	if (unlikely(!util_bool_compare_and_swap64(
+			&ld->lane_locks[lane_idx], 1, 0))) {
+		CORE_LOG_FATAL("util_bool_compare_and_swap64");
 	}
+
+	unsigned nwaiters;
+	util_atomic_load_explicit32(&ld->nwaiters, &nwaiters,
+		memory_order_seq_cst);
+	if (likely(nwaiters == 0))
+		return;
+
+	util_mutex_lock(&ld->wait_lock);
+	ld->nreleases++;
+	os_cond_signal(&ld->wait_cond);
+	util_mutex_unlock(&ld->wait_lock);
+}
+
+/*
+ * lane_primary_assign -- (internal) picks the primary lane for a thread from
+ *	the group of the NUMA node the thread runs on
+ *
+ * Consecutive threads of a group get lanes LANE_JUMP apart, so that their
+ * locks do not share cache lines, and every lane of the group is handed out
+ * once before any of them is handed out again.
+ */
+static uint64_t
+lane_primary_assign(struct lane_descriptor *ld)
+{
+	unsigned nlanes = ld->runtime_nlanes;
+	unsigned group = 0;
+	unsigned node;
+
+	if (ld->ngroups > 1 && os_getcpu_node(&node) == 0)
+		group = node % ld->ngroups;
+
+	unsigned first = (unsigned)((uint64_t)group * nlanes / ld->ngroups);
+	unsigned last = (unsigned)((uint64_t)(group + 1) * nlanes /
+		ld->ngroups);
+	if (first == last) {
+		/* fewer lanes than groups, share all of them */
+		first = 0;
+		last = nlanes;
+	}
+
+	unsigned size = last - first;
+	unsigned stride = size / LANE_JUMP;
+	unsigned k = util_fetch_and_add32(&ld->group_next[group], 1) % size;
+	if (k < stride * LANE_JUMP)
+		k = (k % stride) * (unsigned)LANE_JUMP + k / stride;
+
+	return first + k;
 }
 
 /*
@@ -506,22 +624,116 @@ get_lane_info_record(PMEMobjpool *pop)
 }
 
 /*
- * lane_hold -- grabs a per-thread lane in a round-robin fashion
+ * State shared by the threads recovering the undo logs in parallel.
+ */
+struct lane_undo_recovery {
+	PMEMobjpool *pop;
+	uint64_t next_lane;
+};
+
+/*
+ * lane_undo_recover_worker -- (internal) recovers the undo logs of the lanes
+ *	until there are none left
+ *
+ * The thread holds the lane it recovers, so that the extensions of the undo
+ * log are freed through the redo log of the same lane, and not of a lane
+ * that is being recovered by another thread.
+ */
+static void *
+lane_undo_recover_worker(void *arg)
+{
+	struct lane_undo_recovery *r = arg;
+	PMEMobjpool *pop = r->pop;
+	struct lane_info *info = get_lane_info_record(pop);
+
+	ASSERTeq(info->nest_count, 0);
+	uint64_t lane_idx = info->lane_idx;
+
+	for (;;) {
+		uint64_t i = util_fetch_and_add64(&r->next_lane, 1);
+		if (i >= pop->nlanes)
+			break;
+
+		if (unlikely(!util_bool_compare_and_swap64(
+				&pop->lanes_desc.lane_locks[i], 0, 1))) {
+			CORE_LOG_FATAL("util_bool_compare_and_swap64");
+		}
+		info->lane_idx = i;
+		info->nest_count = 1;
+
+		struct operation_context *ctx = pop->lanes_desc.lane[i].undo;
+		operation_resume(ctx);
+		operation_process(ctx);
+		operation_finish(ctx, ULOG_INC_FIRST_GEN_NUM |
+				ULOG_FREE_AFTER_FIRST);
+
+		info->nest_count = 0;
+		put_lane(&pop->lanes_desc, i);
+	}
+
+	info->lane_idx = lane_idx;
+
+	return NULL;
+}
+
+/*
+ * lane_undo_recover -- (internal) recovers the undo logs of all the lanes
+ *	using the given number of threads, including the calling one
+ *
+ * The lanes are independent, and the heap the extensions of the undo logs
+ * are freed to is already booted and thread-safe.
+ */
+static void
+lane_undo_recover(PMEMobjpool *pop, unsigned nthreads)
+{
+	struct lane_undo_recovery r = {
+		.pop = pop,
+		.next_lane = 0,
+	};
+
+	nthreads = (unsigned)MIN(nthreads, pop->nlanes);
+	if (nthreads <= 1) {
+		lane_undo_recover_worker(&r);
+		return;
+	}
+
+	os_thread_t *threads = Malloc(sizeof(os_thread_t) * (nthreads - 1));
+
+	/* if the threads can't be created, the lanes are recovered anyway */
+	unsigned nstarted = 0;
+	for (unsigned i = 0; threads != NULL && i < nthreads - 1; ++i) {
+		if (os_thread_create(&threads[i], NULL,
+			lane_undo_recover_worker, &r) != 0) {
+			CORE_LOG_WARNING("failed to create a recovery thread, "
+				"continuing with %u", nstarted + 1);
+			break;
+		}
+		nstarted++;
+	}
+
+	lane_undo_recover_worker(&r);
+
+	for (unsigned i = 0; i < nstarted; ++i)
+		os_thread_join(&threads[i], NULL);
+
+	Free(threads);
+}
+
+/*
+ * lane_hold -- grabs a per-thread lane, the primary one if it is free
  */
 unsigned
 lane_hold(PMEMobjpool *pop, struct lane **lanep)
 {
 	struct lane_info *lane = get_lane_info_record(pop);
-	while (unlikely(lane->lane_idx == UINT64_MAX)) {
-		/* initial wrap to next CL */
-		lane->primary = lane->lane_idx = util_fetch_and_add32(
-			&pop->lanes_desc.next_lane_idx, LANE_JUMP);
-	} /* handles wraparound */
+	if (unlikely(lane->lane_idx == UINT64_MAX)) {
+		lane->primary = lane->lane_idx =
+			lane_primary_assign(&pop->lanes_desc);
+	}
 
-	uint64_t *llocks = pop->lanes_desc.lane_locks;
 	/* grab next free lane from lanes available at runtime */
 	if (!lane->nest_count++) {
-		get_lane(llocks, lane, pop->lanes_desc.runtime_nlanes);
+		get_lane(&pop->lanes_desc, lane);
 	}
 
 	struct lane *l = &pop->lanes_desc.lane[lane->lane_idx];
@@ -555,10 +767,103 @@ lane_release(PMEMobjpool *pop)
 	if (unlikely(lane->nest_count == 0)) {
 		CORE_LOG_FATAL("lane_release");
 	} else if (--(lane->nest_count) == 0) {
-		if (unlikely(!util_bool_compare_and_swap64(
-				&pop->lanes_desc.lane_locks[lane->lane_idx],
-				1, 0))) {
-			CORE_LOG_FATAL("util_bool_compare_and_swap64");
-		}
+		put_lane(&pop->lanes_desc, lane->lane_idx);
+	}
+}
+
+/*
+ * lane_detach -- hands the lane held by the calling thread over to
+ *	lane_release_detached, which might be called from a different thread,
+ *	fails if the calling thread holds the lane more than once
+ */
+int
+lane_detach(PMEMobjpool *pop, unsigned *lane_idx)
+{
+	struct lane_info *lane = get_lane_info_record(pop);
+
+	ASSERTne(lane, NULL);
+	ASSERTne(lane->lane_idx, UINT64_MAX);
+
+	if (lane->nest_count != 1)
+		return -1;
+
+	lane->nest_count = 0;
+	*lane_idx = (unsigned)lane->lane_idx;
+
+	return 0;
+}
+
+/*
+ * lane_release_detached -- drops the lane handed over by lane_detach
+ */
+void
+lane_release_detached(PMEMobjpool *pop, unsigned lane_idx)
+{
+	put_lane(&pop->lanes_desc, lane_idx);
+}
+
+/*
+ * CTL_READ_HANDLER(parallel) -- reads the number of threads recovering the
+ *	undo logs of the lanes when a pool is opened
+ */
+static int
+CTL_READ_HANDLER(parallel)(void *ctx,
+	enum ctl_query_source source, void *arg, struct ctl_indexes *indexes)
+{
+	/* suppress unused-parameter errors */
+	SUPPRESS_UNUSED(ctx, source, indexes);
+
+	unsigned *nthreads = arg;
+
+	*nthreads = Lane_recovery_parallel;
+
+	return 0;
+}
+
+/*
+ * CTL_WRITE_HANDLER(parallel) -- sets the number of threads recovering the
+ *	undo logs of the lanes when a pool is opened
+ */
+static int
+CTL_WRITE_HANDLER(parallel)(void *ctx,
+	enum ctl_query_source source, void *arg, struct ctl_indexes *indexes)
+{
+	/* suppress unused-parameter errors */
+	SUPPRESS_UNUSED(ctx, source, indexes);
+
+	unsigned nthreads = *(unsigned *)arg;
+
+	if (nthreads > LANE_RECOVERY_MAX_THREADS) {
+		ERR_WO_ERRNO("number of recovery threads can't exceed %u",
+			LANE_RECOVERY_MAX_THREADS);
+		errno = EINVAL;
+		return -1;
 	}
+
+	Lane_recovery_parallel = nthreads;
+
+	return 0;
+}
+
+static const struct ctl_argument CTL_ARG(parallel) = CTL_ARG_LONG_LONG;
+
+static const struct ctl_node CTL_NODE(recovery)[] = {
+	CTL_LEAF_RW(parallel),
+
+	CTL_NODE_END
+};
+
+static const struct ctl_node CTL_NODE(lane)[] = {
+	CTL_CHILD(recovery),
+
+	CTL_NODE_END
+};
+
+/*
+ * lane_global_ctl_register -- registers the global ctl entries of lanes
+ */
+void
+lane_global_ctl_register(void)
+{
+	CTL_REGISTER_MODULE(NULL, lane);
 }
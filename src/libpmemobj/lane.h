@@ -11,6 +11,7 @@
 #include <stdint.h>
 #include "ulog.h"
 #include "libpmemobj.h"
+#include "os_thread.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -32,6 +33,9 @@ extern "C" {
 
 #define RLANE_DEFAULT 0
 
+/* maximum number of threads recovering the lanes when a pool is opened */
+#define LANE_RECOVERY_MAX_THREADS (1 << 10)
+
 #define LANE_TOTAL_SIZE 3072 /* 3 * 1024 (sum of 3 old lane sections) */
 /*
  * We have 3 kilobytes to distribute.
@@ -94,9 +98,27 @@ struct lane_descriptor {
 	 * other resources e.g. available RNIC's submission queue sizes.
 	 */
 	unsigned runtime_nlanes;
-	unsigned next_lane_idx;
+
+	/*
+	 * The lanes available at runtime are split into one contiguous group
+	 * per NUMA node, and threads get their primary lanes assigned from the
+	 * group of the node they run on. Each group has its own counter of
+	 * assigned primary lanes.
+	 */
+	unsigned ngroups;
+	unsigned *group_next;
+
 	uint64_t *lane_locks;
 	struct lane *lane;
+
+	/*
+	 * Threads that found all the lanes busy sleep on the condition
+	 * variable until one of the lanes is released.
+	 */
+	unsigned nwaiters;
+	uint64_t nreleases;
+	os_mutex_t wait_lock;
+	os_cond_t wait_cond;
 };
 
 typedef int (*section_layout_op)(PMEMobjpool *pop, void *data, unsigned length);
@@ -129,6 +151,10 @@ struct lane_info {
 	struct lane_info *prev, *next;
 };
 
+extern unsigned Lane_recovery_parallel;
+
+void lane_global_ctl_register(void);
+
 void lane_info_boot(void);
 void lane_info_destroy(void);
 
@@ -141,6 +167,8 @@ int lane_check(PMEMobjpool *pop);
 
 unsigned lane_hold(PMEMobjpool *pop, struct lane **lane);
 void lane_release(PMEMobjpool *pop);
+int lane_detach(PMEMobjpool *pop, unsigned *lane_idx);
+void lane_release_detached(PMEMobjpool *pop, unsigned lane_idx);
 
 #ifdef __cplusplus
 }
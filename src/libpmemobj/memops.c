@@ -25,6 +25,9 @@
 
 #define OP_MERGE_SEARCH 64
 
+/* the high-water mark of the use of next ulogs loses 1/16 per operation */
+#define ULOG_RETAIN_DECAY_SHIFT 4
+
 enum operation_state {
 	OPERATION_IDLE,
 	OPERATION_IN_PROGRESS,
@@ -61,6 +64,9 @@ struct operation_context {
 	size_t ulog_capacity; /* sum of capacity, incl all next ulog logs */
 	int ulog_auto_reserve; /* allow or do not to auto ulog reservation */
 	int ulog_any_user_buffer; /* set if any user buffer is added */
+	size_t ulog_retain; /* max capacity of next logs kept for reuse */
+	size_t ulog_retain_hwm; /* high-water mark of the use of next logs */
+	size_t ulog_nt_threshold; /* min size of buffers streamed to the log */
 
 	struct ulog_next next; /* vector of 'next' fields of persistent ulog */
 
@@ -421,11 +427,13 @@ operation_add_entry(struct operation_context *ctx, void *ptr, uint64_t value,
 }
 
 /*
- * operation_add_buffer -- adds a buffer operation to the log
+ * operation_add_buffer_entries -- (internal) adds a buffer operation to the
+ *	log, as one entry per persistent log it spans
  */
-int
-operation_add_buffer(struct operation_context *ctx,
-	void *dest, void *src, size_t size, ulog_operation_type type)
+static int
+operation_add_buffer_entries(struct operation_context *ctx,
+	void *dest, void *src, size_t size, ulog_operation_type type,
+	int nontemporal)
 {
 	size_t real_size = size + sizeof(struct ulog_entry_buf);
 
@@ -472,7 +480,7 @@ operation_add_buffer(struct operation_context *ctx,
 		ctx->ulog_curr_offset,
 		ctx->ulog_curr_gen_num,
 		dest, src, data_size,
-		type, ctx->p_ops);
+		type, nontemporal, ctx->p_ops);
 	ASSERT(entry_size == ulog_entry_size(&e->base));
 	ASSERT(entry_size <= ctx->ulog_curr_capacity);
 
@@ -484,10 +492,116 @@ operation_add_buffer(struct operation_context *ctx,
 	 * Recursively add the data to the log until the entire buffer is
 	 * processed.
 	 */
-	return size - data_size == 0 ? 0 : operation_add_buffer(ctx,
+	return size - data_size == 0 ? 0 : operation_add_buffer_entries(ctx,
 			(char *)dest + data_size,
 			(char *)src + data_size,
-			size - data_size, type);
+			size - data_size, type, nontemporal);
+}
+
+/*
+ * operation_add_buffer -- adds a buffer operation to the log
+ */
+int
+operation_add_buffer(struct operation_context *ctx,
+	void *dest, void *src, size_t size, ulog_operation_type type)
+{
+	return operation_add_buffer_entries(ctx, dest, src, size, type,
+		size >= ctx->ulog_nt_threshold);
+}
+
+/*
+ * operation_log_grow -- (internal) makes sure that the DRAM log has room for
+ *	the given number of bytes, plus the spare cacheline
+ */
+static int
+operation_log_grow(struct operation_context *ctx,
+	struct operation_log *oplog, size_t nbytes)
+{
+	if (nbytes + CACHELINE_SIZE <= oplog->capacity)
+		return 0;
+
+	size_t ncapacity = ALIGN_UP(nbytes + CACHELINE_SIZE,
+		(size_t)ULOG_BASE_SIZE);
+	struct ulog *ulog = Realloc(oplog->ulog, SIZEOF_ULOG(ncapacity));
+	if (ulog == NULL)
+		return -1;
+	oplog->capacity = ncapacity;
+	oplog->ulog = ulog;
+	oplog->ulog->capacity = oplog->capacity;
+
+	/* same as in operation_add_typed_entry */
+	VECQ_CLEAR(&ctx->merge_entries);
+
+	return 0;
+}
+
+/*
+ * operation_log_end -- (internal) returns the offset at which ends the
+ *	persistent log that is going to store the given offset of the shadow log
+ */
+static size_t
+operation_log_end(struct operation_context *ctx, size_t offset)
+{
+	size_t end = ctx->ulog_base_nbytes;
+
+	uint64_t next;
+	VEC_FOREACH(next, &ctx->next) {
+		if (offset < end)
+			break;
+
+		end += ulog_by_offset(next, ctx->p_ops)->capacity;
+	}
+
+	return end;
+}
+
+/*
+ * operation_add_shadow_buffer -- adds a buffer operation to the shadow copy
+ *	of the persistent redo log
+ *
+ * The ulog_store function copies the shadow log into the persistent logs
+ * byte by byte, and so an entry that would straddle two of them is split
+ * into two entries. Since all the buffer entries are cacheline aligned, this
+ * never leaves a gap in the log, as long as all of them are added before any
+ * of the value entries. The space has to be reserved beforehand with
+ * operation_reserve_buffers.
+ */
+void
+operation_add_shadow_buffer(struct operation_context *ctx,
+	void *dest, const void *src, size_t size, ulog_operation_type type)
+{
+	struct operation_log *oplog = &ctx->pshadow_ops;
+
+	ASSERTeq(ctx->type, LOG_TYPE_REDO);
+	ASSERTeq(oplog->offset % CACHELINE_SIZE, 0);
+
+	while (size != 0) {
+		size_t end = operation_log_end(ctx, oplog->offset);
+		ASSERT(end > oplog->offset);
+
+		size_t data_size = MIN(size,
+			end - oplog->offset - sizeof(struct ulog_entry_buf));
+		size_t entry_size = ALIGN_UP(
+			sizeof(struct ulog_entry_buf) + data_size,
+			CACHELINE_SIZE);
+
+		int ret = operation_log_grow(ctx, oplog,
+			oplog->offset + entry_size);
+		ASSERTeq(ret, 0);
+		SUPPRESS_UNUSED(ret);
+
+		ulog_entry_buf_create_shadow(oplog->ulog, oplog->offset,
+			dest, src, data_size, type, &ctx->s_ops);
+
+		oplog->offset += entry_size;
+
+		/* terminates the log, see ulog_store */
+		memset(oplog->ulog->data + oplog->offset, 0, CACHELINE_SIZE);
+
+		dest = (char *)dest + data_size;
+		src = (char *)src + data_size;
+		size -= data_size;
+	}
 }
 
 /*
@@ -630,6 +744,43 @@ operation_set_auto_reserve(struct operation_context *ctx, int auto_reserve)
 	ctx->ulog_auto_reserve = auto_reserve;
 }
 
+/*
+ * operation_set_retain -- sets the maximum capacity of the next ulogs that
+ *	the undo log keeps for the following operations
+ */
+void
+operation_set_retain(struct operation_context *ctx, size_t retain)
+{
+	ctx->ulog_retain = retain;
+}
+
+/*
+ * operation_set_nt_threshold -- sets the minimum size of the buffers that are
+ *	written to the log with non-temporal stores
+ */
+void
+operation_set_nt_threshold(struct operation_context *ctx, size_t threshold)
+{
+	ctx->ulog_nt_threshold = threshold;
+}
+
+/*
+ * operation_retain_update -- (internal) updates the high-water mark of the
+ *	use of the next ulogs and returns the capacity of them to keep
+ */
+static size_t
+operation_retain_update(struct operation_context *ctx)
+{
+	size_t used = ctx->total_logged > ctx->ulog_base_nbytes ?
+		ctx->total_logged - ctx->ulog_base_nbytes : 0;
+
+	/* follow the growth immediately, but let the mark decay slowly */
+	ctx->ulog_retain_hwm -= ctx->ulog_retain_hwm >> ULOG_RETAIN_DECAY_SHIFT;
+	ctx->ulog_retain_hwm = MAX(ctx->ulog_retain_hwm, used);
+
+	return MIN(ctx->ulog_retain_hwm, ctx->ulog_retain);
+}
+
 /*
  * operation_set_any_user_buffer -- set ulog_any_user_buffer value for context
  */
@@ -704,6 +855,41 @@ operation_reserve(struct operation_context *ctx, size_t new_capacity)
 	return 0;
 }
 
+/*
+ * operation_reserve_buffers -- reserves the log space for 'buf_nbytes' of
+ *	buffer entries added with operation_add_shadow_buffer, followed by
+ *	'nbytes' of value entries, 'user_nbytes' is the capacity of the user
+ *	buffers that are going to be added to the log before it's used
+ */
+int
+operation_reserve_buffers(struct operation_context *ctx, size_t buf_nbytes,
+	size_t nbytes, size_t user_nbytes)
+{
+	/*
+	 * Each boundary between two logs might split a buffer entry, which
+	 * costs at most one additional cacheline. Reserving more space might
+	 * add a log, and with it a boundary, hence the loop.
+	 */
+	size_t nlogs;
+	size_t split_nbytes;
+	do {
+		nlogs = VEC_SIZE(&ctx->next);
+		split_nbytes = buf_nbytes + nlogs * CACHELINE_SIZE;
+
+		size_t total = split_nbytes + nbytes;
+		total -= MIN(user_nbytes, total);
+
+		if (operation_reserve(ctx, total) != 0)
+			return -1;
+	} while (VEC_SIZE(&ctx->next) != nlogs);
+
+	/* the shadow log of the buffer entries must not be reallocated later */
+	if (operation_log_grow(ctx, &ctx->pshadow_ops, split_nbytes) != 0)
+		return -1;
+
+	return 0;
+}
+
 /*
  * operation_init -- initializes runtime state of an operation
  */
@@ -832,7 +1018,7 @@ operation_finish(struct operation_context *ctx, unsigned flags)
 		int ret = ulog_clobber_data(ctx->ulog,
 			&ctx->next, ctx->ulog_free,
 			operation_user_buffer_remove,
-			ctx->p_ops, flags);
+			ctx->p_ops, operation_retain_update(ctx), flags);
 		if (ret == 0)
 			goto out;
 	} else if (ctx->type == LOG_TYPE_REDO) {
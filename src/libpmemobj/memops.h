@@ -58,6 +58,8 @@ void operation_free_logs(struct operation_context *ctx, uint64_t flags);
 
 int operation_add_buffer(struct operation_context *ctx,
 	void *dest, void *src, size_t size, ulog_operation_type type);
+void operation_add_shadow_buffer(struct operation_context *ctx,
+	void *dest, const void *src, size_t size, ulog_operation_type type);
 
 int operation_add_entry(struct operation_context *ctx,
 	void *ptr, uint64_t value, ulog_operation_type type);
@@ -70,12 +72,17 @@ void operation_add_user_buffer(struct operation_context *ctx,
 		struct user_buffer_def *userbuf);
 void operation_set_auto_reserve(struct operation_context *ctx,
 		int auto_reserve);
+void operation_set_retain(struct operation_context *ctx, size_t retain);
+void operation_set_nt_threshold(struct operation_context *ctx,
+	size_t threshold);
 void operation_set_any_user_buffer(struct operation_context *ctx,
 	int any_user_buffer);
 int operation_get_any_user_buffer(struct operation_context *ctx);
 int operation_user_buffer_range_cmp(const void *lhs, const void *rhs);
 
 int operation_reserve(struct operation_context *ctx, size_t new_capacity);
+int operation_reserve_buffers(struct operation_context *ctx,
+	size_t buf_nbytes, size_t nbytes, size_t user_nbytes);
 void operation_process(struct operation_context *ctx);
 void operation_finish(struct operation_context *ctx, unsigned flags);
 void operation_cancel(struct operation_context *ctx);
@@ -206,6 +206,7 @@ obj_init(void)
 	 */
 	ctl_global_register();
 	pmalloc_global_ctl_register();
+	lane_global_ctl_register();
 
 	if (obj_ctl_init_and_load(NULL))
 		CORE_LOG_FATAL("error: %s", pmemobj_errormsg());
@@ -935,6 +936,9 @@ obj_runtime_init(PMEMobjpool *pop, int rdonly, int boot, unsigned nlanes)
 
 	pop->user_data = NULL;
 
+	pop->defrag.enumerate = NULL;
+	pop->defrag.arg = NULL;
+
 	VALGRIND_REMOVE_PMEM_MAPPING(&pop->mutex_head,
 		sizeof(pop->mutex_head));
 	VALGRIND_REMOVE_PMEM_MAPPING(&pop->rwlock_head,
@@ -1506,6 +1510,10 @@ obj_pool_cleanup(PMEMobjpool *pop)
 {
 	LOG(3, "pop %p", pop);
 
+	/* the workers use the pool's runtime state, which is destroyed below */
+	tx_post_commit_stop(pop);
+	palloc_heap_reclaim_stop(&pop->heap);
+
 	ravl_delete(pop->ulog_user_buffers.map);
 	util_mutex_destroy(&pop->ulog_user_buffers.lock);
 
@@ -2584,6 +2592,39 @@ pmemobj_xreserve(PMEMobjpool *pop, struct pobj_action *act,
 	return oid;
 }
 
+/*
+ * pmemobj_xreserve_bulk -- reserves multiple objects of the same size
+ */
+int
+pmemobj_xreserve_bulk(PMEMobjpool *pop, struct pobj_action *actv,
+	size_t actvcnt, size_t size, uint64_t type_num, uint64_t flags)
+{
+	LOG(3, "pop %p actv %p actvcnt %zu size %zu type_num %llx flags %llx",
+		pop, actv, actvcnt, size,
+		(unsigned long long)type_num, (unsigned long long)flags);
+
+	if (flags & ~POBJ_ACTION_XRESERVE_VALID_FLAGS) {
+		ERR_WO_ERRNO("unknown flags 0x%" PRIx64,
+				flags & ~POBJ_ACTION_XRESERVE_VALID_FLAGS);
+		errno = EINVAL;
+		return -1;
+	}
+
+	PMEMOBJ_API_START();
+	struct constr_args carg;
+
+	carg.zero_init = flags & POBJ_FLAG_ZERO;
+	carg.constructor = NULL;
+	carg.arg = NULL;
+
+	int ret = palloc_reserve_bulk(&pop->heap, size, constructor_alloc,
+		&carg, type_num, 0, CLASS_ID_FROM_FLAG(flags),
+		ARENA_ID_FROM_FLAG(flags), actv, actvcnt);
+
+	PMEMOBJ_API_END();
+	return ret;
+}
+
 /*
  * pmemobj_set_value -- creates an action to set a value
  */
@@ -2686,6 +2727,103 @@ out:
 	return ret;
 }
 
+/*
+ * pmemobj_defrag_register -- registers the callback that enumerates all
+ *	pointers to the objects in the pool
+ */
+int
+pmemobj_defrag_register(PMEMobjpool *pop, pmemobj_defrag_enum enumerate,
+	void *arg)
+{
+	LOG(3, "pop %p enumerate %p arg %p", pop, enumerate, arg);
+
+	PMEMOBJ_API_START();
+
+	pop->defrag.enumerate = enumerate;
+	pop->defrag.arg = arg;
+
+	PMEMOBJ_API_END();
+	return 0;
+}
+
+struct obj_defrag_visit_arg {
+	PMEMobjpool *pop;
+	palloc_defrag_visit_fn visit;
+	void *visit_arg;
+};
+
+/*
+ * obj_defrag_visit -- (internal) passes the offset of a pointer to an object
+ *	in the pool to the allocator
+ */
+static void
+obj_defrag_visit(PMEMoid *oidp, void *arg)
+{
+	struct obj_defrag_visit_arg *v = arg;
+
+	/* pointers to other pools are not relocated */
+	if (OID_IS_NULL(*oidp) || oidp->pool_uuid_lo != v->pop->uuid_lo)
+		return;
+
+	v->visit(&oidp->off, v->visit_arg);
+}
+
+/*
+ * obj_defrag_enumerate -- (internal) calls the registered pointer enumeration
+ *	callback
+ */
+static int
+obj_defrag_enumerate(palloc_defrag_visit_fn visit, void *visit_arg,
+	void *arg)
+{
+	PMEMobjpool *pop = arg;
+	struct obj_defrag_visit_arg v = {pop, visit, visit_arg};
+
+	return pop->defrag.enumerate(pop, obj_defrag_visit, &v,
+		pop->defrag.arg);
+}
+
+/*
+ * pmemobj_defrag_step -- moves the objects out of at most max_runs of
+ *	the sparsest runs of the heap
+ */
+int
+pmemobj_defrag_step(PMEMobjpool *pop, size_t max_runs,
+	struct pobj_defrag_result *result)
+{
+	LOG(3, "pop %p max_runs %zu", pop, max_runs);
+
+	PMEMOBJ_API_START();
+
+	if (result) {
+		result->relocated = 0;
+		result->total = 0;
+	}
+
+	int ret = 0;
+
+	if (pop->defrag.enumerate == NULL) {
+		ERR_WO_ERRNO("no pointer enumeration callback registered");
+		errno = EINVAL;
+		ret = -1;
+		goto out;
+	}
+
+	if (max_runs == 0)
+		goto out;
+
+	struct operation_context *ctx = pmalloc_operation_hold(pop);
+
+	ret = palloc_defrag_step(&pop->heap, max_runs, obj_defrag_enumerate,
+		pop, ctx, result);
+
+	pmalloc_operation_release(pop);
+
+out:
+	PMEMOBJ_API_END();
+	return ret;
+}
+
 /*
  * pmemobj_list_insert -- adds object to a list
  */
@@ -92,7 +92,7 @@ typedef uint64_t type_num_t;
 #define CONVERSION_FLAG_OLD_SET_CACHE ((1ULL) << 0)
 
 /* PMEM_OBJ_POOL_HEAD_SIZE Without the unused and unused2 arrays */
-#define PMEM_OBJ_POOL_HEAD_SIZE 2110
+#define PMEM_OBJ_POOL_HEAD_SIZE 2246
 #define PMEM_OBJ_POOL_UNUSED2_SIZE (PMEM_PAGESIZE \
 					- OBJ_DSC_P_UNUSED\
 					- PMEM_OBJ_POOL_HEAD_SIZE)
@@ -185,6 +185,12 @@ struct pmemobjpool {
 
 	void *user_data;
 
+	/* pointer enumeration callback of the incremental defragmentation */
+	struct {
+		pmemobj_defrag_enum enumerate;
+		void *arg;
+	} defrag;
+
 	/* padding to align size of this structure to page boundary */
 	/* sizeof(unused2) == 8192 - offsetof(struct pmemobjpool, unused2) */
 	char unused2[PMEM_OBJ_POOL_UNUSED2_SIZE];
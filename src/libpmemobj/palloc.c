@@ -42,6 +42,7 @@
 #include "sys_util.h"
 #include "palloc.h"
 #include "ravl.h"
+#include "tcache.h"
 #include "vec.h"
 
 struct pobj_action_internal {
@@ -159,33 +160,94 @@ alloc_prep_block(struct palloc_heap *heap, const struct memory_block *m,
 }
 
 /*
- * palloc_reservation_create -- creates a volatile reservation of a
- *	memory block.
- *
- * The first step in the allocation of a new block is reserving it in
- * the transient heap - which is represented by the bucket abstraction.
- *
- * To provide optimal scaling for multi-threaded applications and reduce
- * fragmentation the appropriate bucket is chosen depending on the
- * current thread context and to which allocation class the requested
- * size falls into.
- *
- * Once the bucket is selected, just enough memory is reserved for the
- * requested size. The underlying block allocation algorithm
- * (best-fit, next-fit, ...) varies depending on the bucket container.
+ * palloc_reservation_create_cached -- (internal) creates a volatile
+ *	reservation of a single-unit memory block taken from the thread cache
  */
 static int
-palloc_reservation_create(struct palloc_heap *heap, size_t size,
+palloc_reservation_create_cached(struct palloc_heap *heap,
+	struct heap_tcache *tc, struct alloc_class *c,
 	palloc_constr constructor, void *arg,
 	uint64_t extra_field, uint16_t object_flags,
-	uint16_t class_id, uint16_t arena_id,
 	struct pobj_action_internal *out)
 {
-	int err = 0;
+	struct memory_block *new_block = &out->m;
+
+	/*
+	 * Blocks in the thread cache are already reserved, including the
+	 * reference on the run they originate from.
+	 */
+	int err = tcache_get(tc, c, new_block, &out->mresv);
+	if (err != 0) {
+		errno = err;
+		return -1;
+	}
+
+	if (alloc_prep_block(heap, new_block, constructor, arg,
+		extra_field, object_flags, out) != 0) {
+		tcache_put(tc, c, new_block, out->mresv);
+		errno = ECANCELED;
+		return -1;
+	}
+
+	out->lock = new_block->m_ops->get_lock(new_block);
+	out->new_state = MEMBLOCK_ALLOCATED;
+
+	return 0;
+}
 
+static void palloc_reservation_clear(struct palloc_heap *heap,
+	struct pobj_action_internal *act, int publish);
+
+/*
+ * palloc_reservation_create_lockfree -- (internal) creates a volatile
+ *	reservation of a memory block claimed from the active run of a bucket
+ *	without acquiring the bucket lock
+ */
+static int
+palloc_reservation_create_lockfree(struct palloc_heap *heap,
+	struct alloc_class *c, uint32_t size_idx, uint16_t arena_id,
+	palloc_constr constructor, void *arg,
+	uint64_t extra_field, uint16_t object_flags,
+	struct pobj_action_internal *out)
+{
 	struct memory_block *new_block = &out->m;
-	out->type = POBJ_ACTION_TYPE_HEAP;
+	struct bucket_locked *locked =
+		heap_bucket_locked(heap, c->id, arena_id);
+
+	if (bucket_lockfree_alloc(locked, size_idx, new_block,
+		&out->mresv) != 0) {
+		errno = ENOMEM;
+		return -1;
+	}
+
+	new_block->m_ops->ensure_header_type(new_block, c->header_type);
+	new_block->header_type = c->header_type;
+
+	if (alloc_prep_block(heap, new_block, constructor, arg,
+		extra_field, object_flags, out) != 0) {
+		/*
+		 * The block is already accounted for in the run's reservations,
+		 * give it back the same way as a canceled action.
+		 */
+		palloc_reservation_clear(heap, out, 0);
+		errno = ECANCELED;
+		return -1;
+	}
+
+	out->lock = new_block->m_ops->get_lock(new_block);
+	out->new_state = MEMBLOCK_ALLOCATED;
+
+	return 0;
+}
 
+/*
+ * palloc_reservation_class -- (internal) finds the allocation class and
+ *	the number of its units required to hold an object of the given size
+ */
+static struct alloc_class *
+palloc_reservation_class(struct palloc_heap *heap, size_t size,
+	uint16_t class_id, uint32_t *size_idx)
+{
 	ASSERT(class_id < UINT8_MAX);
 	struct alloc_class *c = class_id == 0 ?
 		heap_get_best_class(heap, size) :
@@ -195,7 +257,7 @@ palloc_reservation_create(struct palloc_heap *heap, size_t size,
 	if (c == NULL) {
 		ERR_WO_ERRNO("no allocation class for size %lu bytes", size);
 		errno = EINVAL;
-		return -1;
+		return NULL;
 	}
 
 	/*
@@ -206,22 +268,38 @@ palloc_reservation_create(struct palloc_heap *heap, size_t size,
 	 * For example, to allocate 500 bytes from a bucket that
 	 * provides 256 byte blocks two memory 'units' are required.
 	 */
-	ssize_t size_idx = alloc_class_calc_size_idx(c, size);
-	if (size_idx < 0) {
+	ssize_t idx = alloc_class_calc_size_idx(c, size);
+	if (idx < 0) {
 		ERR_WO_ERRNO("allocation class not suitable for size %lu bytes",
 			size);
 		errno = EINVAL;
-		return -1;
+		return NULL;
 	}
-	ASSERT(size_idx <= UINT32_MAX);
-	*new_block = MEMORY_BLOCK_NONE;
-	new_block->size_idx = (uint32_t)size_idx;
+	ASSERT(idx <= UINT32_MAX);
+	*size_idx = (uint32_t)idx;
 
-	struct bucket *b = heap_bucket_acquire(heap, c->id, arena_id);
+	return c;
+}
 
-	err = heap_get_bestfit_block(heap, b, new_block);
+/*
+ * palloc_reservation_create_locked -- (internal) creates a volatile
+ *	reservation of a memory block from an already acquired bucket
+ */
+static int
+palloc_reservation_create_locked(struct palloc_heap *heap, struct bucket *b,
+	uint32_t size_idx, palloc_constr constructor, void *arg,
+	uint64_t extra_field, uint16_t object_flags,
+	struct pobj_action_internal *out)
+{
+	struct memory_block *new_block = &out->m;
+	out->type = POBJ_ACTION_TYPE_HEAP;
+
+	*new_block = MEMORY_BLOCK_NONE;
+	new_block->size_idx = size_idx;
+
+	int err = heap_get_bestfit_block(heap, b, new_block);
 	if (err != 0)
-		goto out;
+		return err;
 
 	if (alloc_prep_block(heap, new_block, constructor, arg,
 		extra_field, object_flags, out) != 0) {
@@ -232,8 +310,7 @@ palloc_reservation_create(struct palloc_heap *heap, size_t size,
 		if (new_block->type == MEMORY_BLOCK_HUGE) {
 			bucket_insert_block(b, new_block);
 		}
-		err = ECANCELED;
-		goto out;
+		return ECANCELED;
 	}
 
 	/*
@@ -248,7 +325,75 @@ palloc_reservation_create(struct palloc_heap *heap, size_t size,
 	out->lock = new_block->m_ops->get_lock(new_block);
 	out->new_state = MEMBLOCK_ALLOCATED;
 
-out:
+	return 0;
+}
+
+/*
+ * palloc_reservation_create -- creates a volatile reservation of a
+ *	memory block.
+ *
+ * The first step in the allocation of a new block is reserving it in
+ * the transient heap - which is represented by the bucket abstraction.
+ *
+ * To provide optimal scaling for multi-threaded applications and reduce
+ * fragmentation the appropriate bucket is chosen depending on the
+ * current thread context and to which allocation class the requested
+ * size falls into.
+ *
+ * Once the bucket is selected, just enough memory is reserved for the
+ * requested size. The underlying block allocation algorithm
+ * (best-fit, next-fit, ...) varies depending on the bucket container.
+ */
+static int
+palloc_reservation_create(struct palloc_heap *heap, size_t size,
+	palloc_constr constructor, void *arg,
+	uint64_t extra_field, uint16_t object_flags,
+	uint16_t class_id, uint16_t arena_id,
+	struct pobj_action_internal *out)
+{
+	uint32_t size_idx;
+	struct alloc_class *c = palloc_reservation_class(heap, size, class_id,
+		&size_idx);
+	if (c == NULL)
+		return -1;
+
+	out->type = POBJ_ACTION_TYPE_HEAP;
+	out->m = MEMORY_BLOCK_NONE;
+	out->m.size_idx = size_idx;
+
+	/*
+	 * Single-unit allocations from the thread's own arena can be served
+	 * from the thread cache, without acquiring the bucket.
+	 */
+	struct heap_tcache *tc = heap_tcache(heap);
+	if (c->type == CLASS_RUN && size_idx == 1 &&
+	    arena_id == HEAP_ARENA_PER_THREAD && tcache_get_enabled(tc)) {
+		return palloc_reservation_create_cached(heap, tc, c,
+			constructor, arg, extra_field, object_flags, out);
+	}
+
+	/*
+	 * In the lock-free mode the bucket is only acquired once the active
+	 * run has no suitable free units left.
+	 */
+	if (c->type == CLASS_RUN && heap_get_run_lockfree(heap)) {
+		if (palloc_reservation_create_lockfree(heap, c, size_idx,
+			arena_id, constructor, arg, extra_field, object_flags,
+			out) == 0)
+			return 0;
+
+		if (errno != ENOMEM)
+			return -1;
+
+		out->m = MEMORY_BLOCK_NONE;
+		out->m.size_idx = size_idx;
+	}
+
+	struct bucket *b = heap_bucket_acquire(heap, c->id, arena_id);
+
+	int err = palloc_reservation_create_locked(heap, b, size_idx,
+		constructor, arg, extra_field, object_flags, out);
+
 	heap_bucket_release(b);
 
 	if (err == 0)
@@ -507,6 +652,10 @@ static const struct {
 
 /*
  * palloc_action_compare -- compares two actions based on lock address
+ *
+ * Heap actions that share a lock are additionally ordered by their offset,
+ * so that the bitmap updates of neighbouring blocks of a run end up next to
+ * each other and are always coalesced into a single redo log entry.
  */
 static int
 palloc_action_compare(const void *lhs, const void *rhs)
@@ -521,14 +670,24 @@ palloc_action_compare(const void *lhs, const void *rhs)
 	if (vlhs > vrhs)
 		return 1;
 
+	if (mlhs->type != POBJ_ACTION_TYPE_HEAP ||
+	    mrhs->type != POBJ_ACTION_TYPE_HEAP)
+		return 0;
+
+	if (mlhs->offset < mrhs->offset)
+		return -1;
+	if (mlhs->offset > mrhs->offset)
+		return 1;
+
 	return 0;
 }
 
 /*
- * palloc_exec_actions -- perform the provided free/alloc operations
+ * palloc_exec_actions_process -- (internal) makes the provided free/alloc
+ *	operations persistent and unlocks them
  */
 static void
-palloc_exec_actions(struct palloc_heap *heap,
+palloc_exec_actions_process(struct palloc_heap *heap,
 	struct operation_context *ctx,
 	struct pobj_action_internal *actv,
 	size_t actvcnt)
@@ -580,9 +739,20 @@ palloc_exec_actions(struct palloc_heap *heap,
 				util_mutex_unlock(act->lock);
 		}
 	}
+}
 
+/*
+ * palloc_exec_actions_finish -- (internal) performs the volatile finalization
+ *	of already processed free/alloc operations and cleans up the context
+ */
+static void
+palloc_exec_actions_finish(struct palloc_heap *heap,
+	struct operation_context *ctx,
+	struct pobj_action_internal *actv,
+	size_t actvcnt)
+{
 	for (size_t i = 0; i < actvcnt; ++i) {
-		act = &actv[i];
+		struct pobj_action_internal *act = &actv[i];
 
 		action_funcs[act->type].on_unlock(heap, act);
 	}
@@ -590,6 +760,19 @@ palloc_exec_actions(struct palloc_heap *heap,
 	operation_finish(ctx, 0);
 }
 
+/*
+ * palloc_exec_actions -- perform the provided free/alloc operations
+ */
+static void
+palloc_exec_actions(struct palloc_heap *heap,
+	struct operation_context *ctx,
+	struct pobj_action_internal *actv,
+	size_t actvcnt)
+{
+	palloc_exec_actions_process(heap, ctx, actv, actvcnt);
+	palloc_exec_actions_finish(heap, ctx, actv, actvcnt);
+}
+
 /*
  * palloc_reserve -- creates a single reservation
  */
@@ -608,6 +791,53 @@ palloc_reserve(struct palloc_heap *heap, size_t size,
 		(struct pobj_action_internal *)act);
 }
 
+/*
+ * palloc_reserve_bulk -- creates reservations of multiple objects of the same
+ *	size, all taken from the bucket under a single hold
+ *
+ * Either all of the requested objects are reserved or none is.
+ */
+int
+palloc_reserve_bulk(struct palloc_heap *heap, size_t size,
+	palloc_constr constructor, void *arg,
+	uint64_t extra_field, uint16_t object_flags,
+	uint16_t class_id, uint16_t arena_id,
+	struct pobj_action *actv, size_t actvcnt)
+{
+	COMPILE_ERROR_ON(sizeof(struct pobj_action) !=
+		sizeof(struct pobj_action_internal));
+
+	uint32_t size_idx;
+	struct alloc_class *c = palloc_reservation_class(heap, size, class_id,
+		&size_idx);
+	if (c == NULL)
+		return -1;
+
+	struct pobj_action_internal *act =
+		(struct pobj_action_internal *)actv;
+
+	int err = 0;
+	size_t i;
+
+	struct bucket *b = heap_bucket_acquire(heap, c->id, arena_id);
+	for (i = 0; i < actvcnt; ++i) {
+		err = palloc_reservation_create_locked(heap, b, size_idx,
+			constructor, arg, extra_field, object_flags, &act[i]);
+		if (err != 0)
+			break;
+	}
+	heap_bucket_release(b);
+
+	if (err == 0)
+		return 0;
+
+	/* canceling requires the bucket, it must be released at this point */
+	palloc_cancel(heap, actv, i);
+
+	errno = err;
+	return -1;
+}
+
 /*
  * palloc_defer_free -- creates an internal deferred free action
  */
@@ -672,6 +902,33 @@ palloc_publish(struct palloc_heap *heap,
 		(struct pobj_action_internal *)actv, actvcnt);
 }
 
+/*
+ * palloc_publish_process -- makes all reservations in the array persistent,
+ *	the array and the context have to be later passed to
+ *	palloc_publish_finish, possibly from a different thread
+ */
+void
+palloc_publish_process(struct palloc_heap *heap,
+	struct pobj_action *actv, size_t actvcnt,
+	struct operation_context *ctx)
+{
+	palloc_exec_actions_process(heap, ctx,
+		(struct pobj_action_internal *)actv, actvcnt);
+}
+
+/*
+ * palloc_publish_finish -- completes the publication of reservations
+ *	processed by palloc_publish_process
+ */
+void
+palloc_publish_finish(struct palloc_heap *heap,
+	struct pobj_action *actv, size_t actvcnt,
+	struct operation_context *ctx)
+{
+	palloc_exec_actions_finish(heap, ctx,
+		(struct pobj_action_internal *)actv, actvcnt);
+}
+
 /*
  * palloc_operation -- persistent memory operation. Takes a NULL pointer
  *	or an existing memory block and modifies it to occupy, at least, 'size'
@@ -802,6 +1059,15 @@ palloc_offset_compare(const void *lhs, const void *rhs)
 	return 0;
 }
 
+/*
+ * Empirically, 50% fill rate is the sweetspot for moving objects between runs.
+ * Other values tend to produce worse results.
+ */
+#define PALLOC_DEFRAG_MAX_FILL_PCT 50
+
+/* the number of runs processed at once by the incremental defragmentation */
+#define PALLOC_DEFRAG_STEP_MAX_RUNS 64
+
 struct palloc_defrag_entry {
 	uint64_t **offsetp;
 };
@@ -849,12 +1115,13 @@ pobj_actions_add(struct pobj_actions *actv)
 }
 
 /*
- * palloc_defrag -- forces recycling of all available memory, and reallocates
- *	provided objects so that they have the lowest possible address.
+ * palloc_defrag_objects -- (internal) reallocates provided objects so that
+ *	they have the lowest possible address.
  */
-int
-palloc_defrag(struct palloc_heap *heap, uint64_t **objv, size_t objcnt,
-	struct operation_context *ctx, struct pobj_defrag_result *result)
+static int
+palloc_defrag_objects(struct palloc_heap *heap, uint64_t **objv,
+	size_t objcnt, struct operation_context *ctx,
+	struct pobj_defrag_result *result)
 {
 	int ret = -1;
 	/*
@@ -904,8 +1171,6 @@ palloc_defrag(struct palloc_heap *heap, uint64_t **objv, size_t objcnt,
 	if (current_object_sequence > longest_object_sequence)
 		longest_object_sequence = current_object_sequence;
 
-	heap_force_recycle(heap);
-
 	/*
 	 * The number of actions at which the action vector will be processed.
 	 */
@@ -1036,12 +1301,7 @@ palloc_defrag(struct palloc_heap *heap, uint64_t **objv, size_t objcnt,
 		unsigned original_fillpct = m.m_ops->fill_pct(&m);
 		os_mutex_unlock(mlock);
 
-		/*
-		 * Empirically, 50% fill rate is the sweetspot for moving
-		 * objects between runs. Other values tend to produce worse
-		 * results.
-		 */
-		if (original_fillpct > 50)
+		if (original_fillpct > PALLOC_DEFRAG_MAX_FILL_PCT)
 			continue;
 
 		size_t user_size = m.m_ops->get_user_size(&m);
@@ -1159,6 +1419,111 @@ err_ravl:
 	return ret;
 }
 
+/*
+ * palloc_defrag -- forces recycling of all available memory, and reallocates
+ *	provided objects so that they have the lowest possible address.
+ */
+int
+palloc_defrag(struct palloc_heap *heap, uint64_t **objv, size_t objcnt,
+	struct operation_context *ctx, struct pobj_defrag_result *result)
+{
+	heap_force_recycle(heap);
+
+	return palloc_defrag_objects(heap, objv, objcnt, ctx, result);
+}
+
+struct palloc_defrag_range {
+	uint64_t start;
+	uint64_t end;
+};
+
+struct palloc_defrag_collect {
+	struct palloc_defrag_range ranges[PALLOC_DEFRAG_STEP_MAX_RUNS];
+	size_t nranges;
+
+	VEC(, uint64_t *) objv;
+	int error;
+};
+
+/*
+ * palloc_defrag_collect -- (internal) remembers the pointers to the objects
+ *	that reside in the runs being defragmented
+ */
+static void
+palloc_defrag_collect(uint64_t *offsetp, void *arg)
+{
+	struct palloc_defrag_collect *c = arg;
+	uint64_t offset = *offsetp;
+
+	if (c->error != 0)
+		return;
+
+	for (size_t i = 0; i < c->nranges; ++i) {
+		if (offset < c->ranges[i].start || offset >= c->ranges[i].end)
+			continue;
+
+		if (VEC_PUSH_BACK(&c->objv, offsetp) != 0)
+			c->error = ENOMEM;
+		return;
+	}
+}
+
+/*
+ * palloc_defrag_step -- takes up to max_runs of the sparsest runs from
+ *	the heap, moves the objects out of them and gives the runs back.
+ *	The runs that end up empty are released to the global heap.
+ *
+ * The pointers to the objects are obtained through the enumerate callback,
+ * which is called once per step.
+ */
+int
+palloc_defrag_step(struct palloc_heap *heap, size_t max_runs,
+	palloc_defrag_enum_fn enumerate, void *arg,
+	struct operation_context *ctx, struct pobj_defrag_result *result)
+{
+	struct memory_block runs[PALLOC_DEFRAG_STEP_MAX_RUNS];
+	size_t nruns = heap_get_sparse_runs(heap, runs,
+		MIN(max_runs, PALLOC_DEFRAG_STEP_MAX_RUNS),
+		PALLOC_DEFRAG_MAX_FILL_PCT);
+
+	if (nruns == 0) {
+		operation_cancel(ctx);
+		return 0;
+	}
+
+	struct palloc_defrag_collect c;
+	c.nranges = nruns;
+	c.error = 0;
+	VEC_INIT(&c.objv);
+
+	for (size_t i = 0; i < nruns; ++i) {
+		c.ranges[i].start = HEAP_PTR_TO_OFF(heap,
+			heap_get_chunk_run(heap, &runs[i]));
+		c.ranges[i].end = c.ranges[i].start +
+			runs[i].size_idx * CHUNKSIZE;
+	}
+
+	int ret = enumerate(palloc_defrag_collect, &c, arg);
+	if (ret == 0 && c.error != 0) {
+		errno = c.error;
+		ret = -1;
+	}
+
+	if (ret == 0)
+		ret = palloc_defrag_objects(heap, VEC_ARR(&c.objv),
+			VEC_SIZE(&c.objv), ctx, result);
+	else
+		operation_cancel(ctx);
+
+	VEC_DELETE(&c.objv);
+
+	/* the frees are already published, the runs can be reused */
+	for (size_t i = 0; i < nruns; ++i)
+		heap_discard_run(heap, &runs[i]);
+
+	return ret;
+}
+
 /*
  * palloc_usable_size -- returns the number of bytes in the memory block
  */
@@ -1308,6 +1673,15 @@ palloc_heap_cleanup(struct palloc_heap *heap)
 	heap_cleanup(heap);
 }
 
+/*
+ * palloc_heap_reclaim_stop -- stops the background heap reclamation workers
+ */
+void
+palloc_heap_reclaim_stop(struct palloc_heap *heap)
+{
+	heap_reclaim_stop(heap);
+}
+
 #if VG_MEMCHECK_ENABLED
 /*
  * palloc_vg_register_alloc -- (internal) registers allocation header
@@ -56,6 +56,13 @@ palloc_reserve(struct palloc_heap *heap, size_t size,
 	uint16_t class_id, uint16_t arena_id,
 	struct pobj_action *act);
 
+int
+palloc_reserve_bulk(struct palloc_heap *heap, size_t size,
+	palloc_constr constructor, void *arg,
+	uint64_t extra_field, uint16_t object_flags,
+	uint16_t class_id, uint16_t arena_id,
+	struct pobj_action *actv, size_t actvcnt);
+
 void
 palloc_defer_free(struct palloc_heap *heap, uint64_t off,
 	struct pobj_action *act);
@@ -69,6 +76,16 @@ palloc_publish(struct palloc_heap *heap,
 	struct pobj_action *actv, size_t actvcnt,
 	struct operation_context *ctx);
 
+void
+palloc_publish_process(struct palloc_heap *heap,
+	struct pobj_action *actv, size_t actvcnt,
+	struct operation_context *ctx);
+
+void
+palloc_publish_finish(struct palloc_heap *heap,
+	struct pobj_action *actv, size_t actvcnt,
+	struct operation_context *ctx);
+
 void
 palloc_set_value(struct palloc_heap *heap, struct pobj_action *act,
 	uint64_t *ptr, uint64_t value);
@@ -94,11 +111,23 @@ void *palloc_heap_end(struct palloc_heap *h);
 #endif /* VG_MEMCHECK_ENABLED */
 int palloc_heap_check(void *heap_start, uint64_t heap_size);
 void palloc_heap_cleanup(struct palloc_heap *heap);
+void palloc_heap_reclaim_stop(struct palloc_heap *heap);
 size_t palloc_heap(void *heap_start);
 
 int palloc_defrag(struct palloc_heap *heap, uint64_t **objv, size_t objcnt,
 	struct operation_context *ctx, struct pobj_defrag_result *result);
 
+/* called for every pointer to an object that might be relocated */
+typedef void (*palloc_defrag_visit_fn)(uint64_t *offsetp, void *visit_arg);
+
+/* enumerates the pointers to objects, returns non-zero on failure */
+typedef int (*palloc_defrag_enum_fn)(palloc_defrag_visit_fn visit,
+	void *visit_arg, void *arg);
+
+int palloc_defrag_step(struct palloc_heap *heap, size_t max_runs,
+	palloc_defrag_enum_fn enumerate, void *arg,
+	struct operation_context *ctx, struct pobj_defrag_result *result);
+
 /* foreach callback, terminates iteration if return value is non-zero */
 typedef int (*object_callback)(const struct memory_block *m, void *arg);
 
@@ -25,6 +25,7 @@
 #include "alloc_class.h"
 #include "set.h"
 #include "mmap.h"
+#include "tcache.h"
 
 enum pmalloc_operation_type {
 	OPERATION_INTERNAL, /* used only for single, one-off operations */
@@ -195,10 +196,15 @@ pmalloc_boot(PMEMobjpool *pop)
 #endif
 
 	ret = palloc_buckets_init(&pop->heap);
-	if (ret)
+	if (ret) {
 		palloc_heap_cleanup(&pop->heap);
+		return ret;
+	}
 
-	return ret;
+	if (Default_reclaim_parallel != 0)
+		heap_reclaim_parallel(&pop->heap, Default_reclaim_parallel);
+
+	return 0;
 }
 
 /*
@@ -475,6 +481,35 @@ CTL_RUNNABLE_HANDLER(extend)(void *ctx,
 	return ret;
 }
 
+/*
+ * CTL_RUNNABLE_HANDLER(shrink) -- releases the backing storage of the free
+ *	chunk ranges of at least the given size
+ */
+static int
+CTL_RUNNABLE_HANDLER(shrink)(void *ctx,
+	enum ctl_query_source source, void *arg, struct ctl_indexes *indexes)
+{
+	/* suppress unused-parameter errors */
+	SUPPRESS_UNUSED(source, indexes);
+
+	PMEMobjpool *pop = ctx;
+
+	ssize_t arg_in = *(ssize_t *)arg;
+	if (arg_in < 0) {
+		ERR_WO_ERRNO("incorrect size for shrink, must not be negative");
+		errno = EINVAL;
+		return -1;
+	}
+
+	size_t released;
+	if (heap_shrink(&pop->heap, (size_t)arg_in, &released) != 0)
+		return -1;
+
+	LOG(3, "released %zu bytes", released);
+
+	return 0;
+}
+
 /*
  * CTL_READ_HANDLER(granularity) -- reads the current heap grow size
  */
@@ -732,10 +767,38 @@ static struct ctl_argument CTL_ARG(automatic) = CTL_ARG_BOOLEAN;
 static const struct ctl_node CTL_NODE(size)[] = {
 	CTL_LEAF_RW(granularity),
 	CTL_LEAF_RUNNABLE(extend),
+	CTL_LEAF_RUNNABLE(shrink),
 
 	CTL_NODE_END
 };
 
+/*
+ * ctl_arena_size -- (internal) calculates the size of the memory owned
+ *	by the arena
+ */
+static size_t
+ctl_arena_size(struct palloc_heap *heap, unsigned arena_id)
+{
+	/* take buckets for arena */
+	struct bucket_locked **buckets;
+	buckets = heap_get_arena_buckets(heap, arena_id);
+
+	/* calculate number of reservation for arena using buckets */
+	unsigned size = 0;
+	for (int i = 0; i < MAX_ALLOCATION_CLASSES; ++i) {
+		if (buckets[i] != NULL) {
+			struct bucket *b = bucket_acquire(buckets[i]);
+			struct memory_block_reserved *active =
+				bucket_active_block(b);
+
+			size += active ? active->m.size_idx : 0;
+			bucket_release(b);
+		}
+	}
+
+	return size * CHUNKSIZE;
+}
+
 /*
  * CTL_READ_HANDLER(size) -- reads usable size of specified arena
  */
@@ -770,24 +833,43 @@ CTL_READ_HANDLER(size)(void *ctx,
 		return -1;
 	}
 
-	/* take buckets for arena */
-	struct bucket_locked **buckets;
-	buckets = heap_get_arena_buckets(&pop->heap, arena_id);
+	*arena_size = ctl_arena_size(&pop->heap, arena_id);
 
-	/* calculate number of reservation for arena using buckets */
-	unsigned size = 0;
-	for (int i = 0; i < MAX_ALLOCATION_CLASSES; ++i) {
-		if (buckets[i] != NULL) {
-			struct bucket *b = bucket_acquire(buckets[i]);
-			struct memory_block_reserved *active =
-				bucket_active_block(b);
+	return 0;
+}
 
-			size += active ? active->m.size_idx : 0;
-			bucket_release(b);
-		}
+/*
+ * CTL_READ_HANDLER(numa_node) -- reads the NUMA node to which the arena
+ *	is bound
+ */
+static int
+CTL_READ_HANDLER(numa_node)(void *ctx,
+	enum ctl_query_source source, void *arg, struct ctl_indexes *indexes)
+{
+	/* suppress unused-parameter errors */
+	SUPPRESS_UNUSED(source);
+
+	PMEMobjpool *pop = ctx;
+	int *numa_node = arg;
+
+	struct ctl_index *idx = PMDK_SLIST_FIRST(indexes);
+	ASSERTeq(strcmp(idx->name, "arena_id"), 0);
+
+	unsigned arena_id = (unsigned)idx->value;
+	unsigned narenas = heap_get_narenas_total(&pop->heap);
+
+	/*
+	 * check if index is not bigger than number of arenas
+	 * or if it is not equal zero
+	 */
+	if (arena_id < 1 || arena_id > narenas) {
+		ERR_WO_ERRNO("arena id outside of the allowed range: <1,%u>",
+			narenas);
+		errno = ERANGE;
+		return -1;
 	}
 
-	*arena_size = size * CHUNKSIZE;
+	*numa_node = heap_get_arena_numa_node(&pop->heap, arena_id);
 
 	return 0;
 }
@@ -818,6 +900,7 @@ CTL_RUNNABLE_HANDLER(create)(void *ctx,
 static const struct ctl_node CTL_NODE(arena_id)[] = {
 	CTL_LEAF_RO(size),
 	CTL_LEAF_RW(automatic),
+	CTL_LEAF_RO(numa_node),
 
 	CTL_NODE_END
 };
@@ -829,6 +912,389 @@ static const struct ctl_node CTL_NODE(arena)[] = {
 	CTL_NODE_END
 };
 
+/*
+ * CTL_READ_HANDLER(nnodes) -- reads the number of NUMA nodes
+ */
+static int
+CTL_READ_HANDLER(nnodes)(void *ctx,
+	enum ctl_query_source source, void *arg, struct ctl_indexes *indexes)
+{
+	/* suppress unused-parameter errors */
+	SUPPRESS_UNUSED(source, indexes);
+
+	PMEMobjpool *pop = ctx;
+	unsigned *nnodes = arg;
+
+	*nnodes = heap_get_numa_nnodes(&pop->heap);
+
+	return 0;
+}
+
+/*
+ * ctl_numa_node_id -- (internal) retrieves and validates the NUMA node id
+ *	from the query indexes
+ */
+static int
+ctl_numa_node_id(struct palloc_heap *heap, struct ctl_indexes *indexes,
+	unsigned *node_id)
+{
+	struct ctl_index *idx = PMDK_SLIST_FIRST(indexes);
+	ASSERTeq(strcmp(idx->name, "node_id"), 0);
+
+	unsigned nnodes = heap_get_numa_nnodes(heap);
+	if (idx->value < 0 || (unsigned)idx->value >= nnodes) {
+		ERR_WO_ERRNO("node id outside of the allowed range: <0,%u>",
+			nnodes - 1);
+		errno = ERANGE;
+		return -1;
+	}
+
+	*node_id = (unsigned)idx->value;
+
+	return 0;
+}
+
+/*
+ * CTL_READ_HANDLER(narenas, numa) -- reads the number of automatic arenas
+ *	bound to the NUMA node
+ */
+static int
+CTL_READ_HANDLER(narenas, numa)(void *ctx,
+	enum ctl_query_source source, void *arg, struct ctl_indexes *indexes)
+{
+	/* suppress unused-parameter errors */
+	SUPPRESS_UNUSED(source);
+
+	PMEMobjpool *pop = ctx;
+	unsigned *narenas = arg;
+	unsigned node_id;
+
+	if (ctl_numa_node_id(&pop->heap, indexes, &node_id) != 0)
+		return -1;
+
+	*narenas = heap_get_numa_node_arenas(&pop->heap, node_id, NULL);
+
+	return 0;
+}
+
+/*
+ * CTL_READ_HANDLER(nthreads, numa) -- reads the number of threads assigned
+ *	to the arenas bound to the NUMA node
+ */
+static int
+CTL_READ_HANDLER(nthreads, numa)(void *ctx,
+	enum ctl_query_source source, void *arg, struct ctl_indexes *indexes)
+{
+	/* suppress unused-parameter errors */
+	SUPPRESS_UNUSED(source);
+
+	PMEMobjpool *pop = ctx;
+	uint64_t *nthreads = arg;
+	unsigned node_id;
+
+	if (ctl_numa_node_id(&pop->heap, indexes, &node_id) != 0)
+		return -1;
+
+	size_t n;
+	heap_get_numa_node_arenas(&pop->heap, node_id, &n);
+	*nthreads = n;
+
+	return 0;
+}
+
+/*
+ * CTL_READ_HANDLER(size, numa) -- reads the total size of the memory owned
+ *	by the arenas bound to the NUMA node
+ */
+static int
+CTL_READ_HANDLER(size, numa)(void *ctx,
+	enum ctl_query_source source, void *arg, struct ctl_indexes *indexes)
+{
+	/* suppress unused-parameter errors */
+	SUPPRESS_UNUSED(source);
+
+	PMEMobjpool *pop = ctx;
+	uint64_t *node_size = arg;
+	unsigned node_id;
+
+	if (ctl_numa_node_id(&pop->heap, indexes, &node_id) != 0)
+		return -1;
+
+	*node_size = 0;
+
+	unsigned narenas = heap_get_narenas_total(&pop->heap);
+	for (unsigned arena_id = 1; arena_id <= narenas; ++arena_id) {
+		if (heap_get_arena_numa_node(&pop->heap, arena_id) !=
+			(int)node_id)
+			continue;
+
+		*node_size += ctl_arena_size(&pop->heap, arena_id);
+	}
+
+	return 0;
+}
+
+static const struct ctl_node CTL_NODE(node_id)[] = {
+	CTL_LEAF_RO(narenas, numa),
+	CTL_LEAF_RO(nthreads, numa),
+	CTL_LEAF_RO(size, numa),
+
+	CTL_NODE_END
+};
+
+static const struct ctl_node CTL_NODE(numa)[] = {
+	CTL_LEAF_RO(nnodes),
+	CTL_INDEXED(node_id),
+
+	CTL_NODE_END
+};
+
+/*
+ * CTL_READ_HANDLER(enabled) -- reads whether the thread cache is enabled
+ */
+static int
+CTL_READ_HANDLER(enabled)(void *ctx,
+	enum ctl_query_source source, void *arg, struct ctl_indexes *indexes)
+{
+	/* suppress unused-parameter errors */
+	SUPPRESS_UNUSED(source, indexes);
+
+	PMEMobjpool *pop = ctx;
+	int *arg_out = arg;
+
+	*arg_out = tcache_get_enabled(heap_tcache(&pop->heap));
+
+	return 0;
+}
+
+/*
+ * CTL_WRITE_HANDLER(enabled) -- enables or disables the thread cache
+ */
+static int
+CTL_WRITE_HANDLER(enabled)(void *ctx,
+	enum ctl_query_source source, void *arg, struct ctl_indexes *indexes)
+{
+	/* suppress unused-parameter errors */
+	SUPPRESS_UNUSED(source, indexes);
+
+	PMEMobjpool *pop = ctx;
+	int arg_in = *(int *)arg;
+
+	return tcache_set_enabled(heap_tcache(&pop->heap), arg_in);
+}
+
+static const struct ctl_argument CTL_ARG(enabled) = CTL_ARG_BOOLEAN;
+
+/*
+ * CTL_READ_HANDLER(batch) -- reads the number of blocks fetched into
+ *	the thread cache at once
+ */
+static int
+CTL_READ_HANDLER(batch)(void *ctx,
+	enum ctl_query_source source, void *arg, struct ctl_indexes *indexes)
+{
+	/* suppress unused-parameter errors */
+	SUPPRESS_UNUSED(source, indexes);
+
+	PMEMobjpool *pop = ctx;
+	unsigned *arg_out = arg;
+
+	*arg_out = tcache_get_batch(heap_tcache(&pop->heap));
+
+	return 0;
+}
+
+/*
+ * CTL_WRITE_HANDLER(batch) -- sets the number of blocks fetched into
+ *	the thread cache at once
+ */
+static int
+CTL_WRITE_HANDLER(batch)(void *ctx,
+	enum ctl_query_source source, void *arg, struct ctl_indexes *indexes)
+{
+	/* suppress unused-parameter errors */
+	SUPPRESS_UNUSED(source, indexes);
+
+	PMEMobjpool *pop = ctx;
+	unsigned batch = *(unsigned *)arg;
+
+	return tcache_set_batch(heap_tcache(&pop->heap), batch);
+}
+
+static const struct ctl_argument CTL_ARG(batch) = CTL_ARG_LONG_LONG;
+
+/*
+ * CTL_RUNNABLE_HANDLER(flush) -- returns all blocks cached by the calling
+ *	thread back to the arena buckets
+ */
+static int
+CTL_RUNNABLE_HANDLER(flush)(void *ctx,
+	enum ctl_query_source source, void *arg, struct ctl_indexes *indexes)
+{
+	/* suppress unused-parameter errors */
+	SUPPRESS_UNUSED(source, arg, indexes);
+
+	PMEMobjpool *pop = ctx;
+
+	tcache_flush(heap_tcache(&pop->heap));
+
+	return 0;
+}
+
+static const struct ctl_node CTL_NODE(tcache)[] = {
+	CTL_LEAF_RW(enabled),
+	CTL_LEAF_RW(batch),
+	CTL_LEAF_RUNNABLE(flush),
+
+	CTL_NODE_END
+};
+
+/*
+ * CTL_READ_HANDLER(lockfree) -- reads whether run buckets reserve blocks
+ *	without acquiring the bucket lock
+ */
+static int
+CTL_READ_HANDLER(lockfree)(void *ctx,
+	enum ctl_query_source source, void *arg, struct ctl_indexes *indexes)
+{
+	/* suppress unused-parameter errors */
+	SUPPRESS_UNUSED(source, indexes);
+
+	PMEMobjpool *pop = ctx;
+	int *arg_out = arg;
+
+	*arg_out = heap_get_run_lockfree(&pop->heap);
+
+	return 0;
+}
+
+/*
+ * CTL_WRITE_HANDLER(lockfree) -- enables or disables the lock-free
+ *	reservation of blocks from runs
+ */
+static int
+CTL_WRITE_HANDLER(lockfree)(void *ctx,
+	enum ctl_query_source source, void *arg, struct ctl_indexes *indexes)
+{
+	/* suppress unused-parameter errors */
+	SUPPRESS_UNUSED(source, indexes);
+
+	PMEMobjpool *pop = ctx;
+	int arg_in = *(int *)arg;
+
+	heap_set_run_lockfree(&pop->heap, arg_in);
+
+	return 0;
+}
+
+static const struct ctl_argument CTL_ARG(lockfree) = CTL_ARG_BOOLEAN;
+
+static const struct ctl_node CTL_NODE(run)[] = {
+	CTL_LEAF_RW(lockfree),
+
+	CTL_NODE_END
+};
+
+/*
+ * CTL_READ_HANDLER(worker) -- runs the background heap reclamation in
+ *	the calling thread until heap.reclaim.stop is called
+ */
+static int
+CTL_READ_HANDLER(worker)(void *ctx,
+	enum ctl_query_source source, void *arg, struct ctl_indexes *indexes)
+{
+	/* suppress unused-parameter errors */
+	SUPPRESS_UNUSED(source, arg, indexes);
+
+	PMEMobjpool *pop = ctx;
+
+	heap_reclaim_worker(&pop->heap);
+
+	return 0;
+}
+
+/*
+ * CTL_READ_HANDLER(stop) -- stops all background heap reclamation workers
+ */
+static int
+CTL_READ_HANDLER(stop)(void *ctx,
+	enum ctl_query_source source, void *arg, struct ctl_indexes *indexes)
+{
+	/* suppress unused-parameter errors */
+	SUPPRESS_UNUSED(source, arg, indexes);
+
+	PMEMobjpool *pop = ctx;
+
+	heap_reclaim_stop(&pop->heap);
+
+	return 0;
+}
+
+/*
+ * CTL_READ_HANDLER(start) -- allows the background heap reclamation workers
+ *	to run again after heap.reclaim.stop
+ */
+static int
+CTL_READ_HANDLER(start)(void *ctx,
+	enum ctl_query_source source, void *arg, struct ctl_indexes *indexes)
+{
+	/* suppress unused-parameter errors */
+	SUPPRESS_UNUSED(source, arg, indexes);
+
+	PMEMobjpool *pop = ctx;
+
+	heap_reclaim_start(&pop->heap);
+
+	return 0;
+}
+
+/*
+ * CTL_READ_HANDLER(interval) -- reads the time between the passes of
+ *	the background heap reclamation
+ */
+static int
+CTL_READ_HANDLER(interval)(void *ctx,
+	enum ctl_query_source source, void *arg, struct ctl_indexes *indexes)
+{
+	/* suppress unused-parameter errors */
+	SUPPRESS_UNUSED(source, indexes);
+
+	PMEMobjpool *pop = ctx;
+	unsigned *arg_out = arg;
+
+	*arg_out = heap_reclaim_get_interval(&pop->heap);
+
+	return 0;
+}
+
+/*
+ * CTL_WRITE_HANDLER(interval) -- sets the time between the passes of
+ *	the background heap reclamation
+ */
+static int
+CTL_WRITE_HANDLER(interval)(void *ctx,
+	enum ctl_query_source source, void *arg, struct ctl_indexes *indexes)
+{
+	/* suppress unused-parameter errors */
+	SUPPRESS_UNUSED(source, indexes);
+
+	PMEMobjpool *pop = ctx;
+	unsigned interval = *(unsigned *)arg;
+
+	return heap_reclaim_set_interval(&pop->heap, interval);
+}
+
+static const struct ctl_argument CTL_ARG(interval) = CTL_ARG_LONG_LONG;
+
+static const struct ctl_node CTL_NODE(reclaim)[] = {
+	CTL_LEAF_RO(worker),
+	CTL_LEAF_RO(stop),
+	CTL_LEAF_RO(start),
+	CTL_LEAF_RW(interval),
+
+	CTL_NODE_END
+};
+
 static const struct ctl_node CTL_NODE(narenas)[] = {
 	CTL_LEAF_RO(automatic, narenas),
 	CTL_LEAF_RO(total),
@@ -846,9 +1312,13 @@ static const struct ctl_node CTL_NODE(thread)[] = {
 static const struct ctl_node CTL_NODE(heap)[] = {
 	CTL_CHILD(alloc_class),
 	CTL_CHILD(arena),
+	CTL_CHILD(tcache),
+	CTL_CHILD(run),
+	CTL_CHILD(reclaim),
 	CTL_CHILD(size),
 	CTL_CHILD(thread),
 	CTL_CHILD(narenas),
+	CTL_CHILD(numa),
 
 	CTL_NODE_END
 };
@@ -915,6 +1385,8 @@ arenas_assignment_type_parser(const void *arg, void *dest, size_t dest_size)
 		*atype = POBJ_ARENAS_ASSIGNMENT_GLOBAL;
 	} else if (strcmp(vstr, "thread") == 0) {
 		*atype = POBJ_ARENAS_ASSIGNMENT_THREAD_KEY;
+	} else if (strcmp(vstr, "numa") == 0) {
+		*atype = POBJ_ARENAS_ASSIGNMENT_NUMA;
 	} else {
 		ERR_WO_ERRNO("invalid arena assignment type");
 		errno = EINVAL;
@@ -933,6 +1405,84 @@ static const struct ctl_argument CTL_ARG(arenas_assignment_type) = {
 	}
 };
 
+/*
+ * CTL_WRITE_HANDLER(huge_container) -- sets the type of the container
+ *	holding the free chunks of the heaps booted afterwards
+ */
+static int
+CTL_WRITE_HANDLER(huge_container)(void *ctx,
+	enum ctl_query_source source, void *arg, struct ctl_indexes *indexes)
+{
+	/* suppress unused-parameter errors */
+	SUPPRESS_UNUSED(ctx, source, indexes);
+
+	enum pobj_huge_container_type *src = arg;
+
+	if (*src != POBJ_HUGE_CONTAINER_RAVL &&
+	    *src != POBJ_HUGE_CONTAINER_TLSF) {
+		ERR_WO_ERRNO("invalid huge container type");
+		errno = EINVAL;
+		return -1;
+	}
+
+	Default_huge_container = *src;
+
+	return 0;
+}
+
+/*
+ * CTL_READ_HANDLER(huge_container) -- reads the type of the container
+ *	holding the free chunks of the heaps booted afterwards
+ */
+static int
+CTL_READ_HANDLER(huge_container)(void *ctx,
+	enum ctl_query_source source, void *arg, struct ctl_indexes *indexes)
+{
+	/* suppress unused-parameter errors */
+	SUPPRESS_UNUSED(ctx, source, indexes);
+
+	enum pobj_huge_container_type *dest = arg;
+
+	*dest = Default_huge_container;
+
+	return 0;
+}
+
+/*
+ * huge_container_parser -- parses the huge container enum
+ */
+static int
+huge_container_parser(const void *arg, void *dest, size_t dest_size)
+{
+	const char *vstr = arg;
+	enum pobj_huge_container_type *ctype = dest;
+#ifndef DEBUG
+	SUPPRESS_UNUSED(dest_size);
+#endif
+	ASSERTeq(dest_size, sizeof(enum pobj_huge_container_type));
+
+	if (strcmp(vstr, "ravl") == 0) {
+		*ctype = POBJ_HUGE_CONTAINER_RAVL;
+	} else if (strcmp(vstr, "tlsf") == 0) {
+		*ctype = POBJ_HUGE_CONTAINER_TLSF;
+	} else {
+		ERR_WO_ERRNO("invalid huge container type");
+		errno = EINVAL;
+		return -1;
+	}
+
+	return 0;
+}
+
+static const struct ctl_argument CTL_ARG(huge_container) = {
+	.dest_size = sizeof(enum pobj_huge_container_type),
+	.parsers = {
+		CTL_ARG_PARSER(enum pobj_huge_container_type,
+			huge_container_parser),
+		CTL_ARG_PARSER_END
+	}
+};
+
 /*
  * CTL_READ_HANDLER(arenas_default_max) -- reads a max number of arenas
  *	created by default at startup
@@ -978,9 +1528,62 @@ CTL_WRITE_HANDLER(arenas_default_max)(void *ctx,
 static const struct ctl_argument CTL_ARG(arenas_default_max) =
 	CTL_ARG_LONG_LONG;
 
+/*
+ * CTL_READ_HANDLER(parallel) -- reads the number of threads reclaiming
+ *	the zones when a pool is opened
+ */
+static int
+CTL_READ_HANDLER(parallel)(void *ctx,
+	enum ctl_query_source source, void *arg, struct ctl_indexes *indexes)
+{
+	/* suppress unused-parameter errors */
+	SUPPRESS_UNUSED(ctx, source, indexes);
+
+	unsigned *nthreads = arg;
+
+	*nthreads = Default_reclaim_parallel;
+
+	return 0;
+}
+
+/*
+ * CTL_WRITE_HANDLER(parallel) -- sets the number of threads reclaiming
+ *	the zones when a pool is opened
+ */
+static int
+CTL_WRITE_HANDLER(parallel)(void *ctx,
+	enum ctl_query_source source, void *arg, struct ctl_indexes *indexes)
+{
+	/* suppress unused-parameter errors */
+	SUPPRESS_UNUSED(ctx, source, indexes);
+
+	unsigned nthreads = *(unsigned *)arg;
+
+	if (nthreads > HEAP_RECLAIM_MAX_THREADS) {
+		ERR_WO_ERRNO("number of reclaim threads can't exceed %u",
+			HEAP_RECLAIM_MAX_THREADS);
+		errno = EINVAL;
+		return -1;
+	}
+
+	Default_reclaim_parallel = nthreads;
+
+	return 0;
+}
+
+static const struct ctl_argument CTL_ARG(parallel) = CTL_ARG_LONG_LONG;
+
+static const struct ctl_node CTL_NODE(reclaim, global)[] = {
+	CTL_LEAF_RW(parallel),
+
+	CTL_NODE_END
+};
+
 static const struct ctl_node CTL_NODE(heap_global)[] = {
 	CTL_LEAF_RW(arenas_assignment_type),
 	CTL_LEAF_RW(arenas_default_max),
+	CTL_LEAF_RW(huge_container),
+	CTL_CHILD(reclaim, global),
 
 	CTL_NODE_END
 };
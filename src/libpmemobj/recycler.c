@@ -164,6 +164,25 @@ recycler_put(struct recycler *r, struct recycler_element element)
 	return ret;
 }
 
+/*
+ * recycler_take -- (internal) removes the run from the recycler and rebuilds
+ *	its memory block
+ */
+static void
+recycler_take(struct recycler *r, struct ravl_node *n, struct memory_block *m)
+{
+	struct recycler_element *ne = ravl_data(n);
+	m->chunk_id = ne->chunk_id;
+	m->zone_id = ne->zone_id;
+
+	ravl_remove(r->runs, n);
+
+	struct chunk_header *hdr = heap_get_chunk_hdr(r->heap, m);
+	m->size_idx = hdr->size_idx;
+
+	memblock_rebuild_state(r->heap, m);
+}
+
 /*
  * recycler_get -- retrieves a chunk from the recycler
  */
@@ -182,43 +201,88 @@ recycler_get(struct recycler *r, struct memory_block *m)
 		goto out;
 	}
 
-	struct recycler_element *ne = ravl_data(n);
-	m->chunk_id = ne->chunk_id;
-	m->zone_id = ne->zone_id;
+	recycler_take(r, n, m);
 
-	ravl_remove(r->runs, n);
+out:
+	util_mutex_unlock(&r->lock);
 
-	struct chunk_header *hdr = heap_get_chunk_hdr(r->heap, m);
-	m->size_idx = hdr->size_idx;
+	return ret;
+}
 
-	memblock_rebuild_state(r->heap, m);
+/*
+ * recycler_find_sparsest -- (internal) returns the node of the run with the
+ *	highest score, which is the one with the largest free block
+ */
+static struct ravl_node *
+recycler_find_sparsest(struct recycler *r)
+{
+	struct recycler_element e = {
+		.max_free_block = UINT32_MAX,
+		.free_space = UINT32_MAX,
+		.chunk_id = UINT32_MAX,
+		.zone_id = UINT32_MAX,
+	};
+
+	return ravl_find(r->runs, &e, RAVL_PREDICATE_LESS_EQUAL);
+}
+
+/*
+ * recycler_peek_sparsest -- reads the score of the run with the largest free
+ *	block, without removing it from the recycler
+ */
+int
+recycler_peek_sparsest(struct recycler *r, struct recycler_element *e)
+{
+	int ret = 0;
+
+	util_mutex_lock(&r->lock);
+
+	struct ravl_node *n = recycler_find_sparsest(r);
+	if (n == NULL)
+		ret = ENOMEM;
+	else
+		*e = *(struct recycler_element *)ravl_data(n);
 
-out:
 	util_mutex_unlock(&r->lock);
 
 	return ret;
 }
 
 /*
- * recycler_recalc -- recalculates the scores of runs in the recycler to match
- *	the updated persistent state
+ * recycler_get_sparsest -- retrieves the run with the largest free block
+ *	from the recycler
  */
-struct empty_runs
-recycler_recalc(struct recycler *r, int force)
+int
+recycler_get_sparsest(struct recycler *r, struct memory_block *m)
 {
-	struct empty_runs runs;
-	VEC_INIT(&runs);
+	int ret = 0;
 
-	uint64_t units = r->unaccounted_total;
+	util_mutex_lock(&r->lock);
 
-	size_t peak_arenas;
-	util_atomic_load64(r->peak_arenas, &peak_arenas);
+	struct ravl_node *n = recycler_find_sparsest(r);
+	if (n == NULL) {
+		ret = ENOMEM;
+		goto out;
+	}
 
-	uint64_t recalc_threshold =
-		THRESHOLD_MUL * peak_arenas * r->nallocs;
+	*m = MEMORY_BLOCK_NONE;
+	recycler_take(r, n, m);
 
-	if (!force && units < recalc_threshold)
-		return runs;
+out:
+	util_mutex_unlock(&r->lock);
+
+	return ret;
+}
+
+/*
+ * recycler_recalc_units -- (internal) recalculates the scores of runs in
+ *	the recycler until the given number of unaccounted units is found
+ */
+static struct empty_runs
+recycler_recalc_units(struct recycler *r, uint64_t units, int force)
+{
+	struct empty_runs runs;
+	VEC_INIT(&runs);
 
 	if (util_mutex_trylock(&r->lock) != 0)
 		return runs;
@@ -292,6 +356,47 @@ recycler_recalc(struct recycler *r, int force)
 	return runs;
 }
 
+/*
+ * recycler_recalc -- recalculates the scores of runs in the recycler to match
+ *	the updated persistent state
+ */
+struct empty_runs
+recycler_recalc(struct recycler *r, int force)
+{
+	uint64_t units = r->unaccounted_total;
+
+	size_t peak_arenas;
+	util_atomic_load64(r->peak_arenas, &peak_arenas);
+
+	uint64_t recalc_threshold =
+		THRESHOLD_MUL * peak_arenas * r->nallocs;
+
+	if (!force && units < recalc_threshold) {
+		struct empty_runs runs;
+		VEC_INIT(&runs);
+		return runs;
+	}
+
+	return recycler_recalc_units(r, units, force);
+}
+
+/*
+ * recycler_recalc_unaccounted -- recalculates the scores of the runs that
+ *	might have unaccounted units, regardless of how many there are
+ */
+struct empty_runs
+recycler_recalc_unaccounted(struct recycler *r)
+{
+	uint64_t units = r->unaccounted_total;
+	if (units == 0) {
+		struct empty_runs runs;
+		VEC_INIT(&runs);
+		return runs;
+	}
+
+	return recycler_recalc_units(r, units, 0);
+}
+
 /*
  * recycler_inc_unaccounted -- increases the number of unaccounted units in the
  *	recycler
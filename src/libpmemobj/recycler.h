@@ -39,7 +39,11 @@ int recycler_put(struct recycler *r, struct recycler_element element);
 
 int recycler_get(struct recycler *r, struct memory_block *m);
 
+int recycler_peek_sparsest(struct recycler *r, struct recycler_element *e);
+int recycler_get_sparsest(struct recycler *r, struct memory_block *m);
+
 struct empty_runs recycler_recalc(struct recycler *r, int force);
+struct empty_runs recycler_recalc_unaccounted(struct recycler *r);
 
 void recycler_inc_unaccounted(struct recycler *r,
 	const struct memory_block *m);
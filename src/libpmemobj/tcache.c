@@ -0,0 +1,465 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/* Copyright 2026, Intel Corporation */
+
+/*
+ * tcache.c -- implementation of per-thread allocation cache
+ *
+ * Every small allocation normally has to acquire the bucket of the thread's
+ * arena, which is a mutex shared by all threads assigned to that arena.
+ * The thread cache amortizes that cost by reserving a batch of single-unit
+ * blocks from the bucket at once, under a single bucket hold, and then
+ * handing them out to the thread without any locking.
+ *
+ * The cached blocks are regular volatile reservations - exactly the same as
+ * the ones created by palloc_reserve(). They hold a reference (nresv) on the
+ * run from which they originate, which prevents the run from being discarded
+ * or recycled while blocks are still sitting in a cache. Flushing the cache
+ * is therefore equivalent to canceling those reservations: blocks are
+ * returned to their bucket if the run is still attached, and the run is
+ * handed back to the heap once the last reservation is gone.
+ *
+ * Lock ordering: the cache collection lock is never held while acquiring
+ * a bucket, except during the heap cleanup, when no other thread can use
+ * the heap.
+ */
+
+#include "bucket.h"
+#include "heap.h"
+#include "out.h"
+#include "queue.h"
+#include "sys_util.h"
+#include "tcache.h"
+#include "valgrind_internal.h"
+
+struct tcache_entry {
+	struct memory_block m;
+	struct memory_block_reserved *mresv;
+};
+
+/* cached blocks of a single allocation class */
+struct tcache_bin {
+	unsigned nentries;
+	unsigned capacity;
+	struct tcache_entry entries[];
+};
+
+/* cache of a single thread */
+struct tcache_thread {
+	struct heap_tcache *tc;
+	PMDK_LIST_ENTRY(tcache_thread) next;
+
+	struct tcache_bin *bins[MAX_ALLOCATION_CLASSES];
+};
+
+struct heap_tcache {
+	struct palloc_heap *heap;
+
+	/* created on first enable, unused caches do not consume a key */
+	os_tls_key_t key;
+	int key_created;
+
+	/* protects the list of thread caches and the key creation */
+	os_mutex_t lock;
+	PMDK_LIST_HEAD(tcache_threads, tcache_thread) threads;
+
+	int enabled;
+	unsigned batch;
+};
+
+/*
+ * tcache_entry_release -- (internal) cancels the reservation of a cached
+ *	block, must be called without holding the bucket of the block
+ */
+static void
+tcache_entry_release(struct palloc_heap *heap, struct tcache_entry *e)
+{
+	struct memory_block_reserved *mresv = e->mresv;
+	if (mresv == NULL)
+		return;
+
+	if (util_fetch_and_sub64(&mresv->nresv, 1) == 1) {
+		VALGRIND_ANNOTATE_HAPPENS_AFTER(&mresv->nresv);
+		/*
+		 * The run is no longer used by any bucket nor reservation,
+		 * it can be given back to the heap.
+		 */
+		heap_discard_run(heap, &mresv->m);
+		Free(mresv);
+	} else {
+		VALGRIND_ANNOTATE_HAPPENS_BEFORE(&mresv->nresv);
+	}
+}
+
+/*
+ * tcache_bin_flush -- (internal) returns all blocks of a bin back to their
+ *	buckets
+ *
+ * Blocks which originate from the same bucket are returned under a single
+ * bucket hold.
+ */
+static void
+tcache_bin_flush(struct palloc_heap *heap, struct tcache_bin *bin)
+{
+	struct bucket_locked *locked = NULL;
+	struct bucket *b = NULL;
+
+	for (unsigned i = 0; i < bin->nentries; ++i) {
+		struct tcache_entry *e = &bin->entries[i];
+		if (e->mresv == NULL)
+			continue;
+
+		if (e->mresv->bucket != locked) {
+			if (b != NULL)
+				bucket_release(b);
+			locked = e->mresv->bucket;
+			b = bucket_acquire(locked);
+		}
+
+		/*
+		 * If the run is still the active memory block of the bucket
+		 * the block can be reused right away.
+		 */
+		bucket_try_insert_attached_block(b, &e->m);
+	}
+
+	if (b != NULL)
+		bucket_release(b);
+
+	for (unsigned i = 0; i < bin->nentries; ++i)
+		tcache_entry_release(heap, &bin->entries[i]);
+
+	bin->nentries = 0;
+}
+
+/*
+ * tcache_thread_delete -- (internal) flushes and deallocates a thread cache
+ */
+static void
+tcache_thread_delete(struct tcache_thread *t)
+{
+	for (int i = 0; i < MAX_ALLOCATION_CLASSES; ++i) {
+		if (t->bins[i] == NULL)
+			continue;
+
+		tcache_bin_flush(t->tc->heap, t->bins[i]);
+		Free(t->bins[i]);
+	}
+
+	Free(t);
+}
+
+/*
+ * tcache_thread_destructor -- (internal) flushes the cache of an exiting
+ *	thread
+ */
+static void
+tcache_thread_destructor(void *arg)
+{
+	struct tcache_thread *t = arg;
+	struct heap_tcache *tc = t->tc;
+
+	util_mutex_lock(&tc->lock);
+	PMDK_LIST_REMOVE(t, next);
+	util_mutex_unlock(&tc->lock);
+
+	tcache_thread_delete(t);
+}
+
+/*
+ * tcache_new -- creates a new thread cache collection for the heap
+ */
+struct heap_tcache *
+tcache_new(struct palloc_heap *heap)
+{
+	struct heap_tcache *tc = Malloc(sizeof(*tc));
+	if (tc == NULL)
+		goto error_tcache_malloc;
+
+	tc->heap = heap;
+	tc->key_created = 0;
+	tc->enabled = 0;
+	tc->batch = TCACHE_DEFAULT_BATCH;
+	PMDK_LIST_INIT(&tc->threads);
+	util_mutex_init(&tc->lock);
+
+	return tc;
+
+error_tcache_malloc:
+	return NULL;
+}
+
+/*
+ * tcache_delete -- flushes the caches of all threads and deletes
+ *	the collection
+ */
+void
+tcache_delete(struct heap_tcache *tc)
+{
+	util_mutex_lock(&tc->lock);
+	while (!PMDK_LIST_EMPTY(&tc->threads)) {
+		struct tcache_thread *t = PMDK_LIST_FIRST(&tc->threads);
+		PMDK_LIST_REMOVE(t, next);
+		tcache_thread_delete(t);
+	}
+	util_mutex_unlock(&tc->lock);
+
+	if (tc->key_created)
+		os_tls_key_delete(tc->key);
+	util_mutex_destroy(&tc->lock);
+	Free(tc);
+}
+
+/*
+ * tcache_get_enabled -- returns whether the thread cache is used for
+ *	allocations
+ */
+int
+tcache_get_enabled(struct heap_tcache *tc)
+{
+	int enabled;
+	util_atomic_load_explicit32(&tc->enabled, &enabled,
+		memory_order_acquire);
+
+	return enabled;
+}
+
+/*
+ * tcache_set_enabled -- enables or disables the thread cache
+ */
+int
+tcache_set_enabled(struct heap_tcache *tc, int enabled)
+{
+	util_mutex_lock(&tc->lock);
+	if (enabled && !tc->key_created) {
+		int ret = os_tls_key_create(&tc->key,
+			tcache_thread_destructor);
+		if (ret != 0) {
+			util_mutex_unlock(&tc->lock);
+			ERR_WO_ERRNO("cannot create thread cache key");
+			errno = ret;
+			return -1;
+		}
+		util_atomic_store_explicit32(&tc->key_created, 1,
+			memory_order_release);
+	}
+	util_mutex_unlock(&tc->lock);
+
+	/* publishes the key to the threads that observe the cache enabled */
+	util_atomic_store_explicit32(&tc->enabled, enabled,
+		memory_order_release);
+
+	return 0;
+}
+
+/*
+ * tcache_get_batch -- returns the number of blocks fetched in a single refill
+ */
+unsigned
+tcache_get_batch(struct heap_tcache *tc)
+{
+	unsigned batch;
+	util_atomic_load_explicit32(&tc->batch, &batch, memory_order_relaxed);
+
+	return batch;
+}
+
+/*
+ * tcache_set_batch -- sets the number of blocks fetched in a single refill
+ */
+int
+tcache_set_batch(struct heap_tcache *tc, unsigned batch)
+{
+	if (batch == 0 || batch > TCACHE_MAX_BATCH) {
+		ERR_WO_ERRNO("thread cache batch must be between 1 and %u",
+			TCACHE_MAX_BATCH);
+		errno = EINVAL;
+		return -1;
+	}
+
+	util_atomic_store_explicit32(&tc->batch, batch, memory_order_relaxed);
+
+	return 0;
+}
+
+/*
+ * tcache_thread_get -- (internal) returns the cache of the calling thread,
+ *	creates one if needed
+ */
+static struct tcache_thread *
+tcache_thread_get(struct heap_tcache *tc)
+{
+	struct tcache_thread *t = os_tls_get(tc->key);
+	if (t != NULL)
+		return t;
+
+	t = Zalloc(sizeof(*t));
+	if (t == NULL)
+		return NULL;
+
+	t->tc = tc;
+
+	util_mutex_lock(&tc->lock);
+	PMDK_LIST_INSERT_HEAD(&tc->threads, t, next);
+	util_mutex_unlock(&tc->lock);
+
+	os_tls_set(tc->key, t);
+
+	return t;
+}
+
+/*
+ * tcache_bin_get -- (internal) returns the bin of the allocation class with
+ *	at least the given capacity, the bin is (re)allocated only when empty
+ */
+static struct tcache_bin *
+tcache_bin_get(struct tcache_thread *t, uint8_t class_id, unsigned capacity)
+{
+	struct tcache_bin *bin = t->bins[class_id];
+	if (bin != NULL && (bin->nentries != 0 || bin->capacity >= capacity))
+		return bin;
+
+	ASSERT(bin == NULL || bin->nentries == 0);
+
+	struct tcache_bin *nbin = Realloc(bin, sizeof(*bin) +
+		sizeof(struct tcache_entry) * capacity);
+	if (nbin == NULL)
+		return bin;
+
+	nbin->nentries = 0;
+	nbin->capacity = capacity;
+	t->bins[class_id] = nbin;
+
+	return nbin;
+}
+
+/*
+ * tcache_bin_refill -- (internal) reserves a batch of blocks from the bucket
+ *	of the thread's arena
+ */
+static int
+tcache_bin_refill(struct palloc_heap *heap, struct tcache_bin *bin,
+	struct alloc_class *c, unsigned batch)
+{
+	ASSERTeq(bin->nentries, 0);
+	if (batch > bin->capacity)
+		batch = bin->capacity;
+
+	struct bucket *b = heap_bucket_acquire(heap, c->id,
+		HEAP_ARENA_PER_THREAD);
+
+	for (unsigned i = 0; i < batch; ++i) {
+		struct tcache_entry *e = &bin->entries[i];
+		e->m = MEMORY_BLOCK_NONE;
+		e->m.size_idx = 1;
+
+		if (heap_get_bestfit_block(heap, b, &e->m) != 0)
+			break;
+
+		/*
+		 * The active block can change in the middle of the refill if
+		 * the bucket runs dry, and so it has to be fetched for every
+		 * reserved block.
+		 */
+		if ((e->mresv = bucket_active_block(b)) != NULL)
+			util_fetch_and_add64(&e->mresv->nresv, 1);
+
+		bin->nentries++;
+	}
+
+	heap_bucket_release(b);
+
+	if (bin->nentries == 0)
+		return ENOMEM;
+
+	/*
+	 * Blocks are handed out from the end of the bin, reverse the order so
+	 * that consecutive allocations get increasing addresses, just like
+	 * without the cache.
+	 */
+	for (unsigned i = 0; i < bin->nentries / 2; ++i) {
+		struct tcache_entry tmp = bin->entries[i];
+		bin->entries[i] = bin->entries[bin->nentries - i - 1];
+		bin->entries[bin->nentries - i - 1] = tmp;
+	}
+
+	return 0;
+}
+
+/*
+ * tcache_get -- retrieves a reserved single-unit block of the allocation
+ *	class from the cache of the calling thread, refilling it if needed
+ *
+ * The returned block is already accounted for in the nresv counter of
+ * the returned reserved memory block.
+ */
+int
+tcache_get(struct heap_tcache *tc, struct alloc_class *c,
+	struct memory_block *m, struct memory_block_reserved **mresv)
+{
+	ASSERTeq(c->type, CLASS_RUN);
+
+	struct tcache_thread *t = tcache_thread_get(tc);
+	if (t == NULL)
+		return ENOMEM;
+
+	unsigned batch = tcache_get_batch(tc);
+	struct tcache_bin *bin = tcache_bin_get(t, c->id, batch);
+	if (bin == NULL)
+		return ENOMEM;
+
+	if (bin->nentries == 0) {
+		int ret = tcache_bin_refill(tc->heap, bin, c, batch);
+		if (ret != 0)
+			return ret;
+	}
+
+	struct tcache_entry *e = &bin->entries[--bin->nentries];
+	*m = e->m;
+	*mresv = e->mresv;
+
+	return 0;
+}
+
+/*
+ * tcache_put -- puts a reserved block, previously retrieved using
+ *	tcache_get, back into the cache of the calling thread
+ */
+void
+tcache_put(struct heap_tcache *tc, struct alloc_class *c,
+	const struct memory_block *m, struct memory_block_reserved *mresv)
+{
+	struct tcache_thread *t = os_tls_get(tc->key);
+	ASSERTne(t, NULL);
+
+	struct tcache_bin *bin = t->bins[c->id];
+	ASSERTne(bin, NULL);
+
+	/* the slot is guaranteed to be free, it was just taken from the bin */
+	ASSERT(bin->nentries < bin->capacity);
+	struct tcache_entry *e = &bin->entries[bin->nentries++];
+	e->m = *m;
+	e->mresv = mresv;
+}
+
+/*
+ * tcache_flush -- returns all blocks cached by the calling thread back to
+ *	their buckets
+ */
+void
+tcache_flush(struct heap_tcache *tc)
+{
+	int key_created;
+	util_atomic_load_explicit32(&tc->key_created, &key_created,
+		memory_order_acquire);
+	if (!key_created)
+		return;
+
+	struct tcache_thread *t = os_tls_get(tc->key);
+	if (t == NULL)
+		return;
+
+	for (int i = 0; i < MAX_ALLOCATION_CLASSES; ++i) {
+		if (t->bins[i] != NULL)
+			tcache_bin_flush(tc->heap, t->bins[i]);
+	}
+}
@@ -0,0 +1,56 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright 2026, Intel Corporation */
+
+/*
+ * tcache.h -- internal definitions for per-thread allocation cache
+ *
+ * The thread cache sits in front of the arena buckets. It keeps a small
+ * number of reserved, single-unit run blocks for every allocation class, so
+ * that the common allocation path only touches thread-local state.
+ *
+ * Only allocations are served from the cache. A freed run block is returned
+ * to the run's bitmap and accounted in the recycler, and it is not reserved
+ * by anyone, so the run can be reattached to any bucket and the block handed
+ * out again from there. Caching it would require taking a reservation on a
+ * run that might not be attached to a bucket at all.
+ */
+
+#ifndef LIBPMEMOBJ_TCACHE_H
+#define LIBPMEMOBJ_TCACHE_H 1
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "alloc_class.h"
+#include "memblock.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TCACHE_DEFAULT_BATCH 32
+#define TCACHE_MAX_BATCH 1024
+
+struct heap_tcache;
+
+struct heap_tcache *tcache_new(struct palloc_heap *heap);
+void tcache_delete(struct heap_tcache *tc);
+
+int tcache_get_enabled(struct heap_tcache *tc);
+int tcache_set_enabled(struct heap_tcache *tc, int enabled);
+
+unsigned tcache_get_batch(struct heap_tcache *tc);
+int tcache_set_batch(struct heap_tcache *tc, unsigned batch);
+
+int tcache_get(struct heap_tcache *tc, struct alloc_class *c,
+	struct memory_block *m, struct memory_block_reserved **mresv);
+void tcache_put(struct heap_tcache *tc, struct alloc_class *c,
+	const struct memory_block *m, struct memory_block_reserved *mresv);
+
+void tcache_flush(struct heap_tcache *tc);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -8,13 +8,16 @@
 #include <inttypes.h>
 #include <wchar.h>
 #include <stdarg.h>
+#include <time.h>
 
 #include "queue.h"
-#include "ravl.h"
 #include "obj.h"
 #include "core_assert.h"
 #include "pmalloc.h"
+#include "sys_util.h"
 #include "tx.h"
+#include "tx_ranges.h"
+#include "tx_versions.h"
 #include "valgrind_internal.h"
 #include "memops.h"
 
@@ -24,6 +27,16 @@ struct tx_data {
 	enum pobj_tx_failure_behavior failure_behavior;
 };
 
+/*
+ * A write buffered in DRAM until the commit, when it's logged in the redo log,
+ * see pmemobj_tx_xwrite_direct.
+ */
+struct tx_redo_write {
+	uint64_t offset; /* destination in the pool */
+	size_t size;
+	size_t data; /* offset of the new data in the write buffer */
+};
+
 struct tx {
 	PMEMobjpool *pop;
 	enum pobj_tx_stage stage;
@@ -32,18 +45,78 @@ struct tx {
 	PMDK_SLIST_HEAD(txl, tx_lock_data) tx_locks;
 	PMDK_SLIST_HEAD(txd, tx_data) tx_entries;
 
-	struct ravl *ranges;
+	struct tx_ranges ranges;
 
-	VEC(, struct pobj_action) actions;
+	VEC(tx_actions, struct pobj_action) actions;
 	VEC(, struct user_buffer_def) redo_userbufs;
 	size_t redo_userbufs_capacity;
 
+	VEC(, struct tx_redo_write) redo_writes;
+	char *redo_data; /* write buffer */
+	size_t redo_data_size;
+	size_t redo_data_capacity;
+	size_t redo_nbytes; /* size of the redo log entries of the writes */
+
 	pmemobj_tx_callback stage_callback;
 	void *stage_callback_arg;
 
 	int first_snapshot;
 
 	void *user_data;
+
+	/* optimistic concurrency control, NULL table if disabled */
+	struct tx_versions *versions;
+	struct tx_version_set version_set;
+
+	/* group commit, protected by the lock of the commit group */
+	struct tx *group_next;
+	int group_durable;
+};
+
+/*
+ * Group commit state of a pool. A committing transaction joins the group
+ * and, if no other transaction is flushing at the moment, becomes the leader:
+ * it flushes the ranges of all the transactions that joined so far and makes
+ * them durable with a single drain. The transactions that join while the
+ * leader is busy wait for it to finish and then one of them leads the next
+ * group.
+ */
+struct tx_commit_group {
+	os_mutex_t lock;
+	os_cond_t cond;
+
+	struct tx *pending; /* transactions waiting for a leader */
+	int leader; /* set while a leader is flushing */
+};
+
+/*
+ * A committed transaction whose lane is still held until the volatile
+ * finalization of its actions and the cleanup of its logs is done.
+ */
+struct tx_post_commit_entry {
+	struct lane *lane;
+	unsigned lane_idx;
+	struct tx_actions actions;
+};
+
+/*
+ * Post commit queue of a pool. Once the redo log of a transaction is
+ * processed the transaction is durable, and the remaining work - returning
+ * the freed blocks to the heap, clearing reservations and clobbering the
+ * logs - can be done by the workers, off the critical path of the
+ * committing thread. The transaction keeps its lane until that is done.
+ */
+struct tx_post_commit_queue {
+	os_mutex_t lock;
+	os_cond_t cond;
+
+	struct tx_post_commit_entry *entries; /* ring of 'depth' entries */
+	unsigned depth;
+	unsigned head;
+	unsigned count;
+
+	unsigned nworkers;
+	int stop; /* set by tx_post_commit_stop until tx_post_commit_start */
 };
 
 /*
@@ -79,29 +152,6 @@ struct tx_alloc_args {
 #define ALLOC_ARGS(flags)\
 (struct tx_alloc_args){flags, NULL, 0}
 
-struct tx_range_def {
-	uint64_t offset;
-	uint64_t size;
-	uint64_t flags;
-};
-
-/*
- * tx_range_def_cmp -- compares two snapshot ranges
- */
-static int
-tx_range_def_cmp(const void *lhs, const void *rhs)
-{
-	const struct tx_range_def *l = lhs;
-	const struct tx_range_def *r = rhs;
-
-	if (l->offset > r->offset)
-		return 1;
-	else if (l->offset < r->offset)
-		return -1;
-
-	return 0;
-}
-
 /*
  * tx_params_new -- creates a new transactional parameters instance and fills it
  *	with default values.
@@ -113,9 +163,44 @@ tx_params_new(void)
 	if (tx_params == NULL)
 		return NULL;
 
+	tx_params->commit_group = Malloc(sizeof(*tx_params->commit_group));
+	if (tx_params->commit_group == NULL)
+		goto err_group;
+
+	tx_params->post_commit = Malloc(sizeof(*tx_params->post_commit));
+	if (tx_params->post_commit == NULL)
+		goto err_post_commit;
+
 	tx_params->cache_size = TX_DEFAULT_RANGE_CACHE_SIZE;
+	tx_params->cache_retain = TX_DEFAULT_RANGE_CACHE_RETAIN;
+	tx_params->snapshot_nt_threshold = TX_DEFAULT_SNAPSHOT_NT_THRESHOLD;
+	tx_params->group_commit = 0;
+	tx_params->optimistic = 0;
+	tx_params->versions = NULL;
+
+	struct tx_commit_group *g = tx_params->commit_group;
+	util_mutex_init(&g->lock);
+	util_cond_init(&g->cond);
+	g->pending = NULL;
+	g->leader = 0;
+
+	struct tx_post_commit_queue *q = tx_params->post_commit;
+	util_mutex_init(&q->lock);
+	util_cond_init(&q->cond);
+	q->entries = NULL;
+	q->depth = 0;
+	q->head = 0;
+	q->count = 0;
+	q->nworkers = 0;
+	q->stop = 0;
 
 	return tx_params;
+
+err_post_commit:
+	Free(tx_params->commit_group);
+err_group:
+	Free(tx_params);
+	return NULL;
 }
 
 /*
@@ -124,6 +209,18 @@ tx_params_new(void)
 void
 tx_params_delete(struct tx_parameters *tx_params)
 {
+	util_cond_destroy(&tx_params->commit_group->cond);
+	util_mutex_destroy(&tx_params->commit_group->lock);
+	Free(tx_params->commit_group);
+
+	ASSERTeq(tx_params->post_commit->count, 0);
+	util_cond_destroy(&tx_params->post_commit->cond);
+	util_mutex_destroy(&tx_params->post_commit->lock);
+	Free(tx_params->post_commit->entries);
+	Free(tx_params->post_commit);
+
+	tx_versions_delete(tx_params->versions);
+
 	Free(tx_params);
 }
 
@@ -178,6 +275,18 @@ tx_action_reserve(struct tx *tx, size_t n)
 	size_t entries_size = (VEC_SIZE(&tx->actions) + n) *
 		sizeof(struct ulog_entry_val);
 
+	if (tx->redo_nbytes != 0) {
+		/*
+		 * The buffered writes are logged before the actions, and each
+		 * of the user buffers might split one of them.
+		 */
+		size_t buf_nbytes = tx->redo_nbytes +
+			VEC_SIZE(&tx->redo_userbufs) * CACHELINE_SIZE;
+
+		return operation_reserve_buffers(tx->lane->external,
+			buf_nbytes, entries_size, tx->redo_userbufs_capacity);
+	}
+
 	/* take the provided user buffers into account when reserving */
 	entries_size -= MIN(tx->redo_userbufs_capacity, entries_size);
 
@@ -401,29 +510,66 @@ tx_abort_set(PMEMobjpool *pop, struct lane *lane)
 }
 
 /*
- * tx_flush_range -- (internal) flush one range
+ * tx_flush_ctx -- the state of flushing the ranges of a transaction
+ */
+struct tx_flush_ctx {
+	PMEMobjpool *pop;
+
+	/* the range not flushed yet, it may share a cache line with the next */
+	char *start;
+	char *end;
+};
+
+/*
+ * tx_flush_pending -- (internal) flush the pending range, if any
  */
 static void
-tx_flush_range(void *data, void *ctx)
+tx_flush_pending(struct tx_flush_ctx *fctx)
 {
-	PMEMobjpool *pop = ctx;
-	struct tx_range_def *range = data;
-	if (!(range->flags & POBJ_FLAG_NO_FLUSH)) {
-		pmemops_xflush(&pop->p_ops, OBJ_OFF_TO_PTR(pop, range->offset),
-				range->size, PMEMOBJ_F_RELAXED);
+	if (fctx->start == fctx->end)
+		return;
+
+	pmemops_xflush(&fctx->pop->p_ops, fctx->start,
+			(size_t)(fctx->end - fctx->start), PMEMOBJ_F_RELAXED);
+	fctx->start = fctx->end = NULL;
+}
+
+/*
+ * tx_flush_range -- (internal) flush one range
+ *
+ * The ranges come in the ascending order, the ones which share a cache line
+ * with the pending range are merged into it, so that each cache line is
+ * flushed once.
+ */
+static void
+tx_flush_range(struct tx_range_def *range, void *ctx)
+{
+	struct tx_flush_ctx *fctx = ctx;
+	PMEMobjpool *pop = fctx->pop;
+	char *start = OBJ_OFF_TO_PTR(pop, range->offset);
+	char *end = start + range->size;
+
+	if (!(range->flags & POBJ_FLAG_NO_FLUSH) && range->size != 0) {
+		if (fctx->start != fctx->end &&
+		    ALIGN_DOWN((uintptr_t)start, CACHELINE_SIZE) <=
+		    ALIGN_UP((uintptr_t)fctx->end, CACHELINE_SIZE)) {
+			fctx->end = MAX(fctx->end, end);
+		} else {
+			tx_flush_pending(fctx);
+			fctx->start = start;
+			fctx->end = end;
+		}
 	}
-	VALGRIND_REMOVE_FROM_TX(OBJ_OFF_TO_PTR(pop, range->offset),
-		range->size);
+	VALGRIND_REMOVE_FROM_TX(start, range->size);
 }
 
 /*
  * tx_clean_range -- (internal) clean one range
  */
 static void
-tx_clean_range(void *data, void *ctx)
+tx_clean_range(struct tx_range_def *range, void *ctx)
 {
 	PMEMobjpool *pop = ctx;
-	struct tx_range_def *range = data;
 	VALGRIND_REMOVE_FROM_TX(OBJ_OFF_TO_PTR(pop, range->offset),
 		range->size);
 	VALGRIND_SET_CLEAN(OBJ_OFF_TO_PTR(pop, range->offset), range->size);
@@ -437,9 +583,64 @@ tx_pre_commit(struct tx *tx)
 {
 	LOG(5, NULL);
 
-	/* Flush all regions and destroy the whole tree. */
-	ravl_delete_cb(tx->ranges, tx_flush_range, tx->pop);
-	tx->ranges = NULL;
+	struct tx_flush_ctx fctx = {tx->pop, NULL, NULL};
+
+	/* Flush all regions and destroy the whole index. */
+	tx_ranges_fini(&tx->ranges, tx_flush_range, &fctx);
+	tx_flush_pending(&fctx);
+}
+
+/*
+ * tx_pre_commit_group -- (internal) makes the ranges of the transaction
+ *	durable together with the ones of the other concurrent committers
+ */
+static void
+tx_pre_commit_group(struct tx *tx)
+{
+	LOG(5, NULL);
+
+	PMEMobjpool *pop = tx->pop;
+	struct tx_commit_group *g = pop->tx_params->commit_group;
+
+	util_mutex_lock(&g->lock);
+
+	tx->group_durable = 0;
+	tx->group_next = g->pending;
+	g->pending = tx;
+
+	while (!tx->group_durable) {
+		if (g->leader) {
+			os_cond_wait(&g->cond, &g->lock);
+			continue;
+		}
+
+		g->leader = 1;
+		struct tx *group = g->pending;
+		g->pending = NULL;
+
+		util_mutex_unlock(&g->lock);
+
+		/*
+		 * The stores of the other transactions are visible to
+		 * the leader, and flushing a cache line writes it back
+		 * regardless of which CPU modified it, so the leader's drain
+		 * makes the whole group durable.
+		 */
+		for (struct tx *t = group; t != NULL; t = t->group_next)
+			tx_pre_commit(t);
+
+		pmemops_drain(&pop->p_ops);
+
+		util_mutex_lock(&g->lock);
+
+		for (struct tx *t = group; t != NULL; t = t->group_next)
+			t->group_durable = 1;
+
+		g->leader = 0;
+		os_cond_broadcast(&g->cond);
+	}
+
+	util_mutex_unlock(&g->lock);
 }
 
 /*
@@ -454,10 +655,13 @@ tx_abort(PMEMobjpool *pop, struct lane *lane)
 
 	tx_abort_set(pop, lane);
 
-	ravl_delete_cb(tx->ranges, tx_clean_range, pop);
+	/* the rolled back stripes are unlocked with new versions */
+	if (tx->versions != NULL)
+		tx_versions_release(tx->versions, &tx->version_set);
+
+	tx_ranges_fini(&tx->ranges, tx_clean_range, pop);
 	palloc_cancel(&pop->heap,
 		VEC_ARR(&tx->actions), VEC_SIZE(&tx->actions));
-	tx->ranges = NULL;
 }
 
 /*
@@ -558,7 +762,7 @@ release_and_free_tx_locks(struct tx *tx)
 
 /*
  * tx_lane_ranges_insert_def -- (internal) allocates and inserts a new range
- *	definition into the ranges tree
+ *	definition into the ranges index
  */
 static int
 tx_lane_ranges_insert_def(PMEMobjpool *pop, struct tx *tx,
@@ -570,9 +774,9 @@ tx_lane_ranges_insert_def(PMEMobjpool *pop, struct tx *tx,
 	LOG(3, "rdef->offset %"PRIu64" rdef->size %"PRIu64,
 		rdef->offset, rdef->size);
 
-	int ret = ravl_emplace_copy(tx->ranges, rdef);
+	int ret = tx_ranges_insert(&tx->ranges, rdef);
 	if (ret && errno == EEXIST)
-		CORE_LOG_FATAL("invalid state of ranges tree");
+		CORE_LOG_FATAL("invalid state of ranges index");
 	return ret;
 }
 
@@ -711,6 +915,10 @@ tx_construct_user_buffer(struct tx *tx, void *addr, size_t size,
 			goto err;
 		tx->redo_userbufs_capacity +=
 			userbuf.size - TX_INTENT_LOG_BUFFER_OVERHEAD;
+
+		/* the new buffer might split one of the buffered writes */
+		if (tx->redo_nbytes != 0 && tx_action_reserve(tx, 0) != 0)
+			goto err;
 	} else {
 		operation_add_user_buffer(ctx, &userbuf);
 	}
@@ -749,23 +957,37 @@ pmemobj_tx_begin(PMEMobjpool *pop, jmp_buf env, ...)
 	} else if (tx->stage == TX_STAGE_NONE) {
 		VALGRIND_START_TX;
 
-		lane_hold(pop, &tx->lane);
+		unsigned lane_idx = lane_hold(pop, &tx->lane);
+		operation_set_retain(tx->lane->undo,
+			pop->tx_params->cache_retain);
+		operation_set_nt_threshold(tx->lane->undo,
+			pop->tx_params->snapshot_nt_threshold);
 		operation_start(tx->lane->undo);
 
 		VEC_INIT(&tx->actions);
 		VEC_INIT(&tx->redo_userbufs);
 		tx->redo_userbufs_capacity = 0;
+		VEC_INIT(&tx->redo_writes);
+		tx->redo_data = NULL;
+		tx->redo_data_size = 0;
+		tx->redo_data_capacity = 0;
+		tx->redo_nbytes = 0;
 		PMDK_SLIST_INIT(&tx->tx_entries);
 		PMDK_SLIST_INIT(&tx->tx_locks);
 
-		tx->ranges = ravl_new_sized(tx_range_def_cmp,
-			sizeof(struct tx_range_def));
+		tx_ranges_init(&tx->ranges);
 
 		tx->pop = pop;
 
 		tx->first_snapshot = 1;
 
 		tx->user_data = NULL;
+
+		/* the lane identifies the transaction while it's running */
+		tx->versions = pop->tx_params->optimistic ?
+			pop->tx_params->versions : NULL;
+		if (tx->versions != NULL)
+			tx_version_set_init(&tx->version_set, lane_idx);
 	} else {
 		CORE_LOG_FATAL("Invalid stage %d to begin new transaction",
 			tx->stage);
@@ -975,12 +1197,192 @@ pmemobj_tx_errno(void)
 	return get_tx()->last_errnum;
 }
 
+/* the longest wait between two runs, as a shift of one microsecond */
+#define TX_RETRY_MAX_SHIFT 10
+
+/*
+ * pmemobj_tx_retry -- decides whether a transaction started with
+ *	TX_BEGIN_RETRY is run again, and if so, backs off before that so that
+ *	the conflicting transactions can finish
+ */
+int
+pmemobj_tx_retry(int attempt)
+{
+	LOG(3, "attempt %d", attempt);
+
+	if (attempt == 0)
+		return 1;
+
+	/* a nested transaction is retried as a part of the outermost one */
+	struct tx *tx = get_tx();
+	if (tx->last_errnum != EAGAIN || tx->stage != TX_STAGE_NONE ||
+	    attempt >= POBJ_TX_RETRY_MAX)
+		return 0;
+
+	if (attempt > 1) {
+		int shift = MIN(attempt - 2, TX_RETRY_MAX_SHIFT);
+		struct timespec wait = {0, 1000L << shift};
+		nanosleep(&wait, NULL);
+	}
+
+	return 1;
+}
+
+/*
+ * tx_log_redo_writes -- (internal) logs the buffered writes in the redo log,
+ *	the space for them was reserved when they were made
+ */
+static void
+tx_log_redo_writes(struct tx *tx)
+{
+	struct tx_redo_write *w;
+	VEC_FOREACH_BY_PTR(w, &tx->redo_writes) {
+		operation_add_shadow_buffer(tx->lane->external,
+			OBJ_OFF_TO_PTR(tx->pop, w->offset),
+			tx->redo_data + w->data, w->size,
+			ULOG_OPERATION_BUF_CPY);
+	}
+}
+
 static void
 tx_post_commit(struct tx *tx)
 {
 	operation_finish(tx->lane->undo, 0);
 }
 
+/*
+ * tx_post_commit_process -- (internal) finishes a committed transaction
+ *	taken from the post commit queue and releases its lane
+ */
+static void
+tx_post_commit_process(PMEMobjpool *pop, struct tx_post_commit_entry *e)
+{
+	palloc_publish_finish(&pop->heap, VEC_ARR(&e->actions),
+		VEC_SIZE(&e->actions), e->lane->external);
+
+	operation_finish(e->lane->undo, 0);
+
+	lane_release_detached(pop, e->lane_idx);
+
+	VEC_DELETE(&e->actions);
+}
+
+/*
+ * tx_post_commit_defer -- (internal) hands the remainder of the commit over
+ *	to the post commit workers, returns -1 if it has to be done by the
+ *	calling thread
+ */
+static int
+tx_post_commit_defer(struct tx *tx)
+{
+	PMEMobjpool *pop = tx->pop;
+	struct tx_post_commit_queue *q = pop->tx_params->post_commit;
+
+	util_mutex_lock(&q->lock);
+
+	/*
+	 * Every queued transaction holds a lane, leave enough of them for
+	 * the workers, which need one to free the log extensions.
+	 */
+	if (q->nworkers == 0 || q->stop || q->count == q->depth ||
+	    q->count + q->nworkers >= pop->lanes_desc.runtime_nlanes)
+		goto err;
+
+	unsigned lane_idx;
+	if (lane_detach(pop, &lane_idx) != 0)
+		goto err;
+
+	struct tx_post_commit_entry *e =
+		&q->entries[(q->head + q->count) % q->depth];
+	e->lane = tx->lane;
+	e->lane_idx = lane_idx;
+	e->actions = tx->actions;
+	VEC_INIT(&tx->actions);
+
+	q->count++;
+	os_cond_signal(&q->cond);
+
+	util_mutex_unlock(&q->lock);
+
+	return 0;
+
+err:
+	util_mutex_unlock(&q->lock);
+	return -1;
+}
+
+/*
+ * tx_post_commit_worker -- (internal) finishes the queued transactions in
+ *	the calling thread until tx_post_commit_stop is called, returns
+ *	immediately if the workers were stopped and not started again
+ */
+static void
+tx_post_commit_worker(PMEMobjpool *pop)
+{
+	struct tx_post_commit_queue *q = pop->tx_params->post_commit;
+
+	util_mutex_lock(&q->lock);
+	q->nworkers++;
+
+	/* the queue is always drained before the workers return */
+	while (q->count != 0 || !q->stop) {
+		if (q->count == 0) {
+			os_cond_wait(&q->cond, &q->lock);
+			continue;
+		}
+
+		struct tx_post_commit_entry e = q->entries[q->head];
+		q->head = (q->head + 1) % q->depth;
+		q->count--;
+
+		util_mutex_unlock(&q->lock);
+
+		tx_post_commit_process(pop, &e);
+
+		util_mutex_lock(&q->lock);
+	}
+
+	q->nworkers--;
+	os_cond_broadcast(&q->cond);
+	util_mutex_unlock(&q->lock);
+}
+
+/*
+ * tx_post_commit_stop -- stops all post commit workers and waits for them to
+ *	finish the queued transactions, the workers started later return
+ *	immediately until tx_post_commit_start is called
+ */
+void
+tx_post_commit_stop(PMEMobjpool *pop)
+{
+	struct tx_post_commit_queue *q = pop->tx_params->post_commit;
+
+	util_mutex_lock(&q->lock);
+
+	q->stop = 1;
+	os_cond_broadcast(&q->cond);
+	while (q->nworkers != 0)
+		os_cond_wait(&q->cond, &q->lock);
+
+	ASSERTeq(q->count, 0);
+
+	util_mutex_unlock(&q->lock);
+}
+
+/*
+ * tx_post_commit_start -- (internal) allows the post commit workers to run
+ *	again after they were stopped
+ */
+static void
+tx_post_commit_start(PMEMobjpool *pop)
+{
+	struct tx_post_commit_queue *q = pop->tx_params->post_commit;
+
+	util_mutex_lock(&q->lock);
+	q->stop = 0;
+	util_mutex_unlock(&q->lock);
+}
+
 /*
  * pmemobj_tx_commit -- commits current transaction
  */
@@ -1007,10 +1409,34 @@ pmemobj_tx_commit(void)
 
 		PMEMobjpool *pop = tx->pop;
 
+		/*
+		 * The log space reserved for the buffered writes might have
+		 * been released by an atomic operation run in the same lane.
+		 */
+		if (tx->redo_nbytes != 0 && tx_action_reserve(tx, 0) != 0) {
+			ERR_WO_ERRNO(
+				"tx.write: failed to reserve the redo log");
+			obj_tx_abort(ENOMEM, 0);
+			PMEMOBJ_API_END();
+			return;
+		}
+
+		/* all the written stripes are locked at this point */
+		if (tx->versions != NULL && tx_versions_validate(
+				tx->versions, &tx->version_set) != 0) {
+			obj_tx_abort(EAGAIN, 0);
+			PMEMOBJ_API_END();
+			return;
+		}
+
 		/* pre-commit phase */
-		tx_pre_commit(tx);
+		if (pop->tx_params->group_commit) {
+			tx_pre_commit_group(tx);
+		} else {
+			tx_pre_commit(tx);
 
-		pmemops_drain(&pop->p_ops);
+			pmemops_drain(&pop->p_ops);
+		}
 
 		operation_start(tx->lane->external);
 
@@ -1018,12 +1444,25 @@ pmemobj_tx_commit(void)
 		VEC_FOREACH_BY_PTR(userbuf, &tx->redo_userbufs)
 			operation_add_user_buffer(tx->lane->external, userbuf);
 
-		palloc_publish(&pop->heap, VEC_ARR(&tx->actions),
+		/* must precede the entries of the actions */
+		tx_log_redo_writes(tx);
+
+		palloc_publish_process(&pop->heap, VEC_ARR(&tx->actions),
 			VEC_SIZE(&tx->actions), tx->lane->external);
 
-		tx_post_commit(tx);
+		/* the transaction is durable at this point */
+		if (tx->versions != NULL)
+			tx_versions_release(tx->versions, &tx->version_set);
 
-		lane_release(pop);
+		if (tx_post_commit_defer(tx) != 0) {
+			palloc_publish_finish(&pop->heap,
+				VEC_ARR(&tx->actions), VEC_SIZE(&tx->actions),
+				tx->lane->external);
+
+			tx_post_commit(tx);
+
+			lane_release(pop);
+		}
 
 		tx->lane = NULL;
 	}
@@ -1076,6 +1515,14 @@ pmemobj_tx_end(void)
 		tx->stage = TX_STAGE_NONE;
 		VEC_DELETE(&tx->actions);
 		VEC_DELETE(&tx->redo_userbufs);
+		VEC_DELETE(&tx->redo_writes);
+		Free(tx->redo_data);
+		tx->redo_data = NULL;
+
+		if (tx->versions != NULL) {
+			tx_version_set_fini(&tx->version_set);
+			tx->versions = NULL;
+		}
 
 		if (tx->stage_callback) {
 			pmemobj_tx_callback cb = tx->stage_callback;
@@ -1244,6 +1691,11 @@ pmemobj_tx_add_common(struct tx *tx, struct tx_range_def *args)
 		return obj_tx_fail_err(EINVAL, args->flags);
 	}
 
+	/* the range must be locked before it's modified in place */
+	if (tx->versions != NULL && tx_versions_lock(tx->versions,
+			&tx->version_set, args->offset, args->size) != 0)
+		return obj_tx_fail_err(errno, args->flags);
+
 	int ret = 0;
 
 	/*
@@ -1251,24 +1703,21 @@ pmemobj_tx_add_common(struct tx *tx, struct tx_range_def *args)
 	 * snapshot.
 	 */
 	struct tx_range_def r = *args;
-	struct tx_range_def search = {0, 0, 0};
 	/*
 	 * If the range is directly adjacent to an existing one,
 	 * they can be merged, so search for less or equal elements.
 	 */
-	enum ravl_predicate p = RAVL_PREDICATE_LESS_EQUAL;
-	struct ravl_node *nprev = NULL;
+	enum tx_ranges_predicate p = TX_RANGES_LESS_EQUAL;
+	struct tx_range_def *fprev = NULL;
 	while (r.size != 0) {
-		search.offset = r.offset + r.size;
-		struct ravl_node *n = ravl_find(tx->ranges, &search, p);
+		struct tx_range_def *f = tx_ranges_find(&tx->ranges,
+			r.offset + r.size, p);
 		/*
 		 * We have to skip searching for LESS_EQUAL because
 		 * the snapshot we would find is the one that was just
 		 * created.
 		 */
-		p = RAVL_PREDICATE_LESS;
-
-		struct tx_range_def *f = n ? ravl_data(n) : NULL;
+		p = TX_RANGES_LESS;
 
 		size_t fend = f == NULL ? 0: f->offset + f->size;
 		size_t rend = r.offset + r.size;
@@ -1285,20 +1734,19 @@ pmemobj_tx_add_common(struct tx *tx, struct tx_range_def *args)
 			 * or	+--- (no overlap)
 			 * or	---+ (adjacent on on right side)
 			 */
-			if (nprev != NULL) {
+			if (fprev != NULL) {
 				/*
 				 * But, if we have an existing adjacent snapshot
 				 * on the right side, we can just extend it to
 				 * include the desired range.
 				 */
-				struct tx_range_def *fprev = ravl_data(nprev);
 				ASSERTeq(rend, fprev->offset);
 				fprev->offset -= r.size;
 				fprev->size += r.size;
 			} else {
 				/*
 				 * If we don't have anything adjacent, create
-				 * a new range in the tree.
+				 * a new range in the index.
 				 */
 				ret = tx_lane_ranges_insert_def(tx->pop,
 					tx, &r);
@@ -1343,12 +1791,15 @@ pmemobj_tx_add_common(struct tx *tx, struct tx_range_def *args)
 			 * If there's a snapshot adjacent on right side, merge
 			 * the two ranges together.
 			 */
-			if (nprev != NULL) {
-				struct tx_range_def *fprev = ravl_data(nprev);
+			if (fprev != NULL) {
 				ASSERTeq(rend, fprev->offset);
 				f->size += fprev->size;
 				pmemobj_tx_merge_flags(f, fprev);
-				ravl_remove(tx->ranges, nprev);
+				/*
+				 * The ranges before the removed one stay in
+				 * place, so f is still valid.
+				 */
+				tx_ranges_remove(&tx->ranges, fprev);
 			}
 		} else if (fend >= r.offset) {
 			/*
@@ -1367,7 +1818,7 @@ pmemobj_tx_add_common(struct tx *tx, struct tx_range_def *args)
 			 * on this information without risking overwriting an
 			 * existing one. We have to continue iterating, but we
 			 * keep the information about adjacent snapshots in the
-			 * nprev variable.
+			 * fprev variable.
 			 */
 			size_t overlap = rend - MAX(f->offset, r.offset);
 			r.size -= overlap;
@@ -1376,7 +1827,7 @@ pmemobj_tx_add_common(struct tx *tx, struct tx_range_def *args)
 			ASSERT(0);
 		}
 
-		nprev = n;
+		fprev = f;
 	}
 
 	if (ret != 0) {
@@ -1556,55 +2007,393 @@ pmemobj_tx_xadd_range(PMEMoid oid, uint64_t hoff, size_t size, uint64_t flags)
 }
 
 /*
- * pmemobj_tx_alloc -- allocates a new object
+ * tx_write_common -- (internal) buffers a write to be logged in the redo log
  */
-PMEMoid
-pmemobj_tx_alloc(size_t size, uint64_t type_num)
+static int
+tx_write_common(struct tx *tx, uint64_t offset, const void *src, size_t size,
+	uint64_t flags)
 {
-	LOG(3, NULL);
+	if (size == 0)
+		return 0;
 
-	PMEMOBJ_API_START();
-	struct tx *tx = get_tx();
+	uint64_t heap_end = tx->pop->heap_offset + tx->pop->heap_size;
+	if (offset < tx->pop->heap_offset || size > heap_end - offset) {
+		ERR_WO_ERRNO("write outside of the heap");
+		return obj_tx_fail_err(EINVAL, flags);
+	}
 
-	ASSERT_IN_TX(tx);
-	ASSERT_TX_STAGE_WORK(tx);
+	if (tx->versions != NULL && tx_versions_lock(tx->versions,
+			&tx->version_set, offset, size) != 0)
+		return obj_tx_fail_err(errno, flags);
 
-	uint64_t flags = tx_abort_on_failure_flag(tx);
+	/* a repeated write of the same range reuses its buffer */
+	if (VEC_SIZE(&tx->redo_writes) != 0) {
+		struct tx_redo_write *last = &VEC_BACK(&tx->redo_writes);
+		if (last->offset == offset && last->size == size) {
+			memcpy(tx->redo_data + last->data, src, size);
+			return 0;
+		}
+	}
 
-	PMEMoid oid;
-	if (size == 0) {
-		ERR_WO_ERRNO("allocation with size 0");
-		oid = obj_tx_fail_null(EINVAL, flags);
-		PMEMOBJ_API_END();
-		return oid;
+	if (tx->redo_data_size + size > tx->redo_data_capacity) {
+		size_t ncapacity = MAX(tx->redo_data_capacity * 2,
+			tx->redo_data_size + size);
+		char *data = Realloc(tx->redo_data, ncapacity);
+		if (data == NULL) {
+			ERR_W_ERRNO("Realloc");
+			return obj_tx_fail_err(ENOMEM, flags);
+		}
+		tx->redo_data = data;
+		tx->redo_data_capacity = ncapacity;
 	}
 
-	oid = tx_alloc_common(tx, size, (type_num_t)type_num,
-			constructor_tx_alloc, ALLOC_ARGS(flags));
+	struct tx_redo_write w = {
+		.offset = offset,
+		.size = size,
+		.data = tx->redo_data_size,
+	};
+	if (VEC_PUSH_BACK(&tx->redo_writes, w) != 0) {
+		ERR_WO_ERRNO("out of memory");
+		return obj_tx_fail_err(ENOMEM, flags);
+	}
 
-	PMEMOBJ_API_END();
-	return oid;
+	size_t nbytes = ALIGN_UP(sizeof(struct ulog_entry_buf) + size,
+		CACHELINE_SIZE);
+	tx->redo_nbytes += nbytes;
+
+	if (tx_action_reserve(tx, 0) != 0) {
+		tx->redo_nbytes -= nbytes;
+		VEC_POP_BACK(&tx->redo_writes);
+		ERR_WO_ERRNO("tx.write: failed to reserve the redo log");
+		return obj_tx_fail_err(ENOMEM, flags);
+	}
+
+	memcpy(tx->redo_data + tx->redo_data_size, src, size);
+	tx->redo_data_size += size;
+
+	return 0;
 }
 
 /*
- * pmemobj_tx_zalloc -- allocates a new zeroed object
+ * pmemobj_tx_xwrite_direct -- logs the new contents of a memory range,
+ *	which are written to it when the transaction commits
  */
-PMEMoid
-pmemobj_tx_zalloc(size_t size, uint64_t type_num)
+int
+pmemobj_tx_xwrite_direct(void *dest, const void *src, size_t size,
+	uint64_t flags)
 {
 	LOG(3, NULL);
+
+	PMEMOBJ_API_START();
 	struct tx *tx = get_tx();
 
 	ASSERT_IN_TX(tx);
 	ASSERT_TX_STAGE_WORK(tx);
 
-	uint64_t flags = POBJ_FLAG_ZERO;
+	int ret;
+
 	flags |= tx_abort_on_failure_flag(tx);
 
-	PMEMOBJ_API_START();
-	PMEMoid oid;
-	if (size == 0) {
-		ERR_WO_ERRNO("allocation with size 0");
+	if (flags & ~POBJ_XWRITE_VALID_FLAGS) {
+		ERR_WO_ERRNO("unknown flags 0x%" PRIx64, flags
+			& ~POBJ_XWRITE_VALID_FLAGS);
+		ret = obj_tx_fail_err(EINVAL, flags);
+		PMEMOBJ_API_END();
+		return ret;
+	}
+
+	if (!OBJ_PTR_FROM_POOL(tx->pop, dest)) {
+		ERR_WO_ERRNO("object outside of pool");
+		ret = obj_tx_fail_err(EINVAL, flags);
+		PMEMOBJ_API_END();
+		return ret;
+	}
+
+	ret = tx_write_common(tx, (uint64_t)((char *)dest - (char *)tx->pop),
+		src, size, flags);
+
+	PMEMOBJ_API_END();
+	return ret;
+}
+
+/*
+ * pmemobj_tx_write_direct -- logs the new contents of a memory range,
+ *	which are written to it when the transaction commits
+ */
+int
+pmemobj_tx_write_direct(void *dest, const void *src, size_t size)
+{
+	return pmemobj_tx_xwrite_direct(dest, src, size, 0);
+}
+
+/*
+ * pmemobj_tx_xwrite -- logs the new contents of a part of an object,
+ *	which are written to it when the transaction commits
+ */
+int
+pmemobj_tx_xwrite(PMEMoid oid, uint64_t off, const void *src, size_t size,
+	uint64_t flags)
+{
+	LOG(3, NULL);
+
+	PMEMOBJ_API_START();
+	struct tx *tx = get_tx();
+
+	ASSERT_IN_TX(tx);
+	ASSERT_TX_STAGE_WORK(tx);
+
+	int ret;
+
+	flags |= tx_abort_on_failure_flag(tx);
+
+	if (flags & ~POBJ_XWRITE_VALID_FLAGS) {
+		ERR_WO_ERRNO("unknown flags 0x%" PRIx64, flags
+			& ~POBJ_XWRITE_VALID_FLAGS);
+		ret = obj_tx_fail_err(EINVAL, flags);
+		PMEMOBJ_API_END();
+		return ret;
+	}
+
+	if (oid.pool_uuid_lo != tx->pop->uuid_lo) {
+		ERR_WO_ERRNO("invalid pool uuid");
+		ret = obj_tx_fail_err(EINVAL, flags);
+		PMEMOBJ_API_END();
+		return ret;
+	}
+	ASSERT(OBJ_OID_IS_VALID(tx->pop, oid));
+
+	ret = tx_write_common(tx, oid.off + off, src, size, flags);
+
+	PMEMOBJ_API_END();
+	return ret;
+}
+
+/*
+ * pmemobj_tx_write -- logs the new contents of a part of an object,
+ *	which are written to it when the transaction commits
+ */
+int
+pmemobj_tx_write(PMEMoid oid, uint64_t off, const void *src, size_t size)
+{
+	return pmemobj_tx_xwrite(oid, off, src, size, 0);
+}
+
+/*
+ * pmemobj_tx_read_direct -- reads a memory range as seen by the transaction,
+ *	that is, including the writes that are not yet applied
+ */
+void
+pmemobj_tx_read_direct(void *dest, const void *src, size_t size)
+{
+	LOG(3, NULL);
+
+	PMEMOBJ_API_START();
+	struct tx *tx = get_tx();
+
+	ASSERT_IN_TX(tx);
+
+	memcpy(dest, src, size);
+
+	if (!OBJ_PTR_FROM_POOL(tx->pop, src)) {
+		PMEMOBJ_API_END();
+		return;
+	}
+
+	uint64_t begin = (uint64_t)((char *)src - (char *)tx->pop);
+	uint64_t end = begin + size;
+
+	/* the later writes take precedence */
+	struct tx_redo_write *w;
+	VEC_FOREACH_BY_PTR(w, &tx->redo_writes) {
+		uint64_t wbegin = MAX(begin, w->offset);
+		uint64_t wend = MIN(end, w->offset + w->size);
+		if (wbegin >= wend)
+			continue;
+
+		memcpy((char *)dest + (wbegin - begin),
+			tx->redo_data + w->data + (wbegin - w->offset),
+			wend - wbegin);
+	}
+
+	PMEMOBJ_API_END();
+}
+
+/*
+ * tx_read_common -- (internal) adds a range to the read set of the
+ *	transaction
+ */
+static int
+tx_read_common(struct tx *tx, uint64_t offset, size_t size, uint64_t flags)
+{
+	/* without the optimistic concurrency control there's nothing to do */
+	if (tx->versions == NULL || size == 0)
+		return 0;
+
+	uint64_t heap_end = tx->pop->heap_offset + tx->pop->heap_size;
+	if (offset < tx->pop->heap_offset || size > heap_end - offset) {
+		ERR_WO_ERRNO("read outside of the heap");
+		return obj_tx_fail_err(EINVAL, flags);
+	}
+
+	if (tx_versions_read(tx->versions, &tx->version_set, offset,
+			size) != 0)
+		return obj_tx_fail_err(errno, flags);
+
+	return 0;
+}
+
+/*
+ * pmemobj_tx_xread_range_direct -- adds a memory range to the read set of
+ *	the transaction
+ */
+int
+pmemobj_tx_xread_range_direct(const void *ptr, size_t size, uint64_t flags)
+{
+	LOG(3, NULL);
+
+	PMEMOBJ_API_START();
+	struct tx *tx = get_tx();
+
+	ASSERT_IN_TX(tx);
+	ASSERT_TX_STAGE_WORK(tx);
+
+	int ret;
+
+	flags |= tx_abort_on_failure_flag(tx);
+
+	if (flags & ~POBJ_XREAD_VALID_FLAGS) {
+		ERR_WO_ERRNO("unknown flags 0x%" PRIx64,
+			flags & ~POBJ_XREAD_VALID_FLAGS);
+		ret = obj_tx_fail_err(EINVAL, flags);
+		PMEMOBJ_API_END();
+		return ret;
+	}
+
+	if (!OBJ_PTR_FROM_POOL(tx->pop, ptr)) {
+		ERR_WO_ERRNO("object outside of pool");
+		ret = obj_tx_fail_err(EINVAL, flags);
+		PMEMOBJ_API_END();
+		return ret;
+	}
+
+	ret = tx_read_common(tx, (uint64_t)((char *)ptr - (char *)tx->pop),
+		size, flags);
+
+	PMEMOBJ_API_END();
+	return ret;
+}
+
+/*
+ * pmemobj_tx_read_range_direct -- adds a memory range to the read set of the
+ *	transaction
+ */
+int
+pmemobj_tx_read_range_direct(const void *ptr, size_t size)
+{
+	return pmemobj_tx_xread_range_direct(ptr, size, 0);
+}
+
+/*
+ * pmemobj_tx_xread_range -- adds a part of an object to the read set of the
+ *	transaction
+ */
+int
+pmemobj_tx_xread_range(PMEMoid oid, uint64_t off, size_t size, uint64_t flags)
+{
+	LOG(3, NULL);
+
+	PMEMOBJ_API_START();
+	struct tx *tx = get_tx();
+
+	ASSERT_IN_TX(tx);
+	ASSERT_TX_STAGE_WORK(tx);
+
+	int ret;
+
+	flags |= tx_abort_on_failure_flag(tx);
+
+	if (flags & ~POBJ_XREAD_VALID_FLAGS) {
+		ERR_WO_ERRNO("unknown flags 0x%" PRIx64,
+			flags & ~POBJ_XREAD_VALID_FLAGS);
+		ret = obj_tx_fail_err(EINVAL, flags);
+		PMEMOBJ_API_END();
+		return ret;
+	}
+
+	if (oid.pool_uuid_lo != tx->pop->uuid_lo) {
+		ERR_WO_ERRNO("invalid pool uuid");
+		ret = obj_tx_fail_err(EINVAL, flags);
+		PMEMOBJ_API_END();
+		return ret;
+	}
+	ASSERT(OBJ_OID_IS_VALID(tx->pop, oid));
+
+	ret = tx_read_common(tx, oid.off + off, size, flags);
+
+	PMEMOBJ_API_END();
+	return ret;
+}
+
+/*
+ * pmemobj_tx_read_range -- adds a part of an object to the read set of the
+ *	transaction
+ */
+int
+pmemobj_tx_read_range(PMEMoid oid, uint64_t off, size_t size)
+{
+	return pmemobj_tx_xread_range(oid, off, size, 0);
+}
+
+/*
+ * pmemobj_tx_alloc -- allocates a new object
+ */
+PMEMoid
+pmemobj_tx_alloc(size_t size, uint64_t type_num)
+{
+	LOG(3, NULL);
+
+	PMEMOBJ_API_START();
+	struct tx *tx = get_tx();
+
+	ASSERT_IN_TX(tx);
+	ASSERT_TX_STAGE_WORK(tx);
+
+	uint64_t flags = tx_abort_on_failure_flag(tx);
+
+	PMEMoid oid;
+	if (size == 0) {
+		ERR_WO_ERRNO("allocation with size 0");
+		oid = obj_tx_fail_null(EINVAL, flags);
+		PMEMOBJ_API_END();
+		return oid;
+	}
+
+	oid = tx_alloc_common(tx, size, (type_num_t)type_num,
+			constructor_tx_alloc, ALLOC_ARGS(flags));
+
+	PMEMOBJ_API_END();
+	return oid;
+}
+
+/*
+ * pmemobj_tx_zalloc -- allocates a new zeroed object
+ */
+PMEMoid
+pmemobj_tx_zalloc(size_t size, uint64_t type_num)
+{
+	LOG(3, NULL);
+	struct tx *tx = get_tx();
+
+	ASSERT_IN_TX(tx);
+	ASSERT_TX_STAGE_WORK(tx);
+
+	uint64_t flags = POBJ_FLAG_ZERO;
+	flags |= tx_abort_on_failure_flag(tx);
+
+	PMEMOBJ_API_START();
+	PMEMoid oid;
+	if (size == 0) {
+		ERR_WO_ERRNO("allocation with size 0");
 		oid = obj_tx_fail_null(EINVAL, flags);
 		PMEMOBJ_API_END();
 		return oid;
@@ -1849,23 +2638,21 @@ pmemobj_tx_xfree(PMEMoid oid, uint64_t flags)
 
 	struct pobj_action *action;
 
-	struct tx_range_def range = {oid.off, 0, 0};
-	struct ravl_node *n = ravl_find(tx->ranges, &range,
-		RAVL_PREDICATE_EQUAL);
+	struct tx_range_def *r = tx_ranges_find(&tx->ranges, oid.off,
+		TX_RANGES_EQUAL);
 
 	/*
 	 * If attempting to free an object allocated within the same
 	 * transaction, simply cancel the alloc and remove it from the actions.
 	 */
-	if (n != NULL) {
+	if (r != NULL) {
 		VEC_FOREACH_BY_PTR(action, &tx->actions) {
 			if (action->type == POBJ_ACTION_TYPE_HEAP &&
 				action->heap.offset == oid.off) {
-				struct tx_range_def *r = ravl_data(n);
 				void *ptr = OBJ_OFF_TO_PTR(pop, r->offset);
 				VALGRIND_SET_CLEAN(ptr, r->size);
 				VALGRIND_REMOVE_FROM_TX(ptr, r->size);
-				ravl_remove(tx->ranges, n);
+				tx_ranges_remove(&tx->ranges, r);
 				palloc_cancel(&pop->heap, action, 1);
 				VEC_ERASE_BY_PTR(&tx->actions, action);
 				PMEMOBJ_API_END();
@@ -1874,6 +2661,15 @@ pmemobj_tx_xfree(PMEMoid oid, uint64_t flags)
 		}
 	}
 
+	/* the object might be read by optimistic transactions */
+	if (tx->versions != NULL && tx_versions_lock(tx->versions,
+			&tx->version_set, oid.off,
+			palloc_usable_size(&pop->heap, oid.off)) != 0) {
+		int ret = obj_tx_fail_err(errno, flags);
+		PMEMOBJ_API_END();
+		return ret;
+	}
+
 	action = tx_action_add(tx);
 	if (action == NULL) {
 		int ret = obj_tx_fail_err(errno, flags);
@@ -2251,9 +3047,112 @@ CTL_WRITE_HANDLER(threshold)(void *ctx,
 
 static const struct ctl_argument CTL_ARG(threshold) = CTL_ARG_LONG_LONG;
 
+/*
+ * CTL_READ_HANDLER(retain) -- returns the undo log space retained by lanes
+ */
+static int
+CTL_READ_HANDLER(retain)(void *ctx,
+	enum ctl_query_source source, void *arg, struct ctl_indexes *indexes)
+{
+	/* suppress unused-parameter errors */
+	SUPPRESS_UNUSED(source, indexes);
+
+	PMEMobjpool *pop = ctx;
+
+	ssize_t *arg_out = arg;
+
+	*arg_out = (ssize_t)pop->tx_params->cache_retain;
+
+	return 0;
+}
+
+/*
+ * CTL_WRITE_HANDLER(retain) -- sets the undo log space retained by lanes
+ */
+static int
+CTL_WRITE_HANDLER(retain)(void *ctx,
+	enum ctl_query_source source, void *arg, struct ctl_indexes *indexes)
+{
+	/* suppress unused-parameter errors */
+	SUPPRESS_UNUSED(source, indexes);
+
+	PMEMobjpool *pop = ctx;
+
+	ssize_t arg_in = *(long long *)arg;
+
+	if (arg_in < 0 || arg_in > (ssize_t)PMEMOBJ_MAX_ALLOC_SIZE) {
+		errno = EINVAL;
+		ERR_WO_ERRNO(
+			"invalid retained size, must be between 0 and max alloc size");
+		return -1;
+	}
+
+	pop->tx_params->cache_retain = (size_t)arg_in;
+
+	return 0;
+}
+
+static const struct ctl_argument CTL_ARG(retain) = CTL_ARG_LONG_LONG;
+
 static const struct ctl_node CTL_NODE(cache)[] = {
 	CTL_LEAF_RW(size),
 	CTL_LEAF_RW(threshold),
+	CTL_LEAF_RW(retain),
+
+	CTL_NODE_END
+};
+
+/*
+ * CTL_READ_HANDLER(nt_threshold) -- returns the minimum size of snapshots
+ *	copied to the undo log with non-temporal stores
+ */
+static int
+CTL_READ_HANDLER(nt_threshold)(void *ctx,
+	enum ctl_query_source source, void *arg, struct ctl_indexes *indexes)
+{
+	/* suppress unused-parameter errors */
+	SUPPRESS_UNUSED(source, indexes);
+
+	PMEMobjpool *pop = ctx;
+
+	ssize_t *arg_out = arg;
+
+	*arg_out = (ssize_t)pop->tx_params->snapshot_nt_threshold;
+
+	return 0;
+}
+
+/*
+ * CTL_WRITE_HANDLER(nt_threshold) -- sets the minimum size of snapshots
+ *	copied to the undo log with non-temporal stores
+ */
+static int
+CTL_WRITE_HANDLER(nt_threshold)(void *ctx,
+	enum ctl_query_source source, void *arg, struct ctl_indexes *indexes)
+{
+	/* suppress unused-parameter errors */
+	SUPPRESS_UNUSED(source, indexes);
+
+	PMEMobjpool *pop = ctx;
+
+	ssize_t arg_in = *(long long *)arg;
+
+	if (arg_in < 0 || arg_in > (ssize_t)PMEMOBJ_MAX_ALLOC_SIZE) {
+		errno = EINVAL;
+		ERR_WO_ERRNO(
+			"invalid threshold size, must be between 0 and max alloc size");
+		return -1;
+	}
+
+	pop->tx_params->snapshot_nt_threshold = (size_t)arg_in;
+
+	return 0;
+}
+
+static const struct ctl_argument CTL_ARG(nt_threshold) = CTL_ARG_LONG_LONG;
+
+static const struct ctl_node CTL_NODE(snapshot)[] = {
+	CTL_LEAF_RW(nt_threshold),
 
 	CTL_NODE_END
 };
@@ -2357,7 +3256,16 @@ CTL_READ_HANDLER(queue_depth)(void *ctx, enum ctl_query_source source,
 	void *arg, struct ctl_indexes *indexes)
 {
 	/* suppress unused-parameter errors */
-	SUPPRESS_UNUSED(ctx, source, arg, indexes);
+	SUPPRESS_UNUSED(source, indexes);
+
+	PMEMobjpool *pop = ctx;
+	struct tx_post_commit_queue *q = pop->tx_params->post_commit;
+
+	int *arg_out = arg;
+
+	util_mutex_lock(&q->lock);
+	*arg_out = (int)q->depth;
+	util_mutex_unlock(&q->lock);
 
 	return 0;
 }
@@ -2370,7 +3278,44 @@ CTL_WRITE_HANDLER(queue_depth)(void *ctx, enum ctl_query_source source,
 	void *arg, struct ctl_indexes *indexes)
 {
 	/* suppress unused-parameter errors */
-	SUPPRESS_UNUSED(ctx, source, arg, indexes);
+	SUPPRESS_UNUSED(source, indexes);
+
+	PMEMobjpool *pop = ctx;
+	struct tx_post_commit_queue *q = pop->tx_params->post_commit;
+
+	int arg_in = *(int *)arg;
+
+	if (arg_in < 0) {
+		ERR_WO_ERRNO("queue depth cannot be negative");
+		errno = EINVAL;
+		return -1;
+	}
+
+	util_mutex_lock(&q->lock);
+
+	if (q->count != 0) {
+		util_mutex_unlock(&q->lock);
+		ERR_WO_ERRNO("post commit queue is not empty");
+		errno = EBUSY;
+		return -1;
+	}
+
+	struct tx_post_commit_entry *entries = NULL;
+	if (arg_in != 0) {
+		entries = Malloc(sizeof(*entries) * (size_t)arg_in);
+		if (entries == NULL) {
+			util_mutex_unlock(&q->lock);
+			ERR_W_ERRNO("Malloc");
+			return -1;
+		}
+	}
+
+	Free(q->entries);
+	q->entries = entries;
+	q->depth = (unsigned)arg_in;
+	q->head = 0;
+
+	util_mutex_unlock(&q->lock);
 
 	return 0;
 }
@@ -2385,7 +3330,11 @@ CTL_READ_HANDLER(worker)(void *ctx, enum ctl_query_source source,
 	void *arg, struct ctl_indexes *indexes)
 {
 	/* suppress unused-parameter errors */
-	SUPPRESS_UNUSED(ctx, source, arg, indexes);
+	SUPPRESS_UNUSED(source, arg, indexes);
+
+	PMEMobjpool *pop = ctx;
+
+	tx_post_commit_worker(pop);
 
 	return 0;
 }
@@ -2398,7 +3347,29 @@ CTL_READ_HANDLER(stop)(void *ctx, enum ctl_query_source source,
 	void *arg, struct ctl_indexes *indexes)
 {
 	/* suppress unused-parameter errors */
-	SUPPRESS_UNUSED(ctx, source, arg, indexes);
+	SUPPRESS_UNUSED(source, arg, indexes);
+
+	PMEMobjpool *pop = ctx;
+
+	tx_post_commit_stop(pop);
+
+	return 0;
+}
+
+/*
+ * CTL_READ_HANDLER(start) -- allows the post commit workers to run again
+ *	after they were stopped
+ */
+static int
+CTL_READ_HANDLER(start)(void *ctx, enum ctl_query_source source,
+	void *arg, struct ctl_indexes *indexes)
+{
+	/* suppress unused-parameter errors */
+	SUPPRESS_UNUSED(source, arg, indexes);
+
+	PMEMobjpool *pop = ctx;
+
+	tx_post_commit_start(pop);
 
 	return 0;
 }
@@ -2407,6 +3378,112 @@ static const struct ctl_node CTL_NODE(post_commit)[] = {
 	CTL_LEAF_RW(queue_depth),
 	CTL_LEAF_RO(worker),
 	CTL_LEAF_RO(stop),
+	CTL_LEAF_RO(start),
+
+	CTL_NODE_END
+};
+
+/*
+ * CTL_READ_HANDLER(group) -- returns whether the group commit is enabled
+ */
+static int
+CTL_READ_HANDLER(group)(void *ctx,
+	enum ctl_query_source source, void *arg, struct ctl_indexes *indexes)
+{
+	/* suppress unused-parameter errors */
+	SUPPRESS_UNUSED(source, indexes);
+
+	PMEMobjpool *pop = ctx;
+
+	int *arg_out = arg;
+
+	*arg_out = pop->tx_params->group_commit;
+
+	return 0;
+}
+
+/*
+ * CTL_WRITE_HANDLER(group) -- enables or disables the group commit
+ */
+static int
+CTL_WRITE_HANDLER(group)(void *ctx,
+	enum ctl_query_source source, void *arg, struct ctl_indexes *indexes)
+{
+	/* suppress unused-parameter errors */
+	SUPPRESS_UNUSED(source, indexes);
+
+	PMEMobjpool *pop = ctx;
+
+	int arg_in = *(int *)arg;
+
+	pop->tx_params->group_commit = arg_in;
+
+	return 0;
+}
+
+static const struct ctl_argument CTL_ARG(group) = CTL_ARG_BOOLEAN;
+
+static const struct ctl_node CTL_NODE(commit)[] = {
+	CTL_LEAF_RW(group),
+
+	CTL_NODE_END
+};
+
+/*
+ * CTL_READ_HANDLER(enabled) -- returns whether the optimistic concurrency
+ *	control is enabled
+ */
+static int
+CTL_READ_HANDLER(enabled)(void *ctx,
+	enum ctl_query_source source, void *arg, struct ctl_indexes *indexes)
+{
+	/* suppress unused-parameter errors */
+	SUPPRESS_UNUSED(source, indexes);
+
+	PMEMobjpool *pop = ctx;
+
+	int *arg_out = arg;
+
+	*arg_out = pop->tx_params->optimistic;
+
+	return 0;
+}
+
+/*
+ * CTL_WRITE_HANDLER(enabled) -- enables or disables the optimistic
+ *	concurrency control, creating the table of versions on first use
+ */
+static int
+CTL_WRITE_HANDLER(enabled)(void *ctx,
+	enum ctl_query_source source, void *arg, struct ctl_indexes *indexes)
+{
+	/* suppress unused-parameter errors */
+	SUPPRESS_UNUSED(source, indexes);
+
+	PMEMobjpool *pop = ctx;
+	struct tx_parameters *params = pop->tx_params;
+
+	int arg_in = *(int *)arg;
+
+	if (arg_in && params->versions == NULL) {
+		struct tx_versions *v = tx_versions_new();
+		if (v == NULL)
+			return -1;
+
+		/* the table might have been created concurrently */
+		if (!util_bool_compare_and_swap64(&params->versions, NULL, v))
+			tx_versions_delete(v);
+	}
+
+	params->optimistic = arg_in;
+
+	return 0;
+}
+
+static const struct ctl_argument CTL_ARG(enabled) = CTL_ARG_BOOLEAN;
+
+static const struct ctl_node CTL_NODE(optimistic)[] = {
+	CTL_LEAF_RW(enabled),
 
 	CTL_NODE_END
 };
@@ -2414,7 +3491,10 @@ static const struct ctl_node CTL_NODE(post_commit)[] = {
 static const struct ctl_node CTL_NODE(tx)[] = {
 	CTL_CHILD(debug),
 	CTL_CHILD(cache),
+	CTL_CHILD(snapshot),
+	CTL_CHILD(commit),
 	CTL_CHILD(post_commit),
+	CTL_CHILD(optimistic),
 
 	CTL_NODE_END
 };
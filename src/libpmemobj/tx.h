@@ -18,6 +18,8 @@ extern "C" {
 
 #define TX_DEFAULT_RANGE_CACHE_SIZE (1 << 15)
 #define TX_DEFAULT_RANGE_CACHE_THRESHOLD (1 << 12)
+#define TX_DEFAULT_RANGE_CACHE_RETAIN 0
+#define TX_DEFAULT_SNAPSHOT_NT_THRESHOLD (1 << 16)
 
 #define TX_RANGE_MASK (8ULL - 1)
 #define TX_RANGE_MASK_LEGACY (32ULL - 1)
@@ -32,8 +34,25 @@ extern "C" {
 #define TX_INTENT_LOG_BUFFER_OVERHEAD sizeof(struct ulog)
 #define TX_INTENT_LOG_ENTRY_OVERHEAD sizeof(struct ulog_entry_val)
 
+struct tx_commit_group;
+struct tx_post_commit_queue;
+struct tx_versions;
+
 struct tx_parameters {
 	size_t cache_size;
+	size_t cache_retain; /* undo log space each lane keeps between txs */
+	size_t snapshot_nt_threshold; /* min size of streamed snapshots */
+
+	/* outermost commits share the drain of their ranges */
+	int group_commit;
+	struct tx_commit_group *commit_group;
+
+	/* cleanup of committed transactions deferred to the workers */
+	struct tx_post_commit_queue *post_commit;
+
+	/* optimistic concurrency control, the table is kept once created */
+	int optimistic;
+	struct tx_versions *versions;
 };
 
 /*
@@ -47,6 +66,8 @@ void tx_ctl_register(PMEMobjpool *pop);
 struct tx_parameters *tx_params_new(void);
 void tx_params_delete(struct tx_parameters *tx_params);
 
+void tx_post_commit_stop(PMEMobjpool *pop);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,310 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/* Copyright 2026, Intel Corporation */
+
+/*
+ * tx_ranges.c -- index of transaction snapshots
+ *
+ * This is a two-level B+-tree: the leaves are sorted arrays of up to
+ * TX_RANGES_BLOCK_CAPACITY ranges, and the root is a sorted array of pointers
+ * to the leaves. Lookups are two binary searches over contiguous memory.
+ *
+ * Transactions usually snapshot memory in increasing address order, so a
+ * range placed past the end of the last, full, leaf starts a new leaf instead
+ * of splitting it. This keeps the leaves full and makes such inserts O(1).
+ */
+
+#include <errno.h>
+#include <string.h>
+
+#include "alloc.h"
+#include "core_assert.h"
+#include "out.h"
+#include "tx_ranges.h"
+#include "util.h"
+
+#define TX_RANGES_SLAB_MAX_NBLOCKS 64
+
+/*
+ * tx_ranges_init -- initializes an empty index
+ */
+void
+tx_ranges_init(struct tx_ranges *r)
+{
+	VEC_INIT(&r->blocks);
+	VEC_INIT(&r->slabs);
+	r->first.next = NULL;
+	r->unused = &r->first;
+	r->slab_nblocks = 1;
+}
+
+/*
+ * tx_ranges_fini -- calls the callback on all the ranges in the ascending
+ *	order of their offsets and releases the index
+ */
+void
+tx_ranges_fini(struct tx_ranges *r, tx_ranges_cb cb, void *arg)
+{
+	struct tx_ranges_block *b;
+
+	if (cb != NULL) {
+		VEC_FOREACH(b, &r->blocks) {
+			for (size_t i = 0; i < b->nranges; ++i)
+				cb(&b->ranges[i], arg);
+		}
+	}
+
+	void *slab;
+	VEC_FOREACH(slab, &r->slabs) {
+		Free(slab);
+	}
+
+	VEC_DELETE(&r->slabs);
+	VEC_DELETE(&r->blocks);
+	r->unused = NULL;
+}
+
+/*
+ * tx_ranges_block_get -- (internal) takes an unused block, allocating a new
+ *	slab of them if there are none
+ */
+static struct tx_ranges_block *
+tx_ranges_block_get(struct tx_ranges *r)
+{
+	if (r->unused == NULL) {
+		size_t n = r->slab_nblocks;
+		struct tx_ranges_block *slab = Malloc(n * sizeof(*slab));
+		if (slab == NULL) {
+			ERR_W_ERRNO("Malloc");
+			return NULL;
+		}
+
+		if (VEC_PUSH_BACK(&r->slabs, slab) != 0) {
+			Free(slab);
+			return NULL;
+		}
+
+		for (size_t i = 0; i < n; ++i) {
+			slab[i].next = r->unused;
+			r->unused = &slab[i];
+		}
+
+		r->slab_nblocks = MIN(n * 2, TX_RANGES_SLAB_MAX_NBLOCKS);
+	}
+
+	struct tx_ranges_block *b = r->unused;
+	r->unused = b->next;
+	b->nranges = 0;
+
+	return b;
+}
+
+/*
+ * tx_ranges_block_put -- (internal) returns a block to the unused list
+ */
+static void
+tx_ranges_block_put(struct tx_ranges *r, struct tx_ranges_block *b)
+{
+	b->next = r->unused;
+	r->unused = b;
+}
+
+/*
+ * tx_ranges_block_insert -- (internal) inserts a block at the given position
+ *	of the root array
+ */
+static int
+tx_ranges_block_insert(struct tx_ranges *r, size_t pos,
+	struct tx_ranges_block *b)
+{
+	if (VEC_INC_BACK(&r->blocks) != 0)
+		return -1;
+
+	struct tx_ranges_block **arr = VEC_ARR(&r->blocks);
+	memmove(&arr[pos + 1], &arr[pos],
+		(VEC_SIZE(&r->blocks) - 1 - pos) * sizeof(*arr));
+	arr[pos] = b;
+
+	return 0;
+}
+
+/*
+ * tx_ranges_upper -- (internal) returns the number of ranges in the block
+ *	whose offset is less or equal (or just less, if strict) than the given
+ *	one
+ */
+static size_t
+tx_ranges_upper(const struct tx_ranges_block *b, uint64_t offset, int strict)
+{
+	size_t lo = 0;
+	size_t hi = b->nranges;
+
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+		uint64_t o = b->ranges[mid].offset;
+		if (o < offset || (!strict && o == offset))
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo;
+}
+
+/*
+ * tx_ranges_block_find -- (internal) returns the number of blocks whose first
+ *	offset is less or equal (or just less, if strict) than the given one
+ */
+static size_t
+tx_ranges_block_find(struct tx_ranges *r, uint64_t offset, int strict)
+{
+	size_t nblocks = VEC_SIZE(&r->blocks);
+	struct tx_ranges_block **arr = VEC_ARR(&r->blocks);
+
+	if (nblocks == 0)
+		return 0;
+
+	/* fast path for the ranges past the beginning of the last block */
+	uint64_t o = arr[nblocks - 1]->ranges[0].offset;
+	if (o < offset || (!strict && o == offset))
+		return nblocks;
+
+	size_t lo = 0;
+	size_t hi = nblocks - 1;
+
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+		o = arr[mid]->ranges[0].offset;
+		if (o < offset || (!strict && o == offset))
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo;
+}
+
+/*
+ * tx_ranges_find -- returns the range with the greatest offset that satisfies
+ *	the predicate with respect to the given offset, or NULL if none does
+ *
+ * The returned pointer is valid until the next insert or remove.
+ */
+struct tx_range_def *
+tx_ranges_find(struct tx_ranges *r, uint64_t offset,
+	enum tx_ranges_predicate p)
+{
+	int strict = p == TX_RANGES_LESS;
+
+	size_t nblocks = tx_ranges_block_find(r, offset, strict);
+	if (nblocks == 0)
+		return NULL;
+
+	struct tx_ranges_block *b = VEC_ARR(&r->blocks)[nblocks - 1];
+	size_t pos = tx_ranges_upper(b, offset, strict);
+	ASSERTne(pos, 0);
+
+	struct tx_range_def *def = &b->ranges[pos - 1];
+	if (p == TX_RANGES_EQUAL && def->offset != offset)
+		return NULL;
+
+	return def;
+}
+
+/*
+ * tx_ranges_insert -- inserts a copy of the range into the index, fails
+ *	with EEXIST if there's already one with the same offset
+ */
+int
+tx_ranges_insert(struct tx_ranges *r, const struct tx_range_def *def)
+{
+	size_t bpos = tx_ranges_block_find(r, def->offset, 0);
+	struct tx_ranges_block *b;
+
+	if (VEC_SIZE(&r->blocks) == 0) {
+		b = tx_ranges_block_get(r);
+		if (b == NULL)
+			return -1;
+
+		if (tx_ranges_block_insert(r, 0, b) != 0) {
+			tx_ranges_block_put(r, b);
+			return -1;
+		}
+	} else {
+		/* the range goes to the front of the first block */
+		if (bpos == 0)
+			bpos = 1;
+		b = VEC_ARR(&r->blocks)[bpos - 1];
+	}
+
+	size_t pos = tx_ranges_upper(b, def->offset, 0);
+	if (pos != 0 && b->ranges[pos - 1].offset == def->offset) {
+		errno = EEXIST;
+		return -1;
+	}
+
+	if (b->nranges == TX_RANGES_BLOCK_CAPACITY) {
+		struct tx_ranges_block *nb = tx_ranges_block_get(r);
+		if (nb == NULL)
+			return -1;
+
+		if (tx_ranges_block_insert(r, bpos, nb) != 0) {
+			tx_ranges_block_put(r, nb);
+			return -1;
+		}
+
+		if (bpos == VEC_SIZE(&r->blocks) - 1 &&
+		    pos == TX_RANGES_BLOCK_CAPACITY) {
+			/* appending, start a new block */
+			b = nb;
+			pos = 0;
+		} else {
+			size_t half = TX_RANGES_BLOCK_CAPACITY / 2;
+			nb->nranges = b->nranges - half;
+			memcpy(nb->ranges, &b->ranges[half],
+				nb->nranges * sizeof(*nb->ranges));
+			b->nranges = half;
+
+			if (pos > half) {
+				b = nb;
+				pos -= half;
+			}
+		}
+	}
+
+	memmove(&b->ranges[pos + 1], &b->ranges[pos],
+		(b->nranges - pos) * sizeof(*b->ranges));
+	b->ranges[pos] = *def;
+	b->nranges++;
+
+	return 0;
+}
+
+/*
+ * tx_ranges_remove -- removes the range, previously returned by find, from
+ *	the index
+ */
+void
+tx_ranges_remove(struct tx_ranges *r, struct tx_range_def *def)
+{
+	size_t bpos = tx_ranges_block_find(r, def->offset, 0);
+	ASSERTne(bpos, 0);
+	bpos--;
+
+	struct tx_ranges_block *b = VEC_ARR(&r->blocks)[bpos];
+	ASSERT(def >= b->ranges && def < b->ranges + b->nranges);
+
+	size_t pos = (size_t)(def - b->ranges);
+	memmove(&b->ranges[pos], &b->ranges[pos + 1],
+		(b->nranges - pos - 1) * sizeof(*b->ranges));
+	b->nranges--;
+
+	if (b->nranges != 0)
+		return;
+
+	struct tx_ranges_block **arr = VEC_ARR(&r->blocks);
+	memmove(&arr[bpos], &arr[bpos + 1],
+		(VEC_SIZE(&r->blocks) - bpos - 1) * sizeof(*arr));
+	VEC_POP_BACK(&r->blocks);
+
+	tx_ranges_block_put(r, b);
+}
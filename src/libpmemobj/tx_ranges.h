@@ -0,0 +1,71 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright 2026, Intel Corporation */
+
+/*
+ * tx_ranges.h -- internal definitions for the index of transaction snapshots
+ */
+
+#ifndef LIBPMEMOBJ_TX_RANGES_H
+#define LIBPMEMOBJ_TX_RANGES_H 1
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "vec.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct tx_range_def {
+	uint64_t offset;
+	uint64_t size;
+	uint64_t flags;
+};
+
+#define TX_RANGES_BLOCK_CAPACITY 64
+
+/* a sorted array of ranges, a leaf of the index */
+struct tx_ranges_block {
+	struct tx_ranges_block *next; /* next unused block */
+	size_t nranges;
+	struct tx_range_def ranges[TX_RANGES_BLOCK_CAPACITY];
+};
+
+/*
+ * Snapshot ranges of a transaction ordered by their offsets.
+ *
+ * The ranges are stored in fixed-size sorted blocks which are themselves
+ * kept in a sorted array, and the blocks are carved out of slabs of growing
+ * size. The first block is embedded in the structure, so small transactions
+ * do not allocate at all.
+ */
+struct tx_ranges {
+	VEC(, struct tx_ranges_block *) blocks; /* ordered, never empty */
+	struct tx_ranges_block *unused;
+	VEC(, struct tx_ranges_block *) slabs;
+	size_t slab_nblocks; /* size of the next slab */
+	struct tx_ranges_block first;
+};
+
+enum tx_ranges_predicate {
+	TX_RANGES_EQUAL,
+	TX_RANGES_LESS,
+	TX_RANGES_LESS_EQUAL,
+};
+
+typedef void (*tx_ranges_cb)(struct tx_range_def *def, void *arg);
+
+void tx_ranges_init(struct tx_ranges *r);
+void tx_ranges_fini(struct tx_ranges *r, tx_ranges_cb cb, void *arg);
+
+int tx_ranges_insert(struct tx_ranges *r, const struct tx_range_def *def);
+void tx_ranges_remove(struct tx_ranges *r, struct tx_range_def *def);
+struct tx_range_def *tx_ranges_find(struct tx_ranges *r, uint64_t offset,
+	enum tx_ranges_predicate p);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LIBPMEMOBJ_TX_RANGES_H */
@@ -0,0 +1,284 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/* Copyright 2026, Intel Corporation */
+
+/*
+ * tx_versions.c -- optimistic concurrency control of transactions
+ *
+ * A transaction locks the stripes of the ranges it is about to modify, before
+ * they are modified in place, and records the versions of the stripes of the
+ * ranges it reads. At commit, when all of its locks are held, it checks that
+ * none of the stripes it read has changed since. The locks are released, and
+ * the versions of the stripes incremented, once the transaction is either
+ * durable or rolled back.
+ *
+ * Neither locking nor reading ever waits for another transaction - finding
+ * a stripe locked by a different transaction is a conflict, reported with
+ * EAGAIN, and the transaction is expected to be aborted and retried.
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+
+#include "alloc.h"
+#include "core_assert.h"
+#include "out.h"
+#include "tx_versions.h"
+#include "util.h"
+
+#define TX_VERSIONS_STRIPE_MASK ((uint64_t)TX_VERSIONS_NSTRIPES - 1)
+
+/*
+ * tx_versions_new -- allocates a table with all the stripes at version zero
+ */
+struct tx_versions *
+tx_versions_new(void)
+{
+	struct tx_versions *v = Zalloc(sizeof(*v));
+	if (v == NULL)
+		ERR_W_ERRNO("Zalloc");
+
+	return v;
+}
+
+/*
+ * tx_versions_delete -- releases the table
+ */
+void
+tx_versions_delete(struct tx_versions *v)
+{
+	Free(v);
+}
+
+/*
+ * tx_version_set_init -- initializes an empty set for a transaction with the
+ *	given id, unique among the running transactions
+ */
+void
+tx_version_set_init(struct tx_version_set *s, uint64_t id)
+{
+	s->owner = (id << 1) | 1;
+	VEC_INIT(&s->reads);
+	VEC_INIT(&s->writes);
+}
+
+/*
+ * tx_version_set_fini -- releases the set, its stripes must be unlocked
+ */
+void
+tx_version_set_fini(struct tx_version_set *s)
+{
+	ASSERTeq(VEC_SIZE(&s->writes), 0);
+
+	VEC_DELETE(&s->reads);
+	VEC_DELETE(&s->writes);
+}
+
+/*
+ * tx_versions_stripes -- (internal) returns the first stripe of the range
+ *	and the number of stripes it covers
+ */
+static uint64_t
+tx_versions_stripes(uint64_t offset, size_t size, uint64_t *nstripes)
+{
+	uint64_t first = offset >> TX_VERSIONS_STRIPE_SHIFT;
+	uint64_t last = (offset + size - 1) >> TX_VERSIONS_STRIPE_SHIFT;
+
+	*nstripes = MIN(last - first + 1, TX_VERSIONS_NSTRIPES);
+
+	return first;
+}
+
+/*
+ * tx_versions_read -- records the versions of the stripes of the range,
+ *	fails with EAGAIN if any of them is being written by a different
+ *	transaction
+ */
+int
+tx_versions_read(struct tx_versions *v, struct tx_version_set *s,
+	uint64_t offset, size_t size)
+{
+	if (size == 0)
+		return 0;
+
+	uint64_t n;
+	uint64_t first = tx_versions_stripes(offset, size, &n);
+
+	for (uint64_t i = 0; i < n; ++i) {
+		uint64_t stripe = (first + i) & TX_VERSIONS_STRIPE_MASK;
+
+		uint64_t version;
+		util_atomic_load_explicit64(&v->stripes[stripe], &version,
+			memory_order_acquire);
+
+		/* the transaction reads its own writes */
+		if (version == s->owner)
+			continue;
+
+		if (version & 1) {
+			errno = EAGAIN;
+			return -1;
+		}
+
+		/* the same stripe is often read a few times in a row */
+		if (VEC_SIZE(&s->reads) != 0 &&
+		    VEC_BACK(&s->reads).stripe == stripe &&
+		    VEC_BACK(&s->reads).version == version)
+			continue;
+
+		struct tx_version_entry e = {stripe, version};
+		if (VEC_PUSH_BACK(&s->reads, e) != 0)
+			return -1;
+	}
+
+	return 0;
+}
+
+/*
+ * tx_versions_lock -- locks the stripes of the range for writing, fails with
+ *	EAGAIN if any of them is already locked by a different transaction
+ *
+ * The stripes locked before the failure stay locked, until the set is
+ * released.
+ */
+int
+tx_versions_lock(struct tx_versions *v, struct tx_version_set *s,
+	uint64_t offset, size_t size)
+{
+	if (size == 0)
+		return 0;
+
+	uint64_t n;
+	uint64_t first = tx_versions_stripes(offset, size, &n);
+
+	for (uint64_t i = 0; i < n; ++i) {
+		uint64_t stripe = (first + i) & TX_VERSIONS_STRIPE_MASK;
+		uint64_t *word = &v->stripes[stripe];
+
+		uint64_t version;
+		util_atomic_load_explicit64(word, &version,
+			memory_order_acquire);
+
+		if (version == s->owner)
+			continue;
+
+		/* reserve the entry first, so that a lock is never lost */
+		if (VEC_INC_BACK(&s->writes) != 0)
+			return -1;
+
+		for (;;) {
+			if (version & 1) {
+				VEC_POP_BACK(&s->writes);
+				errno = EAGAIN;
+				return -1;
+			}
+
+			if (util_bool_compare_and_swap64(word, version,
+					s->owner))
+				break;
+
+			util_atomic_load_explicit64(word, &version,
+				memory_order_acquire);
+		}
+
+		VEC_BACK(&s->writes).stripe = stripe;
+		VEC_BACK(&s->writes).version = version;
+	}
+
+	return 0;
+}
+
+/*
+ * tx_version_entry_compare -- (internal) orders the entries by their stripe
+ */
+static int
+tx_version_entry_compare(const void *lhs, const void *rhs)
+{
+	const struct tx_version_entry *elhs = lhs;
+	const struct tx_version_entry *erhs = rhs;
+
+	if (elhs->stripe < erhs->stripe)
+		return -1;
+	if (elhs->stripe > erhs->stripe)
+		return 1;
+
+	return 0;
+}
+
+/*
+ * tx_versions_locked_at -- (internal) checks whether the transaction locked
+ *	the stripe when it was at the given version, the writes must be sorted
+ */
+static int
+tx_versions_locked_at(struct tx_version_set *s, uint64_t stripe,
+	uint64_t version)
+{
+	struct tx_version_entry key = {stripe, 0};
+	struct tx_version_entry *e = bsearch(&key, VEC_ARR(&s->writes),
+		VEC_SIZE(&s->writes), sizeof(key), tx_version_entry_compare);
+
+	return e != NULL && e->version == version;
+}
+
+/*
+ * tx_versions_validate -- checks that none of the stripes read by the
+ *	transaction was written since, fails with EAGAIN otherwise
+ */
+int
+tx_versions_validate(struct tx_versions *v, struct tx_version_set *s)
+{
+	/* the data must have been read before the versions are checked */
+	util_synchronize();
+
+	/*
+	 * The writes are sorted by their stripes, at most once, for the lookups
+	 * of the stripes which were read and then locked by the transaction.
+	 * A stripe is never locked twice, so the stripes of the writes are
+	 * unique.
+	 */
+	int sorted = 0;
+
+	struct tx_version_entry *e;
+	VEC_FOREACH_BY_PTR(e, &s->reads) {
+		uint64_t version;
+		util_atomic_load_explicit64(&v->stripes[e->stripe], &version,
+			memory_order_acquire);
+
+		if (version == e->version)
+			continue;
+
+		if (version == s->owner) {
+			if (!sorted) {
+				qsort(VEC_ARR(&s->writes),
+					VEC_SIZE(&s->writes),
+					sizeof(struct tx_version_entry),
+					tx_version_entry_compare);
+				sorted = 1;
+			}
+
+			if (tx_versions_locked_at(s, e->stripe, e->version))
+				continue;
+		}
+
+		errno = EAGAIN;
+		return -1;
+	}
+
+	return 0;
+}
+
+/*
+ * tx_versions_release -- unlocks all the stripes locked by the transaction,
+ *	incrementing their versions, and forgets the ones it read
+ */
+void
+tx_versions_release(struct tx_versions *v, struct tx_version_set *s)
+{
+	struct tx_version_entry *e;
+	VEC_FOREACH_BY_PTR(e, &s->writes) {
+		util_atomic_store_explicit64(&v->stripes[e->stripe],
+			e->version + 2, memory_order_release);
+	}
+
+	VEC_CLEAR(&s->writes);
+	VEC_CLEAR(&s->reads);
+}
@@ -0,0 +1,66 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright 2026, Intel Corporation */
+
+/*
+ * tx_versions.h -- internal definitions for the optimistic concurrency
+ *	control of transactions
+ */
+
+#ifndef LIBPMEMOBJ_TX_VERSIONS_H
+#define LIBPMEMOBJ_TX_VERSIONS_H 1
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "vec.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* every stripe covers one cache line worth of pool offsets */
+#define TX_VERSIONS_STRIPE_SHIFT 6
+#define TX_VERSIONS_NSTRIPES (1 << 16)
+
+/*
+ * Transient table of version words, shared by all the transactions of a pool.
+ *
+ * The pool offsets are mapped to the version words by stripes, modulo the
+ * size of the table. An even word is the version of the stripe, incremented
+ * by two every time a transaction that wrote to it ends. An odd word is the
+ * id of the transaction which is currently writing to the stripe.
+ */
+struct tx_versions {
+	uint64_t stripes[TX_VERSIONS_NSTRIPES];
+};
+
+struct tx_version_entry {
+	uint64_t stripe;
+	uint64_t version; /* observed, or the one before locking */
+};
+
+/* the stripes read and written by a single transaction */
+struct tx_version_set {
+	uint64_t owner; /* odd id of the transaction */
+	VEC(, struct tx_version_entry) reads;
+	VEC(, struct tx_version_entry) writes;
+};
+
+struct tx_versions *tx_versions_new(void);
+void tx_versions_delete(struct tx_versions *v);
+
+void tx_version_set_init(struct tx_version_set *s, uint64_t id);
+void tx_version_set_fini(struct tx_version_set *s);
+
+int tx_versions_read(struct tx_versions *v, struct tx_version_set *s,
+	uint64_t offset, size_t size);
+int tx_versions_lock(struct tx_versions *v, struct tx_version_set *s,
+	uint64_t offset, size_t size);
+int tx_versions_validate(struct tx_versions *v, struct tx_version_set *s);
+void tx_versions_release(struct tx_versions *v, struct tx_version_set *s);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LIBPMEMOBJ_TX_VERSIONS_H */
@@ -26,6 +26,10 @@
 #define ULOG_OFFSET_MASK		(~(ULOG_OPERATION_MASK))
 
 #define CACHELINE_ALIGN(size) ALIGN_UP(size, CACHELINE_SIZE)
+
+/* the piece of a buffer entry copied and checksummed at once */
+#define ULOG_COPY_CHUNK_SIZE (8 << 10)
+
 #ifdef DEBUG /* variables required for ASSERTs below */
 #define IS_CACHELINE_ALIGNED(ptr)\
 	(((uintptr_t)(ptr) & (CACHELINE_SIZE - 1)) == 0)
@@ -257,7 +261,12 @@ ulog_reserve(struct ulog *ulog,
 	}
 
 	while (capacity < *new_capacity) {
-		if (extend(p_ops->base, &ulog->next, gen_num) != 0)
+		/*
+		 * The size is only a hint - a log that keeps growing gets
+		 * exponentially larger extensions, not a long chain of them.
+		 */
+		size_t size = MAX(*new_capacity - capacity, capacity);
+		if (extend(p_ops->base, &ulog->next, gen_num, size) != 0)
 			return -1;
 		VEC_PUSH_BACK(next, ulog->next);
 		ulog = ulog_next(ulog, p_ops);
@@ -418,15 +427,23 @@ ulog_clobber_entry(const struct ulog_entry_base *e,
 
 /*
  * ulog_entry_buf_create -- atomically creates a buffer entry in the log
+ *
+ * Unless non-temporal stores are requested, the kind of stores used to write
+ * the entry is left for pmem ops to decide.
  */
 struct ulog_entry_buf *
 ulog_entry_buf_create(struct ulog *ulog, size_t offset, uint64_t gen_num,
 		uint64_t *dest, const void *src, uint64_t size,
-		ulog_operation_type type, const struct pmem_ops *p_ops)
+		ulog_operation_type type, int nontemporal,
+		const struct pmem_ops *p_ops)
 {
 	struct ulog_entry_buf *e =
 		(struct ulog_entry_buf *)(ulog->data + offset);
 
+	unsigned flags = PMEMOBJ_F_MEM_NODRAIN;
+	if (nontemporal)
+		flags |= PMEMOBJ_F_MEM_NONTEMPORAL;
+
 	/*
 	 * Depending on the size of the source buffer, we might need to perform
 	 * up to three separate copies:
@@ -465,14 +482,23 @@ ulog_entry_buf_create(struct ulog *ulog, size_t offset, uint64_t gen_num,
 		memset(last_cacheline + lcopy, 0, CACHELINE_SIZE - lcopy);
 	}
 
-	if (rcopy != 0) {
-		void *rdest = e->data + ncopy;
+	b->checksum = util_checksum_seq(b, CACHELINE_SIZE, 0);
+
+	/*
+	 * The data is checksummed a piece at a time, right after the piece is
+	 * copied, while it is still in the CPU caches.
+	 */
+	for (size_t done = 0; done < rcopy; done += ULOG_COPY_CHUNK_SIZE) {
+		size_t chunk = MIN(rcopy - done, ULOG_COPY_CHUNK_SIZE);
+		void *rdest = e->data + ncopy + done;
 		ASSERT(IS_CACHELINE_ALIGNED(rdest));
 
-		VALGRIND_ADD_TO_TX(rdest, rcopy);
-		pmemops_memcpy(p_ops, rdest, srcof, rcopy,
-			PMEMOBJ_F_MEM_NODRAIN | PMEMOBJ_F_MEM_NONTEMPORAL);
-		VALGRIND_REMOVE_FROM_TX(rdest, rcopy);
+		VALGRIND_ADD_TO_TX(rdest, chunk);
+		pmemops_memcpy(p_ops, rdest, srcof + done, chunk, flags);
+		VALGRIND_REMOVE_FROM_TX(rdest, chunk);
+
+		b->checksum = util_checksum_seq(srcof + done, chunk,
+			b->checksum);
 	}
 
 	if (lcopy != 0) {
@@ -481,16 +507,12 @@ ulog_entry_buf_create(struct ulog *ulog, size_t offset, uint64_t gen_num,
 
 		VALGRIND_ADD_TO_TX(ldest, CACHELINE_SIZE);
 		pmemops_memcpy(p_ops, ldest, last_cacheline, CACHELINE_SIZE,
-			PMEMOBJ_F_MEM_NODRAIN | PMEMOBJ_F_MEM_NONTEMPORAL);
+			flags);
 		VALGRIND_REMOVE_FROM_TX(ldest, CACHELINE_SIZE);
-	}
 
-	b->checksum = util_checksum_seq(b, CACHELINE_SIZE, 0);
-	if (rcopy != 0)
-		b->checksum = util_checksum_seq(srcof, rcopy, b->checksum);
-	if (lcopy != 0)
 		b->checksum = util_checksum_seq(last_cacheline,
 			CACHELINE_SIZE, b->checksum);
+	}
 
 	b->checksum = util_checksum_seq(&gen_num, sizeof(gen_num),
 			b->checksum);
@@ -498,8 +520,7 @@ ulog_entry_buf_create(struct ulog *ulog, size_t offset, uint64_t gen_num,
 	ASSERT(IS_CACHELINE_ALIGNED(e));
 
 	VALGRIND_ADD_TO_TX(e, CACHELINE_SIZE);
-	pmemops_memcpy(p_ops, e, b, CACHELINE_SIZE,
-		PMEMOBJ_F_MEM_NODRAIN | PMEMOBJ_F_MEM_NONTEMPORAL);
+	pmemops_memcpy(p_ops, e, b, CACHELINE_SIZE, flags);
 	VALGRIND_REMOVE_FROM_TX(e, CACHELINE_SIZE);
 
 	pmemops_drain(p_ops);
@@ -521,6 +542,37 @@ ulog_entry_buf_create(struct ulog *ulog, size_t offset, uint64_t gen_num,
 	return e;
 }
 
+/*
+ * ulog_entry_buf_create_shadow -- creates a buffer entry in a DRAM resident
+ *	copy of a ulog, which is later stored in the persistent log as a whole
+ */
+struct ulog_entry_buf *
+ulog_entry_buf_create_shadow(struct ulog *ulog, size_t offset,
+	uint64_t *dest, const void *src, uint64_t size,
+	ulog_operation_type type, const struct pmem_ops *p_ops)
+{
+	struct ulog_entry_buf *e =
+		(struct ulog_entry_buf *)(ulog->data + offset);
+
+	e->base.offset = (uint64_t)(dest) - (uint64_t)p_ops->base;
+	e->base.offset |= ULOG_OPERATION(type);
+	e->size = size;
+	e->checksum = 0;
+
+	size_t entry_size = ulog_entry_size(&e->base);
+	memcpy(e->data, src, size);
+	memset(e->data + size, 0, entry_size - sizeof(*e) - size);
+
+	/* the same checksum as the one of ulog_entry_buf_create */
+	e->checksum = util_checksum_seq(e, entry_size, 0);
+	e->checksum = util_checksum_seq(&ulog->gen_num,
+		sizeof(ulog->gen_num), e->checksum);
+
+	ASSERT(ulog_entry_valid(ulog, &e->base));
+
+	return e;
+}
+
 /*
  * ulog_entry_apply -- applies modifications of a single ulog entry
  */
@@ -711,12 +763,15 @@ ulog_clobber(struct ulog *dest, struct ulog_next *next,
 
 /*
  * ulog_clobber_data -- zeroes out 'nbytes' of data in the logs
+ *
+ * The second ulog is always kept, and the ones after it until their total
+ * capacity, together with the second one, reaches 'retain'.
  */
 int
 ulog_clobber_data(struct ulog *ulog_first,
 	struct ulog_next *next, ulog_free_fn ulog_free,
 	ulog_rm_user_buffer_fn user_buff_remove,
-	const struct pmem_ops *p_ops, unsigned flags)
+	const struct pmem_ops *p_ops, size_t retain, unsigned flags)
 {
 	ASSERTne(ulog_first, NULL);
 
@@ -731,17 +786,37 @@ ulog_clobber_data(struct ulog *ulog_first,
 	 */
 	size_t second_offset = VEC_SIZE(next) == 0 ? 0 : *VEC_GET(next, 0);
 	struct ulog *ulog_second = ulog_by_offset(second_offset, p_ops);
-	if (ulog_second && !(flags & ULOG_FREE_AFTER_FIRST))
+
+	/* the last of the ulogs that are going to be reused */
+	struct ulog *ulog_last = ulog_second;
+	if (ulog_second && !(flags & ULOG_FREE_AFTER_FIRST)) {
 		/*
 		 * We want to keep gen_nums consistent between ulogs.
 		 * If the transaction will commit successfully we'll reuse the
-		 * second buffer (third and next ones will be freed anyway).
-		 * If the application will crash we'll free 2nd ulog on
-		 * recovery, which means we'll never read gen_num of the
-		 * second ulog in case of an ungraceful shutdown.
+		 * retained buffers (the next ones will be freed anyway).
+		 * If the application will crash we'll free them on
+		 * recovery, which means we'll never read their gen_nums
+		 * in case of an ungraceful shutdown.
 		 */
 		ulog_inc_gen_num(ulog_second, NULL);
 
+		/* the logs are not retained along with user buffers */
+		size_t nretain = (flags & ULOG_ANY_USER_BUFFER) ?
+			1 : VEC_SIZE(next);
+		size_t retained = ulog_second->capacity;
+		for (size_t i = 1; i < nretain; ++i) {
+			if (retained >= retain)
+				break;
+
+			struct ulog *u = ulog_by_offset(*VEC_GET(next, i),
+				p_ops);
+
+			ulog_inc_gen_num(u, NULL);
+			retained += u->capacity;
+			ulog_last = u;
+		}
+	}
+
 	/* The ULOG_ANY_USER_BUFFER flag indicates more than one ulog exist */
 	if (flags & ULOG_ANY_USER_BUFFER)
 		ASSERTne(ulog_second, NULL);
@@ -762,18 +837,14 @@ ulog_clobber_data(struct ulog *ulog_first,
 	} else {
 		/*
 		 * To make sure that transaction logs do not occupy too
-		 * much of space, all of them, expect for the first one,
-		 * are freed at the end of the operation. The reasoning for
-		 * this is that pmalloc() is a relatively cheap operation for
-		 * transactions where many hundreds of kilobytes are being
-		 * snapshot, and so, allocating and freeing the buffer for
-		 * each transaction is an acceptable overhead for the average
-		 * case.
+		 * much of space, the ones beyond what the caller wants
+		 * to retain for the following operations are freed at the end
+		 * of the operation.
 		 */
 		if (flags & ULOG_FREE_AFTER_FIRST)
 			u = ulog_first;
 		else
-			u = ulog_second;
+			u = ulog_last;
 	}
 
 	if (u == NULL)
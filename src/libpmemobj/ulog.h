@@ -89,7 +89,7 @@ typedef uint64_t ulog_operation_type;
 #define ULOG_ANY_USER_BUFFER (1U << 2)
 
 typedef int (*ulog_check_offset_fn)(void *ctx, uint64_t offset);
-typedef int (*ulog_extend_fn)(void *, uint64_t *, uint64_t);
+typedef int (*ulog_extend_fn)(void *, uint64_t *, uint64_t, size_t);
 typedef int (*ulog_entry_cb)(struct ulog_entry_base *e, void *arg,
 	const struct pmem_ops *p_ops);
 typedef void (*ulog_free_fn)(void *base, uint64_t *next);
@@ -127,9 +127,12 @@ void ulog_clobber(struct ulog *dest, struct ulog_next *next,
 int ulog_clobber_data(struct ulog *dest,
 	struct ulog_next *next, ulog_free_fn ulog_free,
 	ulog_rm_user_buffer_fn user_buff_remove,
-	const struct pmem_ops *p_ops, unsigned flags);
+	const struct pmem_ops *p_ops, size_t retain, unsigned flags);
 void ulog_clobber_entry(const struct ulog_entry_base *e,
 	const struct pmem_ops *p_ops);
+struct ulog_entry_buf *ulog_entry_buf_create_shadow(struct ulog *ulog,
+	size_t offset, uint64_t *dest, const void *src, uint64_t size,
+	ulog_operation_type type, const struct pmem_ops *p_ops);
 
 void ulog_process(struct ulog *ulog, ulog_check_offset_fn check,
 	const struct pmem_ops *p_ops);
@@ -150,7 +153,8 @@ struct ulog_entry_val *ulog_entry_val_create(struct ulog *ulog,
 struct ulog_entry_buf *
 ulog_entry_buf_create(struct ulog *ulog, size_t offset,
 	uint64_t gen_num, uint64_t *dest, const void *src, uint64_t size,
-	ulog_operation_type type, const struct pmem_ops *p_ops);
+	ulog_operation_type type, int nontemporal,
+	const struct pmem_ops *p_ops);
 
 void ulog_entry_apply(const struct ulog_entry_base *e, int persist,
 	const struct pmem_ops *p_ops);
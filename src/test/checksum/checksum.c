@@ -36,6 +36,68 @@ fletcher64(void *addr, size_t len)
 	return htole64((uint64_t)hi32 << 32 | lo32);
 }
 
+/*
+ * fletcher64_seq -- continue a Fletcher64 checksum
+ *
+ * Gold standard implementation used to compare to the
+ * util_checksum_seq() being unit tested.
+ */
+static uint64_t
+fletcher64_seq(const void *addr, size_t len, uint64_t csum)
+{
+	UT_ASSERT(len % 4 == 0);
+	const uint32_t *p32 = addr;
+	const uint32_t *p32end = (const uint32_t *)((const char *)addr + len);
+	uint32_t lo32 = (uint32_t)csum;
+	uint32_t hi32 = (uint32_t)(csum >> 32);
+
+	while (p32 < p32end) {
+		lo32 += le32toh(*p32);
+		p32++;
+		hi32 += lo32;
+	}
+
+	return (uint64_t)hi32 << 32 | lo32;
+}
+
+#define SEQ_BUF_SIZE (64 << 10)
+
+/*
+ * test_seq -- compares util_checksum_seq() with the gold standard for
+ *	the lengths and alignments handled by the different code paths
+ */
+static void
+test_seq(void)
+{
+	char *buf = MALLOC(SEQ_BUF_SIZE + 64);
+	for (size_t i = 0; i < SEQ_BUF_SIZE + 64; ++i)
+		buf[i] = (char)(rand() | (i % 7 == 0 ? 0x80 : 0));
+
+	uint64_t seed = 0x0123456789abcdef;
+
+	for (size_t len = 0; len <= 1024; len += 4) {
+		for (size_t align = 0; align < 64; align += 4) {
+			UT_ASSERTeq(util_checksum_seq(buf + align, len, seed),
+				fletcher64_seq(buf + align, len, seed));
+		}
+	}
+
+	for (size_t len = 1024; len <= SEQ_BUF_SIZE; len *= 2) {
+		UT_ASSERTeq(util_checksum_seq(buf, len, 0),
+			fletcher64_seq(buf, len, 0));
+		UT_ASSERTeq(util_checksum_seq(buf + 4, len - 4, seed),
+			fletcher64_seq(buf + 4, len - 4, seed));
+	}
+
+	/* a checksum continued over the parts is the same as over the whole */
+	uint64_t csum = util_checksum_seq(buf, 100, 0);
+	csum = util_checksum_seq(buf + 100, 4000, csum);
+	csum = util_checksum_seq(buf + 4100, SEQ_BUF_SIZE - 4100, csum);
+	UT_ASSERTeq(csum, fletcher64_seq(buf, SEQ_BUF_SIZE, 0));
+
+	FREE(buf);
+}
+
 int
 main(int argc, char *argv[])
 {
@@ -44,6 +106,11 @@ main(int argc, char *argv[])
 	if (argc < 2)
 		UT_FATAL("usage: %s files...", argv[0]);
 
+	/* selects the implementation of util_checksum_seq */
+	util_init();
+
+	test_seq();
+
 	for (int arg = 1; arg < argc; arg++) {
 		int fd = OPEN(argv[arg], O_RDONLY);
 
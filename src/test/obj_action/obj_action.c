@@ -1,5 +1,5 @@
 // SPDX-License-Identifier: BSD-3-Clause
-/* Copyright 2017-2019, Intel Corporation */
+/* Copyright 2017-2026, Intel Corporation */
 
 /*
  * obj_action.c -- test the action API
@@ -211,6 +211,66 @@ test_duplicate(PMEMobjpool *pop)
 	pmemobj_cancel(pop, a, 5);
 }
 
+#define BULK_OBJ_SIZE 64
+
+static void
+test_reserve_bulk(PMEMobjpool *pop, size_t n)
+{
+	struct pobj_action *act = (struct pobj_action *)
+		MALLOC(sizeof(struct pobj_action) * n);
+
+	int ret = pmemobj_xreserve_bulk(pop, act, n, BULK_OBJ_SIZE, 0,
+		POBJ_XALLOC_ZERO | POBJ_XALLOC_NO_FLUSH);
+	UT_ASSERTeq(ret, -1);
+	UT_ASSERTeq(errno, EINVAL);
+
+	ret = pmemobj_xreserve_bulk(pop, act, n, BULK_OBJ_SIZE, 0,
+		POBJ_XALLOC_ZERO);
+	UT_ASSERTeq(ret, 0);
+
+	for (size_t i = 0; i < n; ++i) {
+		UT_ASSERTne(act[i].heap.offset, 0);
+		UT_ASSERT(act[i].heap.usable_size >= BULK_OBJ_SIZE);
+		if (i != 0)
+			UT_ASSERTne(act[i].heap.offset, act[i - 1].heap.offset);
+
+		char *ptr = (char *)pop + act[i].heap.offset;
+		for (size_t j = 0; j < BULK_OBJ_SIZE; ++j)
+			UT_ASSERTeq(ptr[j], 0);
+	}
+
+	UT_ASSERTeq(pmemobj_publish(pop, act, n), 0);
+
+	size_t nobjs = 0;
+	PMEMoid oid;
+	POBJ_FOREACH(pop, oid)
+		nobjs++;
+	UT_ASSERT(nobjs >= n);
+
+	for (size_t i = 0; i < n; ++i) {
+		PMEMoid o = pmemobj_oid((char *)pop + act[i].heap.offset);
+		pmemobj_defer_free(pop, o, &act[i]);
+	}
+
+	UT_ASSERTeq(pmemobj_publish(pop, act, n), 0);
+
+	FREE(act);
+
+	/* a reservation that cannot be satisfied leaves nothing behind */
+	size_t nbig = PMEMOBJ_MIN_POOL / BULK_OBJ_SIZE;
+	act = (struct pobj_action *)MALLOC(sizeof(struct pobj_action) * nbig);
+
+	ret = pmemobj_xreserve_bulk(pop, act, nbig, BULK_OBJ_SIZE, 0, 0);
+	UT_ASSERTeq(ret, -1);
+	UT_ASSERTeq(errno, ENOMEM);
+
+	ret = pmemobj_xreserve_bulk(pop, act, n, BULK_OBJ_SIZE, 0, 0);
+	UT_ASSERTeq(ret, 0);
+	pmemobj_cancel(pop, act, n);
+
+	FREE(act);
+}
+
 static void
 test_many_sets(PMEMobjpool *pop, size_t n)
 {
@@ -342,6 +402,7 @@ main(int argc, char *argv[])
 
 	test_many(pop, POBJ_MAX_ACTIONS * 2);
 	test_many_sets(pop, POBJ_MAX_ACTIONS * 2);
+	test_reserve_bulk(pop, POBJ_MAX_ACTIONS * 20);
 
 	test_duplicate(pop);
 
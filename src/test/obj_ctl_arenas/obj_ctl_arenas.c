@@ -30,6 +30,10 @@
  *
  * obj_ctl_arenas <file> b - test for config change of
  *	heap.arenas_default_max
+ *
+ * obj_ctl_arenas <file> u - test for config change of
+ *	heap.arenas_assignment_type for numa type, heap.arena.[idx].numa_node
+ *	and heap.numa.* entry points
  */
 
 #include <sched.h>
@@ -249,6 +253,29 @@ worker_arena_ref_obj(struct arena_alloc *ref)
 	UT_ASSERTeq(ret, 0);
 }
 
+/*
+ * worker_numa -- allocates objects from the arena assigned to the thread
+ *	running on its NUMA node
+ */
+static void *
+worker_numa(void *arg)
+{
+	/* suppress unused-parameter errors */
+	SUPPRESS_UNUSED(arg);
+
+	for (int i = 0; i < NOBJECT_THREAD; ++i) {
+		int ret = pmemobj_alloc(pop, NULL, 128, 0, NULL, NULL);
+		UT_ASSERTeq(ret, 0);
+	}
+
+	unsigned arena_id;
+	int ret = pmemobj_ctl_get(pop, "heap.thread.arena_id", &arena_id);
+	UT_ASSERTeq(ret, 0);
+	UT_ASSERTne(arena_id, 0);
+
+	return NULL;
+}
+
 #define MAX_KEYS 1024
 
 int
@@ -257,7 +284,8 @@ main(int argc, char *argv[])
 	START(argc, argv, "obj_ctl_arenas");
 
 	if (argc != 3)
-		UT_FATAL("usage: %s poolset [n|s|c|f|q|m|a|g|p|d|b]", argv[0]);
+		UT_FATAL("usage: %s poolset [n|s|c|f|q|m|a|g|p|d|b|u]",
+			argv[0]);
 
 	const char *path = argv[1];
 	char t = argv[2][0];
@@ -547,6 +575,92 @@ main(int argc, char *argv[])
 		ret = pmemobj_ctl_get(pop, "heap.narenas.total", &narenas);
 		UT_ASSERTeq(ret, 0);
 		UT_ASSERTeq(narenas, target_narenas);
+	} else if (t == 'u') {
+		enum pobj_arenas_assignment_type atype;
+		ret = pmemobj_ctl_get(pop,
+			"heap.arenas_assignment_type", &atype);
+		UT_ASSERTeq(ret, 0);
+		UT_ASSERTeq(atype, POBJ_ARENAS_ASSIGNMENT_NUMA);
+
+		unsigned nnodes;
+		ret = pmemobj_ctl_get(pop, "heap.numa.nnodes", &nnodes);
+		UT_ASSERTeq(ret, 0);
+		UT_ASSERT(nnodes >= 1);
+
+		unsigned narenas_auto;
+		ret = pmemobj_ctl_get(pop, "heap.narenas.automatic",
+			&narenas_auto);
+		UT_ASSERTeq(ret, 0);
+
+		/* every default arena is bound to one of the nodes */
+		char arena_idx[CTL_QUERY_LEN];
+		for (unsigned i = 1; i <= narenas_auto; ++i) {
+			int node;
+			SNPRINTF(arena_idx, CTL_QUERY_LEN,
+				"heap.arena.%u.numa_node", i);
+			ret = pmemobj_ctl_get(pop, arena_idx, &node);
+			UT_ASSERTeq(ret, 0);
+			UT_ASSERT(node >= 0 && (unsigned)node < nnodes);
+		}
+
+		unsigned arena_id;
+		ret = pmemobj_ctl_exec(pop, "heap.arena.create", &arena_id);
+		UT_ASSERTeq(ret, 0);
+
+		int node;
+		SNPRINTF(arena_idx, CTL_QUERY_LEN,
+			"heap.arena.%u.numa_node", arena_id);
+		ret = pmemobj_ctl_get(pop, arena_idx, &node);
+		UT_ASSERTeq(ret, 0);
+		UT_ASSERTeq(node, -1);
+
+		os_thread_t threads[NTHREADX];
+		for (int i = 0; i < NTHREADX; ++i)
+			THREAD_CREATE(&threads[i], NULL, worker_numa, NULL);
+		for (int i = 0; i < NTHREADX; ++i)
+			THREAD_JOIN(&threads[i], NULL);
+
+		ret = pmemobj_alloc(pop, NULL, 128, 0, NULL, NULL);
+		UT_ASSERTeq(ret, 0);
+
+		unsigned narenas_sum = 0;
+		uint64_t nthreads_sum = 0;
+		uint64_t size_sum = 0;
+		for (unsigned i = 0; i < nnodes; ++i) {
+			unsigned narenas;
+			uint64_t nthreads;
+			uint64_t size;
+
+			SNPRINTF(arena_idx, CTL_QUERY_LEN,
+				"heap.numa.%u.narenas", i);
+			ret = pmemobj_ctl_get(pop, arena_idx, &narenas);
+			UT_ASSERTeq(ret, 0);
+			narenas_sum += narenas;
+
+			SNPRINTF(arena_idx, CTL_QUERY_LEN,
+				"heap.numa.%u.nthreads", i);
+			ret = pmemobj_ctl_get(pop, arena_idx, &nthreads);
+			UT_ASSERTeq(ret, 0);
+			nthreads_sum += nthreads;
+
+			SNPRINTF(arena_idx, CTL_QUERY_LEN,
+				"heap.numa.%u.size", i);
+			ret = pmemobj_ctl_get(pop, arena_idx, &size);
+			UT_ASSERTeq(ret, 0);
+			size_sum += size;
+		}
+
+		UT_ASSERTeq(narenas_sum, narenas_auto);
+		/* only the main thread is still alive */
+		UT_ASSERTeq(nthreads_sum, 1);
+		UT_ASSERTne(size_sum, 0);
+
+		unsigned narenas;
+		SNPRINTF(arena_idx, CTL_QUERY_LEN,
+			"heap.numa.%u.narenas", nnodes);
+		ret = pmemobj_ctl_get(pop, arena_idx, &narenas);
+		UT_ASSERTeq(ret, -1);
+		UT_ASSERTeq(errno, ERANGE);
 	} else {
 		UT_ASSERT(0);
 	}
@@ -0,0 +1,121 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/* Copyright 2026, Intel Corporation */
+
+/*
+ * obj_ctl_heap_shrink.c -- tests for the heap.size.shrink ctl entry point
+ */
+
+#include "unittest.h"
+
+#define LAYOUT "obj_ctl_heap_shrink"
+#define POOL_SIZE (64 << 20)
+#define NOBJECTS 16
+#define OBJ_SIZE (2 << 20)
+#define MIN_RELEASED (NOBJECTS * OBJ_SIZE)
+
+static PMEMoid oids[NOBJECTS];
+
+/*
+ * file_blocks -- returns the number of bytes allocated for the file
+ */
+static size_t
+file_blocks(const char *path)
+{
+	os_stat_t st;
+	STAT(path, &st);
+
+	return (size_t)st.st_blocks * 512;
+}
+
+/*
+ * alloc_objects -- allocates the objects and fills them with a pattern
+ */
+static void
+alloc_objects(PMEMobjpool *pop, int c)
+{
+	for (int i = 0; i < NOBJECTS; ++i) {
+		int ret = pmemobj_alloc(pop, &oids[i], OBJ_SIZE, 0, NULL, NULL);
+		UT_ASSERTeq(ret, 0);
+
+		pmemobj_memset_persist(pop, pmemobj_direct(oids[i]),
+			c + i, OBJ_SIZE);
+	}
+}
+
+/*
+ * check_objects -- verifies the pattern of the objects
+ */
+static void
+check_objects(int c)
+{
+	for (int i = 0; i < NOBJECTS; ++i) {
+		unsigned char *data = pmemobj_direct(oids[i]);
+		for (size_t n = 0; n < OBJ_SIZE; n += 4096)
+			UT_ASSERTeq(data[n], (unsigned char)(c + i));
+	}
+}
+
+/*
+ * free_objects -- frees all the objects
+ */
+static void
+free_objects(void)
+{
+	for (int i = 0; i < NOBJECTS; ++i)
+		pmemobj_free(&oids[i]);
+}
+
+int
+main(int argc, char *argv[])
+{
+	START(argc, argv, "obj_ctl_heap_shrink");
+
+	if (argc != 2)
+		UT_FATAL("usage: %s file-name", argv[0]);
+
+	const char *path = argv[1];
+
+	PMEMobjpool *pop;
+	if ((pop = pmemobj_create(path, LAYOUT, POOL_SIZE,
+			S_IWUSR | S_IRUSR)) == NULL)
+		UT_FATAL("!pmemobj_create: %s", path);
+
+	ssize_t min_size = -1;
+	int ret = pmemobj_ctl_exec(pop, "heap.size.shrink", &min_size);
+	UT_ASSERTne(ret, 0);
+
+	alloc_objects(pop, 1);
+	free_objects();
+
+	size_t before = file_blocks(path);
+
+	/* no free range is that large, nothing is released */
+	min_size = POOL_SIZE;
+	ret = pmemobj_ctl_exec(pop, "heap.size.shrink", &min_size);
+	UT_ASSERTeq(ret, 0);
+	UT_ASSERTeq(file_blocks(path), before);
+
+	min_size = 1 << 20;
+	ret = pmemobj_ctl_exec(pop, "heap.size.shrink", &min_size);
+	UT_ASSERTeq(ret, 0);
+
+	size_t after = file_blocks(path);
+	UT_ASSERT(after + MIN_RELEASED <= before);
+
+	/* the released memory is faulted in again once reused */
+	alloc_objects(pop, 2);
+	check_objects(2);
+	UT_ASSERT(file_blocks(path) >= after + MIN_RELEASED);
+
+	pmemobj_close(pop);
+
+	if ((pop = pmemobj_open(path, LAYOUT)) == NULL)
+		UT_FATAL("!pmemobj_open: %s", path);
+
+	check_objects(2);
+	free_objects();
+
+	pmemobj_close(pop);
+
+	DONE(NULL);
+}
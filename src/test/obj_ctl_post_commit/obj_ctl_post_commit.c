@@ -0,0 +1,290 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/* Copyright 2026, Intel Corporation */
+
+/*
+ * obj_ctl_post_commit.c -- tests for the tx.post_commit ctl entry points
+ * usage:
+ * obj_ctl_post_commit <file> [c|m]...
+ *
+ * c - test for tx.post_commit.{queue_depth,worker,stop,start}
+ *
+ * m - mt test for transactions committed with the post commit workers
+ *	running, followed by a pool close with the workers still running and
+ *	a pool reopen
+ */
+
+#include "libpmemobj/ctl.h"
+#include "unittest.h"
+
+#define LAYOUT "obj_ctl_post_commit"
+#define QUEUE_DEPTH 16
+#define NWORKERS 2
+#define NTHREADS 8
+#define NROUNDS 256
+#define OBJ_SIZE 128
+#define BIG_OBJ_SIZE (256 << 10) /* snapshot that needs log extensions */
+
+struct thread_state {
+	PMEMoid obj;
+	PMEMoid big;
+	uint64_t counter;
+};
+
+struct root {
+	struct thread_state threads[NTHREADS];
+};
+
+static PMEMobjpool *pop;
+
+/* number of post_commit_worker threads that have returned */
+static unsigned workers_returned;
+
+/*
+ * post_commit_worker -- finishes the queued transactions until it's stopped
+ */
+static void *
+post_commit_worker(void *arg)
+{
+	int unused;
+	int ret = pmemobj_ctl_get(pop, "tx.post_commit.worker", &unused);
+	UT_ASSERTeq(ret, 0);
+
+	util_fetch_and_add32(&workers_returned, 1);
+
+	return NULL;
+}
+
+/*
+ * post_commit_stop -- stops the post commit workers
+ */
+static void
+post_commit_stop(void)
+{
+	int unused;
+	int ret = pmemobj_ctl_get(pop, "tx.post_commit.stop", &unused);
+	UT_ASSERTeq(ret, 0);
+}
+
+/*
+ * post_commit_start -- allows the post commit workers to run again
+ */
+static void
+post_commit_start(void)
+{
+	int unused;
+	int ret = pmemobj_ctl_get(pop, "tx.post_commit.start", &unused);
+	UT_ASSERTeq(ret, 0);
+}
+
+/*
+ * workers_start -- launches the post commit workers
+ */
+static void
+workers_start(os_thread_t *workers)
+{
+	workers_returned = 0;
+	for (int i = 0; i < NWORKERS; ++i)
+		THREAD_CREATE(&workers[i], NULL, post_commit_worker, NULL);
+}
+
+/*
+ * workers_join -- waits for the post commit workers to return
+ */
+static void
+workers_join(os_thread_t *workers)
+{
+	for (int i = 0; i < NWORKERS; ++i)
+		THREAD_JOIN(&workers[i], NULL);
+}
+
+/*
+ * test_ctl -- checks the basic behavior of the post commit entry points
+ */
+static void
+test_ctl(void)
+{
+	int depth;
+	int ret = pmemobj_ctl_get(pop, "tx.post_commit.queue_depth", &depth);
+	UT_ASSERTeq(ret, 0);
+	UT_ASSERTeq(depth, 0);
+
+	depth = -1;
+	ret = pmemobj_ctl_set(pop, "tx.post_commit.queue_depth", &depth);
+	UT_ASSERTeq(ret, -1);
+	UT_ASSERTeq(errno, EINVAL);
+
+	depth = QUEUE_DEPTH;
+	ret = pmemobj_ctl_set(pop, "tx.post_commit.queue_depth", &depth);
+	UT_ASSERTeq(ret, 0);
+	ret = pmemobj_ctl_get(pop, "tx.post_commit.queue_depth", &depth);
+	UT_ASSERTeq(ret, 0);
+	UT_ASSERTeq(depth, QUEUE_DEPTH);
+
+	/* a worker started after a stop returns immediately */
+	post_commit_stop();
+	workers_returned = 0;
+	post_commit_worker(NULL);
+	UT_ASSERTeq(workers_returned, 1);
+
+	/* the workers can be restarted after they were stopped */
+	for (int r = 0; r < 2; ++r) {
+		post_commit_start();
+
+		os_thread_t workers[NWORKERS];
+		workers_start(workers);
+
+		for (int i = 0; i < NROUNDS; ++i) {
+			PMEMoid oid = OID_NULL;
+			TX_BEGIN(pop) {
+				oid = pmemobj_tx_zalloc(OBJ_SIZE, 0);
+			} TX_ONABORT {
+				UT_ASSERT(0);
+			} TX_END
+
+			TX_BEGIN(pop) {
+				pmemobj_tx_free(oid);
+			} TX_ONABORT {
+				UT_ASSERT(0);
+			} TX_END
+		}
+
+		post_commit_stop();
+		workers_join(workers);
+		UT_ASSERTeq(workers_returned, NWORKERS);
+	}
+
+	/* with the workers gone every commit is finished synchronously */
+	TX_BEGIN(pop) {
+		pmemobj_tx_free(pmemobj_tx_alloc(OBJ_SIZE, 0));
+	} TX_ONABORT {
+		UT_ASSERT(0);
+	} TX_END
+
+	depth = 0;
+	ret = pmemobj_ctl_set(pop, "tx.post_commit.queue_depth", &depth);
+	UT_ASSERTeq(ret, 0);
+}
+
+/*
+ * worker -- modifies the state of a single thread in transactions
+ */
+static void *
+worker(void *arg)
+{
+	struct thread_state *s = arg;
+
+	for (int i = 0; i < NROUNDS; ++i) {
+		TX_BEGIN(pop) {
+			pmemobj_tx_add_range_direct(s, sizeof(*s));
+
+			/* the freed object returns to the heap in a worker */
+			pmemobj_tx_free(s->obj);
+			s->obj = pmemobj_tx_zalloc(OBJ_SIZE, 0);
+			s->counter++;
+
+			if (i % 32 == 0) {
+				pmemobj_tx_add_range(s->big, 0, BIG_OBJ_SIZE);
+				memset(pmemobj_direct(s->big), (int)s->counter,
+					BIG_OBJ_SIZE);
+			}
+		} TX_ONABORT {
+			UT_ASSERT(0);
+		} TX_END
+	}
+
+	return NULL;
+}
+
+/*
+ * check_state -- verifies the state modified by the worker threads
+ */
+static void
+check_state(struct root *rootp)
+{
+	for (int t = 0; t < NTHREADS; ++t) {
+		struct thread_state *s = &rootp->threads[t];
+		UT_ASSERTeq(s->counter, NROUNDS);
+		UT_ASSERT(!OID_IS_NULL(s->obj));
+
+		unsigned char *big = pmemobj_direct(s->big);
+		unsigned char c = (unsigned char)(NROUNDS - 31);
+		for (size_t n = 0; n < BIG_OBJ_SIZE; n += 4096)
+			UT_ASSERTeq(big[n], c);
+	}
+}
+
+/*
+ * test_mt -- commits transactions concurrently with the post commit workers
+ *	running and closes the pool without stopping them
+ */
+static void
+test_mt(const char *path)
+{
+	PMEMoid root = pmemobj_root(pop, sizeof(struct root));
+	struct root *rootp = pmemobj_direct(root);
+
+	for (int t = 0; t < NTHREADS; ++t) {
+		int ret = pmemobj_zalloc(pop, &rootp->threads[t].big,
+			BIG_OBJ_SIZE, 0);
+		UT_ASSERTeq(ret, 0);
+	}
+
+	int depth = QUEUE_DEPTH;
+	int ret = pmemobj_ctl_set(pop, "tx.post_commit.queue_depth", &depth);
+	UT_ASSERTeq(ret, 0);
+
+	os_thread_t workers[NWORKERS];
+	workers_start(workers);
+
+	os_thread_t threads[NTHREADS];
+	for (int t = 0; t < NTHREADS; ++t)
+		THREAD_CREATE(&threads[t], NULL, worker, &rootp->threads[t]);
+
+	for (int t = 0; t < NTHREADS; ++t)
+		THREAD_JOIN(&threads[t], NULL);
+
+	check_state(rootp);
+
+	/* the pool close finishes the queued transactions */
+	pmemobj_close(pop);
+	workers_join(workers);
+
+	pop = pmemobj_open(path, LAYOUT);
+	UT_ASSERTne(pop, NULL);
+
+	root = pmemobj_root(pop, sizeof(struct root));
+	check_state(pmemobj_direct(root));
+}
+
+int
+main(int argc, char *argv[])
+{
+	START(argc, argv, "obj_ctl_post_commit");
+
+	if (argc < 3)
+		UT_FATAL("usage: %s file-name [c|m]...", argv[0]);
+
+	const char *path = argv[1];
+
+	pop = pmemobj_create(path, LAYOUT, PMEMOBJ_MIN_POOL * 4,
+		S_IWUSR | S_IRUSR);
+	if (pop == NULL)
+		UT_FATAL("!pmemobj_create: %s", path);
+
+	for (int i = 2; i < argc; ++i) {
+		switch (argv[i][0]) {
+			case 'c':
+				test_ctl();
+				break;
+			case 'm':
+				test_mt(path);
+				break;
+			default:
+				UT_FATAL("invalid test: %s", argv[i]);
+		}
+	}
+
+	pmemobj_close(pop);
+
+	DONE(NULL);
+}
@@ -0,0 +1,309 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/* Copyright 2026, Intel Corporation */
+
+/*
+ * obj_ctl_reclaim.c -- tests for the heap.reclaim ctl entry points
+ * usage:
+ * obj_ctl_reclaim <file> c - test for
+ *	heap.reclaim.{worker,stop,start,interval}
+ *
+ * obj_ctl_reclaim <file> m - mt test for allocations with the background
+ *	reclamation workers running, followed by a pool close with the workers
+ *	still running and a pool reopen
+ *
+ * obj_ctl_reclaim <file> p - test for heap.reclaim.parallel
+ */
+
+#include "libpmemobj/ctl.h"
+#include "unittest.h"
+
+#define LAYOUT "obj_ctl_reclaim"
+#define NWORKERS 2
+#define NTHREADS 8
+#define NOBJECTS 512
+#define NROUNDS 4
+#define OBJ_SIZE 128
+#define FILL_OBJ_SIZE (16 << 10)
+#define FILL_TYPE_NUM 1
+
+static PMEMobjpool *pop;
+
+/* set once the reclaim_worker thread has returned */
+static unsigned worker_returned;
+
+/*
+ * reclaim_worker -- runs the background reclamation until it's stopped
+ */
+static void *
+reclaim_worker(void *arg)
+{
+	int unused;
+	int ret = pmemobj_ctl_get(pop, "heap.reclaim.worker", &unused);
+	UT_ASSERTeq(ret, 0);
+
+	util_fetch_and_add32(&worker_returned, 1);
+
+	return NULL;
+}
+
+/*
+ * reclaim_stop -- stops the background reclamation workers
+ */
+static void
+reclaim_stop(void)
+{
+	int unused;
+	int ret = pmemobj_ctl_get(pop, "heap.reclaim.stop", &unused);
+	UT_ASSERTeq(ret, 0);
+}
+
+/*
+ * reclaim_start -- allows the background reclamation workers to run again
+ */
+static void
+reclaim_start(void)
+{
+	int unused;
+	int ret = pmemobj_ctl_get(pop, "heap.reclaim.start", &unused);
+	UT_ASSERTeq(ret, 0);
+}
+
+/*
+ * test_ctl -- checks the basic behavior of the reclamation entry points
+ */
+static void
+test_ctl(void)
+{
+	unsigned interval;
+	int ret = pmemobj_ctl_get(pop, "heap.reclaim.interval", &interval);
+	UT_ASSERTeq(ret, 0);
+	UT_ASSERTeq(interval, 100);
+
+	interval = 0;
+	ret = pmemobj_ctl_set(pop, "heap.reclaim.interval", &interval);
+	UT_ASSERTeq(ret, -1);
+	UT_ASSERTeq(errno, EINVAL);
+
+	interval = 60001;
+	ret = pmemobj_ctl_set(pop, "heap.reclaim.interval", &interval);
+	UT_ASSERTeq(ret, -1);
+	UT_ASSERTeq(errno, EINVAL);
+
+	interval = 1;
+	ret = pmemobj_ctl_set(pop, "heap.reclaim.interval", &interval);
+	UT_ASSERTeq(ret, 0);
+	ret = pmemobj_ctl_get(pop, "heap.reclaim.interval", &interval);
+	UT_ASSERTeq(ret, 0);
+	UT_ASSERTeq(interval, 1);
+
+	/* a worker started after a stop returns immediately */
+	reclaim_stop();
+	worker_returned = 0;
+	reclaim_worker(NULL);
+	UT_ASSERTeq(worker_returned, 1);
+
+	/* the workers can be restarted after they were stopped */
+	for (int r = 0; r < 2; ++r) {
+		reclaim_start();
+
+		os_thread_t thread;
+		worker_returned = 0;
+		THREAD_CREATE(&thread, NULL, reclaim_worker, NULL);
+
+		PMEMoid oids[NOBJECTS];
+		for (int i = 0; i < NOBJECTS; ++i) {
+			ret = pmemobj_alloc(pop, &oids[i], OBJ_SIZE, 0,
+				NULL, NULL);
+			UT_ASSERTeq(ret, 0);
+		}
+
+		for (int i = 0; i < NOBJECTS; ++i)
+			pmemobj_free(&oids[i]);
+
+		reclaim_stop();
+		THREAD_JOIN(&thread, NULL);
+		UT_ASSERTeq(worker_returned, 1);
+	}
+}
+
+/*
+ * worker -- allocates and frees objects
+ */
+static void *
+worker(void *arg)
+{
+	PMEMoid *oids = arg;
+
+	for (int r = 0; r < NROUNDS; ++r) {
+		for (int i = 0; i < NOBJECTS; ++i) {
+			int ret = pmemobj_alloc(pop, &oids[i], OBJ_SIZE, 0,
+				NULL, NULL);
+			UT_ASSERTeq(ret, 0);
+		}
+
+		int nfree = r == NROUNDS - 1 ? NOBJECTS / 2 : NOBJECTS;
+		for (int i = 0; i < nfree; ++i)
+			pmemobj_free(&oids[i]);
+	}
+
+	return NULL;
+}
+
+/*
+ * test_mt -- checks that allocations are correct while the background
+ *	workers are running and that closing the pool stops them
+ */
+static void
+test_mt(const char *path)
+{
+	unsigned interval = 1;
+	int ret = pmemobj_ctl_set(pop, "heap.reclaim.interval", &interval);
+	UT_ASSERTeq(ret, 0);
+
+	os_thread_t reclaimers[NWORKERS];
+	for (int i = 0; i < NWORKERS; ++i)
+		THREAD_CREATE(&reclaimers[i], NULL, reclaim_worker, NULL);
+
+	PMEMoid *oids = MALLOC(sizeof(PMEMoid) * NTHREADS * NOBJECTS);
+	os_thread_t threads[NTHREADS];
+	for (int i = 0; i < NTHREADS; ++i)
+		THREAD_CREATE(&threads[i], NULL, worker, &oids[i * NOBJECTS]);
+
+	for (int i = 0; i < NTHREADS; ++i)
+		THREAD_JOIN(&threads[i], NULL);
+
+	size_t nobjects = 0;
+	PMEMoid oid;
+	POBJ_FOREACH(pop, oid)
+		nobjects++;
+	UT_ASSERTeq(nobjects, NTHREADS * NOBJECTS / 2);
+
+	/* closing the pool stops the workers */
+	pmemobj_close(pop);
+
+	for (int i = 0; i < NWORKERS; ++i)
+		THREAD_JOIN(&reclaimers[i], NULL);
+
+	ret = pmemobj_check(path, LAYOUT);
+	UT_ASSERTeq(ret, 1);
+
+	pop = pmemobj_open(path, LAYOUT);
+	UT_ASSERTne(pop, NULL);
+
+	nobjects = 0;
+	POBJ_FOREACH(pop, oid)
+		nobjects++;
+	UT_ASSERTeq(nobjects, NTHREADS * NOBJECTS / 2);
+
+	FREE(oids);
+}
+
+/*
+ * alloc_all -- allocates objects until the pool is full and frees them,
+ *	returns the number of objects that were allocated
+ */
+static size_t
+alloc_all(void)
+{
+	size_t nobjects = 0;
+	PMEMoid oid;
+	while (pmemobj_alloc(pop, &oid, FILL_OBJ_SIZE, FILL_TYPE_NUM,
+		NULL, NULL) == 0)
+		nobjects++;
+
+	PMEMoid next;
+	POBJ_FOREACH_SAFE(pop, oid, next) {
+		if (pmemobj_type_num(oid) == FILL_TYPE_NUM)
+			pmemobj_free(&oid);
+	}
+
+	return nobjects;
+}
+
+/*
+ * test_parallel -- checks that the zones reclaimed in parallel at pool open
+ *	hold the same free space as the ones reclaimed on demand
+ */
+static void
+test_parallel(const char *path)
+{
+	unsigned nthreads;
+	int ret = pmemobj_ctl_get(NULL, "heap.reclaim.parallel", &nthreads);
+	UT_ASSERTeq(ret, 0);
+	UT_ASSERTeq(nthreads, 0);
+
+	nthreads = 1025;
+	ret = pmemobj_ctl_set(NULL, "heap.reclaim.parallel", &nthreads);
+	UT_ASSERTeq(ret, -1);
+	UT_ASSERTeq(errno, EINVAL);
+
+	/* leave some partially used runs behind */
+	PMEMoid oids[NOBJECTS];
+	for (int i = 0; i < NOBJECTS; ++i) {
+		ret = pmemobj_alloc(pop, &oids[i], OBJ_SIZE, 0, NULL, NULL);
+		UT_ASSERTeq(ret, 0);
+	}
+	for (int i = 0; i < NOBJECTS; i += 2)
+		pmemobj_free(&oids[i]);
+
+	pmemobj_close(pop);
+	pop = pmemobj_open(path, LAYOUT);
+	UT_ASSERTne(pop, NULL);
+
+	size_t nobjects = alloc_all();
+
+	pmemobj_close(pop);
+
+	nthreads = 4;
+	ret = pmemobj_ctl_set(NULL, "heap.reclaim.parallel", &nthreads);
+	UT_ASSERTeq(ret, 0);
+	ret = pmemobj_ctl_get(NULL, "heap.reclaim.parallel", &nthreads);
+	UT_ASSERTeq(ret, 0);
+	UT_ASSERTeq(nthreads, 4);
+
+	pop = pmemobj_open(path, LAYOUT);
+	UT_ASSERTne(pop, NULL);
+
+	UT_ASSERTeq(alloc_all(), nobjects);
+
+	pmemobj_close(pop);
+
+	UT_ASSERTeq(pmemobj_check(path, LAYOUT), 1);
+
+	pop = pmemobj_open(path, LAYOUT);
+	UT_ASSERTne(pop, NULL);
+}
+
+int
+main(int argc, char *argv[])
+{
+	START(argc, argv, "obj_ctl_reclaim");
+
+	if (argc != 3)
+		UT_FATAL("usage: %s file-name c|m|p", argv[0]);
+
+	const char *path = argv[1];
+	char t = argv[2][0];
+
+	if ((pop = pmemobj_create(path, LAYOUT, PMEMOBJ_MIN_POOL * 10,
+		S_IWUSR | S_IRUSR)) == NULL)
+		UT_FATAL("!pmemobj_create: %s", path);
+
+	switch (t) {
+		case 'c':
+			test_ctl();
+			break;
+		case 'm':
+			test_mt(path);
+			break;
+		case 'p':
+			test_parallel(path);
+			break;
+		default:
+			UT_FATAL("unknown test type %c", t);
+	}
+
+	pmemobj_close(pop);
+
+	DONE(NULL);
+}
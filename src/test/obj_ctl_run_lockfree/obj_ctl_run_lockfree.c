@@ -0,0 +1,236 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/* Copyright 2026, Intel Corporation */
+
+/*
+ * obj_ctl_run_lockfree.c -- tests for the heap.run.lockfree ctl entry point
+ * usage:
+ * obj_ctl_run_lockfree <file> c - test for heap.run.lockfree
+ *
+ * obj_ctl_run_lockfree <file> m - mt test for lock-free reservations from
+ *	runs, with the mode being switched concurrently, followed by a pool
+ *	reopen
+ */
+
+#include "libpmemobj/ctl.h"
+#include "unittest.h"
+
+#define LAYOUT "obj_ctl_run_lockfree"
+#define NTHREADS 8
+#define NOBJECTS 512
+#define NSWITCHES 64
+#define OBJ_SIZE 128
+
+static PMEMobjpool *pop;
+
+/*
+ * set_lockfree -- sets the heap.run.lockfree value
+ */
+static void
+set_lockfree(int enabled)
+{
+	int ret = pmemobj_ctl_set(pop, "heap.run.lockfree", &enabled);
+	UT_ASSERTeq(ret, 0);
+}
+
+/*
+ * cancel_constructor -- object constructor that always fails
+ */
+static int
+cancel_constructor(PMEMobjpool *pop, void *ptr, void *arg)
+{
+	return 1;
+}
+
+/*
+ * check_unique -- checks that the objects do not overlap
+ */
+static void
+check_unique(PMEMoid *oids, size_t noids, size_t size)
+{
+	for (size_t i = 0; i < noids; ++i) {
+		for (size_t j = i + 1; j < noids; ++j) {
+			UT_ASSERT(oids[i].off + size <= oids[j].off ||
+				oids[j].off + size <= oids[i].off);
+		}
+	}
+}
+
+/*
+ * test_ctl -- checks the basic behavior of the lock-free reservations
+ */
+static void
+test_ctl(void)
+{
+	int enabled;
+	int ret = pmemobj_ctl_get(pop, "heap.run.lockfree", &enabled);
+	UT_ASSERTeq(ret, 0);
+	UT_ASSERTeq(enabled, 0);
+
+	/* the active runs are detached when the mode changes */
+	PMEMoid oid;
+	ret = pmemobj_alloc(pop, &oid, OBJ_SIZE, 0, NULL, NULL);
+	UT_ASSERTeq(ret, 0);
+
+	set_lockfree(1);
+	ret = pmemobj_ctl_get(pop, "heap.run.lockfree", &enabled);
+	UT_ASSERTeq(ret, 0);
+	UT_ASSERTeq(enabled, 1);
+
+	PMEMoid oids[NOBJECTS];
+	oids[0] = oid;
+	for (int i = 1; i < NOBJECTS; ++i) {
+		ret = pmemobj_alloc(pop, &oids[i], OBJ_SIZE, 0, NULL, NULL);
+		UT_ASSERTeq(ret, 0);
+		UT_ASSERT(pmemobj_alloc_usable_size(oids[i]) >= OBJ_SIZE);
+	}
+	check_unique(oids, NOBJECTS, OBJ_SIZE);
+
+	for (int i = 0; i < NOBJECTS; ++i)
+		pmemobj_free(&oids[i]);
+
+	/* multi-unit blocks are claimed from a single bitmap value */
+	for (int i = 0; i < NOBJECTS / 4; ++i) {
+		ret = pmemobj_alloc(pop, &oids[i], OBJ_SIZE * 5, 0, NULL, NULL);
+		UT_ASSERTeq(ret, 0);
+		UT_ASSERT(pmemobj_alloc_usable_size(oids[i]) >= OBJ_SIZE * 5);
+	}
+	check_unique(oids, NOBJECTS / 4, OBJ_SIZE * 5);
+
+	for (int i = 0; i < NOBJECTS / 4; ++i)
+		pmemobj_free(&oids[i]);
+
+	/* failed construction gives the block back to the active run */
+	ret = pmemobj_alloc(pop, &oid, OBJ_SIZE, 0, cancel_constructor, NULL);
+	UT_ASSERTeq(ret, -1);
+	UT_ASSERTeq(errno, ECANCELED);
+
+	struct pobj_action act[2];
+	oids[0] = pmemobj_reserve(pop, &act[0], OBJ_SIZE, 0);
+	UT_ASSERT(!OID_IS_NULL(oids[0]));
+	oids[1] = pmemobj_reserve(pop, &act[1], OBJ_SIZE, 0);
+	UT_ASSERT(!OID_IS_NULL(oids[1]));
+	UT_ASSERTne(oids[0].off, oids[1].off);
+	pmemobj_cancel(pop, act, 2);
+
+	oids[2] = pmemobj_reserve(pop, &act[0], OBJ_SIZE, 0);
+	UT_ASSERT(!OID_IS_NULL(oids[2]));
+	UT_ASSERTeq(pmemobj_publish(pop, act, 1), 0);
+
+	set_lockfree(0);
+	ret = pmemobj_ctl_get(pop, "heap.run.lockfree", &enabled);
+	UT_ASSERTeq(ret, 0);
+	UT_ASSERTeq(enabled, 0);
+
+	ret = pmemobj_alloc(pop, &oid, OBJ_SIZE, 0, NULL, NULL);
+	UT_ASSERTeq(ret, 0);
+	UT_ASSERTne(oid.off, oids[2].off);
+
+	pmemobj_free(&oid);
+	pmemobj_free(&oids[2]);
+}
+
+/*
+ * worker -- allocates and frees objects
+ */
+static void *
+worker(void *arg)
+{
+	PMEMoid *oids = arg;
+
+	for (int i = 0; i < NOBJECTS; ++i) {
+		int ret = pmemobj_alloc(pop, &oids[i], OBJ_SIZE, 0, NULL, NULL);
+		UT_ASSERTeq(ret, 0);
+	}
+
+	for (int i = 0; i < NOBJECTS / 2; ++i)
+		pmemobj_free(&oids[i]);
+
+	return NULL;
+}
+
+/*
+ * switcher -- toggles the reservation mode while the workers are running
+ */
+static void *
+switcher(void *arg)
+{
+	for (int i = 0; i < NSWITCHES; ++i)
+		set_lockfree(i % 2);
+
+	set_lockfree(1);
+
+	return NULL;
+}
+
+/*
+ * test_mt -- checks that the blocks reserved by multiple threads are unique
+ *	and that the heap is consistent after a reopen
+ */
+static void
+test_mt(const char *path)
+{
+	set_lockfree(1);
+
+	PMEMoid *oids = MALLOC(sizeof(PMEMoid) * NTHREADS * NOBJECTS);
+	os_thread_t threads[NTHREADS + 1];
+	for (int i = 0; i < NTHREADS; ++i)
+		THREAD_CREATE(&threads[i], NULL, worker, &oids[i * NOBJECTS]);
+	THREAD_CREATE(&threads[NTHREADS], NULL, switcher, NULL);
+
+	for (int i = 0; i <= NTHREADS; ++i)
+		THREAD_JOIN(&threads[i], NULL);
+
+	/* the objects which are still allocated must not overlap */
+	size_t nobjects = 0;
+	PMEMoid oid;
+	POBJ_FOREACH(pop, oid)
+		oids[nobjects++] = oid;
+	UT_ASSERTeq(nobjects, NTHREADS * NOBJECTS / 2);
+	check_unique(oids, nobjects, OBJ_SIZE);
+
+	pmemobj_close(pop);
+
+	int ret = pmemobj_check(path, LAYOUT);
+	UT_ASSERTeq(ret, 1);
+
+	pop = pmemobj_open(path, LAYOUT);
+	UT_ASSERTne(pop, NULL);
+
+	nobjects = 0;
+	POBJ_FOREACH(pop, oid)
+		nobjects++;
+	UT_ASSERTeq(nobjects, NTHREADS * NOBJECTS / 2);
+
+	FREE(oids);
+}
+
+int
+main(int argc, char *argv[])
+{
+	START(argc, argv, "obj_ctl_run_lockfree");
+
+	if (argc != 3)
+		UT_FATAL("usage: %s file-name c|m", argv[0]);
+
+	const char *path = argv[1];
+	char t = argv[2][0];
+
+	if ((pop = pmemobj_create(path, LAYOUT, PMEMOBJ_MIN_POOL * 10,
+		S_IWUSR | S_IRUSR)) == NULL)
+		UT_FATAL("!pmemobj_create: %s", path);
+
+	switch (t) {
+		case 'c':
+			test_ctl();
+			break;
+		case 'm':
+			test_mt(path);
+			break;
+		default:
+			UT_FATAL("unknown test type %c", t);
+	}
+
+	pmemobj_close(pop);
+
+	DONE(NULL);
+}
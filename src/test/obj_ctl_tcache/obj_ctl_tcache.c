@@ -0,0 +1,191 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/* Copyright 2026, Intel Corporation */
+
+/*
+ * obj_ctl_tcache.c -- tests for the heap.tcache ctl entry points
+ * usage:
+ * obj_ctl_tcache <file> c - test for heap.tcache.enabled, heap.tcache.batch
+ *	and heap.tcache.flush
+ *
+ * obj_ctl_tcache <file> m - mt test for allocations served from the thread
+ *	cache, followed by a pool reopen
+ */
+
+#include "libpmemobj/ctl.h"
+#include "unittest.h"
+
+#define LAYOUT "obj_ctl_tcache"
+#define NTHREADS 8
+#define NOBJECTS 512
+#define OBJ_SIZE 128
+
+static PMEMobjpool *pop;
+
+/*
+ * test_ctl -- checks the basic behavior of the thread cache entry points
+ */
+static void
+test_ctl(void)
+{
+	int enabled;
+	int ret = pmemobj_ctl_get(pop, "heap.tcache.enabled", &enabled);
+	UT_ASSERTeq(ret, 0);
+	UT_ASSERTeq(enabled, 0);
+
+	unsigned batch;
+	ret = pmemobj_ctl_get(pop, "heap.tcache.batch", &batch);
+	UT_ASSERTeq(ret, 0);
+	UT_ASSERTne(batch, 0);
+
+	batch = 0;
+	ret = pmemobj_ctl_set(pop, "heap.tcache.batch", &batch);
+	UT_ASSERTeq(ret, -1);
+	UT_ASSERTeq(errno, EINVAL);
+
+	batch = 16;
+	ret = pmemobj_ctl_set(pop, "heap.tcache.batch", &batch);
+	UT_ASSERTeq(ret, 0);
+	ret = pmemobj_ctl_get(pop, "heap.tcache.batch", &batch);
+	UT_ASSERTeq(ret, 0);
+	UT_ASSERTeq(batch, 16);
+
+	enabled = 1;
+	ret = pmemobj_ctl_set(pop, "heap.tcache.enabled", &enabled);
+	UT_ASSERTeq(ret, 0);
+	ret = pmemobj_ctl_get(pop, "heap.tcache.enabled", &enabled);
+	UT_ASSERTeq(ret, 0);
+	UT_ASSERTeq(enabled, 1);
+
+	PMEMoid oids[NOBJECTS];
+	for (int i = 0; i < NOBJECTS; ++i) {
+		ret = pmemobj_alloc(pop, &oids[i], OBJ_SIZE, 0, NULL, NULL);
+		UT_ASSERTeq(ret, 0);
+		UT_ASSERT(pmemobj_alloc_usable_size(oids[i]) >= OBJ_SIZE);
+		if (i != 0)
+			UT_ASSERTne(oids[i].off, oids[i - 1].off);
+	}
+
+	/* the cache must not hand out the same block twice */
+	for (int i = 0; i < NOBJECTS; ++i) {
+		for (int j = i + 1; j < NOBJECTS; ++j)
+			UT_ASSERTne(oids[i].off, oids[j].off);
+	}
+
+	for (int i = 0; i < NOBJECTS; ++i)
+		pmemobj_free(&oids[i]);
+
+	ret = pmemobj_ctl_exec(pop, "heap.tcache.flush", NULL);
+	UT_ASSERTeq(ret, 0);
+
+	/* canceled reservations go back through the regular path */
+	struct pobj_action act[2];
+	oids[0] = pmemobj_reserve(pop, &act[0], OBJ_SIZE, 0);
+	UT_ASSERT(!OID_IS_NULL(oids[0]));
+	oids[1] = pmemobj_reserve(pop, &act[1], OBJ_SIZE, 0);
+	UT_ASSERT(!OID_IS_NULL(oids[1]));
+	pmemobj_cancel(pop, act, 2);
+
+	enabled = 0;
+	ret = pmemobj_ctl_set(pop, "heap.tcache.enabled", &enabled);
+	UT_ASSERTeq(ret, 0);
+
+	ret = pmemobj_alloc(pop, &oids[0], OBJ_SIZE, 0, NULL, NULL);
+	UT_ASSERTeq(ret, 0);
+	pmemobj_free(&oids[0]);
+}
+
+/*
+ * worker -- allocates and frees objects with the thread cache enabled,
+ *	leaves some of the blocks cached on exit
+ */
+static void *
+worker(void *arg)
+{
+	PMEMoid *oids = arg;
+
+	for (int i = 0; i < NOBJECTS; ++i) {
+		int ret = pmemobj_alloc(pop, &oids[i], OBJ_SIZE, 0, NULL, NULL);
+		UT_ASSERTeq(ret, 0);
+	}
+
+	for (int i = 0; i < NOBJECTS / 2; ++i)
+		pmemobj_free(&oids[i]);
+
+	return NULL;
+}
+
+/*
+ * test_mt -- checks that the blocks handed out to multiple threads are
+ *	unique and that the heap survives a reopen with populated caches
+ */
+static void
+test_mt(const char *path)
+{
+	int enabled = 1;
+	int ret = pmemobj_ctl_set(pop, "heap.tcache.enabled", &enabled);
+	UT_ASSERTeq(ret, 0);
+
+	PMEMoid *oids = MALLOC(sizeof(PMEMoid) * NTHREADS * NOBJECTS);
+	os_thread_t threads[NTHREADS];
+	for (int i = 0; i < NTHREADS; ++i)
+		THREAD_CREATE(&threads[i], NULL, worker, &oids[i * NOBJECTS]);
+
+	for (int i = 0; i < NTHREADS; ++i)
+		THREAD_JOIN(&threads[i], NULL);
+
+	size_t nobjects = 0;
+	PMEMoid oid;
+	POBJ_FOREACH(pop, oid)
+		nobjects++;
+	UT_ASSERTeq(nobjects, NTHREADS * NOBJECTS / 2);
+
+	/* the main thread exits with some blocks still in its cache */
+	ret = pmemobj_alloc(pop, &oid, OBJ_SIZE, 0, NULL, NULL);
+	UT_ASSERTeq(ret, 0);
+
+	pmemobj_close(pop);
+
+	ret = pmemobj_check(path, LAYOUT);
+	UT_ASSERTeq(ret, 1);
+
+	pop = pmemobj_open(path, LAYOUT);
+	UT_ASSERTne(pop, NULL);
+
+	nobjects = 0;
+	POBJ_FOREACH(pop, oid)
+		nobjects++;
+	UT_ASSERTeq(nobjects, NTHREADS * NOBJECTS / 2 + 1);
+
+	FREE(oids);
+}
+
+int
+main(int argc, char *argv[])
+{
+	START(argc, argv, "obj_ctl_tcache");
+
+	if (argc != 3)
+		UT_FATAL("usage: %s file-name c|m", argv[0]);
+
+	const char *path = argv[1];
+	char t = argv[2][0];
+
+	if ((pop = pmemobj_create(path, LAYOUT, PMEMOBJ_MIN_POOL * 10,
+		S_IWUSR | S_IRUSR)) == NULL)
+		UT_FATAL("!pmemobj_create: %s", path);
+
+	switch (t) {
+		case 'c':
+			test_ctl();
+			break;
+		case 'm':
+			test_mt(path);
+			break;
+		default:
+			UT_FATAL("unknown test type %c", t);
+	}
+
+	pmemobj_close(pop);
+
+	DONE(NULL);
+}
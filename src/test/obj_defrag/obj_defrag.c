@@ -163,6 +163,118 @@ defrag_nested_pointers(PMEMobjpool *pop)
 	FREE(oid3pprs);
 }
 
+#define INCREMENTAL_OBJECTS 10000
+#define INCREMENTAL_KEEP_EVERY 10
+
+struct incremental_state {
+	PMEMoid *oids;
+	size_t noids;
+	int fail;
+};
+
+/*
+ * defrag_enumerate -- enumerates the pointers to all of the objects
+ */
+static int
+defrag_enumerate(PMEMobjpool *pop, pmemobj_defrag_visit visit,
+	void *visit_arg, void *arg)
+{
+	struct incremental_state *state = arg;
+	if (state->fail)
+		return -1;
+
+	for (size_t i = 0; i < state->noids; ++i)
+		visit(&state->oids[i], visit_arg);
+
+	return 0;
+}
+
+static void
+defrag_incremental(PMEMobjpool *pop)
+{
+	int ret;
+	struct pobj_defrag_result result;
+
+	/* there's no enumeration callback yet */
+	ret = pmemobj_defrag_step(pop, 1, &result);
+	UT_ASSERTeq(ret, -1);
+	UT_ASSERTeq(errno, EINVAL);
+
+	int enabled = 1;
+	ret = pmemobj_ctl_set(pop, "stats.enabled", &enabled);
+	UT_ASSERTeq(ret, 0);
+
+	struct incremental_state state;
+	state.oids = (PMEMoid *)MALLOC(sizeof(PMEMoid) * INCREMENTAL_OBJECTS);
+	state.noids = 0;
+	state.fail = 0;
+
+	PMEMoid *all = (PMEMoid *)MALLOC(sizeof(PMEMoid) *
+		INCREMENTAL_OBJECTS);
+	for (size_t i = 0; i < INCREMENTAL_OBJECTS; ++i) {
+		ret = pmemobj_zalloc(pop, &all[i], OBJECT_SIZE, 0);
+		UT_ASSERTeq(ret, 0);
+	}
+
+	/* leave the runs sparsely populated */
+	for (size_t i = 0; i < INCREMENTAL_OBJECTS; ++i) {
+		if (i % INCREMENTAL_KEEP_EVERY != 0) {
+			pmemobj_free(&all[i]);
+			continue;
+		}
+
+		size_t *data = (size_t *)pmemobj_direct(all[i]);
+		*data = i;
+		pmemobj_persist(pop, data, sizeof(*data));
+
+		state.oids[state.noids++] = all[i];
+	}
+	FREE(all);
+
+	ret = pmemobj_defrag_register(pop, defrag_enumerate, &state);
+	UT_ASSERTeq(ret, 0);
+
+	/* a failure of the callback is reported */
+	state.fail = 1;
+	ret = pmemobj_defrag_step(pop, 1, &result);
+	UT_ASSERTeq(ret, -1);
+	state.fail = 0;
+
+	uint64_t run_active_before;
+	ret = pmemobj_ctl_get(pop, "stats.heap.run_active",
+		&run_active_before);
+	UT_ASSERTeq(ret, 0);
+
+	size_t relocated = 0;
+	do {
+		ret = pmemobj_defrag_step(pop, 1, &result);
+		UT_ASSERTeq(ret, 0);
+		UT_ASSERT(result.relocated <= result.total);
+		relocated += result.relocated;
+	} while (result.total != 0);
+
+	UT_ASSERTne(relocated, 0);
+
+	uint64_t run_active_after;
+	ret = pmemobj_ctl_get(pop, "stats.heap.run_active",
+		&run_active_after);
+	UT_ASSERTeq(ret, 0);
+
+	/* the runs that were emptied were given back to the heap */
+	UT_ASSERT(run_active_after < run_active_before);
+
+	for (size_t i = 0; i < state.noids; ++i) {
+		size_t *data = (size_t *)pmemobj_direct(state.oids[i]);
+		UT_ASSERTeq(*data, i * INCREMENTAL_KEEP_EVERY);
+		pmemobj_free(&state.oids[i]);
+	}
+
+	ret = pmemobj_defrag_register(pop, NULL, NULL);
+	UT_ASSERTeq(ret, 0);
+
+	FREE(state.oids);
+}
+
 int
 main(int argc, char *argv[])
 {
@@ -178,6 +290,7 @@ main(int argc, char *argv[])
 
 	defrag_basic(pop);
 	defrag_nested_pointers(pop);
+	defrag_incremental(pop);
 
 	pmemobj_close(pop);
 
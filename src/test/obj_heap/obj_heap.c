@@ -23,6 +23,7 @@
 #include "util.h"
 #include "container_ravl.h"
 #include "container_seglists.h"
+#include "container_tlsf.h"
 #include "container.h"
 #include "alloc_class.h"
 #include "valgrind_internal.h"
@@ -185,6 +186,72 @@ test_container(struct block_container *bc, struct palloc_heap *heap)
 	bc->c_ops->destroy(bc);
 }
 
+/*
+ * test_container_tlsf -- checks the size classes of the TLSF container
+ */
+static void
+test_container_tlsf(struct palloc_heap *heap)
+{
+	struct block_container *bc = container_new_tlsf(heap);
+	UT_ASSERTne(bc, NULL);
+
+	/* 32 and 33 share a size class, 34 and 35 share the next one */
+	struct memory_block a = {1, 0, 33, 0};
+	struct memory_block b = {40, 0, 35, 0};
+	struct memory_block c = {80, 0, 1000, 0};
+
+	int ret;
+	ret = bc->c_ops->insert(bc, &a);
+	UT_ASSERTeq(ret, 0);
+
+	ret = bc->c_ops->insert(bc, &b);
+	UT_ASSERTeq(ret, 0);
+
+	ret = bc->c_ops->insert(bc, &c);
+	UT_ASSERTeq(ret, 0);
+
+	/* a block with the same location can't be inserted twice */
+	ret = bc->c_ops->insert(bc, &a);
+	UT_ASSERTne(ret, 0);
+
+	/* the size has to match for the exact removal */
+	struct memory_block a_wrong = {1, 0, 32, 0};
+	ret = bc->c_ops->get_rm_exact(bc, &a_wrong);
+	UT_ASSERTeq(ret, ENOMEM);
+
+	/* the classes above 33 are searched first */
+	struct memory_block m = {0, 0, 33, 0};
+	ret = bc->c_ops->get_rm_bestfit(bc, &m);
+	UT_ASSERTeq(ret, 0);
+	UT_ASSERTeq(m.chunk_id, b.chunk_id);
+	UT_ASSERTeq(m.size_idx, b.size_idx);
+
+	ret = bc->c_ops->get_rm_exact(bc, &c);
+	UT_ASSERTeq(ret, 0);
+
+	ret = bc->c_ops->get_rm_exact(bc, &c);
+	UT_ASSERTeq(ret, ENOMEM);
+
+	/* the class of 33 is scanned when nothing larger is left */
+	m.size_idx = 33;
+	ret = bc->c_ops->get_rm_bestfit(bc, &m);
+	UT_ASSERTeq(ret, 0);
+	UT_ASSERTeq(m.chunk_id, a.chunk_id);
+
+	ret = bc->c_ops->is_empty(bc);
+	UT_ASSERTeq(ret, 1);
+
+	ret = bc->c_ops->insert(bc, &a);
+	UT_ASSERTeq(ret, 0);
+
+	/* 33 is in the class of 32, but doesn't fit 34 */
+	m.size_idx = 34;
+	ret = bc->c_ops->get_rm_bestfit(bc, &m);
+	UT_ASSERTeq(ret, ENOMEM);
+
+	bc->c_ops->destroy(bc);
+}
+
 static void
 do_fault_injection_new_ravl()
 {
@@ -324,6 +391,11 @@ test_heap(void)
 	test_container((struct block_container *)container_new_seglists(heap),
 		heap);
 
+	test_container((struct block_container *)container_new_tlsf(heap),
+		heap);
+
+	test_container_tlsf(heap);
+
 	struct alloc_class *c_small = heap_get_best_class(heap, 1);
 	struct alloc_class *c_big = heap_get_best_class(heap, 2048);
 
@@ -369,6 +441,14 @@ test_heap(void)
 
 	heap_bucket_release(b_run);
 
+	/* the reclaimed zone has a valid summary of its free space */
+	struct zone *z = ZID_TO_ZONE(heap->layout, 0);
+	struct zone_summary *summary = &z->header.summary;
+	UT_ASSERTeq(summary->magic, ZONE_SUMMARY_MAGIC);
+	UT_ASSERTeq(util_checksum(summary, sizeof(*summary),
+		&summary->checksum, 0, 0), 1);
+	UT_ASSERTne(summary->free_chunks, 0);
+
 	stats_delete(pop, s);
 	UT_ASSERT(heap_check(heap_start, heap_size) == 0);
 	heap_cleanup(heap);
@@ -13,6 +13,7 @@
 
 #include "list.h"
 #include "obj.h"
+#include "sys_util.h"
 #include "tx.h"
 #include "unittest.h"
 #include "pmemcommon.h"
@@ -126,7 +127,12 @@ test_lane_hold_release(void)
 	pop->p.nlanes = 1;
 	pop->p.lanes_desc.runtime_nlanes = 1,
 	pop->p.lanes_desc.lane = &mock_lane;
-	pop->p.lanes_desc.next_lane_idx = 0;
+	pop->p.lanes_desc.ngroups = 1;
+	pop->p.lanes_desc.group_next = CALLOC(1, sizeof(unsigned));
+	pop->p.lanes_desc.nwaiters = 0;
+	pop->p.lanes_desc.nreleases = 0;
+	util_mutex_init(&pop->p.lanes_desc.wait_lock);
+	util_cond_init(&pop->p.lanes_desc.wait_cond);
 
 	pop->p.lanes_desc.lane_locks = CALLOC(OBJ_NLANES, sizeof(uint64_t));
 	pop->p.lanes_offset = (uint64_t)&pop->l - (uint64_t)&pop->p;
@@ -158,6 +164,9 @@ test_lane_hold_release(void)
 
 	SIGACTION(SIGABRT, &old, NULL);
 
+	util_cond_destroy(&pop->p.lanes_desc.wait_cond);
+	util_mutex_destroy(&pop->p.lanes_desc.wait_lock);
+	FREE(pop->p.lanes_desc.group_next);
 	FREE(pop->p.lanes_desc.lane_locks);
 	FREE(pop);
 	operation_delete(ctx);
@@ -0,0 +1,210 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/* Copyright 2026, Intel Corporation */
+
+/*
+ * obj_lane_recovery.c -- tests for the parallel recovery of lanes
+ * usage:
+ * obj_lane_recovery <file> c - interrupts a transaction in each of multiple
+ *	threads
+ *
+ * obj_lane_recovery <file> o <nthreads> - opens the pool with the given
+ *	lane.recovery.parallel and checks that the transactions were rolled back
+ *
+ * obj_lane_recovery <file> p <nthreads> - checks the lane.recovery.parallel
+ *	entry point, nthreads is the expected initial value
+ */
+
+#include "unittest.h"
+
+#define LAYOUT "obj_lane_recovery"
+#define NTHREADS 16
+/* large enough for the undo logs to be extended a few times */
+#define OBJ_SIZE (256 << 10)
+#define POOL_SIZE (64 << 20)
+
+struct root {
+	PMEMoid objs[NTHREADS];
+};
+
+static PMEMobjpool *pop;
+
+/* number of threads that are in the middle of a transaction */
+static unsigned ninterrupted;
+
+/*
+ * pattern -- returns the byte the object of the given thread is filled with
+ */
+static int
+pattern(uintptr_t i)
+{
+	return (int)('a' + i);
+}
+
+/*
+ * interrupted_worker -- modifies its object in a transaction that never ends
+ */
+static void *
+interrupted_worker(void *arg)
+{
+	uintptr_t i = (uintptr_t)arg;
+	struct root *r = pmemobj_direct(pmemobj_root(pop, sizeof(struct root)));
+
+	TX_BEGIN(pop) {
+		pmemobj_tx_add_range(r->objs[i], 0, OBJ_SIZE);
+		memset(pmemobj_direct(r->objs[i]), 0xff, OBJ_SIZE);
+
+		util_fetch_and_add32(&ninterrupted, 1);
+		for (;;)
+			usleep(1000);
+	} TX_END
+
+	return NULL;
+}
+
+/*
+ * committed_worker -- modifies its object in a committed transaction
+ */
+static void *
+committed_worker(void *arg)
+{
+	uintptr_t i = (uintptr_t)arg;
+	struct root *r = pmemobj_direct(pmemobj_root(pop, sizeof(struct root)));
+
+	TX_BEGIN(pop) {
+		pmemobj_tx_add_range(r->objs[i], 0, OBJ_SIZE);
+		memset(pmemobj_direct(r->objs[i]), pattern(i), OBJ_SIZE);
+	} TX_ONABORT {
+		UT_ASSERT(0);
+	} TX_END
+
+	return NULL;
+}
+
+/*
+ * test_crash -- creates the objects and simulates a crash in the middle of
+ *	a transaction in each of the threads
+ */
+static void
+test_crash(const char *path)
+{
+	pop = pmemobj_create(path, LAYOUT, POOL_SIZE, S_IWUSR | S_IRUSR);
+	if (pop == NULL)
+		UT_FATAL("!pmemobj_create: %s", path);
+
+	struct root *r = pmemobj_direct(pmemobj_root(pop, sizeof(struct root)));
+	for (uintptr_t i = 0; i < NTHREADS; ++i) {
+		int ret = pmemobj_alloc(pop, &r->objs[i], OBJ_SIZE, 0,
+			NULL, NULL);
+		UT_ASSERTeq(ret, 0);
+
+		pmemobj_memset_persist(pop, pmemobj_direct(r->objs[i]),
+			pattern(i), OBJ_SIZE);
+	}
+	pmemobj_persist(pop, r, sizeof(*r));
+
+	os_thread_t threads[NTHREADS];
+	for (uintptr_t i = 0; i < NTHREADS; ++i)
+		THREAD_CREATE(&threads[i], NULL, interrupted_worker,
+			(void *)i);
+
+	while (util_fetch_and_add32(&ninterrupted, 0) != NTHREADS)
+		usleep(1000);
+
+	exit(0); /* simulate a crash */
+}
+
+/*
+ * check_objects -- verifies the contents of all the objects
+ */
+static void
+check_objects(void)
+{
+	struct root *r = pmemobj_direct(pmemobj_root(pop, sizeof(struct root)));
+	for (uintptr_t i = 0; i < NTHREADS; ++i) {
+		char *data = pmemobj_direct(r->objs[i]);
+		for (size_t j = 0; j < OBJ_SIZE; ++j)
+			UT_ASSERTeq(data[j], pattern(i));
+	}
+}
+
+/*
+ * test_open -- opens the pool recovering the lanes with the given number of
+ *	threads and checks that the lanes can be used again
+ */
+static void
+test_open(const char *path, unsigned nthreads)
+{
+	int ret = pmemobj_ctl_set(NULL, "lane.recovery.parallel", &nthreads);
+	UT_ASSERTeq(ret, 0);
+
+	pop = pmemobj_open(path, LAYOUT);
+	if (pop == NULL)
+		UT_FATAL("!pmemobj_open: %s", path);
+
+	check_objects();
+
+	os_thread_t threads[NTHREADS];
+	for (uintptr_t i = 0; i < NTHREADS; ++i)
+		THREAD_CREATE(&threads[i], NULL, committed_worker, (void *)i);
+	for (int i = 0; i < NTHREADS; ++i)
+		THREAD_JOIN(&threads[i], NULL);
+
+	check_objects();
+
+	pmemobj_close(pop);
+
+	ret = pmemobj_check(path, LAYOUT);
+	UT_ASSERTeq(ret, 1);
+}
+
+/*
+ * test_ctl -- checks the lane.recovery.parallel entry point
+ */
+static void
+test_ctl(unsigned expected)
+{
+	unsigned nthreads;
+	int ret = pmemobj_ctl_get(NULL, "lane.recovery.parallel", &nthreads);
+	UT_ASSERTeq(ret, 0);
+	UT_ASSERTeq(nthreads, expected);
+
+	nthreads = 1025;
+	ret = pmemobj_ctl_set(NULL, "lane.recovery.parallel", &nthreads);
+	UT_ASSERTeq(ret, -1);
+	UT_ASSERTeq(errno, EINVAL);
+
+	nthreads = 1024;
+	ret = pmemobj_ctl_set(NULL, "lane.recovery.parallel", &nthreads);
+	UT_ASSERTeq(ret, 0);
+	ret = pmemobj_ctl_get(NULL, "lane.recovery.parallel", &nthreads);
+	UT_ASSERTeq(ret, 0);
+	UT_ASSERTeq(nthreads, 1024);
+}
+
+int
+main(int argc, char *argv[])
+{
+	START(argc, argv, "obj_lane_recovery");
+
+	if (argc < 3)
+		UT_FATAL("usage: %s file-name c|o|p [nthreads]", argv[0]);
+
+	const char *path = argv[1];
+	unsigned nthreads = argc > 3 ? ATOU(argv[3]) : 0;
+
+	switch (argv[2][0]) {
+	case 'c':
+		test_crash(path);
+		break;
+	case 'o':
+		test_open(path, nthreads);
+		break;
+	case 'p':
+		test_ctl(nthreads);
+		break;
+	default:
+		UT_FATAL("unknown operation");
+	}
+
+	DONE(NULL);
+}
@@ -21,6 +21,7 @@
 #define MAX_CHUNK_V3 (65535 - 7)
 #define SIZEOF_CHUNK_V3 (1024ULL * 256)
 #define SIZEOF_CHUNK_RUN_HEADER_V3 (16)
+#define SIZEOF_ZONE_SUMMARY_V3 (24)
 #define SIZEOF_ZONE_HEADER_V3 (64)
 #define SIZEOF_ZONE_METADATA_V3 (SIZEOF_ZONE_HEADER_V3 +\
 	SIZEOF_CHUNK_HEADER_V3 * MAX_CHUNK_V3)
@@ -93,9 +94,19 @@ main(int argc, char *argv[])
 	UT_COMPILE_ERROR_ON(sizeof(struct chunk_header) !=
 		SIZEOF_CHUNK_HEADER_V3);
 
+	ASSERT_ALIGNED_BEGIN(struct zone_summary);
+	ASSERT_ALIGNED_FIELD(struct zone_summary, magic);
+	ASSERT_ALIGNED_FIELD(struct zone_summary, free_runs);
+	ASSERT_ALIGNED_FIELD(struct zone_summary, free_chunks);
+	ASSERT_ALIGNED_FIELD(struct zone_summary, checksum);
+	ASSERT_ALIGNED_CHECK(struct zone_summary);
+	UT_COMPILE_ERROR_ON(sizeof(struct zone_summary) !=
+		SIZEOF_ZONE_SUMMARY_V3);
+
 	ASSERT_ALIGNED_BEGIN(struct zone_header);
 	ASSERT_ALIGNED_FIELD(struct zone_header, magic);
 	ASSERT_ALIGNED_FIELD(struct zone_header, size_idx);
+	ASSERT_ALIGNED_FIELD(struct zone_header, summary);
 	ASSERT_ALIGNED_FIELD(struct zone_header, reserved);
 	ASSERT_ALIGNED_CHECK(struct zone_header);
 	UT_COMPILE_ERROR_ON(sizeof(struct zone_header) !=
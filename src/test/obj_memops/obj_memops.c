@@ -52,7 +52,8 @@ redo_log_constructor(void *ctx, void *ptr, size_t usable_size, void *arg)
 }
 
 static int
-pmalloc_redo_extend(void *base, uint64_t *redo, uint64_t gen_num)
+pmalloc_redo_extend(void *base, uint64_t *redo, uint64_t gen_num,
+	size_t size)
 {
 	size_t s = SIZEOF_ALIGNED_ULOG(TEST_ENTRIES);
 
@@ -94,7 +95,7 @@ test_set_entries(PMEMobjpool *pop,
 			break;
 			case FAIL_MODIFY_NEXT:
 				pmalloc_redo_extend(pop,
-					&object->redo.next, 0);
+					&object->redo.next, 0, 0);
 			break;
 			case FAIL_MODIFY_VALUE:
 				object->redo.data[16] += 8;
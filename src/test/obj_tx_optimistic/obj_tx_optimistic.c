@@ -0,0 +1,479 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/* Copyright 2026, Intel Corporation */
+
+/*
+ * obj_tx_optimistic.c -- unit test for the optimistic concurrency control
+ *	of transactions
+ * usage:
+ * obj_tx_optimistic <file> [c|o|r|w|a|f|d|n|m]...
+ *
+ * c - test for the tx.optimistic.enabled control
+ *
+ * o - test for reading the ranges modified by the transaction itself
+ *
+ * r - test for a read range modified by a transaction that commits first
+ *
+ * w - test for reading and modifying a range being modified
+ *
+ * a - test for the ranges of an aborted transaction
+ *
+ * f - test for reading an object freed by a different transaction
+ *
+ * d - test for the reads being ignored when the control is disabled
+ *
+ * n - test for nested TX_BEGIN_RETRY and for the limit of its runs
+ *
+ * m - test for concurrent transactions retried with TX_BEGIN_RETRY
+ *
+ * All the tests but c and d expect the control to be enabled by c.
+ */
+
+#include "unittest.h"
+
+#define NTHREADS 8
+#define NOPS 500
+
+struct counters {
+	uint64_t a;
+	uint64_t pad[15];
+	uint64_t b;
+};
+
+POBJ_LAYOUT_BEGIN(obj_tx_optimistic);
+POBJ_LAYOUT_ROOT(obj_tx_optimistic, struct root);
+POBJ_LAYOUT_TOID(obj_tx_optimistic, struct counters);
+POBJ_LAYOUT_END(obj_tx_optimistic);
+
+struct root {
+	TOID(struct counters) c;
+	PMEMoid obj;
+};
+
+static PMEMobjpool *pop;
+static TOID(struct root) root;
+
+/*
+ * tx_increment -- increments the given counter in a new transaction,
+ *	returns the error number of the transaction
+ */
+static int
+tx_increment(uint64_t *counter)
+{
+	TX_BEGIN(pop) {
+		TX_ADD_DIRECT(counter);
+		(*counter)++;
+	} TX_END
+
+	return pmemobj_tx_errno();
+}
+
+/*
+ * increment_a -- increments the first counter from a different thread
+ */
+static void *
+increment_a(void *arg)
+{
+	int *ret = arg;
+	TOID(struct counters) c = D_RO(root)->c;
+
+	*ret = tx_increment(&D_RW(c)->a);
+
+	return NULL;
+}
+
+/*
+ * in_thread -- runs the function in a new thread, while the transaction of
+ *	the calling one is in progress, and returns its result
+ */
+static int
+in_thread(void *(*func)(void *))
+{
+	int ret = -1;
+
+	os_thread_t t;
+	THREAD_CREATE(&t, NULL, func, &ret);
+	THREAD_JOIN(&t, NULL);
+
+	return ret;
+}
+
+/*
+ * test_ctl -- enables the control and checks its value
+ */
+static void
+test_ctl(void)
+{
+	int enabled = -1;
+	int ret = pmemobj_ctl_get(pop, "tx.optimistic.enabled", &enabled);
+	UT_ASSERTeq(ret, 0);
+	UT_ASSERTeq(enabled, 0);
+
+	enabled = 1;
+	ret = pmemobj_ctl_set(pop, "tx.optimistic.enabled", &enabled);
+	UT_ASSERTeq(ret, 0);
+
+	enabled = 0;
+	ret = pmemobj_ctl_get(pop, "tx.optimistic.enabled", &enabled);
+	UT_ASSERTeq(ret, 0);
+	UT_ASSERTeq(enabled, 1);
+}
+
+/*
+ * test_own -- reads the ranges the transaction has modified
+ */
+static void
+test_own(void)
+{
+	TOID(struct counters) c = D_RO(root)->c;
+
+	TX_BEGIN(pop) {
+		TX_ADD_FIELD(c, a);
+		D_RW(c)->a = 1;
+		TX_READ(c);
+		TX_READ_FIELD(c, a);
+		UT_ASSERTeq(D_RO(c)->a, 1);
+
+		pmemobj_tx_write(c.oid, offsetof(struct counters, b),
+			&D_RO(c)->a, sizeof(D_RO(c)->a));
+		TX_READ_FIELD_DIRECT(D_RO(c), b);
+	} TX_ONABORT {
+		UT_ASSERT(0);
+	} TX_END
+
+	UT_ASSERTeq(D_RO(c)->a, 1);
+	UT_ASSERTeq(D_RO(c)->b, 1);
+}
+
+/*
+ * test_read_conflict -- commits a read range which was modified by
+ *	a different transaction in the meantime
+ */
+static void
+test_read_conflict(void)
+{
+	TOID(struct counters) c = D_RO(root)->c;
+	uint64_t a = D_RO(c)->a;
+
+	TX_BEGIN(pop) {
+		TX_READ_FIELD(c, a);
+		UT_ASSERTeq(in_thread(increment_a), 0);
+	} TX_ONCOMMIT {
+		UT_ASSERT(0);
+	} TX_END
+
+	UT_ASSERTeq(pmemobj_tx_errno(), EAGAIN);
+	UT_ASSERTeq(D_RO(c)->a, a + 1);
+
+	/* the other counter is on a different cache line */
+	TX_BEGIN(pop) {
+		TX_READ_FIELD(c, b);
+		UT_ASSERTeq(in_thread(increment_a), 0);
+	} TX_ONABORT {
+		UT_ASSERT(0);
+	} TX_END
+
+	UT_ASSERTeq(D_RO(c)->a, a + 2);
+}
+
+/*
+ * read_a -- reads the first counter from a different thread, returns the
+ *	error number
+ */
+static void *
+read_a(void *arg)
+{
+	int *ret = arg;
+	TOID(struct counters) c = D_RO(root)->c;
+
+	TX_BEGIN(pop) {
+		*ret = pmemobj_tx_xread_range_direct(&D_RO(c)->a,
+			sizeof(D_RO(c)->a), POBJ_XREAD_NO_ABORT);
+		UT_ASSERTeq(pmemobj_tx_stage(), TX_STAGE_WORK);
+	} TX_ONABORT {
+		UT_ASSERT(0);
+	} TX_END
+
+	return NULL;
+}
+
+/*
+ * test_write_conflict -- reads and modifies a range being modified by
+ *	a different transaction
+ */
+static void
+test_write_conflict(void)
+{
+	TOID(struct counters) c = D_RO(root)->c;
+	uint64_t a = D_RO(c)->a;
+
+	TX_BEGIN(pop) {
+		TX_ADD_FIELD(c, a);
+		D_RW(c)->a = 0;
+		UT_ASSERTeq(in_thread(read_a), EAGAIN);
+		UT_ASSERTeq(in_thread(increment_a), EAGAIN);
+		D_RW(c)->a = a + 10;
+	} TX_ONABORT {
+		UT_ASSERT(0);
+	} TX_END
+
+	UT_ASSERTeq(D_RO(c)->a, a + 10);
+
+	/* the commit has released the range */
+	UT_ASSERTeq(in_thread(read_a), 0);
+	UT_ASSERTeq(in_thread(increment_a), 0);
+	UT_ASSERTeq(D_RO(c)->a, a + 11);
+}
+
+/*
+ * test_abort -- checks that the ranges of an aborted transaction are
+ *	released
+ */
+static void
+test_abort(void)
+{
+	TOID(struct counters) c = D_RO(root)->c;
+	uint64_t a = D_RO(c)->a;
+
+	TX_BEGIN(pop) {
+		TX_ADD_FIELD(c, a);
+		D_RW(c)->a = 0;
+		pmemobj_tx_abort(ECANCELED);
+	} TX_END
+
+	UT_ASSERTeq(D_RO(c)->a, a);
+
+	/* a range that failed to be locked is not locked */
+	TX_BEGIN(pop) {
+		TX_ADD_FIELD(c, a);
+		UT_ASSERTeq(in_thread(increment_a), EAGAIN);
+		pmemobj_tx_abort(ECANCELED);
+	} TX_END
+
+	UT_ASSERTeq(in_thread(increment_a), 0);
+	UT_ASSERTeq(D_RO(c)->a, a + 1);
+}
+
+/*
+ * free_obj -- frees the object of the root from a different thread
+ */
+static void *
+free_obj(void *arg)
+{
+	int *ret = arg;
+
+	TX_BEGIN(pop) {
+		pmemobj_tx_add_range(root.oid, offsetof(struct root, obj),
+			sizeof(PMEMoid));
+		pmemobj_tx_free(D_RO(root)->obj);
+		D_RW(root)->obj = OID_NULL;
+	} TX_END
+
+	*ret = pmemobj_tx_errno();
+
+	return NULL;
+}
+
+/*
+ * test_free -- reads an object that is freed by a different transaction
+ */
+static void
+test_free(void)
+{
+	int ret = pmemobj_zalloc(pop, &D_RW(root)->obj, 256, 0);
+	UT_ASSERTeq(ret, 0);
+
+	PMEMoid obj = D_RO(root)->obj;
+
+	TX_BEGIN(pop) {
+		pmemobj_tx_read_range(obj, 128, 64);
+		UT_ASSERTeq(in_thread(free_obj), 0);
+	} TX_ONCOMMIT {
+		UT_ASSERT(0);
+	} TX_END
+
+	UT_ASSERTeq(pmemobj_tx_errno(), EAGAIN);
+	UT_ASSERT(OID_IS_NULL(D_RO(root)->obj));
+}
+
+/*
+ * test_disabled -- checks that the reads are ignored without the control
+ */
+static void
+test_disabled(void)
+{
+	int enabled = 0;
+	int ret = pmemobj_ctl_set(pop, "tx.optimistic.enabled", &enabled);
+	UT_ASSERTeq(ret, 0);
+
+	TOID(struct counters) c = D_RO(root)->c;
+
+	TX_BEGIN(pop) {
+		TX_READ_FIELD(c, a);
+		UT_ASSERTeq(in_thread(increment_a), 0);
+	} TX_ONABORT {
+		UT_ASSERT(0);
+	} TX_END
+
+	enabled = 1;
+	ret = pmemobj_ctl_set(pop, "tx.optimistic.enabled", &enabled);
+	UT_ASSERTeq(ret, 0);
+}
+
+/*
+ * test_retry -- retries a transaction with a nested TX_BEGIN_RETRY, and
+ *	a transaction which conflicts on every run
+ */
+static void
+test_retry(void)
+{
+	TOID(struct counters) c = D_RO(root)->c;
+	uint64_t a = D_RO(c)->a;
+
+	/* an abort of the nested transaction retries the outermost one */
+	int outer = 0;
+	int inner = 0;
+	TX_BEGIN_RETRY(pop) {
+		outer++;
+		TX_BEGIN_RETRY(pop) {
+			inner++;
+			TX_READ_FIELD(c, a);
+			if (outer == 1)
+				UT_ASSERTeq(in_thread(increment_a), 0);
+		} TX_END
+	} TX_ONABORT {
+		UT_ASSERTeq(errno, EAGAIN);
+	} TX_END
+
+	UT_ASSERTeq(pmemobj_tx_errno(), 0);
+	UT_ASSERTeq(outer, 2);
+	UT_ASSERTeq(inner, 2);
+	UT_ASSERTeq(D_RO(c)->a, a + 1);
+
+	/* a transaction that never succeeds is given up on */
+	int runs = 0;
+	TX_BEGIN_RETRY(pop) {
+		runs++;
+		TX_READ_FIELD(c, a);
+		UT_ASSERTeq(in_thread(increment_a), 0);
+	} TX_ONCOMMIT {
+		UT_ASSERT(0);
+	} TX_END
+
+	UT_ASSERTeq(errno, EAGAIN);
+	UT_ASSERTeq(runs, POBJ_TX_RETRY_MAX);
+	UT_ASSERTeq(D_RO(c)->a, a + 1 + POBJ_TX_RETRY_MAX);
+}
+
+/* number of the transfers which were committed */
+static unsigned ntransfers;
+
+/*
+ * transfer -- moves the value between the counters in retried transactions,
+ *	a transaction is given up on after POBJ_TX_RETRY_MAX conflicts
+ */
+static void *
+transfer(void *arg)
+{
+	TOID(struct counters) c = D_RO(root)->c;
+
+	for (int i = 0; i < NOPS; ++i) {
+		TX_BEGIN_RETRY(pop) {
+			TX_READ(c);
+
+			uint64_t a = D_RO(c)->a;
+			uint64_t b = D_RO(c)->b;
+
+			TX_ADD_FIELD(c, a);
+			D_RW(c)->a = a + 1;
+			TX_ADD_FIELD(c, b);
+			D_RW(c)->b = b - 1;
+		} TX_ONCOMMIT {
+			util_fetch_and_add32(&ntransfers, 1);
+		} TX_ONABORT {
+			UT_ASSERTeq(errno, EAGAIN);
+		} TX_END
+	}
+
+	return NULL;
+}
+
+/*
+ * test_mt -- runs conflicting transactions concurrently
+ */
+static void
+test_mt(void)
+{
+	TOID(struct counters) c = D_RO(root)->c;
+	uint64_t a = D_RO(c)->a;
+	uint64_t b = D_RO(c)->b;
+
+	os_thread_t threads[NTHREADS];
+
+	for (int i = 0; i < NTHREADS; ++i)
+		THREAD_CREATE(&threads[i], NULL, transfer, NULL);
+
+	for (int i = 0; i < NTHREADS; ++i)
+		THREAD_JOIN(&threads[i], NULL);
+
+	UT_ASSERTne(ntransfers, 0);
+	UT_ASSERTeq(D_RO(c)->a, a + ntransfers);
+	UT_ASSERTeq(D_RO(c)->b, b - ntransfers);
+}
+
+int
+main(int argc, char *argv[])
+{
+	START(argc, argv, "obj_tx_optimistic");
+
+	if (argc < 3)
+		UT_FATAL("usage: %s <file> [c|o|r|w|a|f|d|n|m]...", argv[0]);
+
+	const char *path = argv[1];
+
+	pop = pmemobj_create(path, POBJ_LAYOUT_NAME(obj_tx_optimistic),
+		PMEMOBJ_MIN_POOL, S_IWUSR | S_IRUSR);
+	if (pop == NULL)
+		UT_FATAL("!pmemobj_create: %s", path);
+
+	root = POBJ_ROOT(pop, struct root);
+	POBJ_ZNEW(pop, &D_RW(root)->c, struct counters);
+	UT_ASSERT(!TOID_IS_NULL(D_RO(root)->c));
+
+	for (int i = 2; i < argc; ++i) {
+		switch (argv[i][0]) {
+			case 'c':
+				test_ctl();
+				break;
+			case 'o':
+				test_own();
+				break;
+			case 'r':
+				test_read_conflict();
+				break;
+			case 'w':
+				test_write_conflict();
+				break;
+			case 'a':
+				test_abort();
+				break;
+			case 'f':
+				test_free();
+				break;
+			case 'd':
+				test_disabled();
+				break;
+			case 'n':
+				test_retry();
+				break;
+			case 'm':
+				test_mt();
+				break;
+			default:
+				UT_FATAL("unknown test: %s", argv[i]);
+		}
+	}
+
+	pmemobj_close(pop);
+
+	DONE(NULL);
+}
@@ -0,0 +1,15 @@
+#!../env.py
+# SPDX-License-Identifier: BSD-3-Clause
+# Copyright 2026, Intel Corporation
+#
+
+import testframework as t
+from testframework import granularity as g
+
+
+@g.no_testdir()
+class TEST0(t.Test):
+    test_type = t.Medium
+
+    def run(self, ctx):
+        ctx.exec('obj_tx_ranges')
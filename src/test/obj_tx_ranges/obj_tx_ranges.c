@@ -0,0 +1,216 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/* Copyright 2026, Intel Corporation */
+
+/*
+ * obj_tx_ranges.c -- unit test for the index of transaction snapshots
+ */
+
+#include <errno.h>
+
+#include "unittest.h"
+#include "../libpmemobj/tx_ranges.h"
+
+#define TEST_KEYS 4096
+#define TEST_OPS 100000
+
+static int Present[TEST_KEYS];
+static uint64_t Last;
+static size_t Count;
+
+/*
+ * check_find -- compares the results of all the predicates for the given
+ *	key with the model
+ */
+static void
+check_find(struct tx_ranges *r, uint64_t key)
+{
+	struct tx_range_def *def = tx_ranges_find(r, key, TX_RANGES_EQUAL);
+	if (key < TEST_KEYS && Present[key]) {
+		UT_ASSERTne(def, NULL);
+		UT_ASSERTeq(def->offset, key);
+		UT_ASSERTeq(def->size, key + 1);
+	} else {
+		UT_ASSERTeq(def, NULL);
+	}
+
+	uint64_t le = key < TEST_KEYS ? key + 1 : TEST_KEYS;
+	while (le != 0 && !Present[le - 1])
+		le--;
+
+	def = tx_ranges_find(r, key, TX_RANGES_LESS_EQUAL);
+	if (le == 0) {
+		UT_ASSERTeq(def, NULL);
+	} else {
+		UT_ASSERTne(def, NULL);
+		UT_ASSERTeq(def->offset, le - 1);
+	}
+
+	uint64_t l = key < TEST_KEYS ? key : TEST_KEYS;
+	while (l != 0 && !Present[l - 1])
+		l--;
+
+	def = tx_ranges_find(r, key, TX_RANGES_LESS);
+	if (l == 0) {
+		UT_ASSERTeq(def, NULL);
+	} else {
+		UT_ASSERTne(def, NULL);
+		UT_ASSERTeq(def->offset, l - 1);
+	}
+}
+
+/*
+ * check_order -- verifies that the ranges are visited in ascending order
+ */
+static void
+check_order(struct tx_range_def *def, void *arg)
+{
+	UT_ASSERT(Count == 0 || def->offset > Last);
+	UT_ASSERT(Present[def->offset]);
+	Last = def->offset;
+	Count++;
+}
+
+/*
+ * check_all -- compares the whole index with the model and releases it
+ */
+static void
+check_all(struct tx_ranges *r)
+{
+	size_t n = 0;
+	for (uint64_t key = 0; key <= TEST_KEYS; ++key) {
+		check_find(r, key);
+		if (key < TEST_KEYS && Present[key])
+			n++;
+	}
+
+	Count = 0;
+	tx_ranges_fini(r, check_order, NULL);
+	UT_ASSERTeq(Count, n);
+
+	memset(Present, 0, sizeof(Present));
+}
+
+/*
+ * insert -- inserts the key to both the index and the model
+ */
+static void
+insert(struct tx_ranges *r, uint64_t key)
+{
+	struct tx_range_def def = {key, key + 1, 0};
+
+	if (Present[key]) {
+		UT_ASSERTeq(tx_ranges_insert(r, &def), -1);
+		UT_ASSERTeq(errno, EEXIST);
+	} else {
+		UT_ASSERTeq(tx_ranges_insert(r, &def), 0);
+		Present[key] = 1;
+	}
+}
+
+/*
+ * test_ascending -- inserts the keys in order, the common case
+ */
+static void
+test_ascending(void)
+{
+	struct tx_ranges r;
+	tx_ranges_init(&r);
+
+	for (uint64_t key = 0; key < TEST_KEYS; key += 2)
+		insert(&r, key);
+
+	/* full blocks are split when filling the gaps */
+	for (uint64_t key = 1; key < TEST_KEYS; key += 2)
+		insert(&r, key);
+
+	check_all(&r);
+}
+
+/*
+ * test_descending -- inserts the keys in reverse order
+ */
+static void
+test_descending(void)
+{
+	struct tx_ranges r;
+	tx_ranges_init(&r);
+
+	for (uint64_t key = TEST_KEYS; key != 0; --key)
+		insert(&r, key - 1);
+
+	check_all(&r);
+}
+
+/*
+ * test_random -- performs random inserts and removes
+ */
+static void
+test_random(void)
+{
+	struct tx_ranges r;
+	tx_ranges_init(&r);
+
+	for (int i = 0; i < TEST_OPS; ++i) {
+		uint64_t key = (uint64_t)rand() % TEST_KEYS;
+
+		if (rand() % 3 != 0) {
+			insert(&r, key);
+			continue;
+		}
+
+		struct tx_range_def *def = tx_ranges_find(&r, key,
+			TX_RANGES_LESS_EQUAL);
+		if (def == NULL)
+			continue;
+
+		Present[def->offset] = 0;
+		tx_ranges_remove(&r, def);
+
+		if (i % 1000 == 0)
+			check_find(&r, key);
+	}
+
+	check_all(&r);
+}
+
+/*
+ * test_remove_all -- empties the index and fills it again
+ */
+static void
+test_remove_all(void)
+{
+	struct tx_ranges r;
+	tx_ranges_init(&r);
+
+	for (int round = 0; round < 2; ++round) {
+		for (uint64_t key = 0; key < TEST_KEYS; ++key)
+			insert(&r, key);
+
+		struct tx_range_def *def;
+		while ((def = tx_ranges_find(&r, TEST_KEYS,
+				TX_RANGES_LESS_EQUAL)) != NULL) {
+			Present[def->offset] = 0;
+			tx_ranges_remove(&r, def);
+		}
+
+		UT_ASSERTeq(VEC_SIZE(&r.blocks), 0);
+		check_find(&r, 0);
+	}
+
+	check_all(&r);
+}
+
+int
+main(int argc, char *argv[])
+{
+	START(argc, argv, "obj_tx_ranges");
+
+	srand(0);
+
+	test_ascending();
+	test_descending();
+	test_random();
+	test_remove_all();
+
+	DONE(NULL);
+}
@@ -0,0 +1,439 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/* Copyright 2026, Intel Corporation */
+
+/*
+ * obj_tx_write.c -- unit test for pmemobj_tx_write and its variants
+ * usage:
+ * obj_tx_write <file> [w|a|o|b|u|m]...
+ *
+ * w - test for writes that are committed
+ *
+ * a - test for writes that are aborted
+ *
+ * o - test for overlapping writes and pmemobj_tx_read_direct
+ *
+ * b - test for writes that need redo log extensions
+ *
+ * u - test for writes logged in a user provided redo log buffer
+ *
+ * m - test for writes mixed with snapshots and allocations
+ *
+ * After all the tests, the pool is reopened and its contents are verified.
+ */
+
+#include "unittest.h"
+
+#define LAYOUT "obj_tx_write"
+#define OBJ_SIZE 1024
+#define BIG_OBJ_SIZE (512 << 10)
+#define NSMALL_WRITES 1000
+#define USER_BUF_SIZE (8 << 10)
+
+struct root {
+	PMEMoid obj;
+	PMEMoid big;
+	PMEMoid mixed;
+	uint64_t value;
+};
+
+static PMEMobjpool *pop;
+static struct root *rootp;
+
+/* expected contents of the objects */
+static char obj_expected[OBJ_SIZE];
+static char *big_expected;
+static uint64_t value_expected;
+
+/*
+ * fill -- fills the buffer with a pattern derived from the seed
+ */
+static void
+fill(char *buf, size_t size, unsigned seed)
+{
+	for (size_t i = 0; i < size; ++i)
+		buf[i] = (char)(seed + i * 7);
+}
+
+/*
+ * verify -- checks the contents of all the objects
+ */
+static void
+verify(void)
+{
+	UT_ASSERTeq(memcmp(pmemobj_direct(rootp->obj), obj_expected,
+		OBJ_SIZE), 0);
+	if (!OID_IS_NULL(rootp->big))
+		UT_ASSERTeq(memcmp(pmemobj_direct(rootp->big), big_expected,
+			BIG_OBJ_SIZE), 0);
+	UT_ASSERTeq(rootp->value, value_expected);
+}
+
+/*
+ * test_commit -- writes are applied when the transaction commits
+ */
+static void
+test_commit(void)
+{
+	char *obj = pmemobj_direct(rootp->obj);
+	char buf[OBJ_SIZE];
+	fill(buf, OBJ_SIZE, 1);
+
+	TX_BEGIN(pop) {
+		UT_ASSERTeq(pmemobj_tx_write(rootp->obj, 0, buf, OBJ_SIZE / 2),
+			0);
+		UT_ASSERTeq(pmemobj_tx_write_direct(obj + OBJ_SIZE / 2,
+			buf + OBJ_SIZE / 2, OBJ_SIZE / 2), 0);
+
+		/* nothing is written until the commit */
+		UT_ASSERTeq(memcmp(obj, obj_expected, OBJ_SIZE), 0);
+
+		/* an empty write is a no-op */
+		UT_ASSERTeq(pmemobj_tx_write_direct(obj, buf, 0), 0);
+	} TX_ONABORT {
+		UT_ASSERT(0);
+	} TX_END
+
+	memcpy(obj_expected, buf, OBJ_SIZE);
+	verify();
+
+	/* a nested transaction writes when the outermost one commits */
+	uint64_t value = 42;
+	TX_BEGIN(pop) {
+		TX_BEGIN(pop) {
+			UT_ASSERTeq(pmemobj_tx_write_direct(&rootp->value,
+				&value, sizeof(value)), 0);
+		} TX_END
+
+		UT_ASSERTeq(rootp->value, value_expected);
+	} TX_END
+
+	value_expected = value;
+	verify();
+
+	/* an invalid write fails without aborting, when asked to */
+	char stack_buf[8];
+	TX_BEGIN(pop) {
+		int ret = pmemobj_tx_xwrite_direct(stack_buf, buf,
+			sizeof(stack_buf), POBJ_XWRITE_NO_ABORT);
+		UT_ASSERTeq(ret, EINVAL);
+
+		ret = pmemobj_tx_xwrite(rootp->obj, 0, buf, 1,
+			POBJ_XWRITE_NO_ABORT | (1ULL << 60));
+		UT_ASSERTeq(ret, EINVAL);
+	} TX_ONABORT {
+		UT_ASSERT(0);
+	} TX_END
+}
+
+/*
+ * test_abort -- writes are discarded when the transaction aborts
+ */
+static void
+test_abort(void)
+{
+	char buf[OBJ_SIZE];
+	fill(buf, OBJ_SIZE, 2);
+
+	TX_BEGIN(pop) {
+		UT_ASSERTeq(pmemobj_tx_write(rootp->obj, 0, buf, OBJ_SIZE), 0);
+		pmemobj_tx_abort(ECANCELED);
+	} TX_ONCOMMIT {
+		UT_ASSERT(0);
+	} TX_END
+
+	verify();
+
+	/* an invalid write aborts the transaction by default */
+	char stack_buf[8];
+	TX_BEGIN(pop) {
+		UT_ASSERTeq(pmemobj_tx_write(rootp->obj, 0, buf, OBJ_SIZE), 0);
+		pmemobj_tx_write_direct(stack_buf, buf, sizeof(stack_buf));
+		UT_ASSERT(0);
+	} TX_ONCOMMIT {
+		UT_ASSERT(0);
+	} TX_END
+
+	verify();
+}
+
+/*
+ * test_overlap -- later writes take precedence over the earlier ones, also
+ *	for the reads in the transaction
+ */
+static void
+test_overlap(void)
+{
+	char *obj = pmemobj_direct(rootp->obj);
+	char a[OBJ_SIZE];
+	char b[OBJ_SIZE];
+	char c[OBJ_SIZE];
+	fill(a, OBJ_SIZE, 3);
+	fill(b, OBJ_SIZE, 4);
+	fill(c, OBJ_SIZE, 5);
+
+	char expected[OBJ_SIZE];
+	memcpy(expected, obj_expected, OBJ_SIZE);
+
+	char read[OBJ_SIZE];
+
+	TX_BEGIN(pop) {
+		pmemobj_tx_write_direct(obj + 100, a, 300);
+		memcpy(expected + 100, a, 300);
+
+		pmemobj_tx_write_direct(obj + 200, b, 400);
+		memcpy(expected + 200, b, 400);
+
+		/* the same range as the previous write */
+		pmemobj_tx_write_direct(obj + 200, c, 400);
+		memcpy(expected + 200, c, 400);
+
+		pmemobj_tx_write_direct(obj + 150, a + 500, 10);
+		memcpy(expected + 150, a + 500, 10);
+
+		pmemobj_tx_read_direct(read, obj, OBJ_SIZE);
+		UT_ASSERTeq(memcmp(read, expected, OBJ_SIZE), 0);
+
+		pmemobj_tx_read_direct(read, obj + 190, 20);
+		UT_ASSERTeq(memcmp(read, expected + 190, 20), 0);
+
+		/* reads of the unmodified parts */
+		pmemobj_tx_read_direct(read, obj, 100);
+		UT_ASSERTeq(memcmp(read, obj_expected, 100), 0);
+
+		pmemobj_tx_read_direct(read, &rootp->value, sizeof(uint64_t));
+		UT_ASSERTeq(memcmp(read, &value_expected, sizeof(uint64_t)),
+			0);
+	} TX_ONABORT {
+		UT_ASSERT(0);
+	} TX_END
+
+	memcpy(obj_expected, expected, OBJ_SIZE);
+	verify();
+}
+
+/*
+ * test_big -- large writes and many small writes need log extensions and are
+ *	split at their boundaries
+ */
+static void
+test_big(void)
+{
+	int ret = pmemobj_zalloc(pop, &rootp->big, BIG_OBJ_SIZE, 0);
+	UT_ASSERTeq(ret, 0);
+	big_expected = ZALLOC(BIG_OBJ_SIZE);
+
+	char *big = pmemobj_direct(rootp->big);
+	char *buf = MALLOC(BIG_OBJ_SIZE);
+	fill(buf, BIG_OBJ_SIZE, 6);
+
+	TX_BEGIN(pop) {
+		pmemobj_tx_write_direct(big, buf, BIG_OBJ_SIZE);
+	} TX_ONABORT {
+		UT_ASSERT(0);
+	} TX_END
+
+	memcpy(big_expected, buf, BIG_OBJ_SIZE);
+	verify();
+
+	/* writes of sizes that don't align with the log boundaries */
+	fill(buf, BIG_OBJ_SIZE, 7);
+	TX_BEGIN(pop) {
+		size_t offset = 0;
+		for (unsigned i = 0; i < NSMALL_WRITES; ++i) {
+			size_t size = 1 + (i * 13) % 300;
+			if (offset + size > BIG_OBJ_SIZE)
+				break;
+			pmemobj_tx_write_direct(big + offset, buf + offset,
+				size);
+			memcpy(big_expected + offset, buf + offset, size);
+			offset += size + i % 3;
+		}
+	} TX_ONABORT {
+		UT_ASSERT(0);
+	} TX_END
+
+	verify();
+
+	/* an aborted large write */
+	fill(buf, BIG_OBJ_SIZE, 8);
+	TX_BEGIN(pop) {
+		pmemobj_tx_write_direct(big, buf, BIG_OBJ_SIZE);
+		pmemobj_tx_abort(ECANCELED);
+	} TX_END
+
+	verify();
+
+	FREE(buf);
+}
+
+/*
+ * test_user_buffer -- writes logged in a user provided redo log buffer
+ */
+static void
+test_user_buffer(void)
+{
+	PMEMoid buf_oid;
+	int ret = pmemobj_alloc(pop, &buf_oid, USER_BUF_SIZE + CACHELINE_SIZE,
+		0, NULL, NULL);
+	UT_ASSERTeq(ret, 0);
+	void *user_buf = (void *)ALIGN_UP(
+		(uintptr_t)pmemobj_direct(buf_oid), CACHELINE_SIZE);
+
+	char *obj = pmemobj_direct(rootp->obj);
+	char *big = pmemobj_direct(rootp->big);
+	char *buf = MALLOC(BIG_OBJ_SIZE);
+	fill(buf, BIG_OBJ_SIZE, 9);
+
+	/* the buffer appended before the writes */
+	TX_BEGIN(pop) {
+		pmemobj_tx_log_append_buffer(TX_LOG_TYPE_INTENT, user_buf,
+			USER_BUF_SIZE);
+		pmemobj_tx_write_direct(obj, buf, OBJ_SIZE);
+		pmemobj_tx_write_direct(big, buf, 3 * USER_BUF_SIZE);
+	} TX_ONABORT {
+		UT_ASSERT(0);
+	} TX_END
+
+	memcpy(obj_expected, buf, OBJ_SIZE);
+	memcpy(big_expected, buf, 3 * USER_BUF_SIZE);
+	verify();
+
+	/* the buffer appended after the writes */
+	fill(buf, BIG_OBJ_SIZE, 10);
+	TX_BEGIN(pop) {
+		pmemobj_tx_write_direct(big, buf, 5 * USER_BUF_SIZE);
+		pmemobj_tx_log_append_buffer(TX_LOG_TYPE_INTENT, user_buf,
+			USER_BUF_SIZE);
+		pmemobj_tx_write_direct(obj, buf, OBJ_SIZE);
+	} TX_ONABORT {
+		UT_ASSERT(0);
+	} TX_END
+
+	memcpy(obj_expected, buf, OBJ_SIZE);
+	memcpy(big_expected, buf, 5 * USER_BUF_SIZE);
+	verify();
+
+	pmemobj_free(&buf_oid);
+	FREE(buf);
+}
+
+/*
+ * test_mixed -- writes mixed with snapshots, allocations and atomic
+ *	operations in the same transaction
+ */
+static void
+test_mixed(void)
+{
+	char *obj = pmemobj_direct(rootp->obj);
+	char buf[OBJ_SIZE];
+	fill(buf, OBJ_SIZE, 11);
+
+	char expected[OBJ_SIZE];
+	memcpy(expected, obj_expected, OBJ_SIZE);
+
+	uint64_t value = 1234;
+
+	TX_BEGIN(pop) {
+		/* the snapshotted part is modified in place */
+		pmemobj_tx_add_range_direct(obj, 64);
+		memset(obj, 0xab, 64);
+		memset(expected, 0xab, 64);
+
+		pmemobj_tx_write_direct(obj + 64, buf, 128);
+		memcpy(expected + 64, buf, 128);
+
+		/* a write into an object allocated in the transaction */
+		PMEMoid mixed = pmemobj_tx_alloc(OBJ_SIZE, 0);
+		pmemobj_tx_write(mixed, 0, buf, OBJ_SIZE);
+		pmemobj_tx_write_direct(&rootp->mixed, &mixed, sizeof(mixed));
+
+		/* an atomic allocation in the same lane */
+		PMEMoid tmp;
+		UT_ASSERTeq(pmemobj_alloc(pop, &tmp, 128, 0, NULL, NULL), 0);
+		pmemobj_free(&tmp);
+
+		pmemobj_tx_write_direct(&rootp->value, &value, sizeof(value));
+	} TX_ONABORT {
+		UT_ASSERT(0);
+	} TX_END
+
+	memcpy(obj_expected, expected, OBJ_SIZE);
+	value_expected = value;
+	verify();
+
+	UT_ASSERTeq(memcmp(pmemobj_direct(rootp->mixed), buf, OBJ_SIZE), 0);
+
+	/* the writes are discarded along with the snapshots on abort */
+	TX_BEGIN(pop) {
+		pmemobj_tx_add_range_direct(obj, 64);
+		memset(obj, 0xcd, 64);
+		pmemobj_tx_write_direct(obj + 64, buf + 1, 128);
+		pmemobj_tx_free(rootp->mixed);
+		pmemobj_tx_abort(ECANCELED);
+	} TX_END
+
+	verify();
+	UT_ASSERTeq(memcmp(pmemobj_direct(rootp->mixed), buf, OBJ_SIZE), 0);
+}
+
+int
+main(int argc, char *argv[])
+{
+	START(argc, argv, "obj_tx_write");
+
+	if (argc < 2)
+		UT_FATAL("usage: %s <file> [w|a|o|b|u|m]...", argv[0]);
+
+	const char *path = argv[1];
+
+	pop = pmemobj_create(path, LAYOUT, PMEMOBJ_MIN_POOL * 4,
+		S_IWUSR | S_IRUSR);
+	if (pop == NULL)
+		UT_FATAL("!pmemobj_create: %s", path);
+
+	rootp = pmemobj_direct(pmemobj_root(pop, sizeof(struct root)));
+
+	int ret = pmemobj_zalloc(pop, &rootp->obj, OBJ_SIZE, 0);
+	UT_ASSERTeq(ret, 0);
+
+	for (int i = 2; i < argc; ++i) {
+		switch (argv[i][0]) {
+			case 'w':
+				test_commit();
+				break;
+			case 'a':
+				test_abort();
+				break;
+			case 'o':
+				test_overlap();
+				break;
+			case 'b':
+				test_big();
+				break;
+			case 'u':
+				test_user_buffer();
+				break;
+			case 'm':
+				test_mixed();
+				break;
+			default:
+				UT_FATAL("invalid mode %s", argv[i]);
+		}
+	}
+
+	pmemobj_close(pop);
+
+	pop = pmemobj_open(path, LAYOUT);
+	if (pop == NULL)
+		UT_FATAL("!pmemobj_open: %s", path);
+
+	rootp = pmemobj_direct(pmemobj_root(pop, sizeof(struct root)));
+	verify();
+
+	pmemobj_close(pop);
+
+	if (big_expected != NULL)
+		FREE(big_expected);
+
+	DONE(NULL);
+}
@@ -954,6 +954,174 @@ do_ctl_snapshots_cache_size(PMEMobjpool *pop)
 	UT_ASSERTeq(cache_size, (ssize_t)PMEMOBJ_MAX_ALLOC_SIZE);
 }
 
+/*
+ * heap_allocated -- returns the number of bytes allocated in the heap
+ */
+static size_t
+heap_allocated(PMEMobjpool *pop)
+{
+	size_t allocated;
+	int ret = pmemobj_ctl_get(pop, "stats.heap.curr_allocated",
+					&allocated);
+	UT_ASSERTeq(ret, 0);
+
+	return allocated;
+}
+
+/*
+ * snapshot_tx -- snapshots the given number of bytes of the object in
+ * separate, not adjacent, ranges
+ */
+static void
+snapshot_tx(PMEMobjpool *pop, PMEMoid oid, size_t size)
+{
+	TX_BEGIN(pop) {
+		for (size_t off = 0; off < size; off += 2 * MIN_ALLOC)
+			pmemobj_tx_add_range(oid, off, MIN_ALLOC);
+	} TX_ONABORT {
+		UT_ASSERT(0);
+	} TX_END
+}
+
+/*
+ * do_ctl_snapshots_cache_retain -- test the undo log space retained by
+ * lanes between transactions
+ */
+static void
+do_ctl_snapshots_cache_retain(PMEMobjpool *pop)
+{
+	UT_OUT("do_ctl_snapshots_cache_retain");
+
+	long long retain = 0;
+	int ret = pmemobj_ctl_get(pop, "tx.cache.retain", &retain);
+	UT_ASSERTeq(ret, 0);
+	UT_ASSERTeq(retain, TX_DEFAULT_RANGE_CACHE_RETAIN);
+
+	retain = -1;
+	ret = pmemobj_ctl_set(pop, "tx.cache.retain", &retain);
+	UT_ASSERTeq(ret, -1);
+
+	retain = (ssize_t)PMEMOBJ_MAX_ALLOC_SIZE + 1;
+	ret = pmemobj_ctl_set(pop, "tx.cache.retain", &retain);
+	UT_ASSERTeq(ret, -1);
+
+	long long cache_size = TX_DEFAULT_RANGE_CACHE_SIZE;
+	ret = pmemobj_ctl_set(pop, "tx.cache.size", &cache_size);
+	UT_ASSERTeq(ret, 0);
+
+	int enabled = 1;
+	ret = pmemobj_ctl_set(pop, "stats.enabled", &enabled);
+	UT_ASSERTeq(ret, 0);
+
+	size_t snapshot_size = 4 * TX_DEFAULT_RANGE_CACHE_SIZE;
+
+	PMEMoid oid;
+	ret = pmemobj_zalloc(pop, &oid, 2 * snapshot_size, 0);
+	UT_ASSERTeq(ret, 0);
+
+	/* without retaining, only the second log is kept */
+	retain = 0;
+	ret = pmemobj_ctl_set(pop, "tx.cache.retain", &retain);
+	UT_ASSERTeq(ret, 0);
+
+	snapshot_tx(pop, oid, snapshot_size);
+	size_t allocated_min = heap_allocated(pop);
+
+	retain = (long long)snapshot_size;
+	ret = pmemobj_ctl_set(pop, "tx.cache.retain", &retain);
+	UT_ASSERTeq(ret, 0);
+
+	snapshot_tx(pop, oid, snapshot_size);
+	size_t allocated_max = heap_allocated(pop);
+	UT_ASSERT(allocated_max > allocated_min);
+
+	/* the retained logs are reused by the next transactions */
+	for (int i = 0; i < 10; ++i) {
+		snapshot_tx(pop, oid, snapshot_size);
+		UT_ASSERTeq(heap_allocated(pop), allocated_max);
+	}
+
+	/* and released after a long enough series of small ones */
+	for (int i = 0; i < 1000; ++i)
+		snapshot_tx(pop, oid, MIN_ALLOC);
+	UT_ASSERTeq(heap_allocated(pop), allocated_min);
+
+	UT_OUT("Undo logs are retained between transactions");
+
+	pmemobj_free(&oid);
+
+	enabled = 0;
+	ret = pmemobj_ctl_set(pop, "stats.enabled", &enabled);
+	UT_ASSERTeq(ret, 0);
+}
+
+/*
+ * snapshot_abort_tx -- snapshots and modifies the given range of the object,
+ * and checks that the abort restores it
+ */
+static void
+snapshot_abort_tx(PMEMobjpool *pop, PMEMoid oid, size_t off, size_t size)
+{
+	unsigned char *data = (unsigned char *)pmemobj_direct(oid) + off;
+	for (size_t i = 0; i < size; ++i)
+		data[i] = (unsigned char)(i * 31 + 7);
+
+	pmemobj_persist(pop, data, size);
+
+	TX_BEGIN(pop) {
+		pmemobj_tx_add_range(oid, off, size);
+		memset(data, 0xff, size);
+		pmemobj_tx_abort(ECANCELED);
+	} TX_END
+
+	for (size_t i = 0; i < size; ++i)
+		UT_ASSERTeq(data[i], (unsigned char)(i * 31 + 7));
+}
+
+/*
+ * do_ctl_snapshot_nt_threshold -- test the minimum size of snapshots copied
+ * to the undo log with non-temporal stores
+ */
+static void
+do_ctl_snapshot_nt_threshold(PMEMobjpool *pop)
+{
+	UT_OUT("do_ctl_snapshot_nt_threshold");
+
+	long long threshold = 0;
+	int ret = pmemobj_ctl_get(pop, "tx.snapshot.nt_threshold", &threshold);
+	UT_ASSERTeq(ret, 0);
+	UT_ASSERTeq(threshold, TX_DEFAULT_SNAPSHOT_NT_THRESHOLD);
+
+	threshold = -1;
+	ret = pmemobj_ctl_set(pop, "tx.snapshot.nt_threshold", &threshold);
+	UT_ASSERTeq(ret, -1);
+
+	threshold = (ssize_t)PMEMOBJ_MAX_ALLOC_SIZE + 1;
+	ret = pmemobj_ctl_set(pop, "tx.snapshot.nt_threshold", &threshold);
+	UT_ASSERTeq(ret, -1);
+
+	PMEMoid oid;
+	ret = pmemobj_zalloc(pop, &oid, MAX_ALLOC, 0);
+	UT_ASSERTeq(ret, 0);
+
+	/* the sizes of the snapshots on both sides of the threshold */
+	long long thresholds[] = {0, MAX_ALLOC, 64 << 10};
+	for (size_t i = 0; i < ARRAY_SIZE(thresholds); ++i) {
+		ret = pmemobj_ctl_set(pop, "tx.snapshot.nt_threshold",
+			&thresholds[i]);
+		UT_ASSERTeq(ret, 0);
+
+		snapshot_abort_tx(pop, oid, 0, MIN_ALLOC);
+		snapshot_abort_tx(pop, oid, 8, (64 << 10) + 13);
+		snapshot_abort_tx(pop, oid, 24, (200 << 10) + 40);
+		snapshot_abort_tx(pop, oid, 0, MAX_ALLOC);
+	}
+
+	UT_OUT("Snapshots are restored regardless of the threshold");
+
+	pmemobj_free(&oid);
+}
+
 int
 main(int argc, char *argv[])
 {
@@ -992,6 +1160,8 @@ main(int argc, char *argv[])
 	do_log_snapshots_max_size(pop);
 
 	do_ctl_snapshots_cache_size(pop);
+	do_ctl_snapshots_cache_retain(pop);
+	do_ctl_snapshot_nt_threshold(pop);
 
 	pmemobj_close(pop);
 	pmemobj_close(pop2);
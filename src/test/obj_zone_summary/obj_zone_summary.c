@@ -0,0 +1,96 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/* Copyright 2026, Intel Corporation */
+
+/*
+ * obj_zone_summary.c -- test for reopening a heap whose zones were full when
+ * last reclaimed, the zone summaries must not prevent the reuse of memory
+ * freed afterwards
+ */
+
+#include "unittest.h"
+
+#define LAYOUT "obj_zone_summary"
+#define MAX_OBJ_SIZE (1 << 20)
+
+/*
+ * fill_pool -- allocates objects of decreasing sizes until the pool is full
+ */
+static void
+fill_pool(PMEMobjpool *pop)
+{
+	for (size_t size = MAX_OBJ_SIZE; size > 0; size /= 2) {
+		PMEMoid oid;
+		while (pmemobj_alloc(pop, &oid, size, 0, NULL, NULL) == 0)
+			;
+		UT_ASSERTeq(errno, ENOMEM);
+	}
+}
+
+/*
+ * reopen -- closes and opens the pool again
+ */
+static PMEMobjpool *
+reopen(PMEMobjpool *pop, const char *path)
+{
+	pmemobj_close(pop);
+
+	UT_ASSERTeq(pmemobj_check(path, LAYOUT), 1);
+
+	pop = pmemobj_open(path, LAYOUT);
+	UT_ASSERTne(pop, NULL);
+
+	return pop;
+}
+
+int
+main(int argc, char *argv[])
+{
+	START(argc, argv, "obj_zone_summary");
+
+	if (argc != 2)
+		UT_FATAL("usage: %s file-name", argv[0]);
+
+	const char *path = argv[1];
+
+	PMEMobjpool *pop = pmemobj_create(path, LAYOUT, PMEMOBJ_MIN_POOL,
+		S_IWUSR | S_IRUSR);
+	if (pop == NULL)
+		UT_FATAL("!pmemobj_create: %s", path);
+
+	fill_pool(pop);
+
+	/* the zone is full when it's reclaimed again */
+	pop = reopen(pop, path);
+
+	PMEMoid oid;
+	UT_ASSERTne(pmemobj_alloc(pop, &oid, 1, 0, NULL, NULL), 0);
+
+	/* the zone is now summarized as full, it's still reclaimed on demand */
+	pop = reopen(pop, path);
+
+	UT_ASSERTne(pmemobj_alloc(pop, &oid, 1, 0, NULL, NULL), 0);
+
+	oid = pmemobj_first(pop);
+	UT_ASSERT(!OID_IS_NULL(oid));
+	size_t size = pmemobj_alloc_usable_size(oid);
+	pmemobj_free(&oid);
+
+	/* the freed object is reusable in the same session... */
+	UT_ASSERTeq(pmemobj_alloc(pop, &oid, size, 0, NULL, NULL), 0);
+	pmemobj_free(&oid);
+
+	/* ...and after reopening the pool */
+	pop = reopen(pop, path);
+
+	UT_ASSERTeq(pmemobj_alloc(pop, &oid, size, 0, NULL, NULL), 0);
+
+	/* freeing without allocating first must not lose the space either */
+	pmemobj_free(&oid);
+	pop = reopen(pop, path);
+
+	UT_ASSERTeq(pmemobj_alloc(pop, &oid, size, 0, NULL, NULL), 0);
+
+	pmemobj_close(pop);
+
+	DONE(NULL);
+}
@@ -0,0 +1,42 @@
+#!../env.py
+# SPDX-License-Identifier: BSD-3-Clause
+# Copyright 2026, Intel Corporation
+#
+
+import testframework as t
+from testframework import granularity as g
+
+
+@g.require_granularity(g.ANY)
+class Pmem2Async(t.Test):
+    test_type = t.Short
+    args = ()
+
+    def run(self, ctx):
+        filepath = ctx.create_holey_file(2 * t.MiB, 'testfile')
+        ctx.exec('pmem2_async', self.test_case, filepath, *self.args)
+
+
+class TEST0(Pmem2Async):
+    test_case = 'test_no_mover'
+
+
+class TEST1(Pmem2Async):
+    test_case = 'test_default_mover'
+    args = (1,)
+
+
+class TEST2(Pmem2Async):
+    test_case = 'test_default_mover'
+    args = (4,)
+
+
+class TEST3(t.Test):
+    test_type = t.Short
+
+    def run(self, ctx):
+        ctx.exec('pmem2_async', 'test_mover_no_threads')
+
+
+class TEST4(Pmem2Async):
+    test_case = 'test_custom_mover'
@@ -0,0 +1,392 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/* Copyright 2026, Intel Corporation */
+
+/*
+ * pmem2_async.c -- tests for the asynchronous operations of libpmem2
+ */
+
+#include "unittest.h"
+#include "ut_pmem2.h"
+#include "util.h"
+
+#define CHUNK_SIZE (16 * 1024)
+#define NFUTURES 32
+
+/*
+ * map_file -- maps the file with the given mover
+ */
+static struct pmem2_map *
+map_file(const char *file, int *fd, struct pmem2_mover *mover)
+{
+	struct pmem2_config *cfg;
+	struct pmem2_source *src;
+	struct pmem2_map *map;
+
+	*fd = OPEN(file, O_RDWR);
+
+	PMEM2_CONFIG_NEW(&cfg);
+	PMEM2_SOURCE_FROM_FD(&src, *fd);
+	PMEM2_CONFIG_SET_GRANULARITY(cfg, PMEM2_GRANULARITY_PAGE);
+
+	int ret = pmem2_config_set_mover(cfg, mover);
+	UT_PMEM2_EXPECT_RETURN(ret, 0);
+
+	ret = pmem2_map_new(&map, cfg, src);
+	UT_PMEM2_EXPECT_RETURN(ret, 0);
+
+	PMEM2_CONFIG_DELETE(&cfg);
+	PMEM2_SOURCE_DELETE(&src);
+
+	UT_ASSERT(pmem2_map_get_size(map) >= 2 * NFUTURES * CHUNK_SIZE);
+
+	return map;
+}
+
+/*
+ * unmap_file -- unmaps the file and closes it
+ */
+static void
+unmap_file(struct pmem2_map **map, int fd)
+{
+	int ret = pmem2_map_delete(map);
+	UT_ASSERTeq(ret, 0);
+	CLOSE(fd);
+}
+
+/*
+ * count_cb -- counts the completed operations
+ */
+static void
+count_cb(struct pmem2_future *fut, void *arg)
+{
+	UT_ASSERTeq(pmem2_future_poll(fut), PMEM2_FUTURE_STATE_RUNNING);
+
+	unsigned *count = arg;
+	util_fetch_and_add32(count, 1);
+}
+
+/*
+ * check_chunks -- submits a copy, a move and a set of every chunk, and
+ *	checks the data once they complete
+ */
+static void
+check_chunks(struct pmem2_map *map)
+{
+	char *addr = pmem2_map_get_address(map);
+	char *src = addr + NFUTURES * CHUNK_SIZE;
+	static char dram[NFUTURES * CHUNK_SIZE];
+	struct pmem2_future *futs[NFUTURES];
+	unsigned count = 0;
+	int ret;
+
+	for (size_t i = 0; i < NFUTURES * CHUNK_SIZE; ++i) {
+		dram[i] = (char)rand();
+		src[i] = (char)rand();
+	}
+
+	for (unsigned i = 0; i < NFUTURES; ++i) {
+		ret = pmem2_future_new(&futs[i]);
+		UT_PMEM2_EXPECT_RETURN(ret, 0);
+		UT_ASSERTeq(pmem2_future_poll(futs[i]),
+			PMEM2_FUTURE_STATE_IDLE);
+
+		ret = pmem2_future_set_callback(futs[i], count_cb, &count);
+		UT_PMEM2_EXPECT_RETURN(ret, 0);
+	}
+
+	/* copies from DRAM, the ones without drain are drained anyway */
+	for (unsigned i = 0; i < NFUTURES; ++i) {
+		ret = pmem2_memcpy_async(map, futs[i], addr + i * CHUNK_SIZE,
+			dram + i * CHUNK_SIZE, CHUNK_SIZE,
+			i % 2 ? PMEM2_F_MEM_NODRAIN : 0);
+		UT_PMEM2_EXPECT_RETURN(ret, 0);
+	}
+
+	for (unsigned i = 0; i < NFUTURES; ++i) {
+		pmem2_future_wait(futs[i]);
+		UT_ASSERTeq(pmem2_future_poll(futs[i]),
+			PMEM2_FUTURE_STATE_COMPLETE);
+	}
+	UT_ASSERTeq(count, NFUTURES);
+	UT_ASSERTeq(memcmp(addr, dram, NFUTURES * CHUNK_SIZE), 0);
+
+	/* moves within the mapping, with the futures reused */
+	for (unsigned i = 0; i < NFUTURES; ++i) {
+		ret = pmem2_memmove_async(map, futs[i], addr + i * CHUNK_SIZE,
+			src + i * CHUNK_SIZE, CHUNK_SIZE, 0);
+		UT_PMEM2_EXPECT_RETURN(ret, 0);
+	}
+
+	/* polling instead of waiting */
+	for (unsigned i = 0; i < NFUTURES; ++i) {
+		while (pmem2_future_poll(futs[i]) !=
+				PMEM2_FUTURE_STATE_COMPLETE)
+			;
+	}
+	UT_ASSERTeq(count, 2 * NFUTURES);
+	UT_ASSERTeq(memcmp(addr, src, NFUTURES * CHUNK_SIZE), 0);
+
+	/* sets, followed by persists of the same chunks */
+	for (unsigned i = 0; i < NFUTURES; ++i) {
+		ret = pmem2_memset_async(map, futs[i], addr + i * CHUNK_SIZE,
+			(int)i, CHUNK_SIZE, PMEM2_F_MEM_NONTEMPORAL);
+		UT_PMEM2_EXPECT_RETURN(ret, 0);
+	}
+
+	for (unsigned i = 0; i < NFUTURES; ++i) {
+		pmem2_future_wait(futs[i]);
+
+		ret = pmem2_persist_async(map, futs[i], addr + i * CHUNK_SIZE,
+			CHUNK_SIZE);
+		UT_PMEM2_EXPECT_RETURN(ret, 0);
+	}
+
+	for (unsigned i = 0; i < NFUTURES; ++i) {
+		pmem2_future_wait(futs[i]);
+
+		for (size_t j = 0; j < CHUNK_SIZE; ++j)
+			UT_ASSERTeq(addr[i * CHUNK_SIZE + j], (char)i);
+
+		ret = pmem2_future_delete(&futs[i]);
+		UT_PMEM2_EXPECT_RETURN(ret, 0);
+		UT_ASSERTeq(futs[i], NULL);
+	}
+	UT_ASSERTeq(count, 4 * NFUTURES);
+}
+
+/*
+ * test_no_mover -- performs the operations on a mapping without a mover,
+ *	they complete before they are submitted
+ */
+static int
+test_no_mover(const struct test_case *tc, int argc, char *argv[])
+{
+	if (argc < 1)
+		UT_FATAL("usage: test_no_mover <file>");
+
+	int fd;
+	struct pmem2_map *map = map_file(argv[0], &fd, NULL);
+
+	char *addr = pmem2_map_get_address(map);
+	struct pmem2_future *fut;
+	unsigned count = 0;
+
+	int ret = pmem2_future_new(&fut);
+	UT_PMEM2_EXPECT_RETURN(ret, 0);
+	ret = pmem2_future_set_callback(fut, count_cb, &count);
+	UT_PMEM2_EXPECT_RETURN(ret, 0);
+
+	ret = pmem2_memset_async(map, fut, addr, 0x11, CHUNK_SIZE, 0);
+	UT_PMEM2_EXPECT_RETURN(ret, 0);
+	UT_ASSERTeq(pmem2_future_poll(fut), PMEM2_FUTURE_STATE_COMPLETE);
+	UT_ASSERTeq(count, 1);
+	UT_ASSERTeq(addr[CHUNK_SIZE - 1], 0x11);
+
+	ret = pmem2_future_delete(&fut);
+	UT_PMEM2_EXPECT_RETURN(ret, 0);
+
+	check_chunks(map);
+
+	unmap_file(&map, fd);
+
+	return 1;
+}
+
+/*
+ * test_default_mover -- performs the operations with the default mover
+ */
+static int
+test_default_mover(const struct test_case *tc, int argc, char *argv[])
+{
+	if (argc < 2)
+		UT_FATAL("usage: test_default_mover <file> <nthreads>");
+
+	unsigned nthreads = ATOU(argv[1]);
+	struct pmem2_mover *mover;
+
+	int ret = pmem2_mover_new(&mover, nthreads);
+	UT_PMEM2_EXPECT_RETURN(ret, 0);
+
+	int fd;
+	struct pmem2_map *map = map_file(argv[0], &fd, mover);
+
+	check_chunks(map);
+
+	unmap_file(&map, fd);
+
+	/* the operations which are still queued are completed at delete */
+	map = map_file(argv[0], &fd, mover);
+	char *addr = pmem2_map_get_address(map);
+	struct pmem2_future *futs[NFUTURES];
+
+	for (unsigned i = 0; i < NFUTURES; ++i) {
+		ret = pmem2_future_new(&futs[i]);
+		UT_PMEM2_EXPECT_RETURN(ret, 0);
+
+		ret = pmem2_memset_async(map, futs[i], addr + i * CHUNK_SIZE,
+			0x22, CHUNK_SIZE, 0);
+		UT_PMEM2_EXPECT_RETURN(ret, 0);
+	}
+
+	ret = pmem2_mover_delete(&mover);
+	UT_PMEM2_EXPECT_RETURN(ret, 0);
+	UT_ASSERTeq(mover, NULL);
+
+	for (unsigned i = 0; i < NFUTURES; ++i) {
+		UT_ASSERTeq(pmem2_future_poll(futs[i]),
+			PMEM2_FUTURE_STATE_COMPLETE);
+		UT_ASSERTeq(addr[i * CHUNK_SIZE], 0x22);
+
+		ret = pmem2_future_delete(&futs[i]);
+		UT_PMEM2_EXPECT_RETURN(ret, 0);
+	}
+
+	unmap_file(&map, fd);
+
+	return 2;
+}
+
+/*
+ * test_mover_no_threads -- creates the default mover without threads
+ */
+static int
+test_mover_no_threads(const struct test_case *tc, int argc, char *argv[])
+{
+	struct pmem2_mover *mover = (struct pmem2_mover *)0x1;
+
+	int ret = pmem2_mover_new(&mover, 0);
+	UT_PMEM2_EXPECT_RETURN(ret, PMEM2_E_INVALID_MOVER);
+	UT_ASSERTeq(mover, NULL);
+
+	ret = pmem2_mover_from_fn(&mover, NULL, NULL);
+	UT_PMEM2_EXPECT_RETURN(ret, PMEM2_E_INVALID_MOVER);
+	UT_ASSERTeq(mover, NULL);
+
+	return 0;
+}
+
+/* the operations handed over to the custom mover */
+struct custom_queue {
+	struct pmem2_future *futs[2 * NFUTURES];
+	unsigned n;
+	int fail;
+};
+
+/*
+ * custom_submit -- the submit function of the custom mover, it only
+ *	remembers the futures
+ */
+static int
+custom_submit(struct pmem2_future *fut, void *arg)
+{
+	struct custom_queue *q = arg;
+
+	if (q->fail)
+		return PMEM2_E_NOSUPP;
+
+	UT_ASSERT(q->n < ARRAY_SIZE(q->futs));
+	q->futs[q->n++] = fut;
+
+	return 0;
+}
+
+/*
+ * custom_worker -- performs the operations remembered by the custom mover
+ */
+static void *
+custom_worker(void *arg)
+{
+	struct custom_queue *q = arg;
+
+	for (unsigned i = 0; i < q->n; ++i)
+		pmem2_future_execute(q->futs[i]);
+
+	return NULL;
+}
+
+/*
+ * test_custom_mover -- performs the operations with a mover which hands
+ *	them over to a thread of the application
+ */
+static int
+test_custom_mover(const struct test_case *tc, int argc, char *argv[])
+{
+	if (argc < 1)
+		UT_FATAL("usage: test_custom_mover <file>");
+
+	struct custom_queue q;
+	memset(&q, 0, sizeof(q));
+
+	struct pmem2_mover *mover;
+	int ret = pmem2_mover_from_fn(&mover, custom_submit, &q);
+	UT_PMEM2_EXPECT_RETURN(ret, 0);
+
+	int fd;
+	struct pmem2_map *map = map_file(argv[0], &fd, mover);
+	char *addr = pmem2_map_get_address(map);
+
+	struct pmem2_future *fut;
+	ret = pmem2_future_new(&fut);
+	UT_PMEM2_EXPECT_RETURN(ret, 0);
+
+	/* the mover cannot take the operation */
+	q.fail = 1;
+	ret = pmem2_memset_async(map, fut, addr, 0x33, CHUNK_SIZE, 0);
+	UT_PMEM2_EXPECT_RETURN(ret, PMEM2_E_NOSUPP);
+	UT_ASSERTeq(pmem2_future_poll(fut), PMEM2_FUTURE_STATE_IDLE);
+	q.fail = 0;
+
+	ret = pmem2_memset_async(map, fut, addr, 0x33, CHUNK_SIZE, 0);
+	UT_PMEM2_EXPECT_RETURN(ret, 0);
+	UT_ASSERTeq(pmem2_future_poll(fut), PMEM2_FUTURE_STATE_RUNNING);
+
+	/* the future cannot be reused nor deleted until it completes */
+	ret = pmem2_memset_async(map, fut, addr, 0x44, CHUNK_SIZE, 0);
+	UT_PMEM2_EXPECT_RETURN(ret, PMEM2_E_FUTURE_RUNNING);
+	ret = pmem2_future_set_callback(fut, NULL, NULL);
+	UT_PMEM2_EXPECT_RETURN(ret, PMEM2_E_FUTURE_RUNNING);
+	ret = pmem2_future_delete(&fut);
+	UT_PMEM2_EXPECT_RETURN(ret, PMEM2_E_FUTURE_RUNNING);
+	UT_ASSERTne(fut, NULL);
+
+	os_thread_t thread;
+	THREAD_CREATE(&thread, NULL, custom_worker, &q);
+
+	pmem2_future_wait(fut);
+	for (size_t i = 0; i < CHUNK_SIZE; ++i)
+		UT_ASSERTeq(addr[i], 0x33);
+
+	THREAD_JOIN(&thread, NULL);
+
+	ret = pmem2_future_delete(&fut);
+	UT_PMEM2_EXPECT_RETURN(ret, 0);
+
+	unmap_file(&map, fd);
+
+	ret = pmem2_mover_delete(&mover);
+	UT_PMEM2_EXPECT_RETURN(ret, 0);
+
+	return 1;
+}
+
+/*
+ * test_cases -- available test cases
+ */
+static struct test_case test_cases[] = {
+	TEST_CASE(test_no_mover),
+	TEST_CASE(test_default_mover),
+	TEST_CASE(test_mover_no_threads),
+	TEST_CASE(test_custom_mover),
+};
+
+#define NTESTS (sizeof(test_cases) / sizeof(test_cases[0]))
+
+int
+main(int argc, char *argv[])
+{
+	START(argc, argv, "pmem2_async");
+
+	TEST_CASE_PROCESS(argc, argv, test_cases, NTESTS);
+
+	DONE(NULL);
+}
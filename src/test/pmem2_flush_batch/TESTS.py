@@ -0,0 +1,43 @@
+#!../env.py
+# SPDX-License-Identifier: BSD-3-Clause
+# Copyright 2026, Intel Corporation
+#
+
+import testframework as t
+from testframework import granularity as g
+
+
+@g.no_testdir()
+class PMEM2_FLUSH_BATCH(t.Test):
+    test_type = t.Short
+    args = ()
+
+    def run(self, ctx):
+        ctx.exec('pmem2_flush_batch', self.test_case, *self.args)
+
+
+class TEST0(PMEM2_FLUSH_BATCH):
+    """adjacent ranges added in order"""
+    test_case = "test_in_order"
+
+
+class TEST1(PMEM2_FLUSH_BATCH):
+    """overlapping ranges added in random order, cache line granularity"""
+    test_case = "test_random"
+    args = ('c', 10000)
+
+
+class TEST2(PMEM2_FLUSH_BATCH):
+    """overlapping ranges added in random order, page granularity"""
+    test_case = "test_random"
+    args = ('p', 10000)
+
+
+class TEST3(PMEM2_FLUSH_BATCH):
+    """more disjoint ranges than the batch holds"""
+    test_case = "test_sparse"
+
+
+class TEST4(PMEM2_FLUSH_BATCH):
+    """byte granularity"""
+    test_case = "test_byte"
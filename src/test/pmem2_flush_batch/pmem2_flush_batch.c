@@ -0,0 +1,284 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/* Copyright 2026, Intel Corporation */
+
+/*
+ * pmem2_flush_batch.c -- pmem2_flush_batch unittests
+ */
+
+#include "map.h"
+#include "unittest.h"
+
+#define REGION_SIZE (256 * 1024)
+#define MAX_UNITS (REGION_SIZE / 64)
+
+static char *Region;
+static size_t Unit;
+
+/* how many times each unit of the region was flushed */
+static unsigned Flushed[MAX_UNITS];
+static uintptr_t Last_flushed;
+static int N_flushes;
+static int N_drains;
+
+/*
+ * mock_flush -- counts the flushes of each unit of the region, and checks
+ *	that the ranges are flushed in ascending order
+ */
+static void
+mock_flush(const void *addr, size_t len)
+{
+	uintptr_t start = (uintptr_t)addr;
+
+	UT_ASSERTeq(start % Unit, 0);
+	UT_ASSERTeq(len % Unit, 0);
+	UT_ASSERT(start >= (uintptr_t)Region);
+	UT_ASSERT(start + len <= (uintptr_t)Region + REGION_SIZE);
+	UT_ASSERT(start >= Last_flushed);
+
+	for (size_t off = 0; off < len; off += Unit)
+		Flushed[(start - (uintptr_t)Region + off) / Unit]++;
+
+	Last_flushed = start + len;
+	N_flushes++;
+}
+
+/*
+ * mock_drain -- counts the drains
+ */
+static void
+mock_drain(void)
+{
+	N_drains++;
+
+	/* the ranges flushed after the drain may start anywhere */
+	Last_flushed = 0;
+}
+
+/*
+ * prepare_map -- fills pmem2_map in minimal scope
+ */
+static void
+prepare_map(struct pmem2_map *map, enum pmem2_granularity g)
+{
+	map->effective_granularity = g;
+	map->flush_fn = mock_flush;
+	map->drain_fn = mock_drain;
+
+	Unit = g == PMEM2_GRANULARITY_PAGE ? Pagesize : 64;
+	UT_ASSERT(REGION_SIZE / Unit <= MAX_UNITS);
+	UT_ASSERTeq(REGION_SIZE % Unit, 0);
+
+	Region = MEMALIGN(Pagesize, REGION_SIZE);
+	memset(Flushed, 0, sizeof(Flushed));
+	Last_flushed = 0;
+	N_flushes = 0;
+	N_drains = 0;
+}
+
+/*
+ * check_flushed -- checks that every unit touched by the ranges added
+ *	to the batch was flushed exactly once
+ */
+static void
+check_flushed(const unsigned *expected)
+{
+	for (size_t i = 0; i < REGION_SIZE / Unit; ++i) {
+		if (Flushed[i] != (expected[i] ? 1U : 0U))
+			UT_FATAL("unit %zu flushed %u times, expected %u",
+				i, Flushed[i], expected[i] ? 1U : 0U);
+	}
+
+	memset(Flushed, 0, sizeof(Flushed));
+}
+
+/*
+ * batch_add -- adds the range to the batch and marks its units as expected
+ *	to be flushed
+ */
+static void
+batch_add(struct pmem2_flush_batch *batch, unsigned *expected, size_t off,
+		size_t len)
+{
+	pmem2_flush_batch_add(batch, Region + off, len);
+
+	if (len == 0)
+		return;
+
+	for (size_t u = off / Unit; u <= (off + len - 1) / Unit; ++u)
+		expected[u] = 1;
+}
+
+/*
+ * test_in_order -- adds small, adjacent ranges in the ascending order,
+ *	they end up flushed with a single call
+ */
+static int
+test_in_order(const struct test_case *tc, int argc, char *argv[])
+{
+	static unsigned expected[MAX_UNITS];
+	struct pmem2_map map;
+	struct pmem2_flush_batch *batch;
+
+	prepare_map(&map, PMEM2_GRANULARITY_CACHE_LINE);
+
+	int ret = pmem2_flush_batch_new(&batch, &map);
+	UT_ASSERTeq(ret, 0);
+
+	for (size_t off = 8; off < 8 + 1000 * 24; off += 24)
+		batch_add(batch, expected, off, 24);
+
+	pmem2_flush_batch_commit(batch);
+
+	check_flushed(expected);
+	UT_ASSERTeq(N_flushes, 1);
+	UT_ASSERTeq(N_drains, 1);
+
+	/* the batch is empty after the commit */
+	pmem2_flush_batch_commit(batch);
+	UT_ASSERTeq(N_flushes, 1);
+	UT_ASSERTeq(N_drains, 2);
+
+	ret = pmem2_flush_batch_delete(&batch);
+	UT_ASSERTeq(ret, 0);
+	UT_ASSERTeq(batch, NULL);
+
+	FREE(Region);
+
+	return 0;
+}
+
+/*
+ * test_random -- adds overlapping ranges in a random order, many more
+ *	than the batch can hold without coalescing them
+ */
+static int
+test_random(const struct test_case *tc, int argc, char *argv[])
+{
+	if (argc < 2)
+		UT_FATAL("usage: test_random <c|p> <nranges>");
+
+	enum pmem2_granularity g = argv[0][0] == 'p' ?
+		PMEM2_GRANULARITY_PAGE : PMEM2_GRANULARITY_CACHE_LINE;
+	unsigned nranges = ATOU(argv[1]);
+
+	static unsigned expected[MAX_UNITS];
+	struct pmem2_map map;
+	struct pmem2_flush_batch *batch;
+
+	prepare_map(&map, g);
+	memset(expected, 0, sizeof(expected));
+
+	int ret = pmem2_flush_batch_new(&batch, &map);
+	UT_ASSERTeq(ret, 0);
+
+	unsigned seed = 42;
+	for (unsigned i = 0; i < nranges; ++i) {
+		size_t off = (size_t)os_rand_r(&seed) % (REGION_SIZE - 256);
+		size_t len = (size_t)os_rand_r(&seed) % 256;
+
+		batch_add(batch, expected, off, len);
+	}
+
+	pmem2_flush_batch_commit(batch);
+
+	check_flushed(expected);
+	UT_ASSERTeq(N_drains, 1);
+
+	ret = pmem2_flush_batch_delete(&batch);
+	UT_ASSERTeq(ret, 0);
+
+	FREE(Region);
+
+	return 2;
+}
+
+/*
+ * test_sparse -- adds many more disjoint ranges than the batch can
+ *	initially hold, each of them twice
+ */
+static int
+test_sparse(const struct test_case *tc, int argc, char *argv[])
+{
+	static unsigned expected[MAX_UNITS];
+	struct pmem2_map map;
+	struct pmem2_flush_batch *batch;
+
+	prepare_map(&map, PMEM2_GRANULARITY_CACHE_LINE);
+	memset(expected, 0, sizeof(expected));
+
+	int ret = pmem2_flush_batch_new(&batch, &map);
+	UT_ASSERTeq(ret, 0);
+
+	/* every other cache line, from the end, twice */
+	for (int pass = 0; pass < 2; ++pass) {
+		for (size_t u = REGION_SIZE / Unit - 1; u >= 2; u -= 2)
+			batch_add(batch, expected, u * Unit + 1, 1);
+	}
+
+	pmem2_flush_batch_commit(batch);
+
+	check_flushed(expected);
+	UT_ASSERTeq(N_flushes, REGION_SIZE / Unit / 2 - 1);
+	UT_ASSERTeq(N_drains, 1);
+
+	ret = pmem2_flush_batch_delete(&batch);
+	UT_ASSERTeq(ret, 0);
+
+	FREE(Region);
+
+	return 0;
+}
+
+/*
+ * test_byte -- the mappings with the byte granularity need only the drain
+ */
+static int
+test_byte(const struct test_case *tc, int argc, char *argv[])
+{
+	static unsigned expected[MAX_UNITS];
+	struct pmem2_map map;
+	struct pmem2_flush_batch *batch;
+
+	prepare_map(&map, PMEM2_GRANULARITY_BYTE);
+	memset(expected, 0, sizeof(expected));
+
+	int ret = pmem2_flush_batch_new(&batch, &map);
+	UT_ASSERTeq(ret, 0);
+
+	pmem2_flush_batch_add(batch, Region, REGION_SIZE);
+	pmem2_flush_batch_commit(batch);
+
+	check_flushed(expected);
+	UT_ASSERTeq(N_flushes, 0);
+	UT_ASSERTeq(N_drains, 1);
+
+	ret = pmem2_flush_batch_delete(&batch);
+	UT_ASSERTeq(ret, 0);
+
+	FREE(Region);
+
+	return 0;
+}
+
+/*
+ * test_cases -- available test cases
+ */
+static struct test_case test_cases[] = {
+	TEST_CASE(test_in_order),
+	TEST_CASE(test_random),
+	TEST_CASE(test_sparse),
+	TEST_CASE(test_byte),
+};
+
+#define NTESTS (sizeof(test_cases) / sizeof(test_cases[0]))
+
+int
+main(int argc, char *argv[])
+{
+	START(argc, argv, "pmem2_flush_batch");
+
+	util_init();
+	TEST_CASE_PROCESS(argc, argv, test_cases, NTESTS);
+
+	DONE(NULL);
+}
@@ -0,0 +1,258 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/* Copyright 2026, Intel Corporation */
+
+/*
+ * pmem2_memcmp.c -- tests for the comparison and the checksumming copy
+ *	of libpmem2
+ */
+
+#include <endian.h>
+
+#include "unittest.h"
+#include "ut_pmem2.h"
+
+#define REGION_SIZE (128 * 1024)
+
+static const size_t Lengths[] = {
+	0, 1, 7, 31, 32, 33, 63, 64, 65, 127, 128, 129, 255, 256, 257,
+	1000, 4096 + 13, REGION_SIZE / 2 - 64,
+};
+
+static const size_t Offsets[] = {0, 1, 8, 31, 32, 33, 63, 64};
+
+static unsigned Flags[] = {
+	0,
+	PMEM2_F_MEM_NODRAIN,
+	PMEM2_F_MEM_NONTEMPORAL,
+	PMEM2_F_MEM_TEMPORAL,
+	PMEM2_F_MEM_WC,
+	PMEM2_F_MEM_WB,
+	PMEM2_F_MEM_NOFLUSH,
+	PMEM2_F_MEM_TEMPORAL | PMEM2_F_MEM_NODRAIN,
+};
+
+/*
+ * map_file -- maps the whole file
+ */
+static struct pmem2_map *
+map_file(const char *file, int *fd)
+{
+	struct pmem2_config *cfg;
+	struct pmem2_source *src;
+	struct pmem2_map *map;
+
+	*fd = OPEN(file, O_RDWR);
+
+	PMEM2_CONFIG_NEW(&cfg);
+	PMEM2_SOURCE_FROM_FD(&src, *fd);
+	PMEM2_CONFIG_SET_GRANULARITY(cfg, PMEM2_GRANULARITY_PAGE);
+
+	int ret = pmem2_map_new(&map, cfg, src);
+	UT_PMEM2_EXPECT_RETURN(ret, 0);
+
+	PMEM2_CONFIG_DELETE(&cfg);
+	PMEM2_SOURCE_DELETE(&src);
+
+	UT_ASSERT(pmem2_map_get_size(map) >= 2 * REGION_SIZE);
+
+	return map;
+}
+
+/*
+ * unmap_file -- unmaps the file and closes it
+ */
+static void
+unmap_file(struct pmem2_map **map, int fd)
+{
+	int ret = pmem2_map_delete(map);
+	UT_ASSERTeq(ret, 0);
+	CLOSE(fd);
+}
+
+/*
+ * sign -- returns the sign of the result of a comparison
+ */
+static int
+sign(int ret)
+{
+	return (ret > 0) - (ret < 0);
+}
+
+/*
+ * check_memcmp -- compares the pmem with the buffer, and checks the result
+ *	against the one of memcmp
+ */
+static void
+check_memcmp(pmem2_memcmp_fn memcmp_fn, const char *pmem, const char *buf,
+		size_t len)
+{
+	int expected = sign(memcmp(pmem, buf, len));
+	int ret = sign(memcmp_fn(pmem, buf, len));
+
+	if (ret != expected)
+		UT_FATAL("pmem %p buf %p len %zu: %d, expected %d", pmem, buf,
+			len, ret, expected);
+}
+
+/*
+ * test_memcmp -- compares equal ranges, and ranges differing in a single
+ *	byte, at various alignments of both of them
+ */
+static int
+test_memcmp(const struct test_case *tc, int argc, char *argv[])
+{
+	if (argc < 1)
+		UT_FATAL("usage: test_memcmp <file>");
+
+	int fd;
+	struct pmem2_map *map = map_file(argv[0], &fd);
+	pmem2_memcmp_fn memcmp_fn = pmem2_get_memcmp_fn(map);
+
+	char *pmem = pmem2_map_get_address(map);
+	static char buf[REGION_SIZE];
+
+	for (size_t i = 0; i < REGION_SIZE; ++i)
+		buf[i] = (char)rand();
+
+	pmem2_memcpy_fn memcpy_fn = pmem2_get_memcpy_fn(map);
+	memcpy_fn(pmem, buf, REGION_SIZE, 0);
+
+	for (size_t l = 0; l < ARRAY_SIZE(Lengths); ++l) {
+		for (size_t o = 0; o < ARRAY_SIZE(Offsets); ++o) {
+			size_t len = Lengths[l];
+			char *p = pmem + Offsets[o];
+
+			/* the same data, with the buffer at other offsets */
+			char *b = buf + Offsets[o];
+			check_memcmp(memcmp_fn, p, b, len);
+			UT_ASSERTeq(memcmp_fn(p, b, len), 0);
+			check_memcmp(memcmp_fn, p, buf + 3, len);
+
+			if (len == 0)
+				continue;
+
+			size_t diffs[] = {0, len / 2, len - 1};
+			for (size_t d = 0; d < ARRAY_SIZE(diffs); ++d) {
+				char orig = b[diffs[d]];
+
+				/* both greater and smaller */
+				b[diffs[d]] = (char)(orig + 1);
+				check_memcmp(memcmp_fn, p, b, len);
+				b[diffs[d]] = (char)(orig - 1);
+				check_memcmp(memcmp_fn, p, b, len);
+
+				b[diffs[d]] = orig;
+			}
+
+			/* the first difference decides, not the later ones */
+			if (len > 2) {
+				b[len - 1] = (char)(b[len - 1] + 1);
+				b[1] = (char)(b[1] - 1);
+				check_memcmp(memcmp_fn, p, b, len);
+				b[len - 1] = (char)(b[len - 1] - 1);
+				b[1] = (char)(b[1] + 1);
+			}
+		}
+	}
+
+	unmap_file(&map, fd);
+
+	return 1;
+}
+
+/*
+ * checksum -- the reference Fletcher64 checksum of 32-bit words
+ */
+static uint64_t
+checksum(const void *addr, size_t len, uint64_t csum)
+{
+	const uint32_t *p32 = addr;
+	uint32_t lo32 = (uint32_t)csum;
+	uint32_t hi32 = (uint32_t)(csum >> 32);
+
+	for (size_t i = 0; i < len / sizeof(uint32_t); ++i) {
+		lo32 += le32toh(p32[i]);
+		hi32 += lo32;
+	}
+
+	return (uint64_t)hi32 << 32 | lo32;
+}
+
+/*
+ * test_memcpy_checksum -- copies buffers of various lengths with every set
+ *	of flags, and checks the data and the checksums
+ */
+static int
+test_memcpy_checksum(const struct test_case *tc, int argc, char *argv[])
+{
+	if (argc < 1)
+		UT_FATAL("usage: test_memcpy_checksum <file>");
+
+	int fd;
+	struct pmem2_map *map = map_file(argv[0], &fd);
+
+	char *dest = pmem2_map_get_address(map);
+	char *src = dest + REGION_SIZE;
+	static char dram[REGION_SIZE];
+
+	for (size_t f = 0; f < ARRAY_SIZE(Flags); ++f) {
+		for (size_t l = 0; l < ARRAY_SIZE(Lengths); ++l) {
+			size_t len = ALIGN_DOWN(Lengths[l], sizeof(uint32_t));
+
+			for (size_t i = 0; i < REGION_SIZE; ++i)
+				dram[i] = (char)rand();
+			memcpy(src, dram, REGION_SIZE);
+			memset(dest, 0, REGION_SIZE);
+
+			/* the checksum is continued from the given one */
+			uint64_t csum = 0xdeadbeefcafe;
+			uint64_t expected = checksum(dram, len, csum);
+
+			int ret = pmem2_memcpy_checksum(map, dest + 4, dram,
+				len, Flags[f], &csum);
+			UT_PMEM2_EXPECT_RETURN(ret, 0);
+			UT_ASSERTeq(csum, expected);
+			UT_ASSERTeq(memcmp(dest + 4, dram, len), 0);
+			UT_ASSERTeq(dest[len + 4], 0);
+		}
+
+		/* the source in the mapping */
+		uint64_t csum = 0;
+		uint64_t expected = checksum(src, REGION_SIZE, 0);
+		int ret = pmem2_memcpy_checksum(map, dest, src, REGION_SIZE,
+			Flags[f], &csum);
+		UT_PMEM2_EXPECT_RETURN(ret, 0);
+		UT_ASSERTeq(csum, expected);
+		UT_ASSERTeq(memcmp(dest, src, REGION_SIZE), 0);
+	}
+
+	/* the checksum is computed over 32-bit words */
+	uint64_t csum = 0;
+	int ret = pmem2_memcpy_checksum(map, dest, dram, 6, 0, &csum);
+	UT_PMEM2_EXPECT_RETURN(ret, PMEM2_E_LENGTH_UNALIGNED);
+	UT_ASSERTeq(csum, 0);
+
+	unmap_file(&map, fd);
+
+	return 1;
+}
+
+/*
+ * test_cases -- available test cases
+ */
+static struct test_case test_cases[] = {
+	TEST_CASE(test_memcmp),
+	TEST_CASE(test_memcpy_checksum),
+};
+
+#define NTESTS (sizeof(test_cases) / sizeof(test_cases[0]))
+
+int
+main(int argc, char *argv[])
+{
+	START(argc, argv, "pmem2_memcmp");
+
+	TEST_CASE_PROCESS(argc, argv, test_cases, NTESTS);
+
+	DONE(NULL);
+}
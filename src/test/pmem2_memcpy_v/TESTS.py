@@ -0,0 +1,40 @@
+#!../env.py
+# SPDX-License-Identifier: BSD-3-Clause
+# Copyright 2026, Intel Corporation
+#
+
+import testframework as t
+from testframework import granularity as g
+
+
+@g.require_granularity(g.ANY)
+class Pmem2MemcpyV(t.Test):
+    test_type = t.Short
+    envs0 = ()
+    envs1 = ()
+
+    def run(self, ctx):
+        for env in self.envs0:
+            ctx.env[env] = '0'
+        for env in self.envs1:
+            ctx.env[env] = '1'
+
+        filepath = ctx.create_holey_file(1 * t.MiB, 'testfile')
+        ctx.exec('pmem2_memcpy_v', filepath)
+
+
+class TEST0(Pmem2MemcpyV):
+    pass
+
+
+class TEST1(Pmem2MemcpyV):
+    envs1 = ("PMEM_NO_MOVNT",)
+
+
+class TEST2(Pmem2MemcpyV):
+    envs1 = ("PMEM_NO_MOVNT", "PMEM_NO_GENERIC_MEMCPY")
+
+
+@t.require_architectures('x86_64')
+class TEST3(Pmem2MemcpyV):
+    envs0 = ("PMEM_AVX512F", "PMEM_AVX",)
@@ -0,0 +1,139 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/* Copyright 2026, Intel Corporation */
+
+/*
+ * pmem2_memcpy_v.c -- test for the vectored memcpy from libpmem2
+ *
+ * usage: pmem2_memcpy_v file
+ */
+
+#include "unittest.h"
+#include "file.h"
+#include "ut_pmem2.h"
+
+#define MAX_IOV 64
+#define REGION_SIZE (64 * 1024)
+
+static unsigned Flags[] = {
+	0,
+	PMEM2_F_MEM_NODRAIN,
+	PMEM2_F_MEM_NONTEMPORAL,
+	PMEM2_F_MEM_TEMPORAL,
+	PMEM2_F_MEM_WC,
+	PMEM2_F_MEM_WB,
+	PMEM2_F_MEM_NOFLUSH,
+	PMEM2_F_MEM_TEMPORAL | PMEM2_F_MEM_NODRAIN,
+};
+
+/* offsets of the elements in the destination and the source, and lengths */
+struct element {
+	size_t dest;
+	size_t src;
+	size_t len;
+};
+
+/* many small elements, each sharing a cache line with the next one */
+static struct element Adjacent[] = {
+	{0, 100, 24}, {24, 900, 24}, {48, 200, 24}, {72, 30, 24},
+	{96, 3000, 8}, {104, 1, 1}, {105, 7, 23}, {128, 8000, 64},
+};
+
+/* elements of different lengths, in no particular order, some with gaps */
+static struct element Mixed[] = {
+	{4096, 0, 4096},
+	{3, 5000, 63},
+	{8200, 77, 1},
+	{66, 10000, 2000},
+	{2100, 20000, 0},
+	{2100, 20001, 255},
+	{2355, 30000, 257},
+	{12000, 40000, 20000},
+	{9000, 9, 64},
+	{9064, 700, 128},
+};
+
+/*
+ * do_memcpy_v -- copies the elements with every set of flags and checks
+ *	the destination, including the bytes between the elements
+ */
+static void
+do_memcpy_v(struct pmem2_map *map, char *dest, char *src,
+		const struct element *e, size_t n)
+{
+	UT_ASSERT(n <= MAX_IOV);
+
+	static char expected[REGION_SIZE];
+	struct pmem2_iov iov[MAX_IOV];
+
+	for (size_t f = 0; f < ARRAY_SIZE(Flags); ++f) {
+		for (size_t i = 0; i < REGION_SIZE; ++i)
+			src[i] = (char)rand();
+
+		memset(dest, 0, REGION_SIZE);
+		memset(expected, 0, REGION_SIZE);
+
+		for (size_t i = 0; i < n; ++i) {
+			UT_ASSERT(e[i].dest + e[i].len <= REGION_SIZE);
+			UT_ASSERT(e[i].src + e[i].len <= REGION_SIZE);
+
+			iov[i].dest = dest + e[i].dest;
+			iov[i].src = src + e[i].src;
+			iov[i].len = e[i].len;
+
+			memcpy(expected + e[i].dest, src + e[i].src, e[i].len);
+		}
+
+		pmem2_memcpy_v(map, iov, n, Flags[f]);
+
+		if (memcmp(dest, expected, REGION_SIZE) != 0)
+			UT_FATAL("%s: unexpected data with flags 0x%x",
+				__func__, Flags[f]);
+	}
+}
+
+int
+main(int argc, char *argv[])
+{
+	struct pmem2_config *cfg;
+	struct pmem2_source *psrc;
+	struct pmem2_map *map;
+
+	START(argc, argv, "pmem2_memcpy_v");
+
+	if (argc != 2)
+		UT_FATAL("usage: %s file", argv[0]);
+
+	int fd = OPEN(argv[1], O_RDWR);
+
+	PMEM2_CONFIG_NEW(&cfg);
+	PMEM2_SOURCE_FROM_FD(&psrc, fd);
+	PMEM2_CONFIG_SET_GRANULARITY(cfg, PMEM2_GRANULARITY_PAGE);
+
+	int ret = pmem2_map_new(&map, cfg, psrc);
+	UT_PMEM2_EXPECT_RETURN(ret, 0);
+
+	PMEM2_CONFIG_DELETE(&cfg);
+	PMEM2_SOURCE_DELETE(&psrc);
+
+	UT_ASSERT(pmem2_map_get_size(map) >= 2 * REGION_SIZE);
+	char *dest = pmem2_map_get_address(map);
+	char *src = dest + REGION_SIZE;
+
+	/* an empty vector does nothing */
+	pmem2_memcpy_v(map, NULL, 0, 0);
+
+	do_memcpy_v(map, dest, src, Adjacent, ARRAY_SIZE(Adjacent));
+	do_memcpy_v(map, dest, src, Mixed, ARRAY_SIZE(Mixed));
+
+	/* the source does not have to be in the mapping */
+	static char dram[REGION_SIZE];
+	do_memcpy_v(map, dest, dram, Adjacent, ARRAY_SIZE(Adjacent));
+	do_memcpy_v(map, dest + 1, dram, Mixed, ARRAY_SIZE(Mixed));
+
+	ret = pmem2_map_delete(&map);
+	UT_ASSERTeq(ret, 0);
+
+	CLOSE(fd);
+
+	DONE(NULL);
+}
@@ -0,0 +1,43 @@
+#!../env.py
+# SPDX-License-Identifier: BSD-3-Clause
+# Copyright 2026, Intel Corporation
+#
+
+import testframework as t
+from testframework import granularity as g
+
+
+@g.require_granularity(g.ANY)
+class Pmem2NtThreshold(t.Test):
+    test_type = t.Short
+    envs = {}
+
+    def run(self, ctx):
+        for env, value in self.envs.items():
+            ctx.env[env] = value
+
+        filepath = ctx.create_holey_file(1 * t.MiB, 'testfile')
+        ctx.exec('pmem2_nt_threshold', filepath, self.test_case)
+
+
+class TEST0(Pmem2NtThreshold):
+    """default threshold of the mapping"""
+    test_case = 'd'
+
+
+class TEST1(Pmem2NtThreshold):
+    """calibrated threshold of the mapping"""
+    test_case = 'c'
+
+
+class TEST2(Pmem2NtThreshold):
+    """calibrated threshold without non-temporal stores"""
+    test_case = 'c'
+    envs = {'PMEM_NO_MOVNT': '1'}
+
+
+@t.require_architectures('x86_64')
+class TEST3(Pmem2NtThreshold):
+    """threshold set by the environment variable"""
+    test_case = 'e'
+    envs = {'PMEM_MOVNT_THRESHOLD': '1024'}
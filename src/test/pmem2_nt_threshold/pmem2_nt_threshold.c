@@ -0,0 +1,203 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/* Copyright 2026, Intel Corporation */
+
+/*
+ * pmem2_nt_threshold.c -- test for the non-temporal threshold of mappings
+ *
+ * usage: pmem2_nt_threshold file d|c|e
+ *
+ * d - the default threshold
+ * c - the calibrated threshold
+ * e - the threshold set by PMEM_MOVNT_THRESHOLD
+ */
+
+#include "unittest.h"
+#include "file.h"
+#include "ut_pmem2.h"
+
+#define DATA_SIZE (256 * 1024)
+
+/*
+ * map_file -- maps the file, with the threshold calibration if requested
+ */
+static struct pmem2_map *
+map_file(int fd, int calibrate)
+{
+	struct pmem2_config *cfg;
+	struct pmem2_source *src;
+	struct pmem2_map *map;
+
+	PMEM2_CONFIG_NEW(&cfg);
+	PMEM2_SOURCE_FROM_FD(&src, fd);
+	PMEM2_CONFIG_SET_GRANULARITY(cfg, PMEM2_GRANULARITY_PAGE);
+
+	int ret = pmem2_config_set_nt_threshold_calibration(cfg, calibrate);
+	UT_PMEM2_EXPECT_RETURN(ret, 0);
+
+	ret = pmem2_map_new(&map, cfg, src);
+	UT_PMEM2_EXPECT_RETURN(ret, 0);
+
+	PMEM2_CONFIG_DELETE(&cfg);
+	PMEM2_SOURCE_DELETE(&src);
+
+	UT_ASSERT(pmem2_map_get_size(map) >= 2 * DATA_SIZE);
+
+	return map;
+}
+
+/*
+ * default_threshold -- returns the threshold of a mapping without
+ *	the calibration
+ */
+static size_t
+default_threshold(struct pmem2_map *map, size_t arch_threshold)
+{
+	if (pmem2_map_get_store_granularity(map) == PMEM2_GRANULARITY_BYTE)
+		return SIZE_MAX;
+
+	return arch_threshold;
+}
+
+/*
+ * check_copies -- checks the data copied to the mapping with its functions,
+ *	with the lengths around all the possible thresholds
+ */
+static void
+check_copies(struct pmem2_map *map)
+{
+	char *addr = pmem2_map_get_address(map);
+	char *src = addr + DATA_SIZE;
+	pmem2_memcpy_fn memcpy_fn = pmem2_get_memcpy_fn(map);
+	pmem2_memset_fn memset_fn = pmem2_get_memset_fn(map);
+
+	for (size_t i = 0; i < DATA_SIZE; ++i)
+		src[i] = (char)rand();
+
+	for (size_t len = 32; len <= DATA_SIZE / 2; len *= 2) {
+		for (size_t l = len - 1; l <= len + 1; ++l) {
+			memset(addr, 0, l + 2);
+
+			memcpy_fn(addr + 1, src, l, 0);
+			UT_ASSERTeq(addr[0], 0);
+			UT_ASSERTeq(memcmp(addr + 1, src, l), 0);
+			UT_ASSERTeq(addr[l + 1], 0);
+
+			memset_fn(addr + 1, 0x5a, l, 0);
+			UT_ASSERTeq(addr[0], 0);
+			for (size_t j = 1; j <= l; ++j)
+				UT_ASSERTeq(addr[j], 0x5a);
+			UT_ASSERTeq(addr[l + 1], 0);
+		}
+	}
+}
+
+/*
+ * test_default -- checks the threshold of a mapping without the calibration
+ */
+static void
+test_default(int fd)
+{
+	struct pmem2_map *map = map_file(fd, 0);
+
+#if defined(__x86_64__) || defined(_M_X64)
+	UT_ASSERTeq(pmem2_map_get_nt_threshold(map),
+		default_threshold(map, 256));
+#else
+	UT_ASSERTeq(pmem2_map_get_nt_threshold(map), SIZE_MAX);
+#endif
+
+	check_copies(map);
+
+	int ret = pmem2_map_delete(&map);
+	UT_ASSERTeq(ret, 0);
+}
+
+/*
+ * test_calibrated -- checks the calibrated threshold and that the calibration
+ *	did not change the data in the mapping
+ */
+static void
+test_calibrated(int fd)
+{
+	struct pmem2_map *map = map_file(fd, 0);
+	char *addr = pmem2_map_get_address(map);
+	size_t uncalibrated = pmem2_map_get_nt_threshold(map);
+
+	for (size_t i = 0; i < DATA_SIZE; ++i)
+		addr[i] = (char)(i % 251);
+	pmem2_get_persist_fn(map)(addr, DATA_SIZE);
+
+	int ret = pmem2_map_delete(&map);
+	UT_ASSERTeq(ret, 0);
+
+	map = map_file(fd, 1);
+	addr = pmem2_map_get_address(map);
+
+	for (size_t i = 0; i < DATA_SIZE; ++i)
+		UT_ASSERTeq(addr[i], (char)(i % 251));
+
+	/*
+	 * the page granularity is never calibrated, and neither are
+	 * the platforms without the non-temporal stores
+	 */
+	size_t threshold = pmem2_map_get_nt_threshold(map);
+	enum pmem2_granularity g = pmem2_map_get_store_granularity(map);
+	if (g == PMEM2_GRANULARITY_PAGE ||
+	    (g == PMEM2_GRANULARITY_CACHE_LINE && uncalibrated == SIZE_MAX)) {
+		UT_ASSERTeq(threshold, uncalibrated);
+	} else if (threshold != SIZE_MAX) {
+		UT_ASSERT(threshold >= 64 && threshold <= 64 * 1024);
+		UT_ASSERTeq(threshold & (threshold - 1), 0);
+	}
+
+	check_copies(map);
+
+	ret = pmem2_map_delete(&map);
+	UT_ASSERTeq(ret, 0);
+}
+
+/*
+ * test_env -- checks the threshold set by PMEM_MOVNT_THRESHOLD
+ */
+static void
+test_env(int fd)
+{
+	struct pmem2_map *map = map_file(fd, 0);
+
+	UT_ASSERTeq(pmem2_map_get_nt_threshold(map),
+		default_threshold(map, 1024));
+
+	check_copies(map);
+
+	int ret = pmem2_map_delete(&map);
+	UT_ASSERTeq(ret, 0);
+}
+
+int
+main(int argc, char *argv[])
+{
+	START(argc, argv, "pmem2_nt_threshold");
+
+	if (argc != 3)
+		UT_FATAL("usage: %s file d|c|e", argv[0]);
+
+	int fd = OPEN(argv[1], O_RDWR);
+
+	switch (argv[2][0]) {
+		case 'd':
+			test_default(fd);
+			break;
+		case 'c':
+			test_calibrated(fd);
+			break;
+		case 'e':
+			test_env(fd);
+			break;
+		default:
+			UT_FATAL("unknown test: %s", argv[2]);
+	}
+
+	CLOSE(fd);
+
+	DONE(NULL);
+}